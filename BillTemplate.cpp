@@ -0,0 +1,332 @@
+// BillTemplate.cpp (implementation)
+#include "BillTemplate.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+
+/**
+ * @brief Name of each field in template source and the section it must appear in, if any.
+ */
+static const struct {
+    const char* name;
+    BillField field;
+    int section; // -1 for anywhere, else a BillSection
+} FIELD_NAMES[] = {
+    {"invoice", BillField::Invoice, -1}, {"historyId", BillField::HistoryId, -1}, {"date", BillField::Date, -1},
+    {"status", BillField::Status, -1}, {"branchId", BillField::BranchId, -1},
+    {"customerId", BillField::CustomerId, -1}, {"customerName", BillField::CustomerName, -1},
+    {"customerPhone", BillField::CustomerPhone, -1},
+    {"vehicleId", BillField::VehicleId, -1}, {"regNo", BillField::RegNo, -1}, {"model", BillField::Model, -1},
+    {"subtotal", BillField::Subtotal, -1}, {"discountPercent", BillField::DiscountPercent, -1},
+    {"discountLabel", BillField::DiscountLabel, -1}, {"discount", BillField::Discount, -1}, {"total", BillField::Total, -1},
+    {"taxTotal", BillField::TaxTotal, -1}, {"amountDue", BillField::AmountDue, -1},
+    {"itemId", BillField::ItemId, static_cast<int>(BillSection::Items)},
+    {"itemName", BillField::ItemName, static_cast<int>(BillSection::Items)},
+    {"itemPrice", BillField::ItemPrice, static_cast<int>(BillSection::Items)},
+    {"taxLabel", BillField::TaxLabel, static_cast<int>(BillSection::Taxes)},
+    {"taxRate", BillField::TaxRate, static_cast<int>(BillSection::Taxes)},
+    {"taxAmount", BillField::TaxAmount, static_cast<int>(BillSection::Taxes)},
+};
+
+static const struct {
+    const char* name;
+    BillSection section;
+} SECTION_NAMES[] = {
+    {"items", BillSection::Items}, {"taxes", BillSection::Taxes}, {"discount", BillSection::Discount},
+    {"customer", BillSection::Customer}, {"vehicle", BillSection::Vehicle},
+};
+
+static const char BUILTIN_TEXT[] =
+    "INVOICE {{invoice}}\n"
+    "Date: {{date}}\n"
+    "Customer: {{#customer}}{{customerName}} ({{customerPhone}}) {{/customer}}#{{customerId}}\n"
+    "Vehicle: {{#vehicle}}{{regNo}} {{model}} {{/vehicle}}#{{vehicleId}}\n"
+    "------------------------------------------------\n"
+    "{{#items}}{{itemName:-36}}{{itemPrice:12}}\n{{/items}}"
+    "------------------------------------------------\n"
+    "Subtotal                            {{subtotal:12}}\n"
+    "{{#discount}}{{discountLabel:-36}}{{discount:12}}\n{{/discount}}"
+    "{{#taxes}}{{taxLabel:-36}}{{taxAmount:12}}\n{{/taxes}}"
+    "Total                               {{amountDue:12}}\n"
+    "Status: {{status}}\n";
+
+static const char BUILTIN_HTML[] =
+    "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>Invoice {{invoice}}</title>\n"
+    "<style>body{font-family:sans-serif}table{border-collapse:collapse}td{padding:2px 12px}"
+    ".amt{text-align:right}.total td{font-weight:bold;border-top:1px solid #000}</style>\n"
+    "</head><body>\n<h1>Invoice {{invoice}}</h1>\n"
+    "<p>Date: {{date}}<br>\n"
+    "Customer: {{#customer}}{{customerName}} ({{customerPhone}}) {{/customer}}#{{customerId}}<br>\n"
+    "Vehicle: {{#vehicle}}{{regNo}} {{model}} {{/vehicle}}#{{vehicleId}}</p>\n<table>\n"
+    "{{#items}}<tr><td>{{itemName}}</td><td class=\"amt\">{{itemPrice}}</td></tr>\n{{/items}}"
+    "<tr class=\"total\"><td>Subtotal</td><td class=\"amt\">{{subtotal}}</td></tr>\n"
+    "{{#discount}}<tr><td>{{discountLabel}}</td><td class=\"amt\">{{discount}}</td></tr>\n{{/discount}}"
+    "{{#taxes}}<tr><td>{{taxLabel}}</td><td class=\"amt\">{{taxAmount}}</td></tr>\n{{/taxes}}"
+    "<tr class=\"total\"><td>Total</td><td class=\"amt\">{{amountDue}}</td></tr>\n"
+    "</table>\n<p>Status: {{status}}</p>\n</body></html>\n";
+
+/**
+ * @brief Returns the source of the built-in bill template.
+ * @param html True for the HTML page, false for plain text.
+ * @return const char* The template source.
+ */
+const char* builtinBillTemplate(bool html) {
+    return html ? BUILTIN_HTML : BUILTIN_TEXT;
+}
+
+// ---- Compiling ----
+
+static void appendText(std::vector<BillInstr>& code, const std::string& source, size_t from, size_t to) {
+    if (from >= to) return;
+    if (!code.empty() && code.back().op == BillOp::Text) {
+        code.back().text.append(source, from, to - from);
+        return;
+    }
+    BillInstr in{BillOp::Text, source.substr(from, to - from)};
+    code.push_back(std::move(in));
+}
+
+/**
+ * @brief Compiles a bill template.
+ * @param source The template.
+ * @param escapeHtml Whether field values are escaped for HTML.
+ * @param out Receives the compiled template.
+ * @param error Receives a description of the first problem if compilation fails.
+ * @return bool True if the template compiled.
+ */
+bool compileBillTemplate(const std::string& source, bool escapeHtml, BillTemplate& out, std::string& error) {
+    BillTemplate t;
+    t.escapeHtml = escapeHtml;
+    std::vector<size_t> open; // Indexes of unclosed Section instructions
+    size_t pos = 0;
+    while (pos < source.size()) {
+        size_t tag = source.find("{{", pos);
+        if (tag == std::string::npos) {
+            appendText(t.code, source, pos, source.size());
+            break;
+        }
+        appendText(t.code, source, pos, tag);
+        size_t close = source.find("}}", tag + 2);
+        if (close == std::string::npos) {
+            error = "unterminated tag at offset " + std::to_string(tag);
+            return false;
+        }
+        std::string name = source.substr(tag + 2, close - tag - 2);
+        pos = close + 2;
+
+        if (!name.empty() && (name[0] == '#' || name[0] == '/')) {
+            const auto* s = std::find_if(std::begin(SECTION_NAMES), std::end(SECTION_NAMES),
+                                         [&](const auto& e) { return name.compare(1, std::string::npos, e.name) == 0; });
+            if (s == std::end(SECTION_NAMES)) {
+                error = "unknown section '" + name.substr(1) + "'";
+                return false;
+            }
+            if (name[0] == '#') {
+                open.push_back(t.code.size());
+                BillInstr in{BillOp::Section, ""};
+                in.section = s->section;
+                t.code.push_back(std::move(in));
+            } else {
+                if (open.empty() || t.code[open.back()].section != s->section) {
+                    error = "unexpected {{" + name + "}}";
+                    return false;
+                }
+                t.code[open.back()].end = t.code.size();
+                open.pop_back();
+                t.code.push_back({BillOp::End, ""});
+            }
+            continue;
+        }
+
+        int width = 0;
+        size_t colon = name.find(':');
+        if (colon != std::string::npos) {
+            const char* begin = name.data() + colon + 1;
+            const char* end = name.data() + name.size();
+            auto r = std::from_chars(begin, end, width);
+            if (r.ec != std::errc() || r.ptr != end) {
+                error = "bad width in {{" + name + "}}";
+                return false;
+            }
+            name.resize(colon);
+        }
+        const auto* f = std::find_if(std::begin(FIELD_NAMES), std::end(FIELD_NAMES),
+                                     [&](const auto& e) { return name == e.name; });
+        if (f == std::end(FIELD_NAMES)) {
+            error = "unknown field '" + name + "'";
+            return false;
+        }
+        if (f->section >= 0) {
+            bool inside = std::any_of(open.begin(), open.end(), [&](size_t i) {
+                return static_cast<int>(t.code[i].section) == f->section;
+            });
+            if (!inside) {
+                error = "field '" + name + "' is only allowed inside its section";
+                return false;
+            }
+        }
+        BillInstr in{BillOp::Field, ""};
+        in.field = f->field;
+        in.width = width;
+        t.code.push_back(std::move(in));
+    }
+    if (!open.empty()) {
+        error = "unclosed section";
+        return false;
+    }
+    out = std::move(t);
+    return true;
+}
+
+// ---- Rendering ----
+
+static void appendInt(std::string& out, long long value) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr);
+}
+
+/**
+ * @brief Appends an amount as "Rs.1234.50", rounded to the paisa.
+ */
+static void appendMoney(std::string& out, double amount) {
+    long long paise = std::llround(amount * 100);
+    if (paise < 0) {
+        out += '-';
+        paise = -paise;
+    }
+    out += "Rs.";
+    appendInt(out, paise / 100);
+    out += '.';
+    out += static_cast<char>('0' + paise / 10 % 10);
+    out += static_cast<char>('0' + paise % 10);
+}
+
+/**
+ * @brief Appends a percentage with at most two decimals and no trailing zeros, e.g. "10", "12.5".
+ */
+static void appendPercent(std::string& out, double percent) {
+    long long hundredths = std::llround(percent * 100);
+    if (hundredths < 0) {
+        out += '-';
+        hundredths = -hundredths;
+    }
+    appendInt(out, hundredths / 100);
+    int frac = static_cast<int>(hundredths % 100);
+    if (frac == 0) return;
+    out += '.';
+    out += static_cast<char>('0' + frac / 10);
+    if (frac % 10) out += static_cast<char>('0' + frac % 10);
+}
+
+static void appendEscaped(std::string& out, const std::string& text, bool html) {
+    if (!html) {
+        out += text;
+        return;
+    }
+    for (char ch : text) {
+        switch (ch) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default: out += ch;
+        }
+    }
+}
+
+static double taxTotal(const BillData& d) {
+    double sum = 0;
+    for (const auto& tx : d.taxes) sum += tx.amount;
+    return sum;
+}
+
+static void appendField(const BillTemplate& t, const BillInstr& in, const BillData& d, const ServiceItem* item,
+                        const BillTaxLine* tax, std::string& out) {
+    const ServiceHistory& h = *d.booking;
+    size_t start = out.size();
+    switch (in.field) {
+        case BillField::Invoice: {
+            char number[24];
+            int n = std::snprintf(number, sizeof(number), "INV-%06d", h.historyId);
+            out.append(number, static_cast<size_t>(n));
+            break;
+        }
+        case BillField::HistoryId: appendInt(out, h.historyId); break;
+        case BillField::Date: appendEscaped(out, h.dateTime, t.escapeHtml); break;
+        case BillField::Status: appendEscaped(out, h.status, t.escapeHtml); break;
+        case BillField::BranchId: appendInt(out, h.branchId); break;
+        case BillField::CustomerId: appendInt(out, h.customerId); break;
+        case BillField::CustomerName: if (d.customer) appendEscaped(out, d.customer->name, t.escapeHtml); break;
+        case BillField::CustomerPhone: if (d.customer) appendEscaped(out, d.customer->phone, t.escapeHtml); break;
+        case BillField::VehicleId: appendInt(out, h.vehicleId); break;
+        case BillField::RegNo: if (d.vehicle) appendEscaped(out, d.vehicle->regNo, t.escapeHtml); break;
+        case BillField::Model: if (d.vehicle) appendEscaped(out, d.vehicle->model, t.escapeHtml); break;
+        case BillField::Subtotal: appendMoney(out, h.subtotal); break;
+        case BillField::DiscountPercent: appendPercent(out, h.discountPercent); break;
+        case BillField::DiscountLabel:
+            out += "Discount (";
+            appendPercent(out, h.discountPercent);
+            out += "%)";
+            break;
+        case BillField::Discount: appendMoney(out, h.total - h.subtotal); break;
+        case BillField::Total: appendMoney(out, h.total); break;
+        case BillField::TaxTotal: appendMoney(out, taxTotal(d)); break;
+        case BillField::AmountDue: appendMoney(out, h.total + taxTotal(d)); break;
+        case BillField::ItemId: appendInt(out, item->id); break;
+        case BillField::ItemName: appendEscaped(out, item->name, t.escapeHtml); break;
+        case BillField::ItemPrice: appendMoney(out, item->price); break;
+        case BillField::TaxLabel: appendEscaped(out, tax->label, t.escapeHtml); break;
+        case BillField::TaxRate: appendPercent(out, tax->ratePercent); break;
+        case BillField::TaxAmount: appendMoney(out, tax->amount); break;
+    }
+    size_t len = out.size() - start;
+    size_t width = static_cast<size_t>(in.width < 0 ? -in.width : in.width);
+    if (len >= width) return;
+    if (in.width < 0) out.append(width - len, ' ');
+    else out.insert(start, width - len, ' ');
+}
+
+static void renderRange(const BillTemplate& t, size_t begin, size_t end, const BillData& d,
+                        const ServiceItem* item, const BillTaxLine* tax, std::string& out) {
+    for (size_t i = begin; i < end; ++i) {
+        const BillInstr& in = t.code[i];
+        switch (in.op) {
+            case BillOp::Text: out += in.text; break;
+            case BillOp::Field: appendField(t, in, d, item, tax, out); break;
+            case BillOp::End: break;
+            case BillOp::Section:
+                switch (in.section) {
+                    case BillSection::Items:
+                        for (const ServiceItem* s : d.items) renderRange(t, i + 1, in.end, d, s, tax, out);
+                        break;
+                    case BillSection::Taxes:
+                        for (const auto& tx : d.taxes) renderRange(t, i + 1, in.end, d, item, &tx, out);
+                        break;
+                    case BillSection::Discount:
+                        if (d.booking->discountPercent > 0) renderRange(t, i + 1, in.end, d, item, tax, out);
+                        break;
+                    case BillSection::Customer:
+                        if (d.customer) renderRange(t, i + 1, in.end, d, item, tax, out);
+                        break;
+                    case BillSection::Vehicle:
+                        if (d.vehicle) renderRange(t, i + 1, in.end, d, item, tax, out);
+                        break;
+                }
+                i = in.end;
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Renders a compiled template.
+ * @param t The template.
+ * @param d The bill.
+ * @param out The rendered bill is appended here.
+ */
+void renderBill(const BillTemplate& t, const BillData& d, std::string& out) {
+    renderRange(t, 0, t.code.size(), d, nullptr, nullptr, out);
+}
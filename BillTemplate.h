@@ -0,0 +1,116 @@
+// BillTemplate.h
+#ifndef BILL_TEMPLATE_H
+#define BILL_TEMPLATE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+
+/**
+ * @brief Kind of a compiled template instruction.
+ */
+enum class BillOp {
+    Text,       /**< Copy literal text. */
+    Field,      /**< Write a field of the bill, padded to a width. */
+    Section,    /**< Render the instructions up to the matching End zero or more times. */
+    End         /**< Close the innermost section. */
+};
+
+/**
+ * @brief A value a template can print.
+ */
+enum class BillField {
+    Invoice, HistoryId, Date, Status, BranchId,
+    CustomerId, CustomerName, CustomerPhone,
+    VehicleId, RegNo, Model,
+    Subtotal, DiscountPercent, DiscountLabel, Discount, Total,
+    TaxTotal, AmountDue,                /**< Sum of the tax lines; total plus that sum. */
+    ItemId, ItemName, ItemPrice,        /**< Only inside an items section. */
+    TaxLabel, TaxRate, TaxAmount        /**< Only inside a taxes section. */
+};
+
+/**
+ * @brief A block of a template that is repeated or shown only when it applies.
+ */
+enum class BillSection {
+    Items,      /**< Once per service on the bill. */
+    Taxes,      /**< Once per tax line. */
+    Discount,   /**< Once if a discount was applied. */
+    Customer,   /**< Once if the customer still exists. */
+    Vehicle     /**< Once if the vehicle still exists. */
+};
+
+/**
+ * @brief One instruction of a compiled template.
+ */
+struct BillInstr {
+    BillOp op;                              /**< What to do. */
+    std::string text;                       /**< Text: the literal. */
+    BillField field = BillField::Invoice;   /**< Field: which value. */
+    int width = 0;                          /**< Field: minimum width; negative pads on the right (left-aligns). */
+    BillSection section = BillSection::Items; /**< Section: which block. */
+    size_t end = 0;                         /**< Section: index of the matching End. */
+};
+
+/**
+ * @brief A template compiled into a flat instruction list.
+ */
+struct BillTemplate {
+    std::vector<BillInstr> code;    /**< Instructions in order. */
+    bool escapeHtml = false;        /**< Escape field values for HTML; literal text is copied as is. */
+};
+
+/**
+ * @brief One tax line of a bill.
+ */
+struct BillTaxLine {
+    std::string label;      /**< Shown name, e.g. "CGST 9%". */
+    double ratePercent;     /**< Rate in percent. */
+    double amount;          /**< Tax in rupees. */
+};
+
+/**
+ * @brief Everything a template can print about one booking.
+ */
+struct BillData {
+    const ServiceHistory* booking = nullptr;    /**< The booking (required). */
+    const Customer* customer = nullptr;         /**< Its customer, or nullptr if deleted. */
+    const Vehicle* vehicle = nullptr;           /**< Its vehicle, or nullptr if deleted. */
+    std::vector<const ServiceItem*> items;      /**< The services still on file, in booking order. */
+    std::vector<BillTaxLine> taxes;             /**< Tax lines, in print order. */
+};
+
+/**
+ * @brief Compiles a bill template.
+ * @param source The template: literal text with {{field}}, {{field:width}} (right-aligned), {{field:-width}}
+ *        (left-aligned), and sections {{#items}}...{{/items}}, {{#taxes}}, {{#discount}}, {{#customer}} and
+ *        {{#vehicle}}. "total" is after the discount and before tax; "amountDue" includes the tax lines.
+ * @param escapeHtml Whether field values are escaped for HTML.
+ * @param out Receives the compiled template.
+ * @param error Receives a description of the first problem if compilation fails.
+ * @return bool True if the template compiled.
+ * @note Item and tax fields are only allowed inside their sections.
+ */
+bool compileBillTemplate(const std::string& source, bool escapeHtml, BillTemplate& out, std::string& error);
+
+/**
+ * @brief Renders a compiled template.
+ * @param t The template.
+ * @param d The bill.
+ * @param out The rendered bill is appended here.
+ * @note Amounts are written as "Rs.1234.50" without going through iostreams; a negative amount gets a
+ *       leading '-'. The discount field is the amount taken off, so it prints negative.
+ */
+void renderBill(const BillTemplate& t, const BillData& d, std::string& out);
+
+/**
+ * @brief Returns the source of the built-in bill template.
+ * @param html True for the HTML page, false for plain text.
+ * @return const char* The template source.
+ */
+const char* builtinBillTemplate(bool html);
+
+#endif // BILL_TEMPLATE_H
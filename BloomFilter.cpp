@@ -0,0 +1,107 @@
+// BloomFilter.cpp (implementation)
+#include "BloomFilter.h"
+
+/**
+ * @brief Mixes a 64-bit value (splitmix64 finalizer).
+ * @param x The value.
+ * @return uint64_t The mixed value.
+ */
+static inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Creates an empty Bloom filter sized for an expected number of keys.
+ * @param expectedKeys The number of keys that will be added.
+ * @param bitsPerKey Bits of filter per key.
+ * @return BloomFilter The empty filter, with at least 64 bits and ln(2) * bitsPerKey probes.
+ */
+BloomFilter makeBloomFilter(size_t expectedKeys, size_t bitsPerKey) {
+    size_t bits = expectedKeys * bitsPerKey;
+    BloomFilter f;
+    f.words.assign(bits / 64 + 1, 0);
+    f.hashes = static_cast<uint32_t>(bitsPerKey * 69 / 100);
+    if (f.hashes < 1) f.hashes = 1;
+    if (f.hashes > 16) f.hashes = 16;
+    return f;
+}
+
+/**
+ * @brief Adds a key to a Bloom filter.
+ * @param f The filter.
+ * @param key The key to add.
+ * @note Probe positions use double hashing: h1 + i * h2.
+ */
+void bloomAdd(BloomFilter& f, int64_t key) {
+    if (f.words.empty()) return;
+    const uint64_t bits = f.words.size() * 64;
+    uint64_t h = mix64(static_cast<uint64_t>(key));
+    uint64_t h2 = (h >> 32) | 1;
+    for (uint32_t i = 0; i < f.hashes; ++i) {
+        uint64_t bit = (h + i * h2) % bits;
+        f.words[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+/**
+ * @brief Tests whether a key may be in a Bloom filter.
+ * @param f The filter.
+ * @param key The key to test.
+ * @return bool False if the key is definitely absent, true if it may be present.
+ * @note An empty (unsized) filter answers true, so a missing filter never hides data.
+ */
+bool bloomMightContain(const BloomFilter& f, int64_t key) {
+    if (f.words.empty()) return true;
+    const uint64_t bits = f.words.size() * 64;
+    uint64_t h = mix64(static_cast<uint64_t>(key));
+    uint64_t h2 = (h >> 32) | 1;
+    for (uint32_t i = 0; i < f.hashes; ++i) {
+        uint64_t bit = (h + i * h2) % bits;
+        if ((f.words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Appends the binary form of a Bloom filter to a buffer.
+ * @param f The filter.
+ * @param out The output buffer.
+ * @note Layout: hash count and word count as 32-bit little-endian values, then the words little-endian.
+ */
+void serializeBloomFilter(const BloomFilter& f, std::string& out) {
+    auto put32 = [&](uint32_t v) {
+        for (int b = 0; b < 32; b += 8) out.push_back(static_cast<char>((v >> b) & 0xFF));
+    };
+    put32(f.hashes);
+    put32(static_cast<uint32_t>(f.words.size()));
+    for (uint64_t w : f.words) {
+        for (int b = 0; b < 64; b += 8) out.push_back(static_cast<char>((w >> b) & 0xFF));
+    }
+}
+
+/**
+ * @brief Reads a Bloom filter written by serializeBloomFilter.
+ * @param buf The input buffer.
+ * @param pos The read offset, advanced past the filter on success.
+ * @param f Receives the filter.
+ * @return bool True if a complete filter was read.
+ */
+bool deserializeBloomFilter(const std::string& buf, size_t& pos, BloomFilter& f) {
+    auto get = [&](size_t at, int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(buf[at + i])) << (8 * i);
+        return v;
+    };
+    if (buf.size() < pos + 8) return false;
+    uint32_t hashes = static_cast<uint32_t>(get(pos, 4));
+    uint64_t words = get(pos + 4, 4);
+    if (hashes == 0 || hashes > 64 || (buf.size() - pos - 8) / 8 < words) return false;
+    f.hashes = hashes;
+    f.words.resize(words);
+    for (uint64_t i = 0; i < words; ++i) f.words[i] = get(pos + 8 + i * 8, 8);
+    pos += 8 + words * 8;
+    return true;
+}
@@ -0,0 +1,56 @@
+// BloomFilter.h
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A fixed-size Bloom filter over integer keys.
+ */
+struct BloomFilter {
+    std::vector<uint64_t> words; /**< Bit array, 64 bits per word. */
+    uint32_t hashes;             /**< Number of probe positions per key. */
+};
+
+/**
+ * @brief Creates an empty Bloom filter sized for an expected number of keys.
+ * @param expectedKeys The number of keys that will be added.
+ * @param bitsPerKey Bits of filter per key (10 gives roughly a 1% false-positive rate).
+ * @return BloomFilter The empty filter.
+ */
+BloomFilter makeBloomFilter(size_t expectedKeys, size_t bitsPerKey = 10);
+
+/**
+ * @brief Adds a key to a Bloom filter.
+ * @param f The filter.
+ * @param key The key to add.
+ */
+void bloomAdd(BloomFilter& f, int64_t key);
+
+/**
+ * @brief Tests whether a key may be in a Bloom filter.
+ * @param f The filter.
+ * @param key The key to test.
+ * @return bool False if the key is definitely absent, true if it may be present.
+ */
+bool bloomMightContain(const BloomFilter& f, int64_t key);
+
+/**
+ * @brief Appends the binary form of a Bloom filter to a buffer.
+ * @param f The filter.
+ * @param out The output buffer.
+ */
+void serializeBloomFilter(const BloomFilter& f, std::string& out);
+
+/**
+ * @brief Reads a Bloom filter written by serializeBloomFilter.
+ * @param buf The input buffer.
+ * @param pos The read offset, advanced past the filter on success.
+ * @param f Receives the filter.
+ * @return bool True if a complete filter was read.
+ */
+bool deserializeBloomFilter(const std::string& buf, size_t& pos, BloomFilter& f);
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,353 @@
+// BranchStore.cpp (implementation)
+#include "BranchStore.h"
+#include "HistoryArchive.h"
+#include "Storage.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef TEST_MODE
+const std::string BRANCH_DIR = "tests/test_branches";
+#else
+const std::string BRANCH_DIR = "branches";
+#endif
+
+const std::string BRANCH_CUSTOMER_FILE = "customers.txt";
+const std::string BRANCH_VEHICLE_FILE = "vehicles.txt";
+const std::string BRANCH_HISTORY_FILE = "service_history.txt";
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Returns the directory holding one subdirectory per branch.
+ * @return const std::string& The directory path.
+ */
+const std::string& branchStoreDir() {
+    return BRANCH_DIR;
+}
+
+/**
+ * @brief Returns the path of one of a branch's files.
+ * @param branchId The branch.
+ * @param file The file name inside the branch directory.
+ * @return std::string The path.
+ */
+std::string branchStorePath(int branchId, const std::string& file) {
+    return BRANCH_DIR + "/" + std::to_string(branchId) + "/" + file;
+}
+
+/**
+ * @brief Lists the branches that have a store.
+ * @return std::vector<int> Branch IDs in ascending order.
+ */
+std::vector<int> listBranches() {
+    std::vector<int> ids;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(BRANCH_DIR, ec)) {
+        if (!entry.is_directory(ec)) continue;
+        try {
+            size_t used = 0;
+            std::string name = entry.path().filename().string();
+            int id = std::stoi(name, &used);
+            if (used == name.size()) ids.push_back(id);
+        } catch (...) {} // Not a branch directory
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// ---- Writing ----
+
+/**
+ * @brief Writes a branch file unless it already holds exactly this content.
+ * @note The file is replaced atomically, so a crash mid-write leaves the previous shard intact.
+ */
+static void writeIfChanged(const std::string& path, const std::string& content) {
+    std::ifstream existing(path, std::ios::binary);
+    if (existing) {
+        std::ostringstream old;
+        old << existing.rdbuf();
+        if (old.str() == content) return;
+    }
+    existing.close();
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    if (!replaceFileAtomically(path, content)) std::cerr << "Error: could not write " << path << "\n";
+}
+
+/**
+ * @brief Writes one file per branch with the rows of that branch.
+ * @param rows All rows of the table.
+ * @param file The file name inside each branch directory.
+ * @param format Formats a row as a line of the file.
+ * @note Branches that have a store but no rows in this table get an empty file.
+ */
+template <typename T, typename Format>
+static void writePerBranch(const std::vector<T>& rows, const std::string& file, Format format) {
+    std::map<int, std::string> content;
+    for (int b : listBranches()) content[b];
+    for (const auto& r : rows) {
+        std::string& out = content[r.branchId];
+        out += format(r);
+        out += '\n';
+    }
+    for (const auto& p : content) writeIfChanged(branchStorePath(p.first, file), p.second);
+}
+
+/**
+ * @brief Rewrites the customer file of every branch whose customers changed.
+ * @param list All customers as saved.
+ */
+void writeBranchCustomers(const std::vector<Customer>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    writePerBranch(list, BRANCH_CUSTOMER_FILE, formatCustomerLine);
+}
+
+/**
+ * @brief Rewrites the vehicle file of every branch whose vehicles changed.
+ * @param list All vehicles as saved.
+ */
+void writeBranchVehicles(const std::vector<Vehicle>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    writePerBranch(list, BRANCH_VEHICLE_FILE, formatVehicleLine);
+}
+
+/**
+ * @brief Rewrites the history file of every branch from the hot history.
+ * @param list The hot service history.
+ * @note Also collapses the rows appended since the last rewrite.
+ */
+void writeBranchHistory(const std::vector<ServiceHistory>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    writePerBranch(list, BRANCH_HISTORY_FILE, formatHistoryLine);
+}
+
+/**
+ * @brief Rebuilds every branch store from the global tables.
+ * @param customers All customers.
+ * @param vehicles All vehicles.
+ * @param history The hot service history.
+ */
+void writeBranchStores(const std::vector<Customer>& customers, const std::vector<Vehicle>& vehicles,
+                       const std::vector<ServiceHistory>& history) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::set<int> live;
+    for (const auto& c : customers) live.insert(c.branchId);
+    for (const auto& v : vehicles) live.insert(v.branchId);
+    for (const auto& h : history) live.insert(h.branchId);
+    std::error_code ec;
+    for (int b : listBranches()) {
+        if (!live.count(b)) fs::remove_all(BRANCH_DIR + "/" + std::to_string(b), ec);
+    }
+    for (int b : live) fs::create_directories(BRANCH_DIR + "/" + std::to_string(b), ec);
+    writePerBranch(customers, BRANCH_CUSTOMER_FILE, formatCustomerLine);
+    writePerBranch(vehicles, BRANCH_VEHICLE_FILE, formatVehicleLine);
+    writePerBranch(history, BRANCH_HISTORY_FILE, formatHistoryLine);
+}
+
+/**
+ * @brief Rebuilds every branch store from the data files.
+ * @note Call at startup after the history log is recovered: it drops rows appended for bookings whose log
+ *       write failed, collapses the appends since the last rewrite and repairs customer and vehicle shards
+ *       left stale by a crash between a table save and its shard rewrite. Unchanged shards are not rewritten.
+ */
+void ensureBranchStores() {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    writeBranchStores(loadCustomers(), loadVehicles(), loadHistory());
+}
+
+/**
+ * @brief Appends new and changed bookings to their branches' history files.
+ * @param rows The rows in the state they now have, in the order they changed.
+ * @note Appends are not synced: the stores are derived from the history, which is durable on its own, and
+ *       ensureBranchStores() rewrites them at startup.
+ */
+void appendBranchHistory(const std::vector<ServiceHistory>& rows) {
+    if (rows.empty()) return;
+    std::map<int, std::string> lines;
+    for (const auto& h : rows) {
+        std::string& out = lines[h.branchId];
+        out += formatHistoryLine(h);
+        out += '\n';
+    }
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::error_code ec;
+    for (const auto& p : lines) {
+        std::string path = branchStorePath(p.first, BRANCH_HISTORY_FILE);
+        fs::create_directories(fs::path(path).parent_path(), ec);
+        std::ofstream ofs(path, std::ios::app | std::ios::binary);
+        ofs << p.second;
+    }
+}
+
+// ---- Reading ----
+
+/**
+ * @brief Reads every parsable line of a branch file.
+ */
+template <typename T, typename Parse>
+static std::vector<T> readBranchFile(const std::string& path, Parse parse) {
+    std::vector<T> rows;
+    std::ifstream ifs(path, std::ios::binary);
+    std::string line;
+    T row;
+    while (std::getline(ifs, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (parse(line, row)) rows.push_back(row); // Skip malformed
+    }
+    return rows;
+}
+
+/**
+ * @brief Loads one branch's customers without reading any other branch.
+ * @param branchId The branch.
+ * @return std::vector<Customer> The branch's customers.
+ */
+std::vector<Customer> loadBranchCustomers(int branchId) {
+    return readBranchFile<Customer>(branchStorePath(branchId, BRANCH_CUSTOMER_FILE), parseCustomerLine);
+}
+
+/**
+ * @brief Loads one branch's vehicles without reading any other branch.
+ * @param branchId The branch.
+ * @return std::vector<Vehicle> The branch's vehicles.
+ */
+std::vector<Vehicle> loadBranchVehicles(int branchId) {
+    return readBranchFile<Vehicle>(branchStorePath(branchId, BRANCH_VEHICLE_FILE), parseVehicleLine);
+}
+
+/**
+ * @brief Loads one branch's hot history without reading any other branch.
+ * @param branchId The branch.
+ * @return std::vector<ServiceHistory> The latest row for each booking, in booking order.
+ */
+std::vector<ServiceHistory> loadBranchHistory(int branchId) {
+    auto rows = readBranchFile<ServiceHistory>(branchStorePath(branchId, BRANCH_HISTORY_FILE), parseHistoryLine);
+    std::vector<ServiceHistory> list;
+    std::unordered_map<int, size_t> index;
+    for (auto& h : rows) {
+        auto it = index.find(h.historyId);
+        if (it != index.end()) {
+            list[it->second] = std::move(h); // A later append supersedes the earlier row
+        } else {
+            index[h.historyId] = list.size();
+            list.push_back(std::move(h));
+        }
+    }
+    return list;
+}
+
+/**
+ * @brief Summarizes one branch from its hot history and its archived rows.
+ * @param branchId The branch.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @param archived The branch's archived rows in the range.
+ * @return BranchSummary The summary.
+ */
+static BranchSummary summarizeBranchRows(int branchId, const std::string& from, const std::string& to,
+                                         const std::vector<ServiceHistory>& archived) {
+    BranchSummary s{branchId, static_cast<int>(loadBranchCustomers(branchId).size()),
+                    static_cast<int>(loadBranchVehicles(branchId).size()),
+                    emptyPartitionSummary(std::to_string(branchId))};
+    std::set<int> hot;
+    for (const auto& h : loadBranchHistory(branchId)) {
+        hot.insert(h.historyId);
+        std::string date = h.dateTime.substr(0, 10);
+        if (date >= from && date <= to) addToPartitionSummary(s.history, h);
+    }
+    for (const auto& h : archived) {
+        if (!hot.count(h.historyId)) addToPartitionSummary(s.history, h); // An interrupted archive run leaves a row in both
+    }
+    return s;
+}
+
+/**
+ * @brief Summarizes one branch: customer and vehicle counts and its bookings in a date range.
+ * @param branchId The branch.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return BranchSummary The summary.
+ */
+BranchSummary summarizeBranch(int branchId, const std::string& from, const std::string& to) {
+    auto archived = loadArchivedHistoryBetween(from, to);
+    archived.erase(std::remove_if(archived.begin(), archived.end(), [&](const ServiceHistory& h) {
+        return h.branchId != branchId;
+    }), archived.end());
+    return summarizeBranchRows(branchId, from, to, archived);
+}
+
+/**
+ * @brief Summarizes every branch, one branch per task on the shared thread pool.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<BranchSummary> One summary per branch, ordered by branch ID.
+ */
+std::vector<BranchSummary> summarizeAllBranches(const std::string& from, const std::string& to) {
+    std::map<int, std::vector<ServiceHistory>> archived;
+    for (auto& h : loadArchivedHistoryBetween(from, to)) archived[h.branchId].push_back(std::move(h));
+    std::vector<int> branches = listBranches();
+    for (const auto& a : archived) branches.push_back(a.first); // A branch may now have archived bookings only
+    std::sort(branches.begin(), branches.end());
+    branches.erase(std::unique(branches.begin(), branches.end()), branches.end());
+
+    std::vector<BranchSummary> out(branches.size());
+    const std::vector<ServiceHistory> none;
+    parallelFor(branches.size(), [&](size_t i) {
+        auto it = archived.find(branches[i]);
+        out[i] = summarizeBranchRows(branches[i], from, to, it == archived.end() ? none : it->second);
+    });
+    return out;
+}
+
+// ---- Maintenance ----
+
+/**
+ * @brief Compacts one branch's files, leaving every other branch untouched.
+ * @param branchId The branch.
+ * @return std::vector<CompactionReport> One report per file.
+ */
+std::vector<CompactionReport> compactBranchStore(int branchId) {
+    std::vector<CompactionReport> reports;
+    reports.push_back(compactDataFile(branchStorePath(branchId, BRANCH_CUSTOMER_FILE), [](const std::string& ln, int& id) {
+        Customer c; if (!parseCustomerLine(ln, c)) return false; id = c.id; return true;
+    }));
+    reports.push_back(compactDataFile(branchStorePath(branchId, BRANCH_VEHICLE_FILE), [](const std::string& ln, int& id) {
+        Vehicle v; if (!parseVehicleLine(ln, v)) return false; id = v.id; return true;
+    }));
+    reports.push_back(compactDataFile(branchStorePath(branchId, BRANCH_HISTORY_FILE), [](const std::string& ln, int& id) {
+        ServiceHistory h; if (!parseHistoryLine(ln, h)) return false; id = h.historyId; return true;
+    }));
+    return reports;
+}
+
+/**
+ * @brief Interactively prints the per-branch summary and the all-branch total for a date range.
+ */
+void viewBranchReport() {
+    std::string from, to;
+    std::cout << "Enter start date (YYYY-MM-DD): "; std::getline(std::cin, from);
+    std::cout << "Enter end date (YYYY-MM-DD): "; std::getline(std::cin, to);
+    auto branches = summarizeAllBranches(from, to);
+    PartitionSummary total = emptyPartitionSummary("all");
+    std::cout << "--- Branch Report " << from << " to " << to << " ---\n";
+    std::cout << std::left << std::setw(8) << "Branch" << std::setw(11) << "Customers" << std::setw(10) << "Vehicles"
+              << std::setw(10) << "Bookings" << std::setw(10) << "Pending" << "Revenue\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& b : branches) {
+        std::cout << std::setw(8) << b.branchId << std::setw(11) << b.customers << std::setw(10) << b.vehicles
+                  << std::setw(10) << b.history.rows << std::setw(10) << b.history.pendingCount
+                  << "Rs." << b.history.totalSum << "\n";
+        mergePartitionSummary(total, b.history);
+    }
+    std::cout << "All branches: " << total.rows << " bookings, revenue Rs." << total.totalSum << "\n";
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::right;
+}
@@ -0,0 +1,141 @@
+// BranchStore.h
+#ifndef BRANCH_STORE_H
+#define BRANCH_STORE_H
+
+#include <string>
+#include <vector>
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+#include "HistoryPartition.h"
+#include "Compaction.h"
+
+/**
+ * @brief Size of one service centre's data, with its history aggregated over a date range.
+ */
+struct BranchSummary {
+    int branchId;               /**< The branch. */
+    int customers;              /**< Customers of the branch. */
+    int vehicles;               /**< Vehicles of the branch. */
+    PartitionSummary history;   /**< Bookings of the branch in the range; key is the branch ID. */
+};
+
+/**
+ * @brief Returns the directory holding one subdirectory per branch.
+ * @return const std::string& The directory path.
+ */
+const std::string& branchStoreDir();
+
+/**
+ * @brief Returns the path of one of a branch's files.
+ * @param branchId The branch.
+ * @param file "customers.txt", "vehicles.txt" or "service_history.txt".
+ * @return std::string The path.
+ */
+std::string branchStorePath(int branchId, const std::string& file);
+
+/**
+ * @brief Lists the branches that have a store.
+ * @return std::vector<int> Branch IDs in ascending order.
+ */
+std::vector<int> listBranches();
+
+/**
+ * @brief Rebuilds every branch store from the global tables.
+ * @param customers All customers.
+ * @param vehicles All vehicles.
+ * @param history The hot service history.
+ * @note Stores of branches that no longer have any rows are removed.
+ */
+void writeBranchStores(const std::vector<Customer>& customers, const std::vector<Vehicle>& vehicles,
+                       const std::vector<ServiceHistory>& history);
+
+/**
+ * @brief Rebuilds every branch store from the data files.
+ * @note Call at startup after the history log is recovered: it drops rows appended for bookings whose log
+ *       write failed, collapses the appends since the last rewrite and repairs customer and vehicle shards
+ *       left stale by a crash between a table save and its shard rewrite. Unchanged shards are not rewritten.
+ */
+void ensureBranchStores();
+
+/**
+ * @brief Rewrites the customer file of every branch whose customers changed.
+ * @param list All customers as saved.
+ */
+void writeBranchCustomers(const std::vector<Customer>& list);
+
+/**
+ * @brief Rewrites the vehicle file of every branch whose vehicles changed.
+ * @param list All vehicles as saved.
+ */
+void writeBranchVehicles(const std::vector<Vehicle>& list);
+
+/**
+ * @brief Rewrites the history file of every branch from the hot history.
+ * @param list The hot service history.
+ */
+void writeBranchHistory(const std::vector<ServiceHistory>& list);
+
+/**
+ * @brief Appends new and changed bookings to their branches' history files.
+ * @param rows The rows in the state they now have, in the order they changed.
+ * @note Branch history files are append-only between compactions: a later row for the same ID replaces an
+ *       earlier one when the file is loaded.
+ */
+void appendBranchHistory(const std::vector<ServiceHistory>& rows);
+
+/**
+ * @brief Loads one branch's customers without reading any other branch.
+ * @param branchId The branch.
+ * @return std::vector<Customer> The branch's customers.
+ */
+std::vector<Customer> loadBranchCustomers(int branchId);
+
+/**
+ * @brief Loads one branch's vehicles without reading any other branch.
+ * @param branchId The branch.
+ * @return std::vector<Vehicle> The branch's vehicles.
+ */
+std::vector<Vehicle> loadBranchVehicles(int branchId);
+
+/**
+ * @brief Loads one branch's hot history without reading any other branch.
+ * @param branchId The branch.
+ * @return std::vector<ServiceHistory> The latest row for each booking, in booking order.
+ */
+std::vector<ServiceHistory> loadBranchHistory(int branchId);
+
+/**
+ * @brief Summarizes one branch: customer and vehicle counts and its bookings in a date range.
+ * @param branchId The branch.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return BranchSummary The summary.
+ * @note Counts the branch's archived bookings in the range as well as its hot history.
+ */
+BranchSummary summarizeBranch(int branchId, const std::string& from, const std::string& to);
+
+/**
+ * @brief Summarizes every branch, one branch per task on the shared thread pool.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<BranchSummary> One summary per branch, ordered by branch ID.
+ * @note The archive is read once for all branches. Merge the history summaries with mergePartitionSummary()
+ *       for the all-branch total, which matches the revenue report over both tiers.
+ */
+std::vector<BranchSummary> summarizeAllBranches(const std::string& from, const std::string& to);
+
+/**
+ * @brief Compacts one branch's files, leaving every other branch untouched.
+ * @param branchId The branch.
+ * @return std::vector<CompactionReport> One report per file.
+ * @note Collapses the appended history rows to the latest row per booking.
+ */
+std::vector<CompactionReport> compactBranchStore(int branchId);
+
+/**
+ * @brief Interactively prints the per-branch summary and the all-branch total for a date range.
+ */
+void viewBranchReport();
+
+#endif // BRANCH_STORE_H
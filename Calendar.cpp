@@ -0,0 +1,514 @@
+// Calendar.cpp (implementation)
+#include "Calendar.h"
+#include "Service.h"
+#include "ChangeFeed.h"
+#include "Storage.h"
+#include "HistoryArchive.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef TEST_MODE
+const std::string APPOINTMENT_FILE = "tests/test_appointments.txt";
+#else
+const std::string APPOINTMENT_FILE = "appointments.txt";
+#endif
+
+/**
+ * @brief Busy slots of one bay on one day; bit i is the slot starting SLOT_MINUTES * i after opening.
+ */
+using DaySlots = std::bitset<SLOTS_PER_DAY>;
+
+/**
+ * @brief An appointment as kept in memory, by day number and slot.
+ */
+struct BookedSlots {
+    long long day;  // Days since 1970-01-01
+    int slot;       // First slot
+    int bay;        // From 1
+    int slots;      // Length
+};
+
+/**
+ * @brief The calendar as kept in memory: busy bitsets by day and the appointments by booking.
+ */
+struct CalendarIndex {
+    bool loaded = false;
+    std::unordered_map<long long, std::array<DaySlots, SERVICE_BAYS>> days; // Day number -> busy slots per bay
+    std::unordered_map<int, BookedSlots> appointments;                       // History ID -> its slots
+};
+
+static std::mutex calendarMutex; // Never held while taking dataFileMutex
+static CalendarIndex calendar;   // Guarded by calendarMutex
+
+// ---- Times ----
+
+/**
+ * @brief Parses "YYYY-MM-DD", "YYYY-MM-DD HH:MM" or "YYYY-MM-DD HH:MM:SS" ('T' may separate the date and time).
+ * @param text The text.
+ * @param day Receives the day number.
+ * @param minute Receives the minute of the day, rounded up to a whole minute; opening time for a bare date.
+ * @return bool False if the text is malformed.
+ */
+static bool parseStartTime(std::string text, long long& day, int& minute) {
+    bool bareDate = text.size() == 10;
+    if (bareDate) text += " 00:00:00";
+    else if (text.size() == 16) text += ":00";
+    if (text.size() != 19) return false;
+    if (text[10] == 'T') text[10] = ' ';
+    long long seconds;
+    if (!dateTimeToSeconds(text, seconds)) return false;
+    day = seconds / 86400;
+    long long secOfDay = seconds % 86400;
+    minute = bareDate ? OPENING_HOUR * 60 : static_cast<int>((secOfDay + 59) / 60);
+    return true;
+}
+
+/**
+ * @brief Formats a day number and slot as "YYYY-MM-DD HH:MM".
+ */
+static std::string formatSlotStart(long long day, int slot) {
+    long long seconds = day * 86400 + (OPENING_HOUR * 60 + static_cast<long long>(slot) * SLOT_MINUTES) * 60;
+    return secondsToDateTime(seconds).substr(0, 16);
+}
+
+/**
+ * @brief Returns the bits at which a run of the given length of set bits starts.
+ */
+static DaySlots runStarts(const DaySlots& free, int length) {
+    DaySlots starts = free;
+    for (int k = 1; k < length && starts.any(); ++k) starts &= free >> static_cast<size_t>(k);
+    return starts;
+}
+
+// ---- Index ----
+
+/**
+ * @brief Marks or clears an appointment's slots in its day's bitset.
+ */
+static void markSlotsLocked(const BookedSlots& b, bool busy) {
+    DaySlots& bits = calendar.days[b.day][static_cast<size_t>(b.bay - 1)];
+    for (int s = b.slot; s < b.slot + b.slots && s < static_cast<int>(SLOTS_PER_DAY); ++s) bits[static_cast<size_t>(s)] = busy;
+}
+
+/**
+ * @brief Formats an appointment as an "A|historyId|YYYY-MM-DD HH:MM|bay|slots" line of the appointment log.
+ */
+static std::string formatAppointmentLine(int historyId, const BookedSlots& b) {
+    return "A|" + std::to_string(historyId) + '|' + formatSlotStart(b.day, b.slot) + '|' + std::to_string(b.bay) + '|' +
+           std::to_string(b.slots);
+}
+
+/**
+ * @brief Appends one line to the appointment log.
+ * @note Not synced: an appointment lost in a crash belongs to a booking that is reconciled at startup.
+ */
+static void appendAppointmentLog(const std::string& line) {
+    std::ofstream ofs(APPOINTMENT_FILE, std::ios::app | std::ios::binary);
+    ofs << line << '\n';
+}
+
+/**
+ * @brief Rewrites the appointment log with just the booked appointments, ordered by booking.
+ */
+static void writeAppointmentsLocked() {
+    std::map<int, const BookedSlots*> ordered;
+    for (const auto& a : calendar.appointments) ordered[a.first] = &a.second;
+    std::string out;
+    for (const auto& a : ordered) {
+        out += formatAppointmentLine(a.first, *a.second);
+        out += '\n';
+    }
+    replaceFileAtomically(APPOINTMENT_FILE, out);
+}
+
+/**
+ * @brief Applies one appointment log line: A books an appointment, X cancels it.
+ */
+static void replayAppointmentLineLocked(const std::string& line) {
+    if (line.size() < 3 || line[1] != '|') return;
+    std::istringstream ss(line.substr(2));
+    std::string idStr, startStr, bayStr, slotsStr;
+    std::getline(ss, idStr, '|');
+    try {
+        int historyId = std::stoi(idStr);
+        auto old = calendar.appointments.find(historyId);
+        if (old != calendar.appointments.end()) {
+            markSlotsLocked(old->second, false);
+            calendar.appointments.erase(old);
+        }
+        if (line[0] != 'A') return;
+        std::getline(ss, startStr, '|');
+        std::getline(ss, bayStr, '|');
+        std::getline(ss, slotsStr, '|');
+        BookedSlots b{0, 0, std::stoi(bayStr), std::stoi(slotsStr)};
+        int minute = 0;
+        if (!parseStartTime(startStr, b.day, minute) || b.bay < 1 || b.bay > SERVICE_BAYS || b.slots < 1) return;
+        b.slot = (minute - OPENING_HOUR * 60) / SLOT_MINUTES;
+        if (b.slot < 0 || b.slot >= static_cast<int>(SLOTS_PER_DAY)) return;
+        calendar.appointments[historyId] = b;
+        markSlotsLocked(b, true);
+    } catch (...) {} // Torn last line
+}
+
+/**
+ * @brief Loads the appointment log on first use.
+ */
+static void loadCalendarLocked() {
+    if (calendar.loaded) return;
+    calendar = CalendarIndex();
+    std::ifstream log(APPOINTMENT_FILE);
+    std::string line;
+    while (std::getline(log, line)) replayAppointmentLineLocked(line);
+    calendar.loaded = true;
+}
+
+/**
+ * @brief Finds the first slot at or after a minute of the day, moving to the next day past closing time.
+ */
+static void firstSlotFrom(long long& day, int minute, int& slot) {
+    int offset = minute - OPENING_HOUR * 60;
+    slot = offset <= 0 ? 0 : (offset + SLOT_MINUTES - 1) / SLOT_MINUTES;
+    if (slot >= static_cast<int>(SLOTS_PER_DAY)) {
+        ++day;
+        slot = 0;
+    }
+}
+
+// ---- Queries and updates ----
+
+/**
+ * @brief Returns the slots a set of services occupies back to back.
+ * @param serviceIds The services (a service may repeat).
+ * @return int The slots, rounding the total duration up; unknown services count DEFAULT_SERVICE_MINUTES.
+ */
+int slotsForServices(const std::vector<int>& serviceIds) {
+    auto services = loadServices();
+    int minutes = 0;
+    for (int id : serviceIds) {
+        auto s = std::find_if(services.begin(), services.end(), [id](const ServiceItem& x) { return x.id == id; });
+        minutes += s != services.end() && s->durationMinutes > 0 ? s->durationMinutes : DEFAULT_SERVICE_MINUTES;
+    }
+    return std::max(1, (minutes + SLOT_MINUTES - 1) / SLOT_MINUTES);
+}
+
+/**
+ * @brief Returns the earliest start times at which some bay is free for a job.
+ * @param slots The slots the job occupies.
+ * @param from Earliest start in "YYYY-MM-DD HH:MM" format (a bare date means opening time).
+ * @param count The number of start times wanted.
+ * @return std::vector<SlotOffer> Up to count start times in time order, searching BOOKING_HORIZON_DAYS days.
+ */
+std::vector<SlotOffer> nextFreeSlots(int slots, const std::string& from, size_t count) {
+    std::vector<SlotOffer> offers;
+    long long day;
+    int minute, firstSlot;
+    if (slots < 1 || slots > static_cast<int>(SLOTS_PER_DAY) || !parseStartTime(from, day, minute)) return offers;
+    firstSlotFrom(day, minute, firstSlot);
+    DaySlots allFree;
+    allFree.set();
+    DaySlots wholeDay = runStarts(allFree, slots);
+
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    for (long long d = day; d < day + BOOKING_HORIZON_DAYS && offers.size() < count; ++d) {
+        std::array<DaySlots, SERVICE_BAYS> starts;
+        auto it = calendar.days.find(d);
+        for (size_t b = 0; b < SERVICE_BAYS; ++b) {
+            starts[b] = it == calendar.days.end() ? wholeDay : runStarts(~it->second[b], slots);
+        }
+        for (size_t s = d == day ? static_cast<size_t>(firstSlot) : 0; s < SLOTS_PER_DAY && offers.size() < count; ++s) {
+            for (size_t b = 0; b < SERVICE_BAYS; ++b) {
+                if (!starts[b][s]) continue;
+                offers.push_back({formatSlotStart(d, static_cast<int>(s)), static_cast<int>(b) + 1});
+                break;
+            }
+        }
+    }
+    return offers;
+}
+
+/**
+ * @brief Returns the earliest start times at which some bay is free for a set of services.
+ * @param serviceIds The services.
+ * @param from Earliest start in "YYYY-MM-DD HH:MM" format (a bare date means opening time).
+ * @param count The number of start times wanted.
+ * @return std::vector<SlotOffer> Up to count start times in time order.
+ */
+std::vector<SlotOffer> nextFreeSlots(const std::vector<int>& serviceIds, const std::string& from, size_t count) {
+    return nextFreeSlots(slotsForServices(serviceIds), from, count);
+}
+
+/**
+ * @brief Parses a requested start into its day and first slot.
+ */
+static bool parseAppointmentStart(const std::string& start, int slots, BookedSlots& b, std::string& error) {
+    int minute = 0;
+    if (start.size() != 16 || !parseStartTime(start, b.day, minute)) {
+        error = "start must be YYYY-MM-DD HH:MM";
+        return false;
+    }
+    int offset = minute - OPENING_HOUR * 60;
+    if (offset < 0 || offset % SLOT_MINUTES != 0) {
+        error = "start must be on a " + std::to_string(SLOT_MINUTES) + "-minute slot within working hours";
+        return false;
+    }
+    b.slot = offset / SLOT_MINUTES;
+    b.slots = slots;
+    if (slots < 1 || b.slot + slots > static_cast<int>(SLOTS_PER_DAY)) {
+        error = "the job does not finish before closing time";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that a requested start is a slot boundary inside working hours.
+ * @param start The start in "YYYY-MM-DD HH:MM" format.
+ * @param slots The slots the job occupies.
+ * @param error Receives the reason if it is not.
+ * @return bool True if the job fits in the working day at that start.
+ */
+bool validAppointmentStart(const std::string& start, int slots, std::string& error) {
+    BookedSlots b{};
+    return parseAppointmentStart(start, slots, b, error);
+}
+
+/**
+ * @brief Books a job into the lowest-numbered bay free for its whole length.
+ * @param historyId The booking.
+ * @param slots The slots the job occupies.
+ * @param start The requested start in "YYYY-MM-DD HH:MM" format.
+ * @param out Receives the appointment.
+ * @param error Receives the reason if the booking is refused.
+ * @return bool True if the appointment was booked.
+ */
+bool bookAppointment(int historyId, int slots, const std::string& start, Appointment& out, std::string& error) {
+    BookedSlots b{};
+    if (!parseAppointmentStart(start, slots, b, error)) return false;
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    if (calendar.appointments.count(historyId)) {
+        error = "booking already has an appointment";
+        return false;
+    }
+    auto it = calendar.days.find(b.day);
+    for (int bay = 1; bay <= SERVICE_BAYS; ++bay) {
+        if (it != calendar.days.end() && !runStarts(~it->second[static_cast<size_t>(bay - 1)], slots)[static_cast<size_t>(b.slot)]) continue;
+        b.bay = bay;
+        calendar.appointments[historyId] = b;
+        markSlotsLocked(b, true);
+        std::string line = formatAppointmentLine(historyId, b);
+        appendAppointmentLog(line);
+        publishChanges({{0, "appointment", "insert", "", line}}); // Written to the feed with the booking's changes
+        out = {historyId, formatSlotStart(b.day, b.slot), b.bay, b.slots};
+        return true;
+    }
+    error = "no bay is free at " + start;
+    return false;
+}
+
+/**
+ * @brief Frees a booking's slots.
+ * @param historyId The booking.
+ * @return bool True if the booking had an appointment.
+ */
+bool cancelAppointment(int historyId) {
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    auto it = calendar.appointments.find(historyId);
+    if (it == calendar.appointments.end()) return false;
+    std::string line = formatAppointmentLine(historyId, it->second);
+    markSlotsLocked(it->second, false);
+    calendar.appointments.erase(it);
+    appendAppointmentLog("X|" + std::to_string(historyId));
+    publishChanges({{0, "appointment", "delete", line, ""}});
+    return true;
+}
+
+/**
+ * @brief Looks up a booking's appointment.
+ * @param historyId The booking.
+ * @param out Receives the appointment.
+ * @return bool True if the booking has one.
+ */
+bool findAppointment(int historyId, Appointment& out) {
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    auto it = calendar.appointments.find(historyId);
+    if (it == calendar.appointments.end()) return false;
+    const BookedSlots& b = it->second;
+    out = {historyId, formatSlotStart(b.day, b.slot), b.bay, b.slots};
+    return true;
+}
+
+/**
+ * @brief Returns the appointments of a day.
+ * @param date The day in "YYYY-MM-DD" format.
+ * @return std::vector<Appointment> The appointments, ordered by start then bay.
+ */
+std::vector<Appointment> appointmentsOn(const std::string& date) {
+    std::vector<Appointment> list;
+    long long day;
+    int minute;
+    if (date.size() != 10 || !parseStartTime(date, day, minute)) return list;
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    if (!calendar.days.count(day)) return list; // Nothing booked that day
+    for (const auto& a : calendar.appointments) {
+        const BookedSlots& b = a.second;
+        if (b.day == day) list.push_back({a.first, formatSlotStart(b.day, b.slot), b.bay, b.slots});
+    }
+    std::sort(list.begin(), list.end(), [](const Appointment& x, const Appointment& y) {
+        return x.start != y.start ? x.start < y.start : x.bay < y.bay;
+    });
+    return list;
+}
+
+/**
+ * @brief Drops past appointments and those of bookings missing from the history, and rewrites the appointment log.
+ * @param today The current date in "YYYY-MM-DD" format.
+ * @return int The number of appointments dropped.
+ */
+int reconcileAppointments(const std::string& today) {
+    long long todayNumber;
+    int minute;
+    if (today.size() < 10 || !parseStartTime(today.substr(0, 10), todayNumber, minute)) return 0;
+    std::unordered_set<int> booked;
+    for (const auto& h : loadHistory()) booked.insert(h.historyId);
+
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    int dropped = 0;
+    std::vector<ChangeEvent> changes;
+    for (auto it = calendar.appointments.begin(); it != calendar.appointments.end();) {
+        if (it->second.day >= todayNumber && booked.count(it->first)) {
+            ++it;
+        } else {
+            changes.push_back({0, "appointment", "delete", formatAppointmentLine(it->first, it->second), ""});
+            markSlotsLocked(it->second, false);
+            it = calendar.appointments.erase(it);
+            ++dropped;
+        }
+    }
+    for (auto it = calendar.days.begin(); it != calendar.days.end();) {
+        it = it->first < todayNumber ? calendar.days.erase(it) : std::next(it);
+    }
+    writeAppointmentsLocked();
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
+    return dropped;
+}
+
+/**
+ * @brief Returns every appointment as an appointment log line.
+ * @return std::vector<std::string> One "A|historyId|YYYY-MM-DD HH:MM|bay|slots" line per appointment, ordered by booking.
+ */
+std::vector<std::string> loadAppointmentLines() {
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    std::map<int, const BookedSlots*> ordered;
+    for (const auto& a : calendar.appointments) ordered[a.first] = &a.second;
+    std::vector<std::string> lines;
+    for (const auto& a : ordered) lines.push_back(formatAppointmentLine(a.first, *a.second));
+    return lines;
+}
+
+/**
+ * @brief Books and cancels appointments from appointment log lines, without checking for free bays.
+ * @param lines "A|..." lines book (or move) a booking's appointment; any other line cancels it.
+ * @param replace True to drop every other appointment first.
+ */
+void applyAppointmentLines(const std::vector<std::string>& lines, bool replace) {
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    loadCalendarLocked();
+    if (replace) {
+        calendar = CalendarIndex();
+        calendar.loaded = true;
+    }
+    for (const auto& line : lines) replayAppointmentLineLocked(line);
+    if (replace) {
+        writeAppointmentsLocked();
+        return;
+    }
+    for (const auto& line : lines) appendAppointmentLog(line);
+}
+
+/**
+ * @brief Discards the in-memory calendar so the next call reloads it from the appointment log.
+ */
+void reloadCalendar() {
+    std::lock_guard<std::mutex> lock(calendarMutex);
+    calendar = CalendarIndex();
+}
+
+// ---- Console ----
+
+/**
+ * @brief Interactively displays one day's bays slot by slot.
+ */
+void viewDayScheduleInteractive() {
+    std::string date;
+    std::cout << "Enter date (YYYY-MM-DD, blank for today): ";
+    std::getline(std::cin, date);
+    if (date.empty()) date = currentDateTime().substr(0, 10);
+    auto list = appointmentsOn(date);
+    std::cout << "--- Schedule for " << date << " ---\n";
+    std::cout << std::left << std::setw(8) << "Time";
+    for (int bay = 1; bay <= SERVICE_BAYS; ++bay) std::cout << std::setw(10) << ("Bay " + std::to_string(bay));
+    std::cout << "\n" << std::string(8 + 10 * SERVICE_BAYS, '-') << "\n";
+    std::vector<std::array<int, SERVICE_BAYS>> grid(SLOTS_PER_DAY);
+    for (auto& row : grid) row.fill(0);
+    for (const auto& a : list) {
+        int slot = ((std::stoi(a.start.substr(11, 2)) - OPENING_HOUR) * 60 + std::stoi(a.start.substr(14, 2))) / SLOT_MINUTES;
+        for (int s = slot; s < slot + a.slots && s < static_cast<int>(SLOTS_PER_DAY); ++s) {
+            grid[static_cast<size_t>(s)][static_cast<size_t>(a.bay - 1)] = a.historyId;
+        }
+    }
+    for (size_t s = 0; s < SLOTS_PER_DAY; ++s) {
+        int minutes = OPENING_HOUR * 60 + static_cast<int>(s) * SLOT_MINUTES;
+        std::ostringstream time;
+        time << std::setw(2) << std::setfill('0') << minutes / 60 << ':' << std::setw(2) << minutes % 60;
+        std::cout << std::left << std::setw(8) << time.str();
+        for (int id : grid[s]) std::cout << std::setw(10) << (id ? "#" + std::to_string(id) : ".");
+        std::cout << "\n";
+    }
+    std::cout << "Appointments: " << list.size() << "\n";
+}
+
+/**
+ * @brief Interactively lists the next free start times for a set of services.
+ */
+void findFreeSlotsInteractive() {
+    std::vector<int> chosen;
+    std::string line;
+    viewServices();
+    std::cout << "Enter service IDs separated by spaces: ";
+    std::getline(std::cin, line);
+    std::istringstream ids(line);
+    int id;
+    while (ids >> id) chosen.push_back(id);
+    if (chosen.empty()) {
+        std::cout << "No services selected.\n";
+        return;
+    }
+    std::string from;
+    std::cout << "Earliest start (YYYY-MM-DD [HH:MM], blank for now): ";
+    std::getline(std::cin, from);
+    if (from.empty()) from = currentDateTime();
+    int slots = slotsForServices(chosen);
+    auto offers = nextFreeSlots(slots, from, 5);
+    std::cout << "Job length: " << slots * SLOT_MINUTES << " minutes\n";
+    if (offers.empty()) {
+        std::cout << "No free slot in the next " << BOOKING_HORIZON_DAYS << " days.\n";
+        return;
+    }
+    for (const auto& o : offers) std::cout << "  " << o.start << "  (bay " << o.bay << ")\n";
+}
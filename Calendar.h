@@ -0,0 +1,167 @@
+// Calendar.h
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Hour the workshop opens; the first slot of each day starts then.
+ */
+const int OPENING_HOUR = 9;
+
+/**
+ * @brief Length of one appointment slot.
+ */
+const int SLOT_MINUTES = 30;
+
+/**
+ * @brief Slots in a working day (09:00 to 18:00).
+ */
+const size_t SLOTS_PER_DAY = 18;
+
+/**
+ * @brief Service bays that can each take one vehicle at a time.
+ */
+const int SERVICE_BAYS = 4;
+
+/**
+ * @brief Days ahead the availability query searches.
+ */
+const int BOOKING_HORIZON_DAYS = 60;
+
+/**
+ * @brief Bay time of a service that does not set a duration.
+ */
+const int DEFAULT_SERVICE_MINUTES = 60;
+
+/**
+ * @brief A booking's place on the calendar.
+ */
+struct Appointment {
+    int historyId;      /**< The booking. */
+    std::string start;  /**< Requested start in "YYYY-MM-DD HH:MM" format. */
+    int bay;            /**< Bay the vehicle is booked into, from 1. */
+    int slots;          /**< Consecutive slots the booking occupies. */
+};
+
+/**
+ * @brief A free start time offered by the availability query.
+ */
+struct SlotOffer {
+    std::string start;  /**< Start in "YYYY-MM-DD HH:MM" format. */
+    int bay;            /**< Lowest-numbered bay free for the whole job. */
+};
+
+/**
+ * @brief Returns the slots a set of services occupies back to back.
+ * @param serviceIds The services (a service may repeat).
+ * @return int The slots, rounding the total duration up; unknown services count DEFAULT_SERVICE_MINUTES.
+ */
+int slotsForServices(const std::vector<int>& serviceIds);
+
+/**
+ * @brief Returns the earliest start times at which some bay is free for a job.
+ * @param slots The slots the job occupies.
+ * @param from Earliest start in "YYYY-MM-DD HH:MM" format (a bare date means opening time).
+ * @param count The number of start times wanted.
+ * @return std::vector<SlotOffer> Up to count start times in time order, searching BOOKING_HORIZON_DAYS days.
+ * @note Each day is a bitset of busy slots per bay. Shifting the free bits and and-ing them leaves the starts
+ *       of every free run of the job's length, so a day is answered with a few word operations per bay.
+ */
+std::vector<SlotOffer> nextFreeSlots(int slots, const std::string& from, size_t count);
+
+/**
+ * @brief Returns the earliest start times at which some bay is free for a set of services.
+ * @param serviceIds The services.
+ * @param from Earliest start in "YYYY-MM-DD HH:MM" format (a bare date means opening time).
+ * @param count The number of start times wanted.
+ * @return std::vector<SlotOffer> Up to count start times in time order.
+ */
+std::vector<SlotOffer> nextFreeSlots(const std::vector<int>& serviceIds, const std::string& from, size_t count);
+
+/**
+ * @brief Checks that a requested start is a slot boundary inside working hours.
+ * @param start The start in "YYYY-MM-DD HH:MM" format.
+ * @param slots The slots the job occupies.
+ * @param error Receives the reason if it is not.
+ * @return bool True if the job fits in the working day at that start.
+ */
+bool validAppointmentStart(const std::string& start, int slots, std::string& error);
+
+/**
+ * @brief Books a job into the lowest-numbered bay free for its whole length.
+ * @param historyId The booking.
+ * @param slots The slots the job occupies.
+ * @param start The requested start in "YYYY-MM-DD HH:MM" format.
+ * @param out Receives the appointment.
+ * @param error Receives the reason if the booking is refused.
+ * @return bool True if the appointment was booked.
+ * @note Checking and marking the slots happen under one lock, so two bookings cannot take the same bay.
+ *       The appointment is appended to the appointment log and queued for the change feed; it is written there
+ *       with the booking's own changes.
+ */
+bool bookAppointment(int historyId, int slots, const std::string& start, Appointment& out, std::string& error);
+
+/**
+ * @brief Frees a booking's slots.
+ * @param historyId The booking.
+ * @return bool True if the booking had an appointment.
+ */
+bool cancelAppointment(int historyId);
+
+/**
+ * @brief Looks up a booking's appointment.
+ * @param historyId The booking.
+ * @param out Receives the appointment.
+ * @return bool True if the booking has one.
+ */
+bool findAppointment(int historyId, Appointment& out);
+
+/**
+ * @brief Returns the appointments of a day.
+ * @param date The day in "YYYY-MM-DD" format.
+ * @return std::vector<Appointment> The appointments, ordered by start then bay.
+ */
+std::vector<Appointment> appointmentsOn(const std::string& date);
+
+/**
+ * @brief Drops past appointments and those of bookings missing from the history, and rewrites the appointment log.
+ * @param today The current date in "YYYY-MM-DD" format.
+ * @return int The number of appointments dropped.
+ * @note Run at startup after the history log is recovered; a crash between booking the slot and logging the
+ *       booking leaves an appointment with no booking.
+ */
+int reconcileAppointments(const std::string& today);
+
+/**
+ * @brief Returns every appointment as an appointment log line.
+ * @return std::vector<std::string> One "A|historyId|YYYY-MM-DD HH:MM|bay|slots" line per appointment, ordered by booking.
+ */
+std::vector<std::string> loadAppointmentLines();
+
+/**
+ * @brief Books and cancels appointments from appointment log lines, without checking for free bays.
+ * @param lines "A|..." lines book (or move) a booking's appointment; any other line cancels it.
+ * @param replace True to drop every other appointment first and rewrite the log; otherwise the lines are appended.
+ * @note Used by standbys, which take the primary's bay assignments as they are.
+ */
+void applyAppointmentLines(const std::vector<std::string>& lines, bool replace);
+
+/**
+ * @brief Discards the in-memory calendar so the next call reloads it from the appointment log.
+ */
+void reloadCalendar();
+
+/**
+ * @brief Interactively displays one day's bays slot by slot.
+ */
+void viewDayScheduleInteractive();
+
+/**
+ * @brief Interactively lists the next free start times for a set of services.
+ */
+void findFreeSlotsInteractive();
+
+#endif // CALENDAR_H
@@ -0,0 +1,262 @@
+// ChangeFeed.cpp (implementation)
+#include "ChangeFeed.h"
+#include "Json.h"
+#include "Storage.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+#ifdef TEST_MODE
+const std::string CHANGE_FEED_FILE = "tests/test_changes.jsonl";
+#else
+const std::string CHANGE_FEED_FILE = "changes.jsonl";
+#endif
+
+/**
+ * @brief Bytes read at a time while scanning the feed file.
+ */
+const size_t FEED_READ_CHUNK = 64 * 1024;
+
+static std::once_flag feedLoaded;
+static std::mutex writeMutex;       // Serializes appends to the file; guards durableSeq
+static std::mutex queueMutex;       // Guards lastSeq, pending and pendingLastSeq
+static std::condition_variable feedAdvanced; // Signalled (under writeMutex) when durableSeq grows
+static long long durableSeq = 0;
+static long long lastSeq = 0;
+static std::string pending;
+static long long pendingLastSeq = 0;
+
+/**
+ * @brief Returns the path of the change feed file.
+ * @return const std::string& The feed path.
+ */
+const std::string& changeFeedPath() {
+    return CHANGE_FEED_FILE;
+}
+
+/**
+ * @brief Reads the sequence number at the start of a feed line.
+ * @return long long The number, or -1 if the line does not start with one.
+ */
+static long long lineSeq(const char* begin, const char* end) {
+    static const char prefix[] = "{\"seq\":";
+    size_t n = sizeof(prefix) - 1;
+    if (static_cast<size_t>(end - begin) <= n || std::memcmp(begin, prefix, n) != 0) return -1;
+    long long seq = -1;
+    std::from_chars(begin + n, end, seq);
+    return seq;
+}
+
+/**
+ * @brief Finds the last sequence number in the feed, cutting off a line left half written by a crash.
+ */
+static void loadFeed() {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(CHANGE_FEED_FILE, ec);
+    if (ec || size == 0) return;
+    std::ifstream in(CHANGE_FEED_FILE, std::ios::binary);
+    uintmax_t from = size > FEED_READ_CHUNK ? size - FEED_READ_CHUNK : 0;
+    std::string tail(static_cast<size_t>(size - from), '\0');
+    in.seekg(static_cast<std::streamoff>(from));
+    in.read(&tail[0], static_cast<std::streamsize>(tail.size()));
+    size_t end = tail.rfind('\n');
+    if (end == std::string::npos) {
+        if (from == 0) fs::resize_file(CHANGE_FEED_FILE, 0, ec);
+        return;
+    }
+    if (end + 1 != tail.size()) fs::resize_file(CHANGE_FEED_FILE, from + end + 1, ec);
+    size_t start = end == 0 ? std::string::npos : tail.rfind('\n', end - 1);
+    start = start == std::string::npos ? 0 : start + 1;
+    long long seq = lineSeq(tail.data() + start, tail.data() + end);
+    if (seq > 0) durableSeq = lastSeq = pendingLastSeq = seq;
+}
+
+/**
+ * @brief Formats an event as one line of JSON (without the newline).
+ * @param e The event.
+ * @return std::string The JSON object.
+ */
+std::string formatChangeEvent(const ChangeEvent& e) {
+    std::string out = "{";
+    appendJsonKey(out, "seq", true); appendJsonNumber(out, e.seq);
+    appendJsonKey(out, "entity"); appendJsonString(out, e.entity);
+    appendJsonKey(out, "op"); appendJsonString(out, e.op);
+    appendJsonKey(out, "before");
+    if (e.before.empty()) out += "null";
+    else appendJsonString(out, e.before);
+    appendJsonKey(out, "after");
+    if (e.after.empty()) out += "null";
+    else appendJsonString(out, e.after);
+    out += '}';
+    return out;
+}
+
+/**
+ * @brief Parses one line written by formatChangeEvent().
+ * @param line The JSON object.
+ * @param out Receives the event.
+ * @return bool False if the line is not an event.
+ */
+bool parseChangeEvent(const std::string& line, ChangeEvent& out) {
+    std::map<std::string, std::string> f;
+    if (!parseJsonObject(line, f)) return false;
+    const std::string& seq = f["seq"];
+    auto r = std::from_chars(seq.data(), seq.data() + seq.size(), out.seq);
+    if (r.ec != std::errc() || out.seq <= 0) return false;
+    out.entity = f["entity"];
+    out.op = f["op"];
+    out.before = f["before"] == "null" ? "" : f["before"];
+    out.after = f["after"] == "null" ? "" : f["after"];
+    return true;
+}
+
+// ---- Writing ----
+
+/**
+ * @brief Numbers events and queues them for the feed.
+ * @param events The events in the order they happened; seq is assigned here.
+ * @return long long The sequence number of the last event, to pass to flushChanges().
+ */
+long long publishChanges(std::vector<ChangeEvent> events) {
+    std::call_once(feedLoaded, loadFeed);
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (auto& e : events) {
+        e.seq = ++lastSeq;
+        pending += formatChangeEvent(e);
+        pending += '\n';
+    }
+    if (!events.empty()) pendingLastSeq = lastSeq;
+    return lastSeq;
+}
+
+/**
+ * @brief Appends every queued event up to a sequence number to the feed file and syncs it.
+ * @param seq The sequence number returned by publishChanges().
+ * @return bool True once the events are durable.
+ * @note Whoever takes the write lock first writes everything queued so far; later callers find their events
+ *       already durable. Events that fail to write are queued again in front of newer ones.
+ */
+bool flushChanges(long long seq) {
+    std::call_once(feedLoaded, loadFeed);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (durableSeq >= seq) return true;
+    std::string data;
+    long long upTo;
+    {
+        std::lock_guard<std::mutex> q(queueMutex);
+        data.swap(pending);
+        upTo = pendingLastSeq;
+    }
+    if (data.empty()) return durableSeq >= seq;
+    if (!appendFileDurably(CHANGE_FEED_FILE, data)) {
+        std::lock_guard<std::mutex> q(queueMutex);
+        pending.insert(0, data);
+        return false;
+    }
+    durableSeq = upTo;
+    feedAdvanced.notify_all();
+    return true;
+}
+
+/**
+ * @brief Returns the sequence number of the last durable event.
+ * @return long long The sequence number, or 0 if the feed is empty.
+ */
+long long lastChangeSeq() {
+    std::call_once(feedLoaded, loadFeed);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return durableSeq;
+}
+
+/**
+ * @brief Waits until an event after a sequence number is durable.
+ * @param afterSeq The last sequence number the caller has seen.
+ * @param timeoutMillis Longest time to wait.
+ * @return bool True if lastChangeSeq() is now greater than afterSeq.
+ */
+bool waitForChanges(long long afterSeq, int timeoutMillis) {
+    std::call_once(feedLoaded, loadFeed);
+    std::unique_lock<std::mutex> lock(writeMutex);
+    return feedAdvanced.wait_for(lock, std::chrono::milliseconds(timeoutMillis), [afterSeq] { return durableSeq > afterSeq; });
+}
+
+// ---- Reading ----
+
+/**
+ * @brief Finds the first complete line starting at or after an offset.
+ * @param in The feed file.
+ * @param offset Offset to look from; a line starting exactly there counts only at offset 0.
+ * @param lineStart Receives the offset of the line.
+ * @return long long The line's sequence number, or -1 if there is no complete line after the offset.
+ */
+static long long seqAfter(std::ifstream& in, uintmax_t offset, uintmax_t& lineStart) {
+    std::string buf(4096, '\0');
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(&buf[0], static_cast<std::streamsize>(buf.size()));
+    buf.resize(static_cast<size_t>(in.gcount()));
+    size_t start = 0;
+    if (offset > 0) {
+        start = buf.find('\n');
+        if (start == std::string::npos) return -1;
+        ++start;
+    }
+    size_t end = buf.find('\n', start);
+    if (end == std::string::npos) return -1;
+    lineStart = offset + start;
+    return lineSeq(buf.data() + start, buf.data() + end);
+}
+
+/**
+ * @brief Reads durable events starting at a sequence number.
+ * @param fromSeq The first sequence number wanted.
+ * @param maxEvents Most events to return (capped at CHANGE_FEED_MAX_READ).
+ * @return std::vector<ChangeEvent> The events in order; empty once the reader has caught up.
+ * @note Narrows the file down to a window of FEED_READ_CHUNK bytes by binary search on line starts, then scans
+ *       forward. A line still being appended (no newline yet) is not returned.
+ */
+std::vector<ChangeEvent> readChanges(long long fromSeq, size_t maxEvents) {
+    std::vector<ChangeEvent> out;
+    maxEvents = std::min(maxEvents, CHANGE_FEED_MAX_READ);
+    std::error_code ec;
+    uintmax_t size = fs::file_size(CHANGE_FEED_FILE, ec);
+    if (ec || size == 0 || maxEvents == 0) return out;
+    std::ifstream in(CHANGE_FEED_FILE, std::ios::binary);
+    if (!in) return out;
+
+    // Invariant: the first line wanted starts in [lo, hi]
+    uintmax_t lo = 0, hi = size;
+    while (hi - lo > FEED_READ_CHUNK) {
+        uintmax_t mid = lo + (hi - lo) / 2, start = 0;
+        long long seq = seqAfter(in, mid, start);
+        if (seq < 0 || start >= hi || seq >= fromSeq) hi = mid;
+        else lo = start;
+    }
+
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(lo));
+    std::string buf, chunk(FEED_READ_CHUNK, '\0');
+    while (out.size() < maxEvents) {
+        in.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+        std::streamsize got = in.gcount();
+        if (got <= 0) break;
+        buf.append(chunk, 0, static_cast<size_t>(got));
+        size_t pos = 0, nl;
+        while (out.size() < maxEvents && (nl = buf.find('\n', pos)) != std::string::npos) {
+            long long seq = lineSeq(buf.data() + pos, buf.data() + nl);
+            if (seq >= fromSeq) {
+                ChangeEvent e;
+                if (parseChangeEvent(buf.substr(pos, nl - pos), e)) out.push_back(std::move(e));
+            }
+            pos = nl + 1;
+        }
+        buf.erase(0, pos);
+    }
+    return out;
+}
@@ -0,0 +1,115 @@
+// ChangeFeed.h
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One entry of the change feed.
+ */
+struct ChangeEvent {
+    long long seq;          /**< Sequence number, starting at 1 and increasing by one per event. */
+    std::string entity;     /**< "customer", "vehicle", "service", "discount", "tax_class", "part", "service_part",
+                                 "reservation", "appointment", "booking" or "archive". */
+    std::string op;         /**< "insert", "update" or "delete"; "run" for an archive run, whose after is the cutoff date. */
+    std::string before;     /**< The record's line in its data file before the change; empty for an insert. */
+    std::string after;      /**< The record's line after the change; empty for a delete. */
+};
+
+/**
+ * @brief Most events returned by one readChanges() call.
+ */
+const size_t CHANGE_FEED_MAX_READ = 10000;
+
+/**
+ * @brief Returns the path of the change feed file.
+ * @return const std::string& The feed path.
+ */
+const std::string& changeFeedPath();
+
+/**
+ * @brief Numbers events and queues them for the feed.
+ * @param events The events in the order they happened; seq is assigned here.
+ * @return long long The sequence number of the last event, to pass to flushChanges().
+ * @note The caller holds dataFileMutex(), so the feed order matches the order the data files changed.
+ */
+long long publishChanges(std::vector<ChangeEvent> events);
+
+/**
+ * @brief Appends every queued event up to a sequence number to the feed file and syncs it.
+ * @param seq The sequence number returned by publishChanges().
+ * @return bool True once the events are durable.
+ * @note Concurrent callers share one append and one sync.
+ */
+bool flushChanges(long long seq);
+
+/**
+ * @brief Returns the sequence number of the last durable event.
+ * @return long long The sequence number, or 0 if the feed is empty.
+ */
+long long lastChangeSeq();
+
+/**
+ * @brief Waits until an event after a sequence number is durable.
+ * @param afterSeq The last sequence number the caller has seen.
+ * @param timeoutMillis Longest time to wait.
+ * @return bool True if lastChangeSeq() is now greater than afterSeq.
+ */
+bool waitForChanges(long long afterSeq, int timeoutMillis);
+
+/**
+ * @brief Reads durable events starting at a sequence number.
+ * @param fromSeq The first sequence number wanted.
+ * @param maxEvents Most events to return (capped at CHANGE_FEED_MAX_READ).
+ * @return std::vector<ChangeEvent> The events in order; empty once the reader has caught up.
+ * @note The start is found by binary search over the file, so a consumer can resume from any point cheaply.
+ *       Resume from the last seq seen plus one.
+ */
+std::vector<ChangeEvent> readChanges(long long fromSeq, size_t maxEvents);
+
+/**
+ * @brief Formats an event as one line of JSON (without the newline).
+ * @param e The event.
+ * @return std::string The JSON object.
+ */
+std::string formatChangeEvent(const ChangeEvent& e);
+
+/**
+ * @brief Parses one line written by formatChangeEvent().
+ * @param line The JSON object.
+ * @param out Receives the event.
+ * @return bool False if the line is not an event.
+ */
+bool parseChangeEvent(const std::string& line, ChangeEvent& out);
+
+/**
+ * @brief Appends the changes between two versions of a table, keyed by record ID.
+ * @param entity The entity name.
+ * @param before The records before the change.
+ * @param after The records after the change.
+ * @param key Returns a record's ID.
+ * @param format Returns a record's data file line.
+ * @param out Receives an insert, update or delete event for every record that differs.
+ */
+template <typename T, typename Key, typename Format>
+void diffTableChanges(const char* entity, const std::vector<T>& before, const std::vector<T>& after, Key key,
+                      Format format, std::vector<ChangeEvent>& out) {
+    std::map<int, std::string> old;
+    for (const auto& r : before) old.emplace(key(r), format(r));
+    for (const auto& r : after) {
+        std::string line = format(r);
+        auto it = old.find(key(r));
+        if (it == old.end()) {
+            out.push_back({0, entity, "insert", "", line});
+        } else {
+            if (it->second != line) out.push_back({0, entity, "update", it->second, line});
+            old.erase(it);
+        }
+    }
+    for (const auto& p : old) out.push_back({0, entity, "delete", p.second, ""});
+}
+
+#endif // CHANGE_FEED_H
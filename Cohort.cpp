@@ -0,0 +1,199 @@
+// Cohort.cpp (implementation)
+#include "Cohort.h"
+#include "HistoryPartition.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+/**
+ * @brief Returns the month index (year * 12 + month - 1) of a "YYYY-MM..." date.
+ * @param date The date.
+ * @param out Receives the index.
+ * @return bool False if the date does not start with a valid year and month.
+ */
+bool monthIndexOf(const std::string& date, int& out) {
+    if (date.size() < 7 || date[4] != '-') return false;
+    for (int i : {0, 1, 2, 3, 5, 6}) {
+        if (!std::isdigit(static_cast<unsigned char>(date[i]))) return false;
+    }
+    int year = std::stoi(date.substr(0, 4)), month = std::stoi(date.substr(5, 2));
+    if (month < 1 || month > 12) return false;
+    out = year * 12 + month - 1;
+    return true;
+}
+
+/**
+ * @brief Formats a month index as "YYYY-MM".
+ */
+static std::string monthKey(int index) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02d", index / 12, index % 12 + 1);
+    return buf;
+}
+
+/**
+ * @brief Builds the visit timelines from (customer ID, month index) pairs.
+ * @param visits One pair per visit, in any order; repeats within a month count once.
+ * @return VisitTimeline The timelines.
+ */
+VisitTimeline buildVisitTimeline(const std::vector<std::pair<int, int>>& visits) {
+    VisitTimeline t;
+    t.offsets.push_back(0);
+    if (visits.empty()) return t;
+
+    // Number the customers in ID order: a presence table when IDs are dense, as they are when assigned in
+    // sequence, otherwise a sorted list searched per visit
+    int minId = visits[0].first, maxId = visits[0].first;
+    for (const auto& v : visits) {
+        minId = std::min(minId, v.first);
+        maxId = std::max(maxId, v.first);
+    }
+    bool dense = minId >= 0 && static_cast<size_t>(maxId) <= visits.size() * 4 + 1024;
+    std::vector<int> slot;
+    if (dense) {
+        slot.assign(static_cast<size_t>(maxId) + 1, -1);
+        for (const auto& v : visits) slot[v.first] = 0;
+        for (size_t id = 0; id < slot.size(); ++id) {
+            if (slot[id] == 0) {
+                slot[id] = static_cast<int>(t.customerIds.size());
+                t.customerIds.push_back(static_cast<int>(id));
+            }
+        }
+    } else {
+        for (const auto& v : visits) t.customerIds.push_back(v.first);
+        std::sort(t.customerIds.begin(), t.customerIds.end());
+        t.customerIds.erase(std::unique(t.customerIds.begin(), t.customerIds.end()), t.customerIds.end());
+    }
+    auto indexOf = [&](int id) {
+        if (dense) return static_cast<size_t>(slot[id]);
+        return static_cast<size_t>(std::lower_bound(t.customerIds.begin(), t.customerIds.end(), id) - t.customerIds.begin());
+    };
+
+    // Counting sort of the visits by customer
+    size_t customers = t.customerIds.size();
+    std::vector<size_t> start(customers + 1, 0);
+    std::vector<size_t> owner(visits.size());
+    for (size_t i = 0; i < visits.size(); ++i) {
+        owner[i] = indexOf(visits[i].first);
+        start[owner[i] + 1]++;
+    }
+    for (size_t c = 0; c < customers; ++c) start[c + 1] += start[c];
+    std::vector<int> bucketed(visits.size());
+    std::vector<size_t> cursor(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < visits.size(); ++i) bucketed[cursor[owner[i]]++] = visits[i].second;
+
+    // Sort each customer's months and drop repeats
+    t.months.reserve(visits.size());
+    for (size_t c = 0; c < customers; ++c) {
+        auto first = bucketed.begin() + start[c], last = bucketed.begin() + start[c + 1];
+        std::sort(first, last);
+        t.months.insert(t.months.end(), first, std::unique(first, last));
+        t.offsets.push_back(t.months.size());
+    }
+    return t;
+}
+
+/**
+ * @brief Builds the visit timelines from history rows.
+ * @param rows The rows; cancelled bookings and undated rows are skipped.
+ * @return VisitTimeline The timelines.
+ */
+VisitTimeline buildVisitTimeline(const std::vector<ServiceHistory>& rows) {
+    std::vector<std::pair<int, int>> visits;
+    visits.reserve(rows.size());
+    int month;
+    for (const auto& h : rows) {
+        if (h.status != "Cancelled" && monthIndexOf(h.dateTime, month)) visits.emplace_back(h.customerId, month);
+    }
+    return buildVisitTimeline(visits);
+}
+
+/**
+ * @brief Computes the retention of the cohorts first served in a range of months.
+ * @param timeline The visit timelines.
+ * @param fromMonth Index of the first cohort month.
+ * @param toMonth Index of the last cohort month.
+ * @return RetentionMatrix One row per month in the range.
+ */
+RetentionMatrix cohortRetention(const VisitTimeline& timeline, int fromMonth, int toMonth) {
+    RetentionMatrix m;
+    if (toMonth < fromMonth) return m;
+    size_t cohorts = static_cast<size_t>(toMonth - fromMonth + 1);
+    for (int month = fromMonth; month <= toMonth; ++month) m.cohorts.push_back(monthKey(month));
+    m.sizes.assign(cohorts, 0);
+    m.returned.assign(cohorts, {});
+
+    // Bucket the customers by the cohort of their first visit
+    size_t customers = timeline.customerIds.size();
+    std::vector<size_t> start(cohorts + 1, 0);
+    for (size_t c = 0; c < customers; ++c) {
+        int first = timeline.months[timeline.offsets[c]];
+        if (first >= fromMonth && first <= toMonth) start[first - fromMonth + 1]++;
+    }
+    for (size_t i = 0; i < cohorts; ++i) start[i + 1] += start[i];
+    std::vector<size_t> members(start[cohorts]);
+    std::vector<size_t> cursor(start.begin(), start.end() - 1);
+    for (size_t c = 0; c < customers; ++c) {
+        int first = timeline.months[timeline.offsets[c]];
+        if (first >= fromMonth && first <= toMonth) members[cursor[first - fromMonth]++] = c;
+    }
+
+    parallelFor(cohorts, [&](size_t i) {
+        auto& row = m.returned[i];
+        int first = fromMonth + static_cast<int>(i);
+        for (size_t k = start[i]; k < start[i + 1]; ++k) {
+            size_t c = members[k];
+            for (size_t j = timeline.offsets[c] + 1; j < timeline.offsets[c + 1]; ++j) {
+                int after = timeline.months[j] - first;
+                if (after > RETENTION_MONTHS) break; // Months are sorted
+                row[after - 1]++;
+            }
+        }
+        m.sizes[i] = static_cast<int>(start[i + 1] - start[i]);
+    });
+    return m;
+}
+
+/**
+ * @brief Computes the retention of the cohorts first served in a range of months, from the hot and archived
+ *        history.
+ * @param fromMonth First cohort month in "YYYY-MM" format.
+ * @param toMonth Last cohort month in "YYYY-MM" format.
+ * @return RetentionMatrix The matrix; empty if a month is malformed.
+ */
+RetentionMatrix cohortRetentionBetween(const std::string& fromMonth, const std::string& toMonth) {
+    int from, to;
+    if (fromMonth.size() != 7 || toMonth.size() != 7 || !monthIndexOf(fromMonth, from) || !monthIndexOf(toMonth, to)) return {};
+    return cohortRetention(buildVisitTimeline(loadHistoryBetween("0000-01-01", "9999-12-31")), from, to);
+}
+
+/**
+ * @brief Interactively prints the retention matrix for a range of cohort months.
+ * @note Each cell is the percentage of the cohort served again in that month after its first visit.
+ */
+void viewRetentionReport() {
+    std::string from, to;
+    std::cout << "Enter first cohort month (YYYY-MM): "; std::getline(std::cin, from);
+    std::cout << "Enter last cohort month (YYYY-MM): "; std::getline(std::cin, to);
+    RetentionMatrix m = cohortRetentionBetween(from, to);
+    if (m.cohorts.empty()) {
+        std::cout << "Invalid month range.\n";
+        return;
+    }
+    std::cout << "--- Customer Retention (% of cohort served again in month M+k) ---\n";
+    std::cout << std::left << std::setw(9) << "Cohort" << std::right << std::setw(7) << "Size";
+    for (int k = 1; k <= RETENTION_MONTHS; ++k) std::cout << std::setw(6) << ("M+" + std::to_string(k));
+    std::cout << "\n" << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < m.cohorts.size(); ++i) {
+        std::cout << std::left << std::setw(9) << m.cohorts[i] << std::right << std::setw(7) << m.sizes[i];
+        for (int k = 0; k < RETENTION_MONTHS; ++k) {
+            if (m.sizes[i] == 0) std::cout << std::setw(6) << "-";
+            else std::cout << std::setw(6) << 100.0 * m.returned[i][k] / m.sizes[i];
+        }
+        std::cout << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,86 @@
+// Cohort.h
+#ifndef COHORT_H
+#define COHORT_H
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Service.h"
+
+/**
+ * @brief Months after the first visit that the retention matrix follows.
+ */
+const int RETENTION_MONTHS = 12;
+
+/**
+ * @brief The months in which each customer was served, as one sorted array per customer.
+ * @note Stored as flat arrays: customer i visited in months[offsets[i]] .. months[offsets[i + 1] - 1], each
+ *       month once and in order, so months[offsets[i]] is the customer's first visit.
+ */
+struct VisitTimeline {
+    std::vector<int> customerIds;     /**< Customer of each timeline, ascending. */
+    std::vector<size_t> offsets;      /**< Start of each customer's months; one more entry than customers. */
+    std::vector<int> months;          /**< Month indexes (year * 12 + month - 1). */
+};
+
+/**
+ * @brief Share of each monthly cohort served again in each of the following months.
+ */
+struct RetentionMatrix {
+    std::vector<std::string> cohorts;                          /**< Cohort months in "YYYY-MM" format. */
+    std::vector<int> sizes;                                    /**< Customers first served in each cohort month. */
+    std::vector<std::array<int, RETENTION_MONTHS>> returned;   /**< [cohort][k]: of them, served in month M+k+1. */
+};
+
+/**
+ * @brief Returns the month index (year * 12 + month - 1) of a "YYYY-MM..." date.
+ * @param date The date.
+ * @param out Receives the index.
+ * @return bool False if the date does not start with a valid year and month.
+ */
+bool monthIndexOf(const std::string& date, int& out);
+
+/**
+ * @brief Builds the visit timelines from (customer ID, month index) pairs.
+ * @param visits One pair per visit, in any order; repeats within a month count once.
+ * @return VisitTimeline The timelines.
+ * @note Customers are numbered densely, bucketed with a counting sort and each customer's few months sorted in
+ *       place, so the build is linear in the visits apart from those short sorts.
+ */
+VisitTimeline buildVisitTimeline(const std::vector<std::pair<int, int>>& visits);
+
+/**
+ * @brief Builds the visit timelines from history rows.
+ * @param rows The rows; cancelled bookings and undated rows are skipped.
+ * @return VisitTimeline The timelines.
+ */
+VisitTimeline buildVisitTimeline(const std::vector<ServiceHistory>& rows);
+
+/**
+ * @brief Computes the retention of the cohorts first served in a range of months.
+ * @param timeline The visit timelines.
+ * @param fromMonth Index of the first cohort month.
+ * @param toMonth Index of the last cohort month.
+ * @return RetentionMatrix One row per month in the range, empty cohorts included.
+ * @note Customers are bucketed by first month, then the cohorts are counted in parallel on the shared pool;
+ *       each cohort touches only its own customers and its own row.
+ */
+RetentionMatrix cohortRetention(const VisitTimeline& timeline, int fromMonth, int toMonth);
+
+/**
+ * @brief Computes the retention of the cohorts first served in a range of months, from the hot and archived
+ *        history.
+ * @param fromMonth First cohort month in "YYYY-MM" format.
+ * @param toMonth Last cohort month in "YYYY-MM" format.
+ * @return RetentionMatrix The matrix; empty if a month is malformed.
+ * @note The whole history is read, as a customer's first visit may precede the range.
+ */
+RetentionMatrix cohortRetentionBetween(const std::string& fromMonth, const std::string& toMonth);
+
+/**
+ * @brief Interactively prints the retention matrix for a range of cohort months.
+ */
+void viewRetentionReport();
+
+#endif // COHORT_H
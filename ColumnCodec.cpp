@@ -0,0 +1,178 @@
+// ColumnCodec.cpp (implementation)
+#include "ColumnCodec.h"
+#include <algorithm>
+
+/**
+ * @brief Number of zero bytes appended after the last block so the decoder may always load 8 bytes at once.
+ */
+static const size_t COLUMN_PADDING = 8;
+
+/**
+ * @brief Appends an unsigned LEB128 varint to a buffer.
+ * @param out The output buffer.
+ * @param v The value.
+ */
+void appendVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint from a buffer.
+ * @param buf The input buffer.
+ * @param pos The read offset, advanced past the varint.
+ * @param v Receives the value.
+ * @return bool True if a complete varint was read.
+ */
+bool readVarint(const std::string& buf, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= buf.size()) return false;
+        uint8_t b = static_cast<uint8_t>(buf[pos++]);
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Loads 8 bytes as a little-endian 64-bit word (compiles to a single load on common targets).
+ * @param p Pointer to the first byte.
+ * @return uint64_t The loaded word.
+ */
+static inline uint64_t load64le(const uint8_t* p) {
+    return static_cast<uint64_t>(p[0]) | static_cast<uint64_t>(p[1]) << 8 |
+           static_cast<uint64_t>(p[2]) << 16 | static_cast<uint64_t>(p[3]) << 24 |
+           static_cast<uint64_t>(p[4]) << 32 | static_cast<uint64_t>(p[5]) << 40 |
+           static_cast<uint64_t>(p[6]) << 48 | static_cast<uint64_t>(p[7]) << 56;
+}
+
+/**
+ * @brief Returns the number of bytes used by a packed block.
+ * @param n The number of values in the block.
+ * @param width The bit width per value.
+ * @return size_t The packed size in bytes.
+ */
+static inline size_t packedBytes(size_t n, unsigned width) {
+    return (n * width + 7) / 8;
+}
+
+/**
+ * @brief Encodes an integer column as deltas, bit-packed in frame-of-reference blocks.
+ * @param values The column values.
+ * @param out The buffer the encoded column is appended to.
+ * @note Layout: varint count, then per block a zigzag varint minimum delta, a width byte and the packed
+ *       offsets, then COLUMN_PADDING zero bytes. Widths above 56 bits are stored as full 64-bit words.
+ *       Delta arithmetic wraps modulo 2^64, so any int64 column round-trips.
+ */
+void encodeDeltaColumn(const std::vector<int64_t>& values, std::string& out) {
+    appendVarint(out, values.size());
+    uint64_t prev = 0;
+    std::vector<uint64_t> deltas(DELTA_BLOCK_SIZE);
+    for (size_t start = 0; start < values.size(); start += DELTA_BLOCK_SIZE) {
+        size_t n = std::min(DELTA_BLOCK_SIZE, values.size() - start);
+        int64_t base = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t v = static_cast<uint64_t>(values[start + i]);
+            deltas[i] = v - prev;
+            prev = v;
+            int64_t d = static_cast<int64_t>(deltas[i]);
+            if (i == 0 || d < base) base = d;
+        }
+        uint64_t maxOffset = 0;
+        for (size_t i = 0; i < n; ++i) {
+            deltas[i] -= static_cast<uint64_t>(base);
+            maxOffset = std::max(maxOffset, deltas[i]);
+        }
+        unsigned width = 0;
+        while (width < 64 && (maxOffset >> width) != 0) ++width;
+        if (width > 56) width = 64;
+
+        appendVarint(out, (static_cast<uint64_t>(base) << 1) ^ static_cast<uint64_t>(base >> 63));
+        out.push_back(static_cast<char>(width));
+
+        if (width == 64) {
+            for (size_t i = 0; i < n; ++i) {
+                for (int b = 0; b < 64; b += 8) out.push_back(static_cast<char>((deltas[i] >> b) & 0xFF));
+            }
+            continue;
+        }
+        uint64_t acc = 0;
+        unsigned accBits = 0;
+        for (size_t i = 0; i < n; ++i) {
+            acc |= deltas[i] << accBits; // accBits < 8 and width <= 56, so nothing is lost
+            accBits += width;
+            while (accBits >= 8) {
+                out.push_back(static_cast<char>(acc & 0xFF));
+                acc >>= 8;
+                accBits -= 8;
+            }
+        }
+        if (accBits > 0) out.push_back(static_cast<char>(acc & 0xFF));
+    }
+    out.append(COLUMN_PADDING, '\0');
+}
+
+/**
+ * @brief Decodes one frame-of-reference block and applies the running prefix sum.
+ * @param p Pointer to the packed offsets; at least COLUMN_PADDING readable bytes must follow them.
+ * @param width The bit width per offset.
+ * @param n The number of values in the block.
+ * @param base The block's minimum delta.
+ * @param prev The running value, updated to the block's last value.
+ * @param out Receives the n decoded values.
+ */
+static inline void unpackBlock(const uint8_t* p, unsigned width, size_t n, uint64_t base, uint64_t& prev, int64_t* out) {
+    if (width == 0) {
+        for (size_t i = 0; i < n; ++i) { prev += base; out[i] = static_cast<int64_t>(prev); }
+    } else if (width <= 56) {
+        const uint64_t mask = (uint64_t(1) << width) - 1;
+        size_t bit = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t u = (load64le(p + (bit >> 3)) >> (bit & 7)) & mask;
+            prev += base + u;
+            out[i] = static_cast<int64_t>(prev);
+            bit += width;
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            prev += base + load64le(p + i * 8);
+            out[i] = static_cast<int64_t>(prev);
+        }
+    }
+}
+
+/**
+ * @brief Decodes a column written by encodeDeltaColumn.
+ * @param buf The buffer holding the encoded column.
+ * @param pos The read offset; advanced past the column (including its padding) on success.
+ * @param out Receives the decoded values (replaced, not appended).
+ * @return bool True if the column was decoded, false if the buffer is truncated or corrupt.
+ * @note Every block is bounds-checked once up front; the inner loop is a branch-free unpack and prefix sum.
+ */
+bool decodeDeltaColumn(const std::string& buf, size_t& pos, std::vector<int64_t>& out) {
+    uint64_t count;
+    size_t p = pos;
+    if (!readVarint(buf, p, count) || count > buf.size() * 64) return false; // Every block costs at least 2 bytes
+    out.resize(count);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buf.data());
+    uint64_t prev = 0;
+    for (size_t start = 0; start < count; start += DELTA_BLOCK_SIZE) {
+        size_t n = std::min<size_t>(DELTA_BLOCK_SIZE, count - start);
+        uint64_t zz;
+        if (!readVarint(buf, p, zz) || p >= buf.size()) return false;
+        uint64_t base = (zz >> 1) ^ (~(zz & 1) + 1);
+        unsigned width = static_cast<uint8_t>(buf[p++]);
+        if (width > 64 || (width > 56 && width != 64)) return false;
+        size_t bytes = width == 64 ? n * 8 : packedBytes(n, width);
+        if (buf.size() - p < bytes + COLUMN_PADDING) return false;
+        unpackBlock(data + p, width, n, base, prev, out.data() + start);
+        p += bytes;
+    }
+    if (buf.size() - p < COLUMN_PADDING) return false;
+    pos = p + COLUMN_PADDING;
+    return true;
+}
@@ -0,0 +1,49 @@
+// ColumnCodec.h
+#ifndef COLUMN_CODEC_H
+#define COLUMN_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Number of values per frame-of-reference block in an encoded delta column.
+ */
+const size_t DELTA_BLOCK_SIZE = 128;
+
+/**
+ * @brief Appends an unsigned LEB128 varint to a buffer.
+ * @param out The output buffer.
+ * @param v The value.
+ */
+void appendVarint(std::string& out, uint64_t v);
+
+/**
+ * @brief Reads an unsigned LEB128 varint from a buffer.
+ * @param buf The input buffer.
+ * @param pos The read offset, advanced past the varint.
+ * @param v Receives the value.
+ * @return bool True if a complete varint was read.
+ */
+bool readVarint(const std::string& buf, size_t& pos, uint64_t& v);
+
+/**
+ * @brief Encodes an integer column as deltas, bit-packed in frame-of-reference blocks.
+ * @param values The column values (typically increasing IDs or timestamps).
+ * @param out The buffer the encoded column is appended to.
+ * @note Each block of DELTA_BLOCK_SIZE deltas stores its minimum delta as a zigzag varint, a bit width,
+ *       and every delta minus that minimum packed at the bit width. Sorted or nearly sorted columns
+ *       therefore cost a few bits per value.
+ */
+void encodeDeltaColumn(const std::vector<int64_t>& values, std::string& out);
+
+/**
+ * @brief Decodes a column written by encodeDeltaColumn.
+ * @param buf The buffer holding the encoded column.
+ * @param pos The read offset; advanced past the column on success.
+ * @param out Receives the decoded values (replaced, not appended).
+ * @return bool True if the column was decoded, false if the buffer is truncated or corrupt.
+ */
+bool decodeDeltaColumn(const std::string& buf, size_t& pos, std::vector<int64_t>& out);
+
+#endif // COLUMN_CODEC_H
@@ -0,0 +1,168 @@
+// Compaction.cpp (implementation)
+#include "Compaction.h"
+#include "Storage.h"
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+#include "Discount.h"
+#include "HistoryPartition.h"
+#include "HistoryLog.h"
+#include "ThreadPool.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+
+#ifdef TEST_MODE
+const std::string COMPACT_CUSTOMER_FILE = "tests/test_customers.txt";
+const std::string COMPACT_VEHICLE_FILE = "tests/test_vehicles.txt";
+const std::string COMPACT_SERVICES_FILE = "tests/test_services.txt";
+const std::string COMPACT_DISCOUNT_FILE = "tests/test_discounts.txt";
+const std::string COMPACT_HISTORY_FILE = "tests/test_service_history.txt";
+#else
+const std::string COMPACT_CUSTOMER_FILE = "customers.txt";
+const std::string COMPACT_VEHICLE_FILE = "vehicles.txt";
+const std::string COMPACT_SERVICES_FILE = "services.txt";
+const std::string COMPACT_DISCOUNT_FILE = "discounts.txt";
+const std::string COMPACT_HISTORY_FILE = "service_history.txt";
+#endif
+
+/**
+ * @brief Maximum number of passes over a file that keeps changing underneath the compactor.
+ */
+const int COMPACTION_ATTEMPTS = 3;
+
+/**
+ * @brief Reads a whole file into a string.
+ * @param path The file path.
+ * @return std::string The file content (empty if the file is missing).
+ */
+static std::string readWholeFile(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::ostringstream buf;
+    buf << ifs.rdbuf();
+    return buf.str();
+}
+
+/**
+ * @brief Compacts one pipe-separated data file keyed by a numeric ID.
+ * @param path The data file.
+ * @param parseId Extracts the ID of a line, rejecting malformed lines.
+ * @param replace Installs the compacted content; defaults to replaceFileAtomically.
+ * @return CompactionReport What was kept, dropped, quarantined and reclaimed.
+ * @note Parsing, deduplication and sorting run without any lock. The data file mutex is held only to
+ *       confirm the file still matches what was read and to swap in the compacted copy, so bookings are
+ *       never blocked behind a full pass. If the file changed in the meantime the pass is retried.
+ */
+CompactionReport compactDataFile(const std::string& path, const RowIdParser& parseId, const FileReplacer& replace) {
+    CompactionReport r{path, 0, 0, 0, 0, 0, 0, false};
+    for (int attempt = 0; attempt < COMPACTION_ATTEMPTS; ++attempt) {
+        std::string original = readWholeFile(path);
+        r = {path, 0, 0, 0, 0, static_cast<long long>(original.size()), static_cast<long long>(original.size()), false};
+
+        std::map<int, std::string> latest;
+        std::string quarantined;
+        std::istringstream in(original);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            r.rowsRead++;
+            int id;
+            if (!parseId(line, id)) {
+                r.rowsQuarantined++;
+                quarantined += line + '\n';
+                continue;
+            }
+            auto it = latest.find(id);
+            if (it != latest.end()) {
+                r.duplicatesDropped++;
+                it->second = line; // Last writer wins
+            } else {
+                latest.emplace(id, line);
+            }
+        }
+        std::string compacted;
+        for (const auto& p : latest) compacted += p.second + '\n';
+        r.rowsKept = static_cast<int>(latest.size());
+        if (compacted == original) return r; // Already compact
+
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        if (readWholeFile(path) != original) continue; // Rewritten by a booking meanwhile; start over
+        if (!quarantined.empty()) {
+            std::ofstream q(path + ".quarantine", std::ios::app | std::ios::binary);
+            q << quarantined;
+        }
+        if (!(replace ? replace(path, compacted) : replaceFileAtomically(path, compacted))) return r;
+        r.bytesAfter = static_cast<long long>(compacted.size());
+        r.rewritten = true;
+        return r;
+    }
+    return r;
+}
+
+/**
+ * @brief Compacts the customer, vehicle, service, discount and history files one after another.
+ * @return std::vector<CompactionReport> One report per file.
+ * @note Each file is validated with the same parser its loader uses, so exactly the rows the loaders
+ *       silently skip are quarantined. The history file is installed together with its log so bookings
+ *       logged since the last checkpoint still apply to the compacted file.
+ */
+std::vector<CompactionReport> compactAllDataFiles() {
+    std::vector<CompactionReport> reports;
+    reports.push_back(compactDataFile(COMPACT_CUSTOMER_FILE, [](const std::string& ln, int& id) {
+        Customer c; if (!parseCustomerLine(ln, c)) return false; id = c.id; return true;
+    }));
+    reports.push_back(compactDataFile(COMPACT_VEHICLE_FILE, [](const std::string& ln, int& id) {
+        Vehicle v; if (!parseVehicleLine(ln, v)) return false; id = v.id; return true;
+    }));
+    reports.push_back(compactDataFile(COMPACT_SERVICES_FILE, [](const std::string& ln, int& id) {
+        ServiceItem s; if (!parseServiceLine(ln, s)) return false; id = s.id; return true;
+    }));
+    reports.push_back(compactDataFile(COMPACT_DISCOUNT_FILE, [](const std::string& ln, int& id) {
+        Discount d; if (!parseDiscountLine(ln, d)) return false; id = d.id; return true;
+    }));
+    reports.push_back(compactDataFile(COMPACT_HISTORY_FILE, [](const std::string& ln, int& id) {
+        ServiceHistory h; if (!parseHistoryLine(ln, h)) return false; id = h.historyId; return true;
+    }, [](const std::string&, const std::string& content) {
+        return installHistoryBase(content, true); // Keep the logged bookings on top of the compacted file
+    }));
+    if (reports.back().rewritten) {
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        writeHistoryPartitions(loadHistory());
+    }
+    return reports;
+}
+
+/**
+ * @brief Starts compactAllDataFiles as a task on the shared thread pool.
+ * @return std::future<std::vector<CompactionReport>> Future holding the reports once the pass finishes.
+ */
+std::future<std::vector<CompactionReport>> startBackgroundCompaction() {
+    auto promise = std::make_shared<std::promise<std::vector<CompactionReport>>>();
+    std::future<std::vector<CompactionReport>> reports = promise->get_future();
+    submitTask([promise](const std::atomic<bool>&) {
+        try {
+            promise->set_value(compactAllDataFiles());
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return reports;
+}
+
+/**
+ * @brief Prints compaction reports, including the total bytes reclaimed.
+ * @param reports The reports to print.
+ */
+void printCompactionReports(const std::vector<CompactionReport>& reports) {
+    long long reclaimed = 0;
+    std::cout << "--- Compaction Report ---\n";
+    for (const auto& r : reports) {
+        std::cout << r.file << ": " << r.rowsKept << " kept, " << r.duplicatesDropped << " duplicates dropped, "
+                  << r.rowsQuarantined << " quarantined, " << (r.bytesBefore - r.bytesAfter) << " bytes reclaimed"
+                  << (r.rewritten ? "" : " (unchanged)") << "\n";
+        reclaimed += r.bytesBefore - r.bytesAfter;
+    }
+    std::cout << "Total reclaimed: " << reclaimed << " bytes\n";
+}
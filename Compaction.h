@@ -0,0 +1,67 @@
+// Compaction.h
+#ifndef COMPACTION_H
+#define COMPACTION_H
+
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Outcome of compacting one data file.
+ */
+struct CompactionReport {
+    std::string file;           /**< Path of the compacted file. */
+    int rowsRead;               /**< Non-empty lines read. */
+    int rowsKept;               /**< Rows written back (one per ID). */
+    int duplicatesDropped;      /**< Older rows superseded by a later row with the same ID. */
+    int rowsQuarantined;        /**< Unparsable rows moved to the quarantine file. */
+    long long bytesBefore;      /**< File size before compaction. */
+    long long bytesAfter;       /**< File size after compaction. */
+    bool rewritten;             /**< False if the file was already compact or changed during the pass. */
+};
+
+/**
+ * @brief Extracts the record ID from a data file line.
+ * @note Returns false if the line is one the loader would skip as malformed.
+ */
+using RowIdParser = std::function<bool(const std::string& line, int& id)>;
+
+/**
+ * @brief Installs the compacted content of a data file; called with dataFileMutex() held.
+ * @note Returns false if the file could not be replaced.
+ */
+using FileReplacer = std::function<bool(const std::string& path, const std::string& content)>;
+
+/**
+ * @brief Compacts one pipe-separated data file keyed by a numeric ID.
+ * @param path The data file.
+ * @param parseId Extracts the ID of a line, rejecting malformed lines.
+ * @param replace Installs the compacted content; defaults to replaceFileAtomically.
+ * @return CompactionReport What was kept, dropped, quarantined and reclaimed.
+ * @note Keeps the last row for each ID (last writer wins), appends malformed rows to "<path>.quarantine"
+ *       and rewrites the rest sorted by ID.
+ */
+CompactionReport compactDataFile(const std::string& path, const RowIdParser& parseId,
+                                 const FileReplacer& replace = nullptr);
+
+/**
+ * @brief Compacts the customer, vehicle, service, discount and history files one after another.
+ * @return std::vector<CompactionReport> One report per file.
+ * @note Rebuilds the history partitions if the history file was rewritten.
+ */
+std::vector<CompactionReport> compactAllDataFiles();
+
+/**
+ * @brief Starts compactAllDataFiles as a task on the shared thread pool.
+ * @return std::future<std::vector<CompactionReport>> Future holding the reports once the pass finishes.
+ */
+std::future<std::vector<CompactionReport>> startBackgroundCompaction();
+
+/**
+ * @brief Prints compaction reports, including the total bytes reclaimed.
+ * @param reports The reports to print.
+ */
+void printCompactionReports(const std::vector<CompactionReport>& reports);
+
+#endif // COMPACTION_H
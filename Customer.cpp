@@ -1,5 +1,9 @@
 // Customer.cpp (implementation)
 #include "Customer.h"
+#include "Storage.h"
+#include "ChangeFeed.h"
+#include "Snapshot.h"
+#include "BranchStore.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -36,6 +40,34 @@ int nextCustomerId() {
     return maxId + 1;
 }
 
+/**
+ * @brief Parses one line of the customer file.
+ * @param line The raw line in "id|name|phone|email[|branchId]" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseCustomerLine(const std::string& line, Customer& out) {
+    if (line.empty()) return false;
+    std::istringstream ss(line);
+    std::string idStr, name, phone, email, branch;
+    if (!std::getline(ss, idStr, '|')) return false;
+    try {
+        Customer c;
+        c.id = std::stoi(idStr);
+        std::getline(ss, name, '|');
+        std::getline(ss, phone, '|');
+        std::getline(ss, email, '|');
+        if (std::getline(ss, branch, '|')) c.branchId = std::stoi(branch);
+        c.name = name;
+        c.phone = phone;
+        c.email = email;
+        out = c;
+        return true;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
 /**
  * @brief Loads all customers from the customer file into a vector.
  * @return std::vector<Customer> A vector containing all valid customer records.
@@ -43,52 +75,66 @@ int nextCustomerId() {
  */
 std::vector<Customer> loadCustomers() {
     std::vector<Customer> list;
+    if (lookupCachedTable(CUSTOMER_FILE, list)) return list;
     std::ifstream ifs(CUSTOMER_FILE);
     std::string line;
+    Customer item;
     while (std::getline(ifs, line)) {
-        if (line.empty()) continue;
-        std::istringstream ss(line);
-        std::string idStr, name, phone, email;
-        if (!std::getline(ss, idStr, '|')) continue;
-        try {
-            Customer c;
-            c.id = std::stoi(idStr);
-            std::getline(ss, name, '|');
-            std::getline(ss, phone, '|');
-            std::getline(ss, email, '|');
-            c.name = name;
-            c.phone = phone;
-            c.email = email;
-            list.push_back(c);
-        } catch (...) {
-            continue; // Skip malformed
-        }
+        if (parseCustomerLine(line, item)) list.push_back(item); // Skip empty or malformed
     }
+    storeCachedTable(CUSTOMER_FILE, list);
     return list;
 }
 
+/**
+ * @brief Formats a customer as its line in the customer file.
+ * @param c The customer.
+ * @return std::string The line (without the newline), as parseCustomerLine() reads it; the branch ID is
+ *         appended only when it is not 0.
+ */
+std::string formatCustomerLine(const Customer& c) {
+    std::ostringstream line;
+    line << c.id << '|' << c.name << '|' << c.phone << '|' << c.email;
+    if (c.branchId != 0) line << '|' << c.branchId; // Main workshop rows keep the original format
+    return line.str();
+}
+
 /**
  * @brief Saves a list of customers to the customer file, ensuring unique IDs.
  * @param list A vector of Customer objects to save.
- * @note Overwrites the existing file and keeps only the first occurrence of each customer ID.
+ * @note Overwrites the existing file and keeps only the first occurrence of each customer ID, then publishes the
+ *       inserted, updated and deleted customers to the change feed.
  */
 void saveCustomers(const std::vector<Customer>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::vector<Customer> before = loadCustomers();
     std::map<int, Customer> unique;
     for (const auto& c : list) {
         if (unique.count(c.id) == 0) {
             unique[c.id] = c;  // Keep first occurrence
         }
     }
-    std::ofstream ofs(CUSTOMER_FILE, std::ios::trunc);
-    for (const auto& p : unique) {
-        const auto& c = p.second;
-        ofs << c.id << '|' << c.name << '|' << c.phone << '|' << c.email << '\n';
+    std::vector<Customer> written;
+    {
+        std::ofstream ofs(CUSTOMER_FILE, std::ios::trunc);
+        for (const auto& p : unique) {
+            const auto& c = p.second;
+            std::string line = formatCustomerLine(c);
+            ofs << line << '\n';
+            Customer row;
+            if (parseCustomerLine(line, row)) written.push_back(row); // Cache exactly what the loader reads back
+        }
     }
+    storeCachedTable(CUSTOMER_FILE, written);
+    writeBranchCustomers(written);
+    std::vector<ChangeEvent> changes;
+    diffTableChanges("customer", before, written, [](const Customer& r) { return r.id; }, formatCustomerLine, changes);
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
 }
 
 /**
  * @brief Interactively adds a new customer to the customer file.
- * @note Prompts the user for name, phone, and email, assigns a new ID, and saves the updated customer list.
+ * @note Prompts the user for name, phone, email and branch, assigns a new ID, and saves the updated customer list.
  */
 void addCustomerInteractive() {
     std::vector<Customer> list = loadCustomers();
@@ -97,6 +143,9 @@ void addCustomerInteractive() {
     std::cout << "Enter name: "; std::getline(std::cin, c.name);
     std::cout << "Enter phone: "; std::getline(std::cin, c.phone);
     std::cout << "Enter email: "; std::getline(std::cin, c.email);
+    std::string branch;
+    std::cout << "Enter branch ID (blank for the main branch): "; std::getline(std::cin, branch);
+    try { c.branchId = branch.empty() ? 0 : std::max(0, std::stoi(branch)); } catch (...) { c.branchId = 0; }
     list.push_back(c);
     saveCustomers(list);
     std::cout << "Customer added with ID: " << c.id << "\n";
@@ -13,8 +13,24 @@ struct Customer {
     std::string name; /**< Full name of the customer. */
     std::string phone; /**< Phone number of the customer. */
     std::string email; /**< Email address of the customer. */
+    int branchId = 0;  /**< Service centre the customer belongs to (0 for the main workshop). */
 };
 
+/**
+ * @brief Parses one line of the customer file.
+ * @param line The raw pipe-separated line.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseCustomerLine(const std::string& line, Customer& out);
+
+/**
+ * @brief Formats a customer as its line in the customer file.
+ * @param c The customer.
+ * @return std::string The line (without the newline).
+ */
+std::string formatCustomerLine(const Customer& c);
+
 /**
  * @brief Loads all customers from the customer file.
  * @return std::vector<Customer> A vector containing all valid customer records.
@@ -1,5 +1,8 @@
 // Discount.cpp (implementation)
 #include "Discount.h"
+#include "Storage.h"
+#include "ChangeFeed.h"
+#include "Snapshot.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -34,6 +37,33 @@ int nextDiscountId() {
     return maxId + 1;
 }
 
+/**
+ * @brief Parses one line of the discount file.
+ * @param line The raw line in "id|name|percent|note" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseDiscountLine(const std::string& line, Discount& out) {
+    if (line.empty()) return false;
+    std::istringstream ss(line);
+    std::string idStr, name, pctStr, note;
+    if (!std::getline(ss, idStr, '|')) return false;
+    try {
+        Discount d;
+        d.id = std::stoi(idStr);
+        std::getline(ss, name, '|');
+        std::getline(ss, pctStr, '|');
+        std::getline(ss, note, '|');
+        d.name = name;
+        d.percent = std::stod(pctStr);
+        d.note = note;
+        out = d;
+        return true;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
 /**
  * @brief Loads all discounts from the discount file into a vector.
  * @return std::vector<Discount> A vector containing all valid discount records.
@@ -41,47 +71,58 @@ int nextDiscountId() {
  */
 std::vector<Discount> loadDiscounts() {
     std::vector<Discount> list;
+    if (lookupCachedTable(DISCOUNT_FILE, list)) return list;
     std::ifstream ifs(DISCOUNT_FILE);
     std::string line;
+    Discount item;
     while (std::getline(ifs, line)) {
-        if (line.empty()) continue;
-        std::istringstream ss(line);
-        std::string idStr, name, pctStr, note;
-        if (!std::getline(ss, idStr, '|')) continue;
-        try {
-            Discount d;
-            d.id = std::stoi(idStr);
-            std::getline(ss, name, '|');
-            std::getline(ss, pctStr, '|');
-            std::getline(ss, note, '|');
-            d.name = name;
-            d.percent = std::stod(pctStr);
-            d.note = note;
-            list.push_back(d);
-        } catch (...) {
-            continue; // Skip malformed
-        }
+        if (parseDiscountLine(line, item)) list.push_back(item); // Skip empty or malformed
     }
+    storeCachedTable(DISCOUNT_FILE, list);
     return list;
 }
 
+/**
+ * @brief Formats a discount as its line in the discount file.
+ * @param d The discount.
+ * @return std::string The line (without the newline), as parseDiscountLine() reads it.
+ */
+std::string formatDiscountLine(const Discount& d) {
+    std::ostringstream line;
+    line << d.id << '|' << d.name << '|' << d.percent << '|' << d.note;
+    return line.str();
+}
+
 /**
  * @brief Saves a list of discounts to the discount file, ensuring unique IDs.
  * @param list A vector of Discount objects to save.
- * @note Overwrites the existing file and keeps only the first occurrence of each discount ID.
+ * @note Overwrites the existing file and keeps only the first occurrence of each discount ID, then publishes the
+ *       inserted, updated and deleted discounts to the change feed.
  */
 void saveDiscounts(const std::vector<Discount>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::vector<Discount> before = loadDiscounts();
     std::map<int, Discount> unique;
     for (const auto& d : list) {
         if (unique.count(d.id) == 0) {
             unique[d.id] = d;
         }
     }
-    std::ofstream ofs(DISCOUNT_FILE, std::ios::trunc);
-    for (const auto& p : unique) {
-        const auto& d = p.second;
-        ofs << d.id << '|' << d.name << '|' << d.percent << '|' << d.note << '\n';
+    std::vector<Discount> written;
+    {
+        std::ofstream ofs(DISCOUNT_FILE, std::ios::trunc);
+        for (const auto& p : unique) {
+            const auto& d = p.second;
+            std::string line = formatDiscountLine(d);
+            ofs << line << '\n';
+            Discount row;
+            if (parseDiscountLine(line, row)) written.push_back(row); // Cache exactly what the loader reads back
+        }
     }
+    storeCachedTable(DISCOUNT_FILE, written);
+    std::vector<ChangeEvent> changes;
+    diffTableChanges("discount", before, written, [](const Discount& r) { return r.id; }, formatDiscountLine, changes);
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
 }
 
 /**
@@ -15,6 +15,21 @@ struct Discount {
     std::string note;   /**< Additional notes or description for the discount. */
 };
 
+/**
+ * @brief Parses one line of the discount file.
+ * @param line The raw pipe-separated line.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseDiscountLine(const std::string& line, Discount& out);
+
+/**
+ * @brief Formats a discount as its line in the discount file.
+ * @param d The discount.
+ * @return std::string The line (without the newline).
+ */
+std::string formatDiscountLine(const Discount& d);
+
 /**
  * @brief Loads all discounts from the discount file.
  * @return std::vector<Discount> A vector containing all valid discount records.
@@ -0,0 +1,704 @@
+// HistoryArchive.cpp (implementation)
+#include "HistoryArchive.h"
+#include "ChangeFeed.h"
+#include "Storage.h"
+#include "Lifecycle.h"
+#include "ColumnCodec.h"
+#include "ThreadPool.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef TEST_MODE
+const std::string ARCHIVE_DIR = "tests/test_history_archive";
+#else
+const std::string ARCHIVE_DIR = "history_archive";
+#endif
+
+/**
+ * @brief Format version written by encodeArchiveSegment; older segments are still readable.
+ * @note Version 3 added the branch ID column, version 4 the tax lines and version 5 the job stage times.
+ */
+const char ARCHIVE_FORMAT_VERSION = 5;
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Builds the compressed segment path for a month key.
+ * @param key The month key.
+ * @return std::string The path of the segment file.
+ */
+static std::string archivePath(const std::string& key) {
+    return ARCHIVE_DIR + "/" + key + ".arc";
+}
+
+/**
+ * @brief Builds the Bloom filter sidecar path for an archive segment.
+ * @param key The month key.
+ * @return std::string The path of the ".bloom" file.
+ */
+static std::string archiveFilterPath(const std::string& key) {
+    return ARCHIVE_DIR + "/" + key + ".bloom";
+}
+
+/**
+ * @brief Builds the distinct-count sketch sidecar path for an archive segment.
+ * @param key The month key.
+ * @return std::string The path of the ".hll" file.
+ */
+std::string archiveSketchPath(const std::string& key) {
+    return ARCHIVE_DIR + "/" + key + ".hll";
+}
+
+/**
+ * @brief Returns the path of the archive index file.
+ * @return std::string The index file path.
+ */
+static std::string archiveIndexPath() {
+    return ARCHIVE_DIR + "/index.txt";
+}
+
+// ---- Byte-level helpers ----
+
+/**
+ * @brief Appends an unsigned LEB128 varint.
+ * @param out The output buffer.
+ * @param v The value.
+ */
+static void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+/**
+ * @brief Appends a signed value as a zigzag varint.
+ * @param out The output buffer.
+ * @param v The value.
+ */
+static void putSigned(std::string& out, int64_t v) {
+    putVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); // Zigzag
+}
+
+/**
+ * @brief Appends a length-prefixed string.
+ * @param out The output buffer.
+ * @param s The string.
+ */
+static void putString(std::string& out, const std::string& s) {
+    putVarint(out, s.size());
+    out += s;
+}
+
+/**
+ * @brief Sequential reader over an encoded segment; every read fails once the input is exhausted.
+ */
+struct ByteReader {
+    const std::string& buf;
+    size_t pos;
+    bool ok;
+
+    explicit ByteReader(const std::string& b) : buf(b), pos(0), ok(true) {}
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= buf.size()) { ok = false; return 0; }
+            uint8_t b = static_cast<uint8_t>(buf[pos++]);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t signedVarint() {
+        uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    std::string str() {
+        uint64_t n = varint();
+        if (!ok || n > buf.size() - pos) { ok = false; return ""; }
+        std::string s = buf.substr(pos, n);
+        pos += n;
+        return s;
+    }
+
+    double raw() {
+        double d = 0;
+        if (buf.size() - pos < sizeof(d)) { ok = false; return 0; }
+        std::memcpy(&d, buf.data() + pos, sizeof(d));
+        pos += sizeof(d);
+        return d;
+    }
+
+    uint8_t byte() {
+        if (pos >= buf.size()) { ok = false; return 0; }
+        return static_cast<uint8_t>(buf[pos++]);
+    }
+};
+
+/**
+ * @brief Writes a money column, as whole paise when every value is exact to two decimals.
+ * @param out The output buffer.
+ * @param values The column values.
+ */
+static void putMoneyColumn(std::string& out, const std::vector<double>& values) {
+    bool exact = true;
+    for (double v : values) {
+        double scaled = std::round(v * 100.0);
+        if (scaled / 100.0 != v || std::fabs(scaled) > 9e15) { exact = false; break; }
+    }
+    out.push_back(exact ? 1 : 0);
+    for (double v : values) {
+        if (exact) {
+            putSigned(out, static_cast<int64_t>(std::round(v * 100.0)));
+        } else {
+            char b[sizeof(double)];
+            std::memcpy(b, &v, sizeof(v));
+            out.append(b, sizeof(b));
+        }
+    }
+}
+
+/**
+ * @brief Reads a money column written by putMoneyColumn.
+ * @param in The reader.
+ * @param n The number of values.
+ * @return std::vector<double> The column values.
+ */
+static std::vector<double> getMoneyColumn(ByteReader& in, size_t n) {
+    std::vector<double> values(n);
+    bool exact = in.byte() == 1;
+    for (size_t i = 0; i < n && in.ok; ++i) {
+        values[i] = exact ? static_cast<double>(in.signedVarint()) / 100.0 : in.raw();
+    }
+    return values;
+}
+
+// ---- Date conversion ----
+
+/**
+ * @brief Converts a civil date to days since 1970-01-01 (proleptic Gregorian calendar).
+ * @param y Year.
+ * @param m Month (1-12).
+ * @param d Day of month (1-31).
+ * @return long long The day number.
+ */
+static long long daysFromCivil(long long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const long long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+/**
+ * @brief Converts a dateTime to seconds since the epoch, treating it as a naive (zone-less) time.
+ * @param dateTime The dateTime in "YYYY-MM-DD HH:MM:SS" format.
+ * @param out Receives the number of seconds.
+ * @return bool True if the dateTime is well formed and round-trips exactly.
+ */
+bool dateTimeToSeconds(const std::string& dateTime, long long& out) {
+    int y, mo, d, h, mi, s;
+    char tail;
+    if (dateTime.size() != 19 ||
+        std::sscanf(dateTime.c_str(), "%4d-%2d-%2d %2d:%2d:%2d%c", &y, &mo, &d, &h, &mi, &s, &tail) != 6) return false;
+    if (mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || s > 59 || h < 0 || mi < 0 || s < 0) return false;
+    out = daysFromCivil(y, static_cast<unsigned>(mo), static_cast<unsigned>(d)) * 86400 + h * 3600 + mi * 60 + s;
+    return secondsToDateTime(out) == dateTime; // Rejects dates such as 2023-02-31
+}
+
+/**
+ * @brief Converts seconds since the epoch back to a "YYYY-MM-DD HH:MM:SS" dateTime.
+ * @param seconds The number of seconds.
+ * @return std::string The formatted dateTime.
+ */
+std::string secondsToDateTime(long long seconds) {
+    long long z = (seconds >= 0 ? seconds : seconds - 86399) / 86400;
+    long long secOfDay = seconds - z * 86400;
+    z += 719468;
+    const long long era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const long long y = static_cast<long long>(yoe) + era * 400 + (m <= 2);
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02u %02lld:%02lld:%02lld", y, m, d,
+                  secOfDay / 3600, (secOfDay / 60) % 60, secOfDay % 60);
+    return buf;
+}
+
+// ---- Segment codec ----
+
+/**
+ * @brief Encodes a month of history rows into a compressed archive segment.
+ * @param rows The rows to encode; every dateTime must be convertible by dateTimeToSeconds.
+ * @return std::string The encoded segment bytes.
+ * @note Layout: "CSA" + version, row count, then one column at a time: IDs and timestamps as
+ *       bit-packed delta columns (see ColumnCodec.h), customer/vehicle/branch IDs, dictionary-encoded service lists, discount IDs, money columns in paise,
+ *       run-length encoded statuses, then the tax lines (a count per row, then class, rate, taxable and tax paise
+ *       per line) and the stage times (a count per row, then stage and offset per entry).
+ */
+std::string encodeArchiveSegment(const std::vector<ServiceHistory>& rows) {
+    std::string out = "CSA";
+    out.push_back(ARCHIVE_FORMAT_VERSION);
+    putVarint(out, rows.size());
+
+    std::vector<int64_t> ids, timestamps;
+    for (const auto& h : rows) {
+        long long ts = 0;
+        dateTimeToSeconds(h.dateTime, ts);
+        ids.push_back(h.historyId);
+        timestamps.push_back(ts);
+    }
+    encodeDeltaColumn(ids, out);
+    encodeDeltaColumn(timestamps, out);
+    for (const auto& h : rows) putSigned(out, h.customerId);
+    for (const auto& h : rows) putSigned(out, h.vehicleId);
+    for (const auto& h : rows) putSigned(out, h.branchId);
+
+    // Service lists: distinct lists go into a dictionary, rows store the dictionary index
+    std::map<std::vector<int>, size_t> dict;
+    std::vector<const std::vector<int>*> dictOrder;
+    for (const auto& h : rows) {
+        if (dict.emplace(h.serviceIds, dictOrder.size()).second) dictOrder.push_back(&h.serviceIds);
+    }
+    putVarint(out, dictOrder.size());
+    for (const auto* ids : dictOrder) {
+        putVarint(out, ids->size());
+        for (int id : *ids) putSigned(out, id);
+    }
+    for (const auto& h : rows) putVarint(out, dict[h.serviceIds]);
+
+    for (const auto& h : rows) putSigned(out, h.discountId);
+
+    std::vector<double> subtotal, pct, total;
+    for (const auto& h : rows) {
+        subtotal.push_back(h.subtotal);
+        pct.push_back(h.discountPercent);
+        total.push_back(h.total);
+    }
+    putMoneyColumn(out, subtotal);
+    putMoneyColumn(out, pct);
+    putMoneyColumn(out, total);
+
+    // Status: (value, run length) pairs
+    std::vector<std::pair<std::string, uint64_t>> runs;
+    for (const auto& h : rows) {
+        if (!runs.empty() && runs.back().first == h.status) runs.back().second++;
+        else runs.push_back({h.status, 1});
+    }
+    putVarint(out, runs.size());
+    for (const auto& r : runs) {
+        putString(out, r.first);
+        putVarint(out, r.second);
+    }
+
+    for (const auto& h : rows) putVarint(out, h.taxes.size());
+    for (const auto& h : rows) {
+        for (const auto& t : h.taxes) {
+            putSigned(out, t.taxClass);
+            putSigned(out, t.rateBasisPoints);
+            putSigned(out, t.taxablePaise);
+            putSigned(out, t.taxPaise);
+        }
+    }
+
+    for (const auto& h : rows) putVarint(out, h.stages.size());
+    for (const auto& h : rows) {
+        for (const auto& t : h.stages) {
+            putSigned(out, t.stage);
+            putSigned(out, t.offsetSeconds);
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Decodes a compressed archive segment.
+ * @param bytes The encoded segment bytes.
+ * @param out Receives the decoded rows (replaced, not appended).
+ * @return bool True if the segment was decoded, false if it is corrupt or of an unknown format.
+ */
+bool decodeArchiveSegment(const std::string& bytes, std::vector<ServiceHistory>& out) {
+    out.clear();
+    if (bytes.size() < 4 || bytes.compare(0, 3, "CSA") != 0) return false;
+    const int version = bytes[3];
+    if (version < 1 || version > ARCHIVE_FORMAT_VERSION) return false;
+    ByteReader in(bytes);
+    in.pos = 4;
+    uint64_t n = in.varint();
+    if (!in.ok || n > bytes.size()) return false;
+    out.resize(n);
+
+    if (version == 1) {
+        // Version 1 stored IDs and timestamps as one zigzag varint delta per row
+        long long id = 0, ts = 0;
+        for (auto& h : out) { id += in.signedVarint(); h.historyId = static_cast<int>(id); }
+        for (auto& h : out) { ts += in.signedVarint(); h.dateTime = secondsToDateTime(ts); }
+    } else {
+        std::vector<int64_t> ids, timestamps;
+        if (!decodeDeltaColumn(bytes, in.pos, ids) || !decodeDeltaColumn(bytes, in.pos, timestamps)) return false;
+        if (ids.size() != n || timestamps.size() != n) return false;
+        for (size_t i = 0; i < n; ++i) {
+            out[i].historyId = static_cast<int>(ids[i]);
+            out[i].dateTime = secondsToDateTime(timestamps[i]);
+        }
+    }
+    for (auto& h : out) h.customerId = static_cast<int>(in.signedVarint());
+    for (auto& h : out) h.vehicleId = static_cast<int>(in.signedVarint());
+    for (auto& h : out) h.branchId = version >= 3 ? static_cast<int>(in.signedVarint()) : 0;
+
+    uint64_t dictSize = in.varint();
+    if (!in.ok || dictSize > bytes.size()) return false;
+    std::vector<std::vector<int>> dict(dictSize);
+    for (auto& ids : dict) {
+        uint64_t len = in.varint();
+        if (!in.ok || len > bytes.size()) return false;
+        for (uint64_t i = 0; i < len; ++i) ids.push_back(static_cast<int>(in.signedVarint()));
+    }
+    for (auto& h : out) {
+        uint64_t idx = in.varint();
+        if (!in.ok || idx >= dict.size()) return false;
+        h.serviceIds = dict[idx];
+    }
+
+    for (auto& h : out) h.discountId = static_cast<int>(in.signedVarint());
+
+    auto subtotal = getMoneyColumn(in, n);
+    auto pct = getMoneyColumn(in, n);
+    auto total = getMoneyColumn(in, n);
+    for (size_t i = 0; i < n; ++i) {
+        out[i].subtotal = subtotal[i];
+        out[i].discountPercent = pct[i];
+        out[i].total = total[i];
+    }
+
+    uint64_t runCount = in.varint();
+    size_t row = 0;
+    for (uint64_t r = 0; r < runCount && in.ok; ++r) {
+        std::string status = in.str();
+        uint64_t len = in.varint();
+        if (!in.ok || len > n - row) return false;
+        for (uint64_t i = 0; i < len; ++i) out[row++].status = status;
+    }
+    if (!in.ok || row != n) return false;
+
+    if (version >= 4) {
+        for (auto& h : out) {
+            uint64_t count = in.varint();
+            if (!in.ok || count > bytes.size()) return false;
+            h.taxes.resize(count);
+        }
+        for (auto& h : out) {
+            for (auto& t : h.taxes) {
+                t.taxClass = static_cast<int>(in.signedVarint());
+                t.rateBasisPoints = static_cast<int>(in.signedVarint());
+                t.taxablePaise = in.signedVarint();
+                t.taxPaise = in.signedVarint();
+            }
+        }
+    }
+    if (version >= 5) {
+        for (auto& h : out) {
+            uint64_t count = in.varint();
+            if (!in.ok || count > bytes.size()) return false;
+            h.stages.resize(count);
+        }
+        for (auto& h : out) {
+            for (auto& t : h.stages) {
+                t.stage = static_cast<int>(in.signedVarint());
+                t.offsetSeconds = in.signedVarint();
+            }
+        }
+    }
+    return in.ok;
+}
+
+// ---- Index and segment files ----
+
+/**
+ * @brief Loads the archive index without decompressing any segment.
+ * @return std::vector<ArchiveSegmentInfo> One entry per archive segment, ordered by month.
+ * @note Index lines are "key|minDate|maxDate|rows|subtotal|total|pending|completed|minId|maxId|bytes".
+ */
+std::vector<ArchiveSegmentInfo> loadArchiveIndex() {
+    std::vector<ArchiveSegmentInfo> list;
+    std::ifstream ifs(archiveIndexPath());
+    std::string ln;
+    while (std::getline(ifs, ln)) {
+        if (ln.empty()) continue;
+        std::istringstream ss(ln);
+        std::string f[11];
+        for (auto& field : f) std::getline(ss, field, '|');
+        try {
+            ArchiveSegmentInfo a;
+            a.summary = {f[0], f[1], f[2], std::stoi(f[3]), std::stod(f[4]), std::stod(f[5]),
+                         std::stoi(f[6]), std::stoi(f[7])};
+            a.minHistoryId = std::stoi(f[8]);
+            a.maxHistoryId = std::stoi(f[9]);
+            a.bytes = std::stoll(f[10]);
+            list.push_back(a);
+        } catch (...) {
+            continue; // Skip malformed
+        }
+    }
+    std::sort(list.begin(), list.end(), [](const ArchiveSegmentInfo& a, const ArchiveSegmentInfo& b) {
+        return a.summary.key < b.summary.key;
+    });
+    return list;
+}
+
+/**
+ * @brief Saves the archive index, replacing the existing file atomically.
+ * @param list The index entries to save.
+ * @return bool True if the new index is durable.
+ */
+static bool saveArchiveIndex(const std::vector<ArchiveSegmentInfo>& list) {
+    std::ostringstream out;
+    out << std::setprecision(17); // Round-trips the sums exactly; the default six digits drop the paise
+    for (const auto& a : list) {
+        const auto& s = a.summary;
+        out << s.key << '|' << s.minDate << '|' << s.maxDate << '|' << s.rows << '|' << s.subtotalSum << '|'
+            << s.totalSum << '|' << s.pendingCount << '|' << s.completedCount << '|'
+            << a.minHistoryId << '|' << a.maxHistoryId << '|' << a.bytes << '\n';
+    }
+    return replaceFileAtomically(archiveIndexPath(), out.str());
+}
+
+/**
+ * @brief Decompresses and returns the archived rows of one month.
+ * @param key The month key in "YYYY-MM" format.
+ * @return std::vector<ServiceHistory> The archived rows, or an empty vector if the segment is missing or corrupt.
+ */
+std::vector<ServiceHistory> loadArchiveSegment(const std::string& key) {
+    std::vector<ServiceHistory> rows;
+    std::ifstream ifs(archivePath(key), std::ios::binary);
+    if (!ifs) return rows;
+    std::ostringstream buf;
+    buf << ifs.rdbuf();
+    if (!decodeArchiveSegment(buf.str(), rows)) rows.clear();
+    return rows;
+}
+
+/**
+ * @brief Writes one month's archive segment and its sidecars.
+ * @param key The month key in "YYYY-MM" format.
+ * @param rows The month's rows, ordered by history ID.
+ * @param info Receives the segment's index entry.
+ * @return bool True if the segment is durable; the sidecars are rebuilt if they are lost.
+ */
+static bool writeArchiveSegment(const std::string& key, const std::vector<ServiceHistory>& rows, ArchiveSegmentInfo& info) {
+    std::string bytes = encodeArchiveSegment(rows);
+    if (!replaceFileAtomically(archivePath(key), bytes)) return false;
+    writeSegmentFilters(archiveFilterPath(key), buildSegmentFilters(rows));
+    writeSegmentSketches(archiveSketchPath(key), buildSegmentSketches(rows));
+    info.summary = emptyPartitionSummary(key);
+    for (const auto& h : rows) addToPartitionSummary(info.summary, h);
+    info.minHistoryId = rows.front().historyId;
+    info.maxHistoryId = rows.back().historyId;
+    info.bytes = static_cast<long long>(bytes.size());
+    return true;
+}
+
+/**
+ * @brief Moves closed (completed, delivered or cancelled) history rows dated before a cutoff into compressed archive segments.
+ * @param cutoffDate The cutoff date in "YYYY-MM-DD" format (exclusive).
+ * @return int The number of rows moved out of the hot history file.
+ * @note Rows are merged into any existing segment for their month. Each segment and the index replace the
+ *       old file atomically and are durable before the hot file is rewritten, so an interruption can only leave
+ *       a row in both tiers; the next run replaces the archived copy by ID, so reruns are idempotent. The data
+ *       file mutex is held throughout, so no change to the hot history is lost between reading it and rewriting
+ *       it. The run is published to the change feed, so standbys archive the
+ *       same rows at the same point in the feed.
+ */
+int archiveCompletedHistory(const std::string& cutoffDate) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    auto hot = loadHistory();
+    std::vector<ServiceHistory> keep;
+    std::map<std::string, std::vector<ServiceHistory>> moved;
+    long long ts;
+    for (const auto& h : hot) {
+        bool closed = isDoneStatus(h.status) || h.status == "Cancelled";
+        if (closed && h.dateTime.substr(0, 10) < cutoffDate && dateTimeToSeconds(h.dateTime, ts)) {
+            moved[partitionKeyFor(h.dateTime)].push_back(h);
+        } else {
+            keep.push_back(h);
+        }
+    }
+    if (moved.empty()) return 0;
+
+    std::error_code ec;
+    fs::create_directories(ARCHIVE_DIR, ec);
+    auto index = loadArchiveIndex();
+    int count = 0;
+    for (auto& m : moved) {
+        count += static_cast<int>(m.second.size());
+        // A run that failed part-way left some rows in both tiers; the hot copy replaces the archived one
+        std::set<int> incoming;
+        for (const auto& h : m.second) incoming.insert(h.historyId);
+        auto rows = loadArchiveSegment(m.first);
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [&](const ServiceHistory& h) {
+            return incoming.count(h.historyId) > 0;
+        }), rows.end());
+        rows.insert(rows.end(), m.second.begin(), m.second.end());
+        std::stable_sort(rows.begin(), rows.end(), [](const ServiceHistory& a, const ServiceHistory& b) {
+            return a.historyId < b.historyId;
+        });
+
+        ArchiveSegmentInfo info;
+        if (!writeArchiveSegment(m.first, rows, info)) {
+            std::cout << "Failed to write archive segment " << m.first << "; the hot history is unchanged.\n";
+            return 0;
+        }
+        index.erase(std::remove_if(index.begin(), index.end(), [&](const ArchiveSegmentInfo& a) {
+            return a.summary.key == m.first;
+        }), index.end());
+        index.push_back(info);
+    }
+    if (!saveArchiveIndex(index)) {
+        std::cout << "Failed to write the archive index; the hot history is unchanged.\n";
+        return 0;
+    }
+    saveHistory(keep);
+    flushChanges(publishChanges({{0, "archive", "run", "", cutoffDate}}));
+    return count;
+}
+
+/**
+ * @brief Replaces the whole archive with a set of rows, as copied from a primary.
+ * @param rows The archived rows, in any order.
+ * @return bool True if every segment and the index were written.
+ * @note Segments of months no longer present are removed after the new index is in place.
+ */
+bool replaceArchivedHistory(const std::vector<ServiceHistory>& rows) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::map<std::string, std::vector<ServiceHistory>> months;
+    for (const auto& h : rows) months[partitionKeyFor(h.dateTime)].push_back(h);
+    auto old = loadArchiveIndex();
+    if (months.empty() && old.empty()) return true;
+
+    std::error_code ec;
+    fs::create_directories(ARCHIVE_DIR, ec);
+    std::vector<ArchiveSegmentInfo> index;
+    for (auto& m : months) {
+        std::stable_sort(m.second.begin(), m.second.end(), [](const ServiceHistory& a, const ServiceHistory& b) {
+            return a.historyId < b.historyId;
+        });
+        ArchiveSegmentInfo info;
+        if (!writeArchiveSegment(m.first, m.second, info)) return false;
+        index.push_back(info);
+    }
+    if (!saveArchiveIndex(index)) return false;
+    for (const auto& a : old) {
+        if (months.count(a.summary.key)) continue;
+        fs::remove(archivePath(a.summary.key), ec);
+        fs::remove(archiveFilterPath(a.summary.key), ec);
+        fs::remove(archiveSketchPath(a.summary.key), ec);
+    }
+    return true;
+}
+
+/**
+ * @brief Loads archived rows whose date falls within an inclusive date range.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<ServiceHistory> Matching rows, ordered by month and then history ID.
+ * @note Only segments whose indexed date span overlaps the range are decompressed, in parallel on the thread pool.
+ */
+std::vector<ServiceHistory> loadArchivedHistoryBetween(const std::string& from, const std::string& to) {
+    std::vector<std::string> keys;
+    for (const auto& a : loadArchiveIndex()) {
+        const auto& s = a.summary;
+        if (s.rows == 0 || s.maxDate.substr(0, 10) < from || s.minDate.substr(0, 10) > to) continue;
+        keys.push_back(s.key);
+    }
+    std::vector<std::vector<ServiceHistory>> parts(keys.size());
+    parallelFor(keys.size(), [&](size_t i) {
+        for (const auto& h : loadArchiveSegment(keys[i])) {
+            std::string d = h.dateTime.substr(0, 10);
+            if (d >= from && d <= to) parts[i].push_back(h);
+        }
+    });
+    std::vector<ServiceHistory> list;
+    for (const auto& part : parts) list.insert(list.end(), part.begin(), part.end());
+    return list;
+}
+
+/**
+ * @brief Finds archived rows with a given history, customer or vehicle ID.
+ * @param key The column to match.
+ * @param value The value to match.
+ * @return std::vector<ServiceHistory> Matching rows, ordered by month.
+ * @note History ID lookups first use the indexed ID range; every lookup then probes the segment's
+ *       Bloom filters, so only segments that may hold the value are decompressed.
+ */
+std::vector<ServiceHistory> findArchivedRows(HistoryKey key, int value) {
+    std::vector<ServiceHistory> list;
+    for (const auto& a : loadArchiveIndex()) {
+        if (key == HistoryKey::HistoryId && (value < a.minHistoryId || value > a.maxHistoryId)) continue;
+        SegmentFilters f;
+        if (loadSegmentFilters(archiveFilterPath(a.summary.key), f) && !segmentMightContain(f, key, value)) continue;
+        countHistorySegmentRead();
+        for (const auto& h : loadArchiveSegment(a.summary.key)) {
+            if (historyKeyMatches(h, key, value)) list.push_back(h);
+        }
+    }
+    return list;
+}
+
+/**
+ * @brief Finds an archived history entry by ID.
+ * @param historyId The history ID to look up.
+ * @param out Receives the entry if found.
+ * @return bool True if the entry was found in the archive.
+ * @note Only segments whose ID range and Bloom filter admit the ID are decompressed.
+ */
+bool findArchivedHistory(int historyId, ServiceHistory& out) {
+    auto rows = findArchivedRows(HistoryKey::HistoryId, historyId);
+    if (rows.empty()) return false;
+    out = rows.back();
+    return true;
+}
+
+/**
+ * @brief Returns the largest history ID stored in the archive.
+ * @return int The largest archived history ID, or 0 if the archive is empty.
+ * @note Reads the index only.
+ */
+int archivedMaxHistoryId() {
+    int maxId = 0;
+    for (const auto& a : loadArchiveIndex()) maxId = std::max(maxId, a.maxHistoryId);
+    return maxId;
+}
+
+/**
+ * @brief Interactively archives completed history older than a cutoff date.
+ * @note Prompts for the cutoff date and reports how many rows were archived and the archive size.
+ */
+void archiveHistoryInteractive() {
+    std::string cutoff;
+    std::cout << "Archive completed services before date (YYYY-MM-DD): ";
+    std::getline(std::cin, cutoff);
+    int count = archiveCompletedHistory(cutoff);
+    long long bytes = 0;
+    for (const auto& a : loadArchiveIndex()) bytes += a.bytes;
+    std::cout << "Archived " << count << " entries. Archive size: " << bytes << " bytes.\n";
+}
@@ -0,0 +1,119 @@
+// HistoryArchive.h
+#ifndef HISTORY_ARCHIVE_H
+#define HISTORY_ARCHIVE_H
+
+#include <string>
+#include <vector>
+#include "Service.h"
+#include "HistoryPartition.h"
+
+/**
+ * @brief Index entry describing one compressed archive segment.
+ */
+struct ArchiveSegmentInfo {
+    PartitionSummary summary;   /**< Month key, date span, row count, revenue sums and status counts. */
+    int minHistoryId;           /**< Smallest history ID stored in the segment. */
+    int maxHistoryId;           /**< Largest history ID stored in the segment. */
+    long long bytes;            /**< Size of the compressed segment file in bytes. */
+};
+
+/**
+ * @brief Converts a "YYYY-MM-DD HH:MM:SS" dateTime to seconds since 1970-01-01 00:00:00.
+ * @param dateTime The dateTime string.
+ * @param out Receives the number of seconds.
+ * @return bool True if the dateTime is well formed.
+ */
+bool dateTimeToSeconds(const std::string& dateTime, long long& out);
+
+/**
+ * @brief Converts seconds since 1970-01-01 00:00:00 back to a "YYYY-MM-DD HH:MM:SS" dateTime.
+ * @param seconds The number of seconds.
+ * @return std::string The formatted dateTime.
+ */
+std::string secondsToDateTime(long long seconds);
+
+/**
+ * @brief Encodes a month of history rows into a compressed archive segment.
+ * @param rows The rows to encode, all from the same month.
+ * @return std::string The encoded segment bytes.
+ */
+std::string encodeArchiveSegment(const std::vector<ServiceHistory>& rows);
+
+/**
+ * @brief Decodes a compressed archive segment.
+ * @param bytes The encoded segment bytes.
+ * @param out Receives the decoded rows.
+ * @return bool True if the segment was decoded, false if it is corrupt or of an unknown format.
+ */
+bool decodeArchiveSegment(const std::string& bytes, std::vector<ServiceHistory>& out);
+
+/**
+ * @brief Moves closed (completed, delivered or cancelled) history rows dated before a cutoff into compressed archive segments.
+ * @param cutoffDate The cutoff date in "YYYY-MM-DD" format (exclusive).
+ * @return int The number of rows moved out of the hot history file.
+ */
+int archiveCompletedHistory(const std::string& cutoffDate);
+
+/**
+ * @brief Replaces the whole archive with a set of rows, as copied from a primary.
+ * @param rows The archived rows, in any order.
+ * @return bool True if every segment and the index were written.
+ */
+bool replaceArchivedHistory(const std::vector<ServiceHistory>& rows);
+
+/**
+ * @brief Loads the archive index without decompressing any segment.
+ * @return std::vector<ArchiveSegmentInfo> One entry per archive segment, ordered by month.
+ */
+std::vector<ArchiveSegmentInfo> loadArchiveIndex();
+
+/**
+ * @brief Decompresses and returns the archived rows of one month.
+ * @param key The month key in "YYYY-MM" format.
+ * @return std::vector<ServiceHistory> The archived rows, or an empty vector if there is no such segment.
+ */
+std::vector<ServiceHistory> loadArchiveSegment(const std::string& key);
+
+/**
+ * @brief Builds the distinct-count sketch sidecar path for an archive segment.
+ * @param key The month key in "YYYY-MM" format.
+ * @return std::string The path of the ".hll" file.
+ */
+std::string archiveSketchPath(const std::string& key);
+
+/**
+ * @brief Loads archived rows whose date falls within an inclusive date range.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<ServiceHistory> Matching rows; only overlapping segments are decompressed.
+ */
+std::vector<ServiceHistory> loadArchivedHistoryBetween(const std::string& from, const std::string& to);
+
+/**
+ * @brief Finds an archived history entry by ID.
+ * @param historyId The history ID to look up.
+ * @param out Receives the entry if found.
+ * @return bool True if the entry was found in the archive.
+ */
+bool findArchivedHistory(int historyId, ServiceHistory& out);
+
+/**
+ * @brief Finds archived rows with a given history, customer or vehicle ID.
+ * @param key The column to match.
+ * @param value The value to match.
+ * @return std::vector<ServiceHistory> Matching rows; segments ruled out by their Bloom filters are not decompressed.
+ */
+std::vector<ServiceHistory> findArchivedRows(HistoryKey key, int value);
+
+/**
+ * @brief Returns the largest history ID stored in the archive.
+ * @return int The largest archived history ID, or 0 if the archive is empty.
+ */
+int archivedMaxHistoryId();
+
+/**
+ * @brief Interactively archives completed history older than a cutoff date.
+ */
+void archiveHistoryInteractive();
+
+#endif // HISTORY_ARCHIVE_H
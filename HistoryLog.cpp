@@ -0,0 +1,573 @@
+// HistoryLog.cpp (implementation)
+#include "HistoryLog.h"
+#include "HistoryPartition.h"
+#include "HistoryArchive.h"
+#include "Lifecycle.h"
+#include "Snapshot.h"
+#include "Storage.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+#ifdef TEST_MODE
+const std::string LOG_HISTORY_FILE = "tests/test_service_history.txt";
+const std::string HISTORY_LOG_FILE = "tests/test_history.wal";
+#else
+const std::string LOG_HISTORY_FILE = "service_history.txt";
+const std::string HISTORY_LOG_FILE = "history.wal";
+#endif
+
+/**
+ * @brief Size of the "#LOG|<16 hex digits>\n" header that opens every log.
+ */
+const size_t LOG_HEADER_BYTES = 22;
+
+/**
+ * @brief What the log currently appended to was checked against, so appends need not re-read the history file.
+ * @note Guarded by historyLogMutex().
+ */
+struct LogState {
+    bool known = false;     /**< Whether the fields below are current. */
+    FileStamp baseStamp{};  /**< Stamp of the history file when the log header was checked. */
+};
+static LogState logState;
+
+/**
+ * @brief Records waiting to be written together, and the outcome once they are.
+ */
+struct HistoryLogBatch {
+    std::string data;   /**< The batched records, each followed by a newline. */
+    int records = 0;    /**< Number of records in data. */
+    bool done = false;  /**< Whether the batch has been written (or has failed). */
+    bool ok = false;    /**< Whether the batch was written and synced. */
+};
+
+// Group commit state, guarded by commitMutex
+static std::mutex commitMutex;
+static std::condition_variable commitDone;
+static std::shared_ptr<HistoryLogBatch> openBatch;      // Collecting records; written by the next leader
+static std::shared_ptr<HistoryLogBatch> flushingBatch;  // Being written by the current leader
+static HistoryLogCommitStats commitStats{0, 0, 0};
+
+static std::atomic<int> failpoint{static_cast<int>(CheckpointFailpoint::None)};
+
+/**
+ * @brief Exits the process immediately if a test armed this failpoint.
+ */
+static void crashAt(CheckpointFailpoint point) {
+    if (failpoint == static_cast<int>(point)) std::_Exit(3);
+}
+
+/**
+ * @brief Makes the next checkpoint exit the process at the given point (test hook).
+ * @param point The failpoint; CheckpointFailpoint::None disables it.
+ */
+void setCheckpointFailpoint(CheckpointFailpoint point) {
+    failpoint = static_cast<int>(point);
+}
+
+/**
+ * @brief Mutex held while the history log file is written, replaced or read.
+ * @return std::mutex& The history log mutex.
+ */
+std::mutex& historyLogMutex() {
+    static std::mutex m;
+    return m;
+}
+
+/**
+ * @brief Returns the path of the history log.
+ * @return const std::string& The log path.
+ */
+const std::string& historyLogPath() {
+    return HISTORY_LOG_FILE;
+}
+
+static std::string readFile(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::ostringstream buf;
+    buf << ifs.rdbuf();
+    return buf.str();
+}
+
+/**
+ * @brief Computes a 64-bit fingerprint of a history file's content, eight bytes at a time.
+ */
+static uint64_t fingerprint(const std::string& content) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ content.size();
+    size_t i = 0;
+    for (; i + 8 <= content.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, content.data() + i, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    uint64_t w = 0;
+    std::memcpy(&w, content.data() + i, content.size() - i);
+    h = (h ^ w) * 0xC4CEB9FE1A85EC53ULL;
+    return h ^ (h >> 29);
+}
+
+static std::string logHeader(uint64_t fp) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "#LOG|%016llx\n", static_cast<unsigned long long>(fp));
+    return buf;
+}
+
+/**
+ * @brief Returns the complete records of a log (header and any torn final line removed).
+ */
+static std::string logBody(const std::string& log) {
+    size_t end = log.rfind('\n');
+    if (end == std::string::npos || end < LOG_HEADER_BYTES) return "";
+    return log.substr(LOG_HEADER_BYTES, end + 1 - LOG_HEADER_BYTES);
+}
+
+static int countRecords(const std::string& body) {
+    int n = 0;
+    for (char c : body) n += c == '\n';
+    return n;
+}
+
+/**
+ * @brief Finds the log written for a history file with the given fingerprint.
+ * @param fp The fingerprint of the history file.
+ * @param body Receives the complete records of the matching log.
+ * @return bool True if the log (or a staged log left by an interrupted checkpoint) matches.
+ */
+static bool logBodyFor(uint64_t fp, std::string& body) {
+    std::string header = logHeader(fp);
+    for (const std::string& path : {HISTORY_LOG_FILE, HISTORY_LOG_FILE + ".next"}) {
+        std::string log = readFile(path);
+        if (log.compare(0, header.size(), header) == 0) {
+            body = logBody(log);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Builds the log record for a new booking.
+ * @param h The history entry.
+ * @return std::string The record, "I|" followed by the history file line.
+ */
+std::string historyInsertRecord(const ServiceHistory& h) {
+    return "I|" + formatHistoryLine(h);
+}
+
+/**
+ * @brief Builds the log record for a status change.
+ * @param historyId The history ID.
+ * @param status The new status.
+ * @param at When the change happened, in "YYYY-MM-DD HH:MM:SS" format.
+ * @return std::string The record, "S|id|status|at".
+ */
+std::string historyStatusRecord(int historyId, const std::string& status, const std::string& at) {
+    return "S|" + std::to_string(historyId) + '|' + status + '|' + at;
+}
+
+/**
+ * @brief Sets a row's status and, when the change carries a time, records when the row reached the stage.
+ * @note A stage is recorded once, so replaying a record again leaves the row unchanged.
+ */
+static void applyStatus(ServiceHistory& h, const std::string& status, const std::string& at) {
+    h.status = status;
+    JobStage stage;
+    long long booked, reached;
+    if (at.empty() || !parseJobStage(status, stage) || stage == JobStage::Booked) return;
+    if (!dateTimeToSeconds(h.dateTime, booked) || !dateTimeToSeconds(at, reached)) return;
+    for (const auto& t : h.stages) {
+        if (t.stage == static_cast<int>(stage)) return;
+    }
+    h.stages.push_back({static_cast<int>(stage), reached - booked});
+}
+
+/**
+ * @brief Applies one record, using an ID-to-position index if one is supplied.
+ */
+static bool applyRecord(std::vector<ServiceHistory>& list, const std::string& record,
+                        std::unordered_map<int, size_t>* index) {
+    if (record.size() < 2 || record[1] != '|') return false;
+    auto find = [&](int id) -> ServiceHistory* {
+        if (index) {
+            auto it = index->find(id);
+            return it == index->end() ? nullptr : &list[it->second];
+        }
+        for (size_t i = list.size(); i-- > 0;) {
+            if (list[i].historyId == id) return &list[i]; // Last occurrence wins, as in findHistoryById
+        }
+        return nullptr;
+    };
+    if (record[0] == 'I') {
+        ServiceHistory h;
+        if (!parseHistoryLine(record.substr(2), h)) return false;
+        if (ServiceHistory* existing = find(h.historyId)) {
+            *existing = h; // Already folded into the history file by an interrupted checkpoint
+        } else {
+            list.push_back(h);
+            if (index) (*index)[h.historyId] = list.size() - 1;
+        }
+        return true;
+    }
+    if (record[0] == 'S') {
+        size_t bar = record.find('|', 2);
+        if (bar == std::string::npos) return false;
+        try {
+            int id = std::stoi(record.substr(2, bar - 2));
+            size_t timeBar = record.find('|', bar + 1); // Records written before stage times end at the status
+            std::string status = record.substr(bar + 1, timeBar == std::string::npos ? std::string::npos : timeBar - bar - 1);
+            std::string at = timeBar == std::string::npos ? "" : record.substr(timeBar + 1);
+            if (ServiceHistory* existing = find(id)) applyStatus(*existing, status, at);
+        } catch (...) {
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Applies one log record to an in-memory history list.
+ * @param list The history list.
+ * @param record The record.
+ * @return bool True if the record was well formed.
+ */
+bool applyHistoryRecord(std::vector<ServiceHistory>& list, const std::string& record) {
+    return applyRecord(list, record, nullptr);
+}
+
+/**
+ * @brief Replays the history log on top of rows parsed from the history file.
+ * @param baseContent The exact content of the history file the rows came from.
+ * @param list The parsed rows; log records are applied in order.
+ * @return int The number of records applied.
+ * @note The log header carries the fingerprint of the history file it extends. A log written for another
+ *       version of the file (for example one a checkpoint already folded in) is ignored. Records still
+ *       waiting in a group commit batch are applied as well, so every loader sees each change it could
+ *       have observed through the cache; applying one twice is harmless.
+ */
+int replayHistoryLog(const std::string& baseContent, std::vector<ServiceHistory>& list) {
+    std::string body;
+    logBodyFor(fingerprint(baseContent), body);
+    {
+        std::lock_guard<std::mutex> lock(commitMutex);
+        if (flushingBatch) body += flushingBatch->data;
+        if (openBatch) body += openBatch->data;
+    }
+    if (body.empty()) return 0;
+    std::unordered_map<int, size_t> index;
+    for (size_t i = 0; i < list.size(); ++i) index[list[i].historyId] = i;
+    int applied = 0;
+    std::istringstream in(body);
+    std::string record;
+    while (std::getline(in, record)) {
+        if (applyRecord(list, record, &index)) applied++;
+    }
+    return applied;
+}
+
+/**
+ * @brief Writes a batch of records to the log and syncs it; the caller holds historyLogMutex().
+ * @param data The records, each followed by a newline.
+ * @return bool True once the records are durable.
+ * @note The log header is checked against the history file only when the file's stamp changes, so a
+ *       steady stream of batches costs one append and one sync each.
+ */
+static bool writeLogBatch(const std::string& data) {
+    FileStamp baseStamp = fileStamp(LOG_HISTORY_FILE);
+    if (!logState.known || logState.baseStamp != baseStamp || !fs::exists(HISTORY_LOG_FILE)) {
+        std::string header = logHeader(fingerprint(readFile(LOG_HISTORY_FILE)));
+        std::string log = readFile(HISTORY_LOG_FILE);
+        if (log.compare(0, header.size(), header) != 0) {
+            if (!writeFileDurably(HISTORY_LOG_FILE, header)) return false; // Stale or missing: start afresh
+        } else if (log.back() != '\n') {
+            if (!writeFileDurably(HISTORY_LOG_FILE, header + logBody(log))) return false; // Drop a torn record
+        }
+        logState = {true, baseStamp};
+    }
+    return appendFileDurably(HISTORY_LOG_FILE, data);
+}
+
+/**
+ * @brief Adds a record to the batch the next group commit will write.
+ * @param record The record.
+ * @return std::shared_ptr<HistoryLogBatch> The batch, to pass to waitHistoryLogDurable().
+ */
+std::shared_ptr<HistoryLogBatch> enqueueHistoryLog(const std::string& record) {
+    std::lock_guard<std::mutex> lock(commitMutex);
+    if (!openBatch) openBatch = std::make_shared<HistoryLogBatch>();
+    openBatch->data += record + '\n';
+    openBatch->records++;
+    return openBatch;
+}
+
+/**
+ * @brief Waits until a batch is durable, writing it (and everything queued with it) if no one else is.
+ * @param batch A batch returned by enqueueHistoryLog().
+ * @return bool True if the batch was written and synced.
+ * @note The first waiter to find no write in progress becomes the leader: it takes the open batch, writes
+ *       it with one append and one sync, and wakes the others. Records queued while it writes form the
+ *       next batch, so under load many bookings share each sync.
+ */
+bool waitHistoryLogDurable(const std::shared_ptr<HistoryLogBatch>& batch) {
+    std::unique_lock<std::mutex> lock(commitMutex);
+    commitDone.wait(lock, [&] { return batch->done || !flushingBatch; });
+    if (batch->done) return batch->ok;
+
+    flushingBatch = openBatch; // Not done and nothing in flight, so ours is the open batch
+    openBatch.reset();
+    lock.unlock();
+    bool ok;
+    {
+        std::lock_guard<std::mutex> file(historyLogMutex());
+        ok = writeLogBatch(flushingBatch->data);
+        if (ok) refreshCachedLogStamp<ServiceHistory>(); // The cache already holds these records
+    }
+    if (!ok) invalidateCachedTable<ServiceHistory>(); // The cache holds records that never reached the log
+    lock.lock();
+    flushingBatch->ok = ok;
+    flushingBatch->done = true;
+    commitStats.records += flushingBatch->records;
+    commitStats.batches++;
+    commitStats.largestBatch = std::max<long long>(commitStats.largestBatch, flushingBatch->records);
+    flushingBatch.reset();
+    commitDone.notify_all();
+    return ok;
+}
+
+/**
+ * @brief Appends a record to the history log and waits until it is synced to disk.
+ * @param record The record.
+ * @return bool True once the record is durable.
+ */
+bool appendHistoryLog(const std::string& record) {
+    return waitHistoryLogDurable(enqueueHistoryLog(record));
+}
+
+/**
+ * @brief Writes any queued records and waits for a write in progress to finish.
+ * @note Called with dataFileMutex() held before the log is read for a checkpoint or replaced; bookings
+ *       queue under that mutex, so nothing new can join once this returns.
+ */
+static void flushHistoryLog() {
+    std::shared_ptr<HistoryLogBatch> pending;
+    {
+        std::lock_guard<std::mutex> lock(commitMutex);
+        pending = openBatch;
+    }
+    if (pending) waitHistoryLogDurable(pending);
+    std::lock_guard<std::mutex> file(historyLogMutex()); // Waits out a leader still writing an earlier batch
+}
+
+/**
+ * @brief Returns group commit counters since the process started.
+ * @return HistoryLogCommitStats Records written, batches (one append and sync each) and the largest batch.
+ */
+HistoryLogCommitStats historyLogCommitStats() {
+    std::lock_guard<std::mutex> lock(commitMutex);
+    return commitStats;
+}
+
+/**
+ * @brief Installs a history file already written to "<file>.tmp" and resets the log to match it.
+ * @param fp The fingerprint of the staged content.
+ * @param carried Complete records to keep in the new log.
+ * @return bool True if the staged file was installed.
+ * @note The new log is staged first, then the history file is renamed into place, then the log. Readers
+ *       accept either log whose header matches the installed file, so every crash point is recoverable.
+ */
+static bool commitStagedBase(uint64_t fp, const std::string& carried) { // Caller holds historyLogMutex()
+    std::error_code ec;
+    if (!writeFileDurably(HISTORY_LOG_FILE + ".next", logHeader(fp) + carried)) {
+        fs::remove(LOG_HISTORY_FILE + ".tmp", ec);
+        return false;
+    }
+    crashAt(CheckpointFailpoint::AfterLogStaged);
+    fs::rename(LOG_HISTORY_FILE + ".tmp", LOG_HISTORY_FILE, ec);
+    if (ec) {
+        fs::remove(LOG_HISTORY_FILE + ".tmp", ec);
+        fs::remove(HISTORY_LOG_FILE + ".next", ec);
+        return false;
+    }
+    crashAt(CheckpointFailpoint::AfterBaseInstalled);
+    fs::rename(HISTORY_LOG_FILE + ".next", HISTORY_LOG_FILE, ec);
+    logState = {!ec, fileStamp(LOG_HISTORY_FILE)};
+    return true;
+}
+
+/**
+ * @brief Installs new history file content and resets the log to match it.
+ * @param content The new history file content.
+ * @param keepLogRecords True to carry the current log records over.
+ * @return bool True if the new content was installed.
+ */
+bool installHistoryBase(const std::string& content, bool keepLogRecords) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    flushHistoryLog();
+    std::lock_guard<std::mutex> file(historyLogMutex());
+    std::string carried;
+    if (keepLogRecords) logBodyFor(fingerprint(readFile(LOG_HISTORY_FILE)), carried);
+    if (!writeFileDurably(LOG_HISTORY_FILE + ".tmp", content)) return false;
+    return commitStagedBase(fingerprint(content), carried);
+}
+
+/**
+ * @brief Returns the current size of the history log in bytes.
+ * @return long long The size, or 0 if there is no log.
+ */
+long long historyLogBytes() {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(HISTORY_LOG_FILE, ec);
+    return ec ? 0 : static_cast<long long>(size);
+}
+
+/**
+ * @brief Folds the history log into the history file and truncates the log.
+ * @return CheckpointReport What was folded and carried over.
+ * @note Three phases: under the lock, take the current rows and the log length; without the lock, format
+ *       and sync the new history file beside the old one; under the lock again, carry over any records
+ *       appended meanwhile and install. If the history file was replaced in between (a full save, archive
+ *       or compaction) the pass is abandoned, since that replacement already reset the log.
+ */
+CheckpointReport checkpointHistory() {
+    CheckpointReport r{false, 0, 0, 0, 0};
+    std::vector<ServiceHistory> list;
+    FileStamp baseStamp;
+    std::string logAtStart;
+    {
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        flushHistoryLog();
+        list = loadHistory();
+        std::lock_guard<std::mutex> file(historyLogMutex());
+        baseStamp = fileStamp(LOG_HISTORY_FILE);
+        logAtStart = readFile(HISTORY_LOG_FILE);
+        r.logBytesBefore = static_cast<long long>(logAtStart.size());
+        r.recordsFolded = countRecords(logBody(logAtStart));
+        if (r.recordsFolded == 0) return r;
+    }
+
+    std::string content;
+    for (const auto& h : list) content += formatHistoryLine(h) + '\n';
+    std::error_code ec;
+    if (!writeFileDurably(LOG_HISTORY_FILE + ".tmp", content)) {
+        fs::remove(LOG_HISTORY_FILE + ".tmp", ec);
+        return r;
+    }
+    crashAt(CheckpointFailpoint::AfterBaseStaged);
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        flushHistoryLog();
+        if (fileStamp(LOG_HISTORY_FILE) != baseStamp) {
+            fs::remove(LOG_HISTORY_FILE + ".tmp", ec);
+            return r;
+        }
+        flushHistoryPartitions(); // The log is about to drop records the segments may still miss
+        std::vector<ServiceHistory> current = loadHistory();
+        std::lock_guard<std::mutex> file(historyLogMutex());
+        std::string log = readFile(HISTORY_LOG_FILE);
+        std::string tail;
+        size_t end = log.rfind('\n');
+        if (end != std::string::npos && end + 1 > logAtStart.size()) tail = log.substr(logAtStart.size(), end + 1 - logAtStart.size());
+        r.recordsCarried = countRecords(tail);
+        if (!commitStagedBase(fingerprint(content), tail)) return r;
+        storeCachedTable(LOG_HISTORY_FILE, current, HISTORY_LOG_FILE);
+        r.logBytesAfter = historyLogBytes();
+        r.ran = true;
+    }
+    writeSnapshotImage();
+    return r;
+}
+
+/**
+ * @brief Repairs the history file and log after a crash, then checkpoints any logged records.
+ * @return int The number of log records found and folded into the history file.
+ * @note A staged history file that was never installed is discarded. A staged log is adopted if it matches
+ *       the installed history file, otherwise discarded. The partitions are rebuilt afterwards because
+ *       the crash may have come between a log append and the matching partition refresh.
+ */
+int recoverHistoryLog() {
+    int records = 0;
+    {
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        flushHistoryLog();
+        std::lock_guard<std::mutex> file(historyLogMutex());
+        std::error_code ec;
+        fs::remove(LOG_HISTORY_FILE + ".tmp", ec);
+        uint64_t fp = fingerprint(readFile(LOG_HISTORY_FILE));
+        if (fs::exists(HISTORY_LOG_FILE + ".next", ec)) {
+            std::string header = logHeader(fp);
+            if (readFile(HISTORY_LOG_FILE + ".next").compare(0, header.size(), header) == 0) {
+                fs::rename(HISTORY_LOG_FILE + ".next", HISTORY_LOG_FILE, ec);
+            } else {
+                fs::remove(HISTORY_LOG_FILE + ".next", ec);
+            }
+        }
+        logState.known = false;
+        std::string body;
+        if (logBodyFor(fp, body)) records = countRecords(body);
+    }
+    if (records > 0) {
+        checkpointHistory();
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        writeHistoryPartitions(loadHistory());
+    }
+    return records;
+}
+
+// 📌 Background Checkpointer
+
+static std::thread checkpointer;
+static std::mutex checkpointerMutex;
+static std::condition_variable checkpointerWake;
+static bool checkpointerStop = false;
+
+/**
+ * @brief Starts a background thread that checkpoints when the log grows too large or too old.
+ * @param maxLogBytes Checkpoint once the log reaches this size.
+ * @param maxIntervalSeconds Checkpoint a non-empty log at least this often.
+ * @note The log size is polled once a second; a running checkpointer is stopped and replaced.
+ */
+void startHistoryCheckpointer(long long maxLogBytes, int maxIntervalSeconds) {
+    stopHistoryCheckpointer();
+    checkpointerStop = false;
+    checkpointer = std::thread([maxLogBytes, maxIntervalSeconds] {
+        auto last = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(checkpointerMutex);
+        while (!checkpointerWake.wait_for(lock, std::chrono::seconds(1), [] { return checkpointerStop; })) {
+            long long bytes = historyLogBytes();
+            if (bytes <= static_cast<long long>(LOG_HEADER_BYTES)) continue; // Nothing logged
+            bool due = bytes >= maxLogBytes ||
+                       std::chrono::steady_clock::now() - last >= std::chrono::seconds(maxIntervalSeconds);
+            if (!due) continue;
+            lock.unlock();
+            checkpointHistory();
+            lock.lock();
+            last = std::chrono::steady_clock::now();
+        }
+    });
+}
+
+/**
+ * @brief Stops the background checkpointer, waiting for a running checkpoint to finish.
+ */
+void stopHistoryCheckpointer() {
+    {
+        std::lock_guard<std::mutex> lock(checkpointerMutex);
+        checkpointerStop = true;
+    }
+    checkpointerWake.notify_all();
+    if (checkpointer.joinable()) checkpointer.join();
+}
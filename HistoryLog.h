@@ -0,0 +1,183 @@
+// HistoryLog.h
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Service.h"
+
+/**
+ * @brief Log size at which the background checkpointer folds the log into the history file.
+ */
+const long long HISTORY_LOG_CHECKPOINT_BYTES = 1 << 20;
+
+/**
+ * @brief Longest time in seconds a logged record waits before the background checkpointer folds it in.
+ */
+const int HISTORY_LOG_CHECKPOINT_SECONDS = 300;
+
+/**
+ * @brief Outcome of one checkpoint of the history log into the history file.
+ */
+struct CheckpointReport {
+    bool ran;                   /**< False if the log was empty or the history file changed during the pass. */
+    int recordsFolded;          /**< Log records folded into the history file. */
+    int recordsCarried;         /**< Records appended while the checkpoint ran, kept in the new log. */
+    long long logBytesBefore;   /**< Log size when the checkpoint started. */
+    long long logBytesAfter;    /**< Log size after truncation. */
+};
+
+/**
+ * @brief Group commit counters since the process started.
+ */
+struct HistoryLogCommitStats {
+    long long records;      /**< Records written to the log. */
+    long long batches;      /**< Batches written, each with one append and one sync. */
+    long long largestBatch; /**< Most records written by a single batch. */
+};
+
+/**
+ * @brief Records queued for the same log append and sync (opaque).
+ */
+struct HistoryLogBatch;
+
+/**
+ * @brief Points inside a checkpoint at which a test can make the process exit, simulating a crash.
+ */
+enum class CheckpointFailpoint {
+    None,               /**< Run to completion. */
+    AfterBaseStaged,    /**< The new history file is written beside the old one but not installed. */
+    AfterLogStaged,     /**< The truncated log is written beside the old one as well. */
+    AfterBaseInstalled  /**< The new history file is installed but the old log is still in place. */
+};
+
+/**
+ * @brief Mutex held while the history log file is written, replaced or read.
+ * @return std::mutex& The history log mutex.
+ * @note Always taken after dataFileMutex(), never before it.
+ */
+std::mutex& historyLogMutex();
+
+/**
+ * @brief Returns the path of the history log.
+ * @return const std::string& The log path.
+ */
+const std::string& historyLogPath();
+
+/**
+ * @brief Builds the log record for a new booking.
+ * @param h The history entry.
+ * @return std::string The record (without the trailing newline).
+ */
+std::string historyInsertRecord(const ServiceHistory& h);
+
+/**
+ * @brief Builds the log record for a status change.
+ * @param historyId The history ID.
+ * @param status The new status.
+ * @param at When the change happened, in "YYYY-MM-DD HH:MM:SS" format; recorded as the time the job reached
+ *           the new stage.
+ * @return std::string The record (without the trailing newline).
+ */
+std::string historyStatusRecord(int historyId, const std::string& status, const std::string& at = currentDateTime());
+
+/**
+ * @brief Applies one log record to an in-memory history list.
+ * @param list The history list.
+ * @param record The record.
+ * @return bool True if the record was well formed.
+ * @note Records assign full state, so replaying a record the list already reflects changes nothing.
+ */
+bool applyHistoryRecord(std::vector<ServiceHistory>& list, const std::string& record);
+
+/**
+ * @brief Replays the history log on top of rows parsed from the history file.
+ * @param baseContent The exact content of the history file the rows came from.
+ * @param list The parsed rows; log records are applied in order.
+ * @return int The number of records applied (0 if the log belongs to a different history file).
+ * @note The caller holds historyLogMutex(). Records queued for a group commit are applied too.
+ */
+int replayHistoryLog(const std::string& baseContent, std::vector<ServiceHistory>& list);
+
+/**
+ * @brief Adds a record to the batch the next group commit will write.
+ * @param record The record.
+ * @return std::shared_ptr<HistoryLogBatch> The batch, to pass to waitHistoryLogDurable().
+ * @note Records reach the log in the order they are queued.
+ */
+std::shared_ptr<HistoryLogBatch> enqueueHistoryLog(const std::string& record);
+
+/**
+ * @brief Waits until a batch is durable, writing it (and everything queued with it) if no one else is.
+ * @param batch A batch returned by enqueueHistoryLog().
+ * @return bool True if the batch was written and synced.
+ * @note Concurrent callers share one append and one sync per batch (group commit).
+ */
+bool waitHistoryLogDurable(const std::shared_ptr<HistoryLogBatch>& batch);
+
+/**
+ * @brief Appends a record to the history log and waits until it is synced to disk.
+ * @param record The record.
+ * @return bool True once the record is durable.
+ * @note A log left over from a different history file is replaced.
+ */
+bool appendHistoryLog(const std::string& record);
+
+/**
+ * @brief Returns group commit counters since the process started.
+ * @return HistoryLogCommitStats Records written, batches and the largest batch.
+ */
+HistoryLogCommitStats historyLogCommitStats();
+
+/**
+ * @brief Installs new history file content and resets the log to match it.
+ * @param content The new history file content.
+ * @param keepLogRecords True to carry the current log records over (the content must already reflect them).
+ * @return bool True if the new content was installed.
+ * @note Runs under dataFileMutex(). A crash at any point leaves either the old file with the old log or the
+ *       new file with the new log.
+ */
+bool installHistoryBase(const std::string& content, bool keepLogRecords);
+
+/**
+ * @brief Returns the current size of the history log in bytes.
+ * @return long long The size, or 0 if there is no log.
+ */
+long long historyLogBytes();
+
+/**
+ * @brief Folds the history log into the history file and truncates the log.
+ * @return CheckpointReport What was folded and carried over.
+ * @note The new history file is formatted and written without holding dataFileMutex(); the lock is held only
+ *       to take the starting state and to install the result, so bookings are paused for a few renames.
+ */
+CheckpointReport checkpointHistory();
+
+/**
+ * @brief Repairs the history file and log after a crash, then checkpoints any logged records.
+ * @return int The number of log records found and folded into the history file.
+ * @note Call once at startup, before the first booking.
+ */
+int recoverHistoryLog();
+
+/**
+ * @brief Starts a background thread that checkpoints when the log grows too large or too old.
+ * @param maxLogBytes Checkpoint once the log reaches this size.
+ * @param maxIntervalSeconds Checkpoint a non-empty log at least this often.
+ */
+void startHistoryCheckpointer(long long maxLogBytes, int maxIntervalSeconds);
+
+/**
+ * @brief Stops the background checkpointer, waiting for a running checkpoint to finish.
+ */
+void stopHistoryCheckpointer();
+
+/**
+ * @brief Makes the next checkpoint exit the process at the given point (test hook).
+ * @param point The failpoint; CheckpointFailpoint::None disables it.
+ */
+void setCheckpointFailpoint(CheckpointFailpoint point);
+
+#endif // HISTORY_LOG_H
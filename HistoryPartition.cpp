@@ -0,0 +1,733 @@
+// HistoryPartition.cpp (implementation)
+#include "HistoryPartition.h"
+#include "Lifecycle.h"
+#include "HistoryArchive.h"
+#include "ThreadPool.h"
+#include "Storage.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <cctype>
+#include <mutex>
+#include <atomic>
+
+#ifdef TEST_MODE
+const std::string PARTITION_DIR = "tests/test_history_partitions";
+#else
+const std::string PARTITION_DIR = "history_partitions";
+#endif
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Builds the segment file path for a partition key.
+ * @param key The partition key.
+ * @return std::string The path of the segment file.
+ */
+static std::string partitionPath(const std::string& key) {
+    return PARTITION_DIR + "/" + key + ".txt";
+}
+
+/**
+ * @brief Builds the Bloom filter sidecar path for a partition key.
+ * @param key The partition key.
+ * @return std::string The path of the ".bloom" file.
+ */
+static std::string partitionFilterPath(const std::string& key) {
+    return PARTITION_DIR + "/" + key + ".bloom";
+}
+
+/**
+ * @brief Builds the distinct-count sketch sidecar path for a partition key.
+ * @param key The partition key.
+ * @return std::string The path of the ".hll" file.
+ */
+static std::string partitionSketchPath(const std::string& key) {
+    return PARTITION_DIR + "/" + key + ".hll";
+}
+
+/**
+ * @brief Returns the date part ("YYYY-MM-DD") of a dateTime string.
+ * @param dateTime The dateTime string.
+ * @return std::string The first ten characters of the dateTime.
+ */
+static std::string datePart(const std::string& dateTime) {
+    return dateTime.substr(0, 10);
+}
+
+/**
+ * @brief Creates an empty summary for a key.
+ * @param key The partition key.
+ * @return PartitionSummary A summary with zero counts and sums.
+ */
+PartitionSummary emptyPartitionSummary(const std::string& key) {
+    return {key, "", "", 0, 0.0, 0.0, 0, 0};
+}
+
+/**
+ * @brief Adds one history row to a summary.
+ * @param s The summary to update.
+ * @param h The history row.
+ * @note Also used by the archive tier to build the summaries of compressed segments.
+ */
+void addToPartitionSummary(PartitionSummary& s, const ServiceHistory& h) {
+    if (s.rows == 0 || h.dateTime < s.minDate) s.minDate = h.dateTime;
+    if (s.rows == 0 || h.dateTime > s.maxDate) s.maxDate = h.dateTime;
+    s.rows++;
+    s.subtotalSum += h.subtotal;
+    s.totalSum += h.total;
+    if (isOpenStatus(h.status)) s.pendingCount++;
+    else if (isDoneStatus(h.status)) s.completedCount++;
+}
+
+/**
+ * @brief Adds the counts and sums of one summary into another.
+ * @param into The summary to update.
+ * @param s The summary to add.
+ * @note Date spans are widened to cover both summaries.
+ */
+void mergePartitionSummary(PartitionSummary& into, const PartitionSummary& s) {
+    if (s.rows == 0) return;
+    if (into.rows == 0 || s.minDate < into.minDate) into.minDate = s.minDate;
+    if (into.rows == 0 || s.maxDate > into.maxDate) into.maxDate = s.maxDate;
+    into.rows += s.rows;
+    into.subtotalSum += s.subtotalSum;
+    into.totalSum += s.totalSum;
+    into.pendingCount += s.pendingCount;
+    into.completedCount += s.completedCount;
+}
+
+/**
+ * @brief Parses a "#PART|..." header line.
+ * @param ln The header line.
+ * @param key The partition key of the segment.
+ * @param out Receives the parsed summary.
+ * @return bool True if the header was parsed.
+ */
+static bool parseSummaryHeader(const std::string& ln, const std::string& key, PartitionSummary& out) {
+    std::istringstream ss(ln);
+    std::string tag, minDate, maxDate, rows, subtotal, total, pending, completed;
+    std::getline(ss, tag, '|');
+    if (tag != "#PART") return false;
+    std::getline(ss, minDate, '|');
+    std::getline(ss, maxDate, '|');
+    std::getline(ss, rows, '|');
+    std::getline(ss, subtotal, '|');
+    std::getline(ss, total, '|');
+    std::getline(ss, pending, '|');
+    std::getline(ss, completed, '|');
+    try {
+        out = {key, minDate, maxDate, std::stoi(rows), std::stod(subtotal), std::stod(total),
+               std::stoi(pending), std::stoi(completed)};
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the partition key for a history dateTime.
+ * @param dateTime The dateTime in "YYYY-MM-DD HH:MM:SS" format.
+ * @return std::string The "YYYY-MM" key, or "undated" if the year or month is not numeric.
+ */
+std::string partitionKeyFor(const std::string& dateTime) {
+    if (dateTime.size() < 7 || dateTime[4] != '-') return "undated";
+    for (int i : {0, 1, 2, 3, 5, 6}) {
+        if (!std::isdigit(static_cast<unsigned char>(dateTime[i]))) return "undated";
+    }
+    return dateTime.substr(0, 7);
+}
+
+/**
+ * @brief Writes one month's partition segment, its Bloom filter and its distinct-count sketches.
+ * @param key The month key in "YYYY-MM" format.
+ * @param rows The month's rows, in history order.
+ * @note Skips the write when the segment already holds exactly this content. Each file is replaced
+ *       atomically, so a crash leaves either the old or the new segment, never a torn one.
+ */
+static void writePartitionSegment(const std::string& key, const std::vector<const ServiceHistory*>& rows) {
+    std::string filterPath = partitionFilterPath(key);
+    PartitionSummary s = emptyPartitionSummary(key);
+    for (const auto* h : rows) addToPartitionSummary(s, *h);
+    std::ostringstream content;
+    content << std::setprecision(17); // Round-trips the sums exactly; the default six digits drop the paise
+    content << "#PART|" << s.minDate << '|' << s.maxDate << '|' << s.rows << '|' << s.subtotalSum << '|'
+            << s.totalSum << '|' << s.pendingCount << '|' << s.completedCount << '\n';
+    for (const auto* h : rows) content << formatHistoryLine(*h) << '\n';
+
+    std::error_code ec;
+    std::string path = partitionPath(key);
+    std::ifstream existing(path, std::ios::binary);
+    if (existing) {
+        std::ostringstream old; old << existing.rdbuf();
+        if (old.str() == content.str() && fs::exists(filterPath, ec) && fs::exists(partitionSketchPath(key), ec)) return;
+    }
+    existing.close();
+    if (!replaceFileAtomically(path, content.str())) {
+        std::cout << "Failed to write history partition " << key << ".\n"; // The old segment and sidecars still agree
+        return;
+    }
+    std::vector<ServiceHistory> copies;
+    for (const auto* h : rows) copies.push_back(*h);
+    writeSegmentFilters(filterPath, buildSegmentFilters(copies));
+    writeSegmentSketches(partitionSketchPath(key), buildSegmentSketches(copies));
+}
+
+/**
+ * @brief Rewrites the monthly partition segments from a full history list.
+ * @param list The complete list of history entries.
+ * @note Each segment starts with a "#PART|min|max|rows|subtotal|total|pending|completed" header and has a
+ *       ".bloom" sidecar with its key filters and a ".hll" sidecar with its distinct-count sketches. Unchanged segments are left untouched and segments for
+ *       vanished months are deleted.
+ */
+void writeHistoryPartitions(const std::vector<ServiceHistory>& list) {
+    std::map<std::string, std::vector<const ServiceHistory*>> groups;
+    for (const auto& h : list) groups[partitionKeyFor(h.dateTime)].push_back(&h);
+
+    std::error_code ec;
+    fs::create_directories(PARTITION_DIR, ec);
+
+    // Remove segments for months that no longer have rows
+    for (const auto& entry : fs::directory_iterator(PARTITION_DIR, ec)) {
+        auto ext = entry.path().extension();
+        if (ext != ".txt" && ext != ".bloom" && ext != ".hll") continue;
+        if (groups.count(entry.path().stem().string()) == 0) fs::remove(entry.path(), ec);
+    }
+
+    // Segments are independent files, so they are formatted and written in parallel
+    std::vector<const std::pair<const std::string, std::vector<const ServiceHistory*>>*> months;
+    for (const auto& g : groups) months.push_back(&g);
+    parallelFor(months.size(), [&](size_t i) { writePartitionSegment(months[i]->first, months[i]->second); });
+}
+
+/**
+ * @brief Rewrites the partition segment of a single month from the full history list.
+ * @param list The full service history.
+ * @param key The month key in "YYYY-MM" format.
+ * @note Used after a single booking or status change so only the affected month is rewritten.
+ */
+void refreshHistoryPartition(const std::vector<ServiceHistory>& list, const std::string& key) {
+    std::vector<const ServiceHistory*> rows;
+    for (const auto& h : list) {
+        if (partitionKeyFor(h.dateTime) == key) rows.push_back(&h);
+    }
+    std::error_code ec;
+    if (rows.empty()) {
+        fs::remove(partitionPath(key), ec);
+        fs::remove(partitionFilterPath(key), ec);
+        fs::remove(partitionSketchPath(key), ec);
+        return;
+    }
+    fs::create_directories(PARTITION_DIR, ec);
+    writePartitionSegment(key, rows);
+}
+
+static std::mutex pendingPartitionMutex;        // Guards pendingPartitionKeys; taken after dataFileMutex
+static std::set<std::string> pendingPartitionKeys; // Months whose segment misses logged changes
+
+/**
+ * @brief Marks month partitions as out of date, to be rewritten by the next flushHistoryPartitions().
+ * @param keys The month keys in "YYYY-MM" format.
+ */
+void deferHistoryPartitionRefresh(const std::set<std::string>& keys) {
+    std::lock_guard<std::mutex> lock(pendingPartitionMutex);
+    pendingPartitionKeys.insert(keys.begin(), keys.end());
+}
+
+/**
+ * @brief Rewrites the month partitions marked out of date from the current history.
+ * @note Keys stay pending until their segment is written, so a reader arriving mid-flush waits on the data
+ *       file mutex for it rather than reading the old segment.
+ */
+void flushHistoryPartitions() {
+    {
+        std::lock_guard<std::mutex> lock(pendingPartitionMutex);
+        if (pendingPartitionKeys.empty()) return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::set<std::string> keys;
+    {
+        std::lock_guard<std::mutex> pending(pendingPartitionMutex);
+        keys = pendingPartitionKeys;
+    }
+    if (keys.empty()) return;
+    auto list = loadHistory();
+    for (const auto& key : keys) refreshHistoryPartition(list, key);
+    std::lock_guard<std::mutex> pending(pendingPartitionMutex);
+    for (const auto& key : keys) pendingPartitionKeys.erase(key);
+}
+
+/**
+ * @brief Builds the partition segments from the history file if none exist yet.
+ * @note Used at startup so history written before partitioning existed becomes visible to segment lookups.
+ */
+void ensureHistoryPartitions() {
+    if (!loadPartitionSummaries().empty()) return;
+    auto list = loadHistory();
+    if (!list.empty()) writeHistoryPartitions(list);
+}
+
+/**
+ * @brief Loads only the summary headers of all partition segments.
+ * @return std::vector<PartitionSummary> One summary per segment, ordered by key.
+ * @note Reads a single line per segment; segments with a missing or malformed header are skipped.
+ */
+std::vector<PartitionSummary> loadPartitionSummaries() {
+    flushHistoryPartitions();
+    std::vector<PartitionSummary> list;
+    std::error_code ec;
+    std::set<fs::path> paths;
+    for (const auto& entry : fs::directory_iterator(PARTITION_DIR, ec)) {
+        if (entry.path().extension() == ".txt") paths.insert(entry.path());
+    }
+    for (const auto& p : paths) {
+        std::ifstream ifs(p);
+        std::string ln;
+        PartitionSummary s;
+        if (std::getline(ifs, ln) && parseSummaryHeader(ln, p.stem().string(), s)) list.push_back(s);
+    }
+    return list;
+}
+
+/**
+ * @brief Checks whether a partition may contain rows within a date range.
+ * @param s The partition summary.
+ * @param from Start date (inclusive).
+ * @param to End date (inclusive).
+ * @return bool True if the partition's date span overlaps the range.
+ */
+static bool overlaps(const PartitionSummary& s, const std::string& from, const std::string& to) {
+    return s.rows > 0 && datePart(s.maxDate) >= from && datePart(s.minDate) <= to;
+}
+
+/**
+ * @brief Reads the rows of one partition segment that fall within a date range.
+ * @param key The partition key.
+ * @param from Start date (inclusive).
+ * @param to End date (inclusive).
+ * @param out Receives the matching rows.
+ */
+static void readPartitionRows(const std::string& key, const std::string& from, const std::string& to,
+                              std::vector<ServiceHistory>& out) {
+    std::ifstream ifs(partitionPath(key));
+    std::string ln;
+    ServiceHistory h;
+    while (std::getline(ifs, ln)) {
+        if (ln.empty() || ln[0] == '#') continue;
+        if (!parseHistoryLine(ln, h)) continue;
+        std::string d = datePart(h.dateTime);
+        if (d >= from && d <= to) out.push_back(h);
+    }
+}
+
+/**
+ * @brief Loads the history rows whose date falls within an inclusive date range.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<ServiceHistory> Matching archived rows followed by matching hot rows.
+ * @note Partitions whose header span does not overlap the range are never opened past the header,
+ *       and archive segments outside the range are never decompressed. Segments are read in parallel.
+ */
+std::vector<ServiceHistory> loadHistoryBetween(const std::string& from, const std::string& to) {
+    std::vector<ServiceHistory> list = loadArchivedHistoryBetween(from, to);
+    std::vector<std::string> keys;
+    for (const auto& s : loadPartitionSummaries()) {
+        if (overlaps(s, from, to)) keys.push_back(s.key);
+    }
+    std::vector<std::vector<ServiceHistory>> parts(keys.size());
+    parallelFor(keys.size(), [&](size_t i) { readPartitionRows(keys[i], from, to, parts[i]); });
+    for (const auto& part : parts) list.insert(list.end(), part.begin(), part.end());
+    return list;
+}
+
+/**
+ * @brief Aggregates row count, revenue and status counts over an inclusive date range.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return PartitionSummary The aggregate, keyed "from..to".
+ * @note Partitions and archive segments fully inside the range contribute their header;
+ *       only boundary partitions are scanned and only boundary archive segments are decompressed,
+ *       each as a task on the shared thread pool.
+ */
+PartitionSummary summarizeHistoryBetween(const std::string& from, const std::string& to) {
+    PartitionSummary total = emptyPartitionSummary(from + ".." + to);
+    std::vector<std::string> archiveScans, partitionScans;
+    for (const auto& a : loadArchiveIndex()) {
+        const PartitionSummary& s = a.summary;
+        if (!overlaps(s, from, to)) continue;
+        if (datePart(s.minDate) >= from && datePart(s.maxDate) <= to) mergePartitionSummary(total, s);
+        else archiveScans.push_back(s.key);
+    }
+    for (const auto& s : loadPartitionSummaries()) {
+        if (!overlaps(s, from, to)) continue;
+        if (datePart(s.minDate) >= from && datePart(s.maxDate) <= to) mergePartitionSummary(total, s); // Fully covered: the header is enough
+        else partitionScans.push_back(s.key);
+    }
+
+    // Boundary segments are scanned in parallel; the partial sums are merged in segment order
+    size_t archived = archiveScans.size();
+    std::vector<PartitionSummary> partials(archived + partitionScans.size(), emptyPartitionSummary(""));
+    parallelFor(partials.size(), [&](size_t i) {
+        std::vector<ServiceHistory> rows;
+        if (i < archived) rows = loadArchiveSegment(archiveScans[i]);
+        else readPartitionRows(partitionScans[i - archived], from, to, rows);
+        for (const auto& h : rows) {
+            std::string d = datePart(h.dateTime);
+            if (d >= from && d <= to) addToPartitionSummary(partials[i], h);
+        }
+    });
+    for (const auto& p : partials) mergePartitionSummary(total, p);
+    return total;
+}
+
+// ---- Segment Bloom filters ----
+
+static std::atomic<long long> segmentReads{0};
+
+/**
+ * @brief Returns the number of partition and archive segments read by keyed lookups so far.
+ * @return long long The running count of segment reads.
+ */
+long long historySegmentReads() {
+    return segmentReads.load();
+}
+
+/**
+ * @brief Records that a keyed lookup had to read a segment.
+ */
+void countHistorySegmentRead() {
+    segmentReads++;
+}
+
+/**
+ * @brief Builds the Bloom filters for the rows of one segment.
+ * @param rows The rows of the segment.
+ * @return SegmentFilters Filters over history, customer and vehicle IDs, sized at 10 bits per row.
+ */
+SegmentFilters buildSegmentFilters(const std::vector<ServiceHistory>& rows) {
+    SegmentFilters f{makeBloomFilter(rows.size()), makeBloomFilter(rows.size()), makeBloomFilter(rows.size())};
+    for (const auto& h : rows) {
+        bloomAdd(f.historyIds, h.historyId);
+        bloomAdd(f.customerIds, h.customerId);
+        bloomAdd(f.vehicleIds, h.vehicleId);
+    }
+    return f;
+}
+
+/**
+ * @brief In-memory copy of a sidecar file, valid while the file's size and modification time are unchanged.
+ */
+struct CachedSegmentFilters {
+    uintmax_t size;
+    fs::file_time_type modified;
+    SegmentFilters filters;
+};
+
+static std::mutex filterCacheMutex;
+static std::map<std::string, CachedSegmentFilters> filterCache;
+
+/**
+ * @brief Writes segment filters to a sidecar file.
+ * @param path The path of the ".bloom" file.
+ * @param f The filters to write.
+ * @note Layout: "BLM1" followed by the history, customer and vehicle filters. The file is replaced atomically
+ *       and the in-memory cache updated as well; if the write fails the old file is removed.
+ */
+void writeSegmentFilters(const std::string& path, const SegmentFilters& f) {
+    std::string buf = "BLM1";
+    serializeBloomFilter(f.historyIds, buf);
+    serializeBloomFilter(f.customerIds, buf);
+    serializeBloomFilter(f.vehicleIds, buf);
+    std::error_code ec;
+    if (!replaceFileAtomically(path, buf)) {
+        fs::remove(path, ec); // A stale filter could hide new rows; with none the segment is scanned
+        std::lock_guard<std::mutex> lock(filterCacheMutex);
+        filterCache.erase(path);
+        return;
+    }
+    // Refresh the cache now: a rewrite within the same timestamp tick must not leave a stale entry
+    uintmax_t size = fs::file_size(path, ec);
+    fs::file_time_type modified = fs::last_write_time(path, ec);
+    std::lock_guard<std::mutex> lock(filterCacheMutex);
+    if (ec) filterCache.erase(path);
+    else filterCache[path] = {size, modified, f};
+}
+
+/**
+ * @brief Loads segment filters from a sidecar file, served from memory while the file is unchanged.
+ * @param path The path of the ".bloom" file.
+ * @param out Receives the filters.
+ * @return bool True if the filters were loaded; false if the file is missing or corrupt.
+ * @note Only a stat is needed on a cache hit, so probing a segment costs no file read.
+ */
+bool loadSegmentFilters(const std::string& path, SegmentFilters& out) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(path, ec);
+    if (ec) return false;
+    fs::file_time_type modified = fs::last_write_time(path, ec);
+    if (ec) return false;
+
+    std::lock_guard<std::mutex> lock(filterCacheMutex);
+    auto it = filterCache.find(path);
+    if (it != filterCache.end() && it->second.size == size && it->second.modified == modified) {
+        out = it->second.filters;
+        return true;
+    }
+    std::ifstream ifs(path, std::ios::binary);
+    std::ostringstream buf;
+    buf << ifs.rdbuf();
+    std::string bytes = buf.str();
+    size_t pos = 4;
+    SegmentFilters f;
+    if (bytes.compare(0, 4, "BLM1") != 0 ||
+        !deserializeBloomFilter(bytes, pos, f.historyIds) ||
+        !deserializeBloomFilter(bytes, pos, f.customerIds) ||
+        !deserializeBloomFilter(bytes, pos, f.vehicleIds)) {
+        filterCache.erase(path);
+        return false;
+    }
+    filterCache[path] = {size, modified, f};
+    out = f;
+    return true;
+}
+
+/**
+ * @brief Probes segment filters for a key value.
+ * @param f The segment filters.
+ * @param key The column to probe.
+ * @param value The value to look for.
+ * @return bool False if the segment definitely has no matching row.
+ */
+bool segmentMightContain(const SegmentFilters& f, HistoryKey key, int value) {
+    switch (key) {
+        case HistoryKey::HistoryId: return bloomMightContain(f.historyIds, value);
+        case HistoryKey::CustomerId: return bloomMightContain(f.customerIds, value);
+        case HistoryKey::VehicleId: return bloomMightContain(f.vehicleIds, value);
+    }
+    return true;
+}
+
+// ---- Segment distinct-count sketches ----
+
+/**
+ * @brief Builds the distinct-count sketches for the rows of one segment.
+ * @param rows The rows of the segment.
+ * @return std::vector<BranchSketches> One entry per branch with rows, ordered by branch ID; cancelled
+ *         bookings are not counted.
+ */
+std::vector<BranchSketches> buildSegmentSketches(const std::vector<ServiceHistory>& rows) {
+    std::map<int, BranchSketches> branches;
+    for (const auto& h : rows) {
+        if (h.status == "Cancelled") continue;
+        auto it = branches.find(h.branchId);
+        if (it == branches.end()) it = branches.emplace(h.branchId, BranchSketches{h.branchId, makeHyperLogLog(), makeHyperLogLog()}).first;
+        hllAdd(it->second.customers, h.customerId);
+        hllAdd(it->second.vehicles, h.vehicleId);
+    }
+    std::vector<BranchSketches> list;
+    for (auto& b : branches) list.push_back(std::move(b.second));
+    return list;
+}
+
+/**
+ * @brief Writes distinct-count sketches to a sidecar file.
+ * @param path The path of the ".hll" file.
+ * @param sketches The sketches to write.
+ * @note Layout: "HLL1", the branch count as a 32-bit little-endian value, then per branch its ID (32-bit)
+ *       followed by the customer and vehicle sketches. The file is replaced atomically; if the write fails
+ *       the old file is removed rather than left stale.
+ */
+void writeSegmentSketches(const std::string& path, const std::vector<BranchSketches>& sketches) {
+    std::string buf = "HLL1";
+    auto put32 = [&](uint32_t v) {
+        for (int b = 0; b < 32; b += 8) buf.push_back(static_cast<char>((v >> b) & 0xFF));
+    };
+    put32(static_cast<uint32_t>(sketches.size()));
+    for (const auto& b : sketches) {
+        put32(static_cast<uint32_t>(b.branchId));
+        serializeHyperLogLog(b.customers, buf);
+        serializeHyperLogLog(b.vehicles, buf);
+    }
+    std::error_code ec;
+    if (!replaceFileAtomically(path, buf)) fs::remove(path, ec); // A missing sidecar is rebuilt from the rows
+}
+
+/**
+ * @brief Loads distinct-count sketches from a sidecar file.
+ * @param path The path of the ".hll" file.
+ * @param out Receives the sketches.
+ * @return bool True if the sketches were loaded; false if the file is missing or corrupt.
+ */
+bool loadSegmentSketches(const std::string& path, std::vector<BranchSketches>& out) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return false;
+    std::ostringstream buf;
+    buf << ifs.rdbuf();
+    std::string bytes = buf.str();
+    auto get32 = [&](size_t at) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[at + i])) << (8 * i);
+        return v;
+    };
+    if (bytes.size() < 8 || bytes.compare(0, 4, "HLL1") != 0) return false;
+    uint32_t count = get32(4);
+    size_t pos = 8;
+    std::vector<BranchSketches> list;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (bytes.size() < pos + 4) return false;
+        BranchSketches b{static_cast<int>(get32(pos)), {}, {}};
+        pos += 4;
+        if (!deserializeHyperLogLog(bytes, pos, b.customers) || !deserializeHyperLogLog(bytes, pos, b.vehicles)) return false;
+        list.push_back(std::move(b));
+    }
+    out = std::move(list);
+    return true;
+}
+
+/**
+ * @brief Estimates the distinct customers and vehicles served in a range of months, hot and archived.
+ * @param fromMonth First month in "YYYY-MM" format.
+ * @param toMonth Last month in "YYYY-MM" format.
+ * @param branchId Only bookings of this branch, or -1 for every branch.
+ * @return DistinctCounts The estimates; zero if a month is malformed.
+ * @note A row caught in both tiers by an interrupted archive run is counted once, as merging is a union.
+ */
+DistinctCounts distinctBetween(const std::string& fromMonth, const std::string& toMonth, int branchId) {
+    if (fromMonth.size() != 7 || toMonth.size() != 7 || partitionKeyFor(fromMonth) != fromMonth ||
+        partitionKeyFor(toMonth) != toMonth) return {0, 0};
+    std::vector<std::pair<std::string, bool>> segments; // Month key, archived
+    for (const auto& a : loadArchiveIndex()) {
+        if (a.summary.key >= fromMonth && a.summary.key <= toMonth) segments.emplace_back(a.summary.key, true);
+    }
+    for (const auto& s : loadPartitionSummaries()) {
+        if (s.key >= fromMonth && s.key <= toMonth) segments.emplace_back(s.key, false);
+    }
+    HyperLogLog customers = makeHyperLogLog(), vehicles = makeHyperLogLog();
+    for (const auto& [key, archived] : segments) {
+        std::string path = archived ? archiveSketchPath(key) : partitionSketchPath(key);
+        std::vector<BranchSketches> sketches;
+        if (!loadSegmentSketches(path, sketches)) {
+            std::lock_guard<std::recursive_mutex> lock(dataFileMutex()); // Not racing a rewrite of the segment
+            std::vector<ServiceHistory> rows;
+            if (archived) rows = loadArchiveSegment(key);
+            else readPartitionRows(key, "0000-00-00", "9999-99-99", rows);
+            sketches = buildSegmentSketches(rows);
+            writeSegmentSketches(path, sketches);
+        }
+        for (const auto& b : sketches) {
+            if (branchId >= 0 && b.branchId != branchId) continue;
+            hllMerge(customers, b.customers);
+            hllMerge(vehicles, b.vehicles);
+        }
+    }
+    return {hllEstimate(customers), hllEstimate(vehicles)};
+}
+
+/**
+ * @brief Checks whether a history row matches a key value.
+ * @param h The history row.
+ * @param key The column to compare.
+ * @param value The value to compare with.
+ * @return bool True if the row's column equals the value.
+ */
+bool historyKeyMatches(const ServiceHistory& h, HistoryKey key, int value) {
+    switch (key) {
+        case HistoryKey::HistoryId: return h.historyId == value;
+        case HistoryKey::CustomerId: return h.customerId == value;
+        case HistoryKey::VehicleId: return h.vehicleId == value;
+    }
+    return false;
+}
+
+/**
+ * @brief Finds all history rows (hot and archived) with a given history, customer or vehicle ID.
+ * @param key The column to match.
+ * @param value The value to match.
+ * @return std::vector<ServiceHistory> Matching archived rows followed by matching hot rows.
+ * @note A segment is read only if its Bloom filter may contain the value (or it has no usable filter).
+ */
+std::vector<ServiceHistory> findHistoryRows(HistoryKey key, int value) {
+    flushHistoryPartitions();
+    std::vector<ServiceHistory> list = findArchivedRows(key, value);
+    std::error_code ec;
+    std::set<std::string> keys;
+    for (const auto& entry : fs::directory_iterator(PARTITION_DIR, ec)) {
+        if (entry.path().extension() == ".txt") keys.insert(entry.path().stem().string());
+    }
+    for (const auto& k : keys) {
+        SegmentFilters f;
+        if (loadSegmentFilters(partitionFilterPath(k), f) && !segmentMightContain(f, key, value)) continue;
+        countHistorySegmentRead();
+        std::ifstream ifs(partitionPath(k));
+        std::string ln;
+        ServiceHistory h;
+        while (std::getline(ifs, ln)) {
+            if (ln.empty() || ln[0] == '#') continue;
+            if (parseHistoryLine(ln, h) && historyKeyMatches(h, key, value)) list.push_back(h);
+        }
+    }
+    return list;
+}
+
+/**
+ * @brief Finds a history entry by ID across the hot partitions and the archive.
+ * @param historyId The history ID.
+ * @param out Receives the entry if found.
+ * @return bool True if the entry was found.
+ * @note When an ID is duplicated the last occurrence wins.
+ */
+bool findHistoryById(int historyId, ServiceHistory& out) {
+    auto rows = findHistoryRows(HistoryKey::HistoryId, historyId);
+    if (rows.empty()) return false;
+    out = rows.back();
+    return true;
+}
+
+/**
+ * @brief Interactively prints a revenue report for a date range.
+ * @note Prompts for start and end dates and prints bookings, subtotal, revenue and status counts.
+ */
+void viewRevenueReport() {
+    std::string from, to;
+    std::cout << "Enter start date (YYYY-MM-DD): "; std::getline(std::cin, from);
+    std::cout << "Enter end date (YYYY-MM-DD): "; std::getline(std::cin, to);
+    PartitionSummary s = summarizeHistoryBetween(from, to);
+    std::cout << "--- Revenue Report " << from << " to " << to << " ---\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Bookings: " << s.rows << "\n";
+    std::cout << "Subtotal: Rs." << s.subtotalSum << "\n";
+    std::cout << "Revenue: Rs." << s.totalSum << "\n";
+    std::cout << "Pending: " << s.pendingCount << ", Completed: " << s.completedCount << "\n";
+    std::cout.unsetf(std::ios::fixed);
+}
+
+/**
+ * @brief Interactively prints the distinct customers and vehicles served per month and over a range of months.
+ * @note Prompts for the first and last month and a branch; every figure comes from the segment sketches.
+ */
+void viewDistinctReport() {
+    std::string from, to;
+    std::cout << "Enter first month (YYYY-MM): "; std::getline(std::cin, from);
+    std::cout << "Enter last month (YYYY-MM): "; std::getline(std::cin, to);
+    std::cout << "Enter branch ID (-1 for all): ";
+    int branchId; std::cin >> branchId; std::cin.ignore();
+    std::set<std::string> months;
+    for (const auto& a : loadArchiveIndex()) {
+        if (a.summary.key >= from && a.summary.key <= to) months.insert(a.summary.key);
+    }
+    for (const auto& s : loadPartitionSummaries()) {
+        if (s.key >= from && s.key <= to) months.insert(s.key);
+    }
+    std::cout << "--- Unique Customers and Vehicles " << from << " to " << to << " (estimated) ---\n";
+    std::cout << std::left << std::setw(10) << "Month" << std::setw(12) << "Customers" << "Vehicles\n";
+    for (const auto& key : months) {
+        DistinctCounts c = distinctBetween(key, key, branchId);
+        std::cout << std::left << std::setw(10) << key << std::setw(12) << c.customers << c.vehicles << "\n";
+    }
+    DistinctCounts total = distinctBetween(from, to, branchId);
+    std::cout << std::left << std::setw(10) << "Total" << std::setw(12) << total.customers << total.vehicles << "\n";
+}
@@ -0,0 +1,259 @@
+// HistoryPartition.h
+#ifndef HISTORY_PARTITION_H
+#define HISTORY_PARTITION_H
+
+#include <set>
+#include <string>
+#include <vector>
+#include "Service.h"
+#include "BloomFilter.h"
+#include "HyperLogLog.h"
+
+/**
+ * @brief Summary header stored at the top of each monthly history partition segment.
+ */
+struct PartitionSummary {
+    std::string key;        /**< Partition key in "YYYY-MM" format ("undated" for rows without a valid date). */
+    std::string minDate;    /**< Earliest dateTime in the partition. */
+    std::string maxDate;    /**< Latest dateTime in the partition. */
+    int rows;               /**< Number of history rows in the partition. */
+    double subtotalSum;     /**< Sum of subtotals of all rows. */
+    double totalSum;        /**< Sum of totals (revenue after discount) of all rows. */
+    int pendingCount;       /**< Number of open jobs (booked through quality check). */
+    int completedCount;     /**< Number of completed or delivered jobs. */
+};
+
+/**
+ * @brief Identifies the history column used for a keyed segment lookup.
+ */
+enum class HistoryKey {
+    HistoryId,  /**< Look up by ServiceHistory::historyId. */
+    CustomerId, /**< Look up by ServiceHistory::customerId. */
+    VehicleId   /**< Look up by ServiceHistory::vehicleId. */
+};
+
+/**
+ * @brief Per-segment Bloom filters stored next to each partition or archive segment.
+ */
+struct SegmentFilters {
+    BloomFilter historyIds;  /**< Filter over the history IDs in the segment. */
+    BloomFilter customerIds; /**< Filter over the customer IDs in the segment. */
+    BloomFilter vehicleIds;  /**< Filter over the vehicle IDs in the segment. */
+};
+
+/**
+ * @brief Computes the partition key for a history dateTime.
+ * @param dateTime The dateTime in "YYYY-MM-DD HH:MM:SS" format.
+ * @return std::string The "YYYY-MM" key, or "undated" if the dateTime is not well formed.
+ */
+std::string partitionKeyFor(const std::string& dateTime);
+
+/**
+ * @brief Distinct-count sketches of one branch's bookings in a segment, stored next to each partition or
+ *        archive segment.
+ */
+struct BranchSketches {
+    int branchId;             /**< The branch. */
+    HyperLogLog customers;    /**< Sketch over the customer IDs served. */
+    HyperLogLog vehicles;     /**< Sketch over the vehicle IDs served. */
+};
+
+/**
+ * @brief Estimated numbers of distinct customers and vehicles served.
+ */
+struct DistinctCounts {
+    long long customers;      /**< Distinct customers. */
+    long long vehicles;       /**< Distinct vehicles. */
+};
+
+/**
+ * @brief Creates an empty summary for a key.
+ * @param key The partition key.
+ * @return PartitionSummary A summary with zero counts and sums.
+ */
+PartitionSummary emptyPartitionSummary(const std::string& key);
+
+/**
+ * @brief Adds one history row to a summary.
+ * @param s The summary to update.
+ * @param h The history row.
+ */
+void addToPartitionSummary(PartitionSummary& s, const ServiceHistory& h);
+
+/**
+ * @brief Adds the counts and sums of one summary into another.
+ * @param into The summary to update.
+ * @param s The summary to add.
+ */
+void mergePartitionSummary(PartitionSummary& into, const PartitionSummary& s);
+
+/**
+ * @brief Rewrites the monthly partition segments from a full history list.
+ * @param list The complete list of history entries.
+ * @note Segments whose content is unchanged are not rewritten; segments for months no longer present are removed.
+ */
+void writeHistoryPartitions(const std::vector<ServiceHistory>& list);
+
+/**
+ * @brief Rewrites the partition segment of a single month from the full history list.
+ * @param list The complete list of history entries.
+ * @param key The month key in "YYYY-MM" format; the segment is removed if the month has no rows.
+ */
+void refreshHistoryPartition(const std::vector<ServiceHistory>& list, const std::string& key);
+
+/**
+ * @brief Marks month partitions as out of date, to be rewritten by the next flushHistoryPartitions().
+ * @param keys The month keys in "YYYY-MM" format.
+ * @note Called under the data file mutex by logHistoryChanges(), so a booking costs no segment rewrite while
+ *       the mutex is held. Until the next checkpoint the history log holds every change the segments miss, and
+ *       recovery rebuilds the segments whenever the log holds records.
+ */
+void deferHistoryPartitionRefresh(const std::set<std::string>& keys);
+
+/**
+ * @brief Rewrites the month partitions marked out of date from the current history.
+ * @note Every partition reader calls it first, so reads see every logged change. It is cheap when nothing
+ *       is pending, and one call rewrites each month once however many bookings touched it.
+ */
+void flushHistoryPartitions();
+
+/**
+ * @brief Builds the partition segments from the history file if none exist yet.
+ */
+void ensureHistoryPartitions();
+
+/**
+ * @brief Loads only the summary headers of all partition segments.
+ * @return std::vector<PartitionSummary> One summary per segment, ordered by key.
+ */
+std::vector<PartitionSummary> loadPartitionSummaries();
+
+/**
+ * @brief Loads the history rows whose date falls within an inclusive date range.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<ServiceHistory> Matching archived and hot rows; partitions outside the range are not read.
+ */
+std::vector<ServiceHistory> loadHistoryBetween(const std::string& from, const std::string& to);
+
+/**
+ * @brief Aggregates row count, revenue and status counts over an inclusive date range.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return PartitionSummary The aggregate; partitions fully inside the range are answered from their headers.
+ */
+PartitionSummary summarizeHistoryBetween(const std::string& from, const std::string& to);
+
+/**
+ * @brief Builds the Bloom filters for the rows of one segment.
+ * @param rows The rows of the segment.
+ * @return SegmentFilters Filters over history, customer and vehicle IDs.
+ */
+SegmentFilters buildSegmentFilters(const std::vector<ServiceHistory>& rows);
+
+/**
+ * @brief Writes segment filters to a sidecar file.
+ * @param path The path of the ".bloom" file.
+ * @param f The filters to write.
+ */
+void writeSegmentFilters(const std::string& path, const SegmentFilters& f);
+
+/**
+ * @brief Loads segment filters from a sidecar file, served from memory while the file is unchanged.
+ * @param path The path of the ".bloom" file.
+ * @param out Receives the filters.
+ * @return bool True if the filters were loaded.
+ */
+bool loadSegmentFilters(const std::string& path, SegmentFilters& out);
+
+/**
+ * @brief Probes segment filters for a key value.
+ * @param f The segment filters.
+ * @param key The column to probe.
+ * @param value The value to look for.
+ * @return bool False if the segment definitely has no matching row.
+ */
+bool segmentMightContain(const SegmentFilters& f, HistoryKey key, int value);
+
+/**
+ * @brief Builds the distinct-count sketches for the rows of one segment.
+ * @param rows The rows of the segment.
+ * @return std::vector<BranchSketches> One entry per branch with rows, ordered by branch ID; cancelled
+ *         bookings are not counted.
+ */
+std::vector<BranchSketches> buildSegmentSketches(const std::vector<ServiceHistory>& rows);
+
+/**
+ * @brief Writes distinct-count sketches to a sidecar file.
+ * @param path The path of the ".hll" file.
+ * @param sketches The sketches to write.
+ */
+void writeSegmentSketches(const std::string& path, const std::vector<BranchSketches>& sketches);
+
+/**
+ * @brief Loads distinct-count sketches from a sidecar file.
+ * @param path The path of the ".hll" file.
+ * @param out Receives the sketches.
+ * @return bool True if the sketches were loaded; false if the file is missing or corrupt.
+ */
+bool loadSegmentSketches(const std::string& path, std::vector<BranchSketches>& out);
+
+/**
+ * @brief Estimates the distinct customers and vehicles served in a range of months, hot and archived.
+ * @param fromMonth First month in "YYYY-MM" format.
+ * @param toMonth Last month in "YYYY-MM" format.
+ * @param branchId Only bookings of this branch, or -1 for every branch.
+ * @return DistinctCounts The estimates (about 1.6% standard error); zero if a month is malformed.
+ * @note Answered by merging the ".hll" sidecars of the segments in the range into one pair of sketches, so
+ *       memory stays constant whatever the range and no history row is read. A segment without a sidecar
+ *       (written by an older version) is read once and given one.
+ */
+DistinctCounts distinctBetween(const std::string& fromMonth, const std::string& toMonth, int branchId = -1);
+
+/**
+ * @brief Checks whether a history row matches a key value.
+ * @param h The history row.
+ * @param key The column to compare.
+ * @param value The value to compare with.
+ * @return bool True if the row's column equals the value.
+ */
+bool historyKeyMatches(const ServiceHistory& h, HistoryKey key, int value);
+
+/**
+ * @brief Finds all history rows (hot and archived) with a given history, customer or vehicle ID.
+ * @param key The column to match.
+ * @param value The value to match.
+ * @return std::vector<ServiceHistory> Matching rows; segments whose filters rule out the value are not read.
+ */
+std::vector<ServiceHistory> findHistoryRows(HistoryKey key, int value);
+
+/**
+ * @brief Finds a history entry by ID across the hot partitions and the archive.
+ * @param historyId The history ID.
+ * @param out Receives the entry if found (the last occurrence if the ID is duplicated).
+ * @return bool True if the entry was found.
+ */
+bool findHistoryById(int historyId, ServiceHistory& out);
+
+/**
+ * @brief Returns the number of partition and archive segments read by keyed lookups so far.
+ * @return long long The running count of segment reads.
+ */
+long long historySegmentReads();
+
+/**
+ * @brief Records that a keyed lookup had to read a segment.
+ */
+void countHistorySegmentRead();
+
+/**
+ * @brief Interactively prints a revenue report for a date range.
+ */
+void viewRevenueReport();
+
+/**
+ * @brief Interactively prints the distinct customers and vehicles served per month and over a range of months.
+ */
+void viewDistinctReport();
+
+#endif // HISTORY_PARTITION_H
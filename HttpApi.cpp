@@ -0,0 +1,804 @@
+// HttpApi.cpp (implementation)
+#include "HttpApi.h"
+#include "Json.h"
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+#include "Discount.h"
+#include "HistoryPartition.h"
+#include "StorageWriter.h"
+#include "ChangeFeed.h"
+#include "Invoice.h"
+#include "Tax.h"
+#include "Calendar.h"
+#include "Lifecycle.h"
+#include "Cohort.h"
+#include "HistoryArchive.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <map>
+#include <vector>
+
+// ---- HTTP framing ----
+
+/**
+ * @brief Compares two strings ignoring ASCII case.
+ */
+static bool equalsIgnoreCase(const std::string& a, const char* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i]; ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return i == a.size() && !b[i];
+}
+
+/**
+ * @brief Parses one request from a buffer of received bytes.
+ * @param buf The received bytes.
+ * @param start Offset of the request in buf.
+ * @param out Receives the request.
+ * @param end Receives the offset just past the request.
+ * @return HttpParseResult Whether a request was parsed.
+ */
+HttpParseResult parseHttpRequest(const std::string& buf, size_t start, HttpRequest& out, size_t& end) {
+    size_t headEnd = buf.find("\r\n\r\n", start);
+    if (headEnd == std::string::npos) {
+        return buf.size() - start > HTTP_MAX_HEAD ? HttpParseResult::Invalid : HttpParseResult::Incomplete;
+    }
+    if (headEnd - start > HTTP_MAX_HEAD) return HttpParseResult::Invalid;
+
+    // Request line: METHOD SP target SP HTTP/1.x
+    size_t lineEnd = buf.find("\r\n", start);
+    size_t sp1 = buf.find(' ', start);
+    size_t sp2 = sp1 == std::string::npos ? sp1 : buf.find(' ', sp1 + 1);
+    if (sp2 == std::string::npos || sp2 > lineEnd) return HttpParseResult::Invalid;
+    out = HttpRequest();
+    out.method = buf.substr(start, sp1 - start);
+    std::string target = buf.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string version = buf.substr(sp2 + 1, lineEnd - sp2 - 1);
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") return HttpParseResult::Invalid;
+    if (target.empty() || target[0] != '/') return HttpParseResult::Invalid;
+    size_t q = target.find('?');
+    out.path = target.substr(0, q);
+    if (q != std::string::npos) out.query = target.substr(q + 1);
+    out.keepAlive = version == "HTTP/1.1";
+
+    size_t contentLength = 0;
+    for (size_t pos = lineEnd + 2; pos < headEnd;) {
+        size_t next = buf.find("\r\n", pos);
+        size_t colon = buf.find(':', pos);
+        if (colon == std::string::npos || colon > next) return HttpParseResult::Invalid;
+        std::string name = buf.substr(pos, colon - pos);
+        size_t v = colon + 1;
+        while (v < next && (buf[v] == ' ' || buf[v] == '\t')) ++v;
+        std::string value = buf.substr(v, next - v);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.pop_back();
+        if (equalsIgnoreCase(name, "Content-Length")) {
+            auto r = std::from_chars(value.data(), value.data() + value.size(), contentLength);
+            if (r.ec != std::errc() || r.ptr != value.data() + value.size()) return HttpParseResult::Invalid;
+        } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+            return HttpParseResult::Invalid; // Chunked request bodies are not supported
+        } else if (equalsIgnoreCase(name, "Connection")) {
+            if (equalsIgnoreCase(value, "close")) out.keepAlive = false;
+            else if (equalsIgnoreCase(value, "keep-alive")) out.keepAlive = true;
+        }
+        pos = next + 2;
+    }
+    if (contentLength > HTTP_MAX_BODY) return HttpParseResult::Invalid;
+    size_t bodyStart = headEnd + 4;
+    if (buf.size() - bodyStart < contentLength) return HttpParseResult::Incomplete;
+    out.body = buf.substr(bodyStart, contentLength);
+    end = bodyStart + contentLength;
+    return HttpParseResult::Complete;
+}
+
+/**
+ * @brief Returns the reason phrase for a status code.
+ */
+static const char* reasonPhrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+/**
+ * @brief Formats a complete HTTP/1.1 response.
+ * @param status The status code.
+ * @param body The body.
+ * @param keepAlive False to tell the client the connection closes.
+ * @param contentType The media type of the body.
+ * @return std::string The response bytes.
+ */
+std::string formatHttpResponse(int status, const std::string& body, bool keepAlive, const char* contentType) {
+    std::string out;
+    out.reserve(128 + body.size());
+    out += "HTTP/1.1 ";
+    appendJsonNumber(out, static_cast<long long>(status));
+    out += ' ';
+    out += reasonPhrase(status);
+    out += "\r\nContent-Type: ";
+    out += contentType;
+    out += "\r\nContent-Length: ";
+    appendJsonNumber(out, static_cast<long long>(body.size()));
+    out += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    out += body;
+    return out;
+}
+
+// ---- JSON views of the records ----
+
+static void appendCustomerJson(std::string& out, const Customer& c) {
+    out += '{';
+    appendJsonKey(out, "id", true); appendJsonNumber(out, static_cast<long long>(c.id));
+    appendJsonKey(out, "name"); appendJsonString(out, c.name);
+    appendJsonKey(out, "phone"); appendJsonString(out, c.phone);
+    appendJsonKey(out, "email"); appendJsonString(out, c.email);
+    appendJsonKey(out, "branchId"); appendJsonNumber(out, static_cast<long long>(c.branchId));
+    out += '}';
+}
+
+static void appendVehicleJson(std::string& out, const Vehicle& v) {
+    out += '{';
+    appendJsonKey(out, "id", true); appendJsonNumber(out, static_cast<long long>(v.id));
+    appendJsonKey(out, "customerId"); appendJsonNumber(out, static_cast<long long>(v.customerId));
+    appendJsonKey(out, "regNo"); appendJsonString(out, v.regNo);
+    appendJsonKey(out, "model"); appendJsonString(out, v.model);
+    appendJsonKey(out, "color"); appendJsonString(out, v.color);
+    appendJsonKey(out, "branchId"); appendJsonNumber(out, static_cast<long long>(v.branchId));
+    out += '}';
+}
+
+static void appendServiceJson(std::string& out, const ServiceItem& s) {
+    out += '{';
+    appendJsonKey(out, "id", true); appendJsonNumber(out, static_cast<long long>(s.id));
+    appendJsonKey(out, "name"); appendJsonString(out, s.name);
+    appendJsonKey(out, "price"); appendJsonNumber(out, s.price);
+    appendJsonKey(out, "taxClass"); appendJsonNumber(out, static_cast<long long>(s.taxClass));
+    appendJsonKey(out, "durationMinutes"); appendJsonNumber(out, static_cast<long long>(s.durationMinutes));
+    out += '}';
+}
+
+static void appendDiscountJson(std::string& out, const Discount& d) {
+    out += '{';
+    appendJsonKey(out, "id", true); appendJsonNumber(out, static_cast<long long>(d.id));
+    appendJsonKey(out, "name"); appendJsonString(out, d.name);
+    appendJsonKey(out, "percent"); appendJsonNumber(out, d.percent);
+    appendJsonKey(out, "note"); appendJsonString(out, d.note);
+    out += '}';
+}
+
+static void appendBookingJson(std::string& out, const ServiceHistory& h) {
+    out += '{';
+    appendJsonKey(out, "id", true); appendJsonNumber(out, static_cast<long long>(h.historyId));
+    appendJsonKey(out, "customerId"); appendJsonNumber(out, static_cast<long long>(h.customerId));
+    appendJsonKey(out, "vehicleId"); appendJsonNumber(out, static_cast<long long>(h.vehicleId));
+    appendJsonKey(out, "serviceIds");
+    out += '[';
+    for (size_t i = 0; i < h.serviceIds.size(); ++i) {
+        if (i) out += ',';
+        appendJsonNumber(out, static_cast<long long>(h.serviceIds[i]));
+    }
+    out += ']';
+    appendJsonKey(out, "dateTime"); appendJsonString(out, h.dateTime);
+    appendJsonKey(out, "subtotal"); appendJsonNumber(out, h.subtotal);
+    appendJsonKey(out, "discountId"); appendJsonNumber(out, static_cast<long long>(h.discountId));
+    appendJsonKey(out, "discountPercent"); appendJsonNumber(out, h.discountPercent);
+    appendJsonKey(out, "total"); appendJsonNumber(out, h.total);
+    appendJsonKey(out, "tax"); appendJsonNumber(out, bookingTaxPaise(h) / 100.0);
+    appendJsonKey(out, "status"); appendJsonString(out, h.status);
+    appendJsonKey(out, "branchId"); appendJsonNumber(out, static_cast<long long>(h.branchId));
+    if (!h.stages.empty()) {
+        appendJsonKey(out, "stages");
+        out += '[';
+        for (size_t i = 0; i < h.stages.size(); ++i) {
+            long long at;
+            JobStage stage = static_cast<JobStage>(h.stages[i].stage);
+            if (i) out += ',';
+            out += '{';
+            appendJsonKey(out, "status", true); appendJsonString(out, jobStageStatus(stage));
+            appendJsonKey(out, "at"); appendJsonString(out, stageReachedAt(h, stage, at) ? secondsToDateTime(at) : "");
+            out += '}';
+        }
+        out += ']';
+    }
+    Appointment appt;
+    if (findAppointment(h.historyId, appt)) {
+        appendJsonKey(out, "start"); appendJsonString(out, appt.start);
+        appendJsonKey(out, "bay"); appendJsonNumber(out, static_cast<long long>(appt.bay));
+    }
+    out += '}';
+}
+
+template <typename T, typename Fn>
+static std::string jsonArray(const std::vector<T>& rows, Fn append) {
+    std::string out = "[";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i) out += ',';
+        append(out, rows[i]);
+    }
+    out += ']';
+    return out;
+}
+
+static std::string jsonError(const std::string& message) {
+    std::string out = "{";
+    appendJsonKey(out, "error", true);
+    appendJsonString(out, message);
+    out += '}';
+    return out;
+}
+
+/**
+ * @brief Builds the bill of a booking: its services with names and prices, the amounts and the GST lines.
+ */
+static std::string billJson(const ServiceHistory& h) {
+    auto services = loadServices();
+    std::string out = "{";
+    appendJsonKey(out, "historyId", true); appendJsonNumber(out, static_cast<long long>(h.historyId));
+    appendJsonKey(out, "customerId"); appendJsonNumber(out, static_cast<long long>(h.customerId));
+    appendJsonKey(out, "vehicleId"); appendJsonNumber(out, static_cast<long long>(h.vehicleId));
+    appendJsonKey(out, "dateTime"); appendJsonString(out, h.dateTime);
+    appendJsonKey(out, "items");
+    out += '[';
+    bool first = true;
+    for (int sid : h.serviceIds) {
+        auto it = std::find_if(services.begin(), services.end(), [sid](const ServiceItem& s) { return s.id == sid; });
+        if (it == services.end()) continue;
+        if (!first) out += ',';
+        first = false;
+        appendServiceJson(out, *it);
+    }
+    out += ']';
+    appendJsonKey(out, "subtotal"); appendJsonNumber(out, h.subtotal);
+    appendJsonKey(out, "discountPercent"); appendJsonNumber(out, h.discountPercent);
+    appendJsonKey(out, "discount"); appendJsonNumber(out, h.subtotal - h.total);
+    appendJsonKey(out, "total"); appendJsonNumber(out, h.total);
+    appendJsonKey(out, "taxes");
+    out += '[';
+    for (size_t i = 0; i < h.taxes.size(); ++i) {
+        const TaxLine& t = h.taxes[i];
+        long long cgst, sgst;
+        splitGst(t, cgst, sgst);
+        if (i) out += ',';
+        out += '{';
+        appendJsonKey(out, "taxClass", true); appendJsonNumber(out, static_cast<long long>(t.taxClass));
+        appendJsonKey(out, "ratePercent"); appendJsonNumber(out, t.rateBasisPoints / 100.0);
+        appendJsonKey(out, "taxable"); appendJsonNumber(out, t.taxablePaise / 100.0);
+        appendJsonKey(out, "cgst"); appendJsonNumber(out, cgst / 100.0);
+        appendJsonKey(out, "sgst"); appendJsonNumber(out, sgst / 100.0);
+        out += '}';
+    }
+    out += ']';
+    long long tax = bookingTaxPaise(h);
+    appendJsonKey(out, "tax"); appendJsonNumber(out, tax / 100.0);
+    appendJsonKey(out, "amountDue"); appendJsonNumber(out, (toPaise(h.total) + tax) / 100.0);
+    appendJsonKey(out, "status"); appendJsonString(out, h.status);
+    out += '}';
+    return out;
+}
+
+// ---- Routing ----
+
+/**
+ * @brief Splits a path such as "/customers/7/vehicles" into its segments.
+ */
+static std::vector<std::string> pathSegments(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t pos = 1;
+    while (pos <= path.size()) {
+        size_t next = path.find('/', pos);
+        if (next == std::string::npos) next = path.size();
+        if (next > pos) parts.push_back(path.substr(pos, next - pos));
+        pos = next + 1;
+    }
+    return parts;
+}
+
+static bool parseId(const std::string& s, int& id) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), id);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size() && id > 0;
+}
+
+static bool readIntField(const std::map<std::string, std::string>& f, const char* key, int& out) {
+    auto it = f.find(key);
+    if (it == f.end()) return false;
+    auto r = std::from_chars(it->second.data(), it->second.data() + it->second.size(), out);
+    return r.ec == std::errc() && r.ptr == it->second.data() + it->second.size();
+}
+
+/**
+ * @brief Reads a parameter from a query string such as "from=10&format=text".
+ * @return bool False if the parameter is missing.
+ */
+static bool queryValue(const std::string& query, const std::string& name, std::string& out) {
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) amp = query.size();
+        if (query.compare(pos, name.size() + 1, name + "=") == 0) {
+            out = query.substr(pos + name.size() + 1, amp - pos - name.size() - 1);
+            return true;
+        }
+        pos = amp + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the invoice layout a bill request asks for with ?format=text or ?format=html.
+ * @return bool False for the default JSON bill.
+ */
+static bool billFormat(const HttpRequest& req, InvoiceFormat& format) {
+    std::string value;
+    if (!queryValue(req.query, "format", value)) return false;
+    if (value == "text") format = InvoiceFormat::Text;
+    else if (value == "html") format = InvoiceFormat::Html;
+    else return false;
+    return true;
+}
+
+/**
+ * @brief Returns the media type of the response to a request.
+ * @param req The request.
+ * @param status The status code of the response.
+ * @return const char* "application/json", or a text type for a bill rendered with an invoice template.
+ */
+const char* httpContentType(const HttpRequest& req, int status) {
+    InvoiceFormat format;
+    if (status != 200 || req.path.compare(0, 7, "/bills/") != 0 || !billFormat(req, format)) return "application/json";
+    return format == InvoiceFormat::Html ? "text/html; charset=utf-8" : "text/plain; charset=utf-8";
+}
+
+/**
+ * @brief Reads a numeric parameter from a query string such as "from=10&limit=50".
+ * @return bool False if the parameter is missing or not a number.
+ */
+static bool queryNumber(const std::string& query, const std::string& name, long long& out) {
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) amp = query.size();
+        if (query.compare(pos, name.size() + 1, name + "=") == 0) {
+            const char* begin = query.data() + pos + name.size() + 1;
+            auto r = std::from_chars(begin, query.data() + amp, out);
+            return r.ec == std::errc() && r.ptr == query.data() + amp;
+        }
+        pos = amp + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief Builds a page of the change feed: {"events": [...], "next": <seq to resume from>}.
+ */
+static std::string changesJson(const HttpRequest& req) {
+    long long from = 1, limit = 1000;
+    queryNumber(req.query, "from", from);
+    queryNumber(req.query, "limit", limit);
+    auto events = readChanges(from, static_cast<size_t>(std::max(0LL, limit)));
+    std::string out = "{";
+    appendJsonKey(out, "events", true);
+    out += '[';
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (i) out += ',';
+        out += formatChangeEvent(events[i]);
+    }
+    out += ']';
+    appendJsonKey(out, "next");
+    appendJsonNumber(out, events.empty() ? std::max(from, 1LL) : events.back().seq + 1);
+    out += '}';
+    return out;
+}
+
+/**
+ * @brief Returns the JSON body of GET /availability?services=1,5[&from=...][&count=5]: the next free start times.
+ * @return bool False if the services parameter is missing or malformed.
+ */
+static bool availabilityJson(const HttpRequest& req, std::string& out) {
+    std::string list, from;
+    std::vector<int> serviceIds;
+    if (!queryValue(req.query, "services", list)) return false;
+    for (size_t pos; (pos = list.find("%2C")) != std::string::npos;) list.replace(pos, 3, ",");
+    if (!parseJsonIntArray("[" + list + "]", serviceIds) || serviceIds.empty()) return false;
+    long long count = 5;
+    queryNumber(req.query, "count", count);
+    if (!queryValue(req.query, "from", from)) from = currentDateTime();
+    for (size_t pos; (pos = from.find("%20")) != std::string::npos;) from.replace(pos, 3, " ");
+    std::replace(from.begin(), from.end(), '+', ' ');
+    int slots = slotsForServices(serviceIds);
+    auto offers = nextFreeSlots(slots, from, static_cast<size_t>(std::clamp(count, 1LL, 100LL)));
+    out = "{";
+    appendJsonKey(out, "minutes", true); appendJsonNumber(out, static_cast<long long>(slots * SLOT_MINUTES));
+    appendJsonKey(out, "slots");
+    out += '[';
+    for (size_t i = 0; i < offers.size(); ++i) {
+        if (i) out += ',';
+        out += '{';
+        appendJsonKey(out, "start", true); appendJsonString(out, offers[i].start);
+        appendJsonKey(out, "bay"); appendJsonNumber(out, static_cast<long long>(offers[i].bay));
+        out += '}';
+    }
+    out += "]}";
+    return true;
+}
+
+/**
+ * @brief Appends the count and p50/p90/p99 of a job time sketch, in minutes.
+ */
+static void appendPercentilesJson(std::string& out, const QuantileSketch& s) {
+    out += '{';
+    appendJsonKey(out, "jobs", true); appendJsonNumber(out, static_cast<long long>(s.count));
+    appendJsonKey(out, "p50"); appendJsonNumber(out, static_cast<long long>(sketchQuantile(s, 0.5)));
+    appendJsonKey(out, "p90"); appendJsonNumber(out, static_cast<long long>(sketchQuantile(s, 0.9)));
+    appendJsonKey(out, "p99"); appendJsonNumber(out, static_cast<long long>(sketchQuantile(s, 0.99)));
+    appendJsonKey(out, "max"); appendJsonNumber(out, static_cast<long long>(s.maxValue));
+    out += '}';
+}
+
+/**
+ * @brief Returns the JSON body of GET /job-times?from=YYYY-MM-DD&to=YYYY-MM-DD[&service=1][&branch=2]: wait,
+ *        work and turnaround percentiles of the jobs booked in the range.
+ * @return bool False if a date is missing.
+ */
+static bool jobTimesJson(const HttpRequest& req, std::string& out) {
+    std::string from, to;
+    if (!queryValue(req.query, "from", from) || !queryValue(req.query, "to", to)) return false;
+    long long service = 0, branch = -1;
+    queryNumber(req.query, "service", service);
+    queryNumber(req.query, "branch", branch);
+    JobTimeStats stats = jobTimesBetween(from, to, static_cast<int>(service), static_cast<int>(branch));
+    out = "{";
+    appendJsonKey(out, "wait", true); appendPercentilesJson(out, stats.wait);
+    appendJsonKey(out, "work"); appendPercentilesJson(out, stats.work);
+    appendJsonKey(out, "turnaround"); appendPercentilesJson(out, stats.turnaround);
+    out += '}';
+    return true;
+}
+
+/**
+ * @brief Returns the JSON body of GET /distinct?from=YYYY-MM&to=YYYY-MM[&branch=2]: estimated distinct
+ *        customers and vehicles served in the range.
+ * @return bool False if a month is missing.
+ */
+static bool distinctJson(const HttpRequest& req, std::string& out) {
+    std::string from, to;
+    if (!queryValue(req.query, "from", from) || !queryValue(req.query, "to", to)) return false;
+    long long branch = -1;
+    queryNumber(req.query, "branch", branch);
+    DistinctCounts c = distinctBetween(from, to, static_cast<int>(branch));
+    out = "{";
+    appendJsonKey(out, "customers", true); appendJsonNumber(out, c.customers);
+    appendJsonKey(out, "vehicles"); appendJsonNumber(out, c.vehicles);
+    out += '}';
+    return true;
+}
+
+/**
+ * @brief Returns the JSON body of GET /retention?from=YYYY-MM&to=YYYY-MM: per cohort month, the customers first
+ *        served then and how many were served again in each of the next twelve months.
+ * @return bool False if a month is missing or malformed.
+ */
+static bool retentionJson(const HttpRequest& req, std::string& out) {
+    std::string from, to;
+    if (!queryValue(req.query, "from", from) || !queryValue(req.query, "to", to)) return false;
+    RetentionMatrix m = cohortRetentionBetween(from, to);
+    if (m.cohorts.empty()) return false;
+    out = "[";
+    for (size_t i = 0; i < m.cohorts.size(); ++i) {
+        if (i) out += ',';
+        out += '{';
+        appendJsonKey(out, "cohort", true); appendJsonString(out, m.cohorts[i]);
+        appendJsonKey(out, "size"); appendJsonNumber(out, static_cast<long long>(m.sizes[i]));
+        appendJsonKey(out, "returned");
+        out += '[';
+        for (int k = 0; k < RETENTION_MONTHS; ++k) {
+            if (k) out += ',';
+            appendJsonNumber(out, static_cast<long long>(m.returned[i][k]));
+        }
+        out += "]}";
+    }
+    out += ']';
+    return true;
+}
+
+/**
+ * @brief Builds a report on the thread pool and answers through the deferred callback, so a long scan of the
+ *        history does not hold up the event loop.
+ * @param build Fills the JSON body; returns false if the query is malformed.
+ * @param usage The error message for a malformed query.
+ * @return bool False: the response always comes through later.
+ */
+static bool submitReport(const HttpRequest& req, bool (*build)(const HttpRequest&, std::string&), const char* usage,
+                         const HttpReplyFn& later) {
+    submitTask([req, build, usage, later](const std::atomic<bool>&) {
+        std::string out;
+        try {
+            if (build(req, out)) later(200, out);
+            else later(400, jsonError(usage));
+        } catch (...) {
+            later(500, jsonError("report failed"));
+        }
+    });
+    return false;
+}
+
+/**
+ * @brief Queues a mutation whose response is sent once it is durable.
+ * @return bool False (deferred) on success; true with a 503 if the writer queue is full.
+ */
+static bool submitDeferred(Mutation m, int& status, std::string& body) {
+    if (submitMutation(std::move(m), false)) return false;
+    status = 503;
+    body = jsonError("busy, retry later");
+    return true;
+}
+
+static bool postCustomer(const HttpRequest& req, int& status, std::string& body, const HttpReplyFn& later) {
+    std::map<std::string, std::string> f;
+    if (!parseJsonObject(req.body, f) || f["name"].empty()) {
+        status = 400;
+        body = jsonError("expected {\"name\", \"phone\", \"email\"}");
+        return true;
+    }
+    int branchId = 0;
+    if (!f["branchId"].empty()) {
+        try { branchId = std::stoi(f["branchId"]); } catch (...) { branchId = -1; }
+        if (branchId < 0) {
+            status = 400;
+            body = jsonError("invalid branchId");
+            return true;
+        }
+    }
+    Mutation m;
+    m.type = MutationType::AddCustomer;
+    m.customer = {0, f["name"], f["phone"], f["email"], branchId};
+    Customer created = m.customer;
+    m.done = [later, created](bool ok, int id, const std::string&) mutable {
+        if (!ok) return later(500, jsonError("write failed"));
+        created.id = id;
+        std::string out;
+        appendCustomerJson(out, created);
+        later(201, out);
+    };
+    return submitDeferred(std::move(m), status, body);
+}
+
+static bool postVehicle(const HttpRequest& req, int& status, std::string& body, const HttpReplyFn& later) {
+    std::map<std::string, std::string> f;
+    int customerId;
+    if (!parseJsonObject(req.body, f) || !readIntField(f, "customerId", customerId) || f["regNo"].empty()) {
+        status = 400;
+        body = jsonError("expected {\"customerId\", \"regNo\", \"model\", \"color\"}");
+        return true;
+    }
+    auto customers = loadCustomers();
+    Customer* owner = findCustomerById(customers, customerId);
+    if (!owner) {
+        status = 400;
+        body = jsonError("unknown customerId");
+        return true;
+    }
+    Mutation m;
+    m.type = MutationType::AddVehicle;
+    m.vehicle = {0, customerId, f["regNo"], f["model"], f["color"], owner->branchId};
+    Vehicle created = m.vehicle;
+    m.done = [later, created](bool ok, int id, const std::string&) mutable {
+        if (!ok) return later(500, jsonError("write failed"));
+        created.id = id;
+        std::string out;
+        appendVehicleJson(out, created);
+        later(201, out);
+    };
+    return submitDeferred(std::move(m), status, body);
+}
+
+static bool postBooking(const HttpRequest& req, int& status, std::string& body, const HttpReplyFn& later) {
+    std::map<std::string, std::string> f;
+    int customerId, vehicleId, discountId = 0;
+    std::vector<int> serviceIds;
+    if (!parseJsonObject(req.body, f) || !readIntField(f, "customerId", customerId) ||
+        !readIntField(f, "vehicleId", vehicleId) || !parseJsonIntArray(f["serviceIds"], serviceIds) ||
+        (f.count("discountId") && !readIntField(f, "discountId", discountId))) {
+        status = 400;
+        body = jsonError("expected {\"customerId\", \"vehicleId\", \"serviceIds\": [...], \"discountId\", \"start\"}");
+        return true;
+    }
+    Mutation m;
+    std::string error;
+    if (!prepareBooking(customerId, vehicleId, serviceIds, discountId, m.booking, error)) {
+        status = 400;
+        body = jsonError(error);
+        return true;
+    }
+    const std::string& start = f["start"];
+    if (!start.empty()) {
+        int slots = slotsForServices(serviceIds);
+        if (!validAppointmentStart(start, slots, error)) {
+            status = 400;
+            body = jsonError(error);
+            return true;
+        }
+        auto offers = nextFreeSlots(slots, start, 1);
+        if (offers.empty() || offers[0].start != start) {
+            status = 409;
+            body = jsonError("no bay is free at " + start);
+            return true;
+        }
+        m.appointmentStart = start; // The writer books it; a bay taken meanwhile fails the write
+    }
+    m.type = MutationType::AddBooking;
+    m.booking.dateTime = currentDateTime(); // Stamped now so the response can show it
+    ServiceHistory created = m.booking;
+    m.done = [later, created](bool ok, int id, const std::string&) mutable {
+        if (!ok) return later(500, jsonError("write failed"));
+        created.historyId = id;
+        std::string out;
+        appendBookingJson(out, created);
+        later(201, out);
+    };
+    return submitDeferred(std::move(m), status, body);
+}
+
+static bool putBookingStatus(int historyId, const HttpRequest& req, int& status, std::string& body, const HttpReplyFn& later) {
+    std::map<std::string, std::string> f;
+    if (!parseJsonObject(req.body, f) || f["status"].empty()) {
+        status = 400;
+        body = jsonError("expected {\"status\"}");
+        return true;
+    }
+    ServiceHistory h;
+    if (!findHistoryById(historyId, h)) {
+        status = 404;
+        body = jsonError("booking not found");
+        return true;
+    }
+    std::string error;
+    JobStage stage;
+    if (!parseJobStage(f["status"], stage)) {
+        status = 400;
+        body = jsonError("unknown status " + f["status"]);
+        return true;
+    }
+    if (!checkStatusChange(h.status, f["status"], error)) {
+        status = 409;
+        body = jsonError(error);
+        return true;
+    }
+    Mutation m;
+    m.type = MutationType::SetStatus;
+    m.historyId = historyId;
+    m.status = jobStageStatus(stage);
+    h.status = m.status;
+    m.done = [later, h](bool ok, int, const std::string& error) {
+        if (!error.empty()) return later(409, jsonError(error)); // Another change got there first
+        if (!ok) return later(500, jsonError("write failed"));
+        ServiceHistory updated = h;
+        findHistoryById(h.historyId, updated); // Picks up the stage time just recorded
+        std::string out;
+        appendBookingJson(out, updated);
+        later(200, out);
+    };
+    return submitDeferred(std::move(m), status, body);
+}
+
+/**
+ * @brief Runs a request against the REST API.
+ * @param req The request.
+ * @param status Receives the status code of an immediate response.
+ * @param body Receives the JSON body of an immediate response.
+ * @param later Called with the response once a write is durable or a report is built, if the response is deferred.
+ * @return bool True if status and body hold the response; false if it will come through later.
+ */
+bool routeHttpRequest(const HttpRequest& req, int& status, std::string& body, const HttpReplyFn& later) {
+    auto parts = pathSegments(req.path);
+    bool get = req.method == "GET";
+    int id = 0;
+    bool hasId = parts.size() >= 2 && parseId(parts[1], id);
+    status = 200;
+
+    if (parts.empty()) {
+        status = 404;
+    } else if (parts[0] == "customers") {
+        if (parts.size() == 1 && get) {
+            body = jsonArray(loadCustomers(), appendCustomerJson);
+            return true;
+        }
+        if (parts.size() == 1 && req.method == "POST") return postCustomer(req, status, body, later);
+        if (!hasId || parts.size() > 3) {
+            status = 404;
+        } else if (!get) {
+            status = 405;
+        } else if (parts.size() == 2) {
+            auto list = loadCustomers();
+            Customer* c = findCustomerById(list, id);
+            if (c) appendCustomerJson(body, *c);
+            else status = 404;
+        } else if (parts[2] == "vehicles") {
+            auto list = loadVehicles();
+            list.erase(std::remove_if(list.begin(), list.end(), [id](const Vehicle& v) { return v.customerId != id; }), list.end());
+            body = jsonArray(list, appendVehicleJson);
+        } else if (parts[2] == "bookings") {
+            body = jsonArray(findHistoryRows(HistoryKey::CustomerId, id), appendBookingJson);
+        } else {
+            status = 404;
+        }
+    } else if (parts[0] == "vehicles") {
+        if (parts.size() == 1 && req.method == "POST") return postVehicle(req, status, body, later);
+        if (!get) {
+            status = 405;
+        } else if (parts.size() == 1) {
+            body = jsonArray(loadVehicles(), appendVehicleJson);
+        } else if (hasId && parts.size() == 2) {
+            auto list = loadVehicles();
+            auto it = std::find_if(list.begin(), list.end(), [id](const Vehicle& v) { return v.id == id; });
+            if (it != list.end()) appendVehicleJson(body, *it);
+            else status = 404;
+        } else {
+            status = 404;
+        }
+    } else if (parts[0] == "services" && parts.size() == 1) {
+        if (get) body = jsonArray(loadServices(), appendServiceJson);
+        else status = 405;
+    } else if (parts[0] == "discounts" && parts.size() == 1) {
+        if (get) body = jsonArray(loadDiscounts(), appendDiscountJson);
+        else status = 405;
+    } else if (parts[0] == "bookings") {
+        if (parts.size() == 1) {
+            if (req.method == "POST") return postBooking(req, status, body, later);
+            status = 405;
+        } else if (hasId && parts.size() == 3 && parts[2] == "status") {
+            if (req.method == "PUT") return putBookingStatus(id, req, status, body, later);
+            status = 405;
+        } else if (hasId && parts.size() == 2) {
+            ServiceHistory h;
+            if (!get) status = 405;
+            else if (findHistoryById(id, h)) appendBookingJson(body, h);
+            else status = 404;
+        } else {
+            status = 404;
+        }
+    } else if (parts[0] == "availability" && parts.size() == 1) {
+        if (!get) status = 405;
+        else if (!availabilityJson(req, body)) {
+            status = 400;
+            body = jsonError("expected ?services=1,5[&from=YYYY-MM-DD HH:MM][&count=5]");
+        }
+    } else if (parts[0] == "job-times" && parts.size() == 1) {
+        if (!get) status = 405;
+        else return submitReport(req, jobTimesJson, "expected ?from=YYYY-MM-DD&to=YYYY-MM-DD[&service=1][&branch=0]", later);
+    } else if (parts[0] == "distinct" && parts.size() == 1) {
+        if (!get) status = 405;
+        else if (!distinctJson(req, body)) {
+            status = 400;
+            body = jsonError("expected ?from=YYYY-MM&to=YYYY-MM[&branch=0]");
+        }
+    } else if (parts[0] == "retention" && parts.size() == 1) {
+        if (!get) status = 405;
+        else return submitReport(req, retentionJson, "expected ?from=YYYY-MM&to=YYYY-MM", later);
+    } else if (parts[0] == "changes" && parts.size() == 1) {
+        if (get) body = changesJson(req);
+        else status = 405;
+    } else if (parts[0] == "bills" && hasId && parts.size() == 2) {
+        ServiceHistory h;
+        InvoiceFormat format;
+        if (!get) status = 405;
+        else if (!findHistoryById(id, h)) status = 404;
+        else if (billFormat(req, format)) renderInvoice(h, loadInvoiceContextFor(h), format, body);
+        else body = billJson(h);
+    } else {
+        status = 404;
+    }
+    if (status == 404 && body.empty()) body = jsonError("not found");
+    if (status == 405) body = jsonError("method not allowed");
+    return true;
+}
@@ -0,0 +1,92 @@
+// HttpApi.h
+#ifndef HTTP_API_H
+#define HTTP_API_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Largest request head (request line and headers) accepted.
+ */
+const size_t HTTP_MAX_HEAD = 8 * 1024;
+
+/**
+ * @brief Largest request body accepted.
+ */
+const size_t HTTP_MAX_BODY = 1024 * 1024;
+
+/**
+ * @brief One parsed HTTP/1.x request.
+ */
+struct HttpRequest {
+    std::string method;     /**< Request method, e.g. "GET". */
+    std::string path;       /**< Path without the query string. */
+    std::string query;      /**< Query string without the '?', possibly empty. */
+    std::string body;       /**< Request body (Content-Length bytes). */
+    bool keepAlive = true;  /**< False if the connection closes after the response. */
+};
+
+/**
+ * @brief Outcome of trying to parse a request from buffered bytes.
+ */
+enum class HttpParseResult {
+    Incomplete, /**< More bytes are needed. */
+    Complete,   /**< A request was parsed. */
+    Invalid     /**< The bytes are not a request this server accepts; answer 400 and close. */
+};
+
+/**
+ * @brief Deferred response callback; may be called from any thread.
+ */
+using HttpReplyFn = std::function<void(int status, const std::string& body)>;
+
+/**
+ * @brief Parses one request from a buffer of received bytes.
+ * @param buf The received bytes.
+ * @param start Offset of the request in buf.
+ * @param out Receives the request.
+ * @param end Receives the offset just past the request.
+ * @return HttpParseResult Whether a request was parsed.
+ * @note Requests must carry a Content-Length if they have a body; chunked bodies are refused.
+ */
+HttpParseResult parseHttpRequest(const std::string& buf, size_t start, HttpRequest& out, size_t& end);
+
+/**
+ * @brief Formats a complete HTTP/1.1 response.
+ * @param status The status code.
+ * @param body The body.
+ * @param keepAlive False to tell the client the connection closes.
+ * @param contentType The media type of the body.
+ * @return std::string The response bytes.
+ */
+std::string formatHttpResponse(int status, const std::string& body, bool keepAlive,
+                               const char* contentType = "application/json");
+
+/**
+ * @brief Returns the media type of the response to a request.
+ * @param req The request.
+ * @param status The status code of the response.
+ * @return const char* "application/json", or a text type for a bill rendered with an invoice template.
+ */
+const char* httpContentType(const HttpRequest& req, int status);
+
+/**
+ * @brief Runs a request against the REST API.
+ * @param req The request.
+ * @param status Receives the status code of an immediate response.
+ * @param body Receives the JSON body of an immediate response.
+ * @param later Called with the response once a write is durable or a report is built, if the response is deferred.
+ * @return bool True if status and body hold the response; false if it will come through later.
+ * @note Endpoints: GET /customers, /customers/{id}, /customers/{id}/vehicles, /customers/{id}/bookings,
+ *       /vehicles, /vehicles/{id}, /services, /discounts, /bookings/{id}, /bills/{id} (?format=text or
+ *       ?format=html renders the invoice template instead of JSON),
+ *       /changes?from={seq}&limit={n}, /availability?services={id,...}&from={start}&count={n};
+ *       POST /customers, POST /vehicles, POST /bookings (an optional "start" books an appointment; 409 if no bay is free);
+ *       PUT /bookings/{id}/status (409 if the job lifecycle does not allow the change). Writes go through the
+ *       storage writer and answer 503 if its queue is full. GET /job-times and /retention are built on the
+ *       thread pool and answered through later.
+ */
+bool routeHttpRequest(const HttpRequest& req, int& status, std::string& body, const HttpReplyFn& later);
+
+#endif // HTTP_API_H
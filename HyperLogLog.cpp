@@ -0,0 +1,145 @@
+// HyperLogLog.cpp (implementation)
+#include "HyperLogLog.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief Mixes a 64-bit value (splitmix64 finalizer).
+ * @param x The value.
+ * @return uint64_t The mixed value.
+ */
+static inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Creates an empty HyperLogLog sketch.
+ * @param precision Register index bits, clamped to 4..16.
+ * @return HyperLogLog The empty sketch.
+ */
+HyperLogLog makeHyperLogLog(uint32_t precision) {
+    precision = std::clamp<uint32_t>(precision, 4, 16);
+    return {std::vector<uint8_t>(size_t(1) << precision, 0), precision};
+}
+
+/**
+ * @brief Adds a key to a sketch.
+ * @param h The sketch.
+ * @param key The key to add.
+ * @note The top precision bits of the hash pick the register; the register keeps the largest position of the
+ *       first set bit among the remaining bits.
+ */
+void hllAdd(HyperLogLog& h, int64_t key) {
+    if (h.registers.empty()) return;
+    uint64_t x = mix64(static_cast<uint64_t>(key));
+    size_t index = static_cast<size_t>(x >> (64 - h.precision));
+    uint64_t rest = x << h.precision;
+    uint8_t rank = 1;
+    while (rank <= 64 - h.precision && (rest & (uint64_t(1) << 63)) == 0) {
+        rest <<= 1;
+        ++rank;
+    }
+    if (rank > h.registers[index]) h.registers[index] = rank;
+}
+
+/**
+ * @brief Merges one sketch into another, so it counts the union of both.
+ * @param into The sketch to update.
+ * @param h The sketch to merge.
+ * @return bool False if the precisions differ.
+ */
+bool hllMerge(HyperLogLog& into, const HyperLogLog& h) {
+    if (into.precision != h.precision || into.registers.size() != h.registers.size()) return false;
+    for (size_t i = 0; i < h.registers.size(); ++i) into.registers[i] = std::max(into.registers[i], h.registers[i]);
+    return true;
+}
+
+/**
+ * @brief Estimates the number of distinct keys added to a sketch.
+ * @param h The sketch.
+ * @return long long The estimate, rounded to the nearest key.
+ * @note Small cardinalities, where many registers are still empty, use linear counting instead of the raw
+ *       harmonic-mean estimate.
+ */
+long long hllEstimate(const HyperLogLog& h) {
+    if (h.registers.empty()) return 0;
+    double m = static_cast<double>(h.registers.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : h.registers) {
+        sum += std::ldexp(1.0, -static_cast<int>(r));
+        if (r == 0) ++zeros;
+    }
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * std::log(m / static_cast<double>(zeros));
+    return std::llround(estimate);
+}
+
+/**
+ * @brief Appends the binary form of a sketch to a buffer.
+ * @param h The sketch.
+ * @param out The output buffer.
+ * @note Layout: precision and the number of non-empty registers as 32-bit little-endian values, then either
+ *       every register (dense) or, when fewer than a third are set, each set register as a 16-bit index and
+ *       its value (sparse), as most monthly segments see far fewer keys than there are registers.
+ */
+void serializeHyperLogLog(const HyperLogLog& h, std::string& out) {
+    auto put32 = [&](uint32_t v) {
+        for (int b = 0; b < 32; b += 8) out.push_back(static_cast<char>((v >> b) & 0xFF));
+    };
+    uint32_t used = static_cast<uint32_t>(h.registers.size() - std::count(h.registers.begin(), h.registers.end(), 0));
+    put32(h.precision);
+    put32(used);
+    if (used < h.registers.size() / 3) {
+        for (size_t i = 0; i < h.registers.size(); ++i) {
+            if (h.registers[i] == 0) continue;
+            out.push_back(static_cast<char>(i & 0xFF));
+            out.push_back(static_cast<char>(i >> 8));
+            out.push_back(static_cast<char>(h.registers[i]));
+        }
+    } else {
+        out.append(h.registers.begin(), h.registers.end());
+    }
+}
+
+/**
+ * @brief Reads a sketch written by serializeHyperLogLog.
+ * @param buf The input buffer.
+ * @param pos The read offset, advanced past the sketch on success.
+ * @param h Receives the sketch.
+ * @return bool True if a complete sketch was read.
+ */
+bool deserializeHyperLogLog(const std::string& buf, size_t& pos, HyperLogLog& h) {
+    auto get = [&](size_t at, int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(buf[at + i])) << (8 * i);
+        return v;
+    };
+    if (buf.size() < pos + 8) return false;
+    uint32_t precision = static_cast<uint32_t>(get(pos, 4));
+    uint64_t used = get(pos + 4, 4);
+    if (precision < 4 || precision > 16) return false;
+    size_t m = size_t(1) << precision;
+    size_t at = pos + 8;
+    HyperLogLog result = makeHyperLogLog(precision);
+    if (used < m / 3) {
+        if ((buf.size() - at) / 3 < used) return false;
+        for (uint64_t i = 0; i < used; ++i, at += 3) {
+            size_t index = static_cast<size_t>(get(at, 2));
+            if (index >= m) return false;
+            result.registers[index] = static_cast<uint8_t>(buf[at + 2]);
+        }
+    } else {
+        if (buf.size() - at < m) return false;
+        for (size_t i = 0; i < m; ++i) result.registers[i] = static_cast<uint8_t>(buf[at + i]);
+        at += m;
+    }
+    h = std::move(result);
+    pos = at;
+    return true;
+}
@@ -0,0 +1,64 @@
+// HyperLogLog.h
+#ifndef HYPER_LOG_LOG_H
+#define HYPER_LOG_LOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A HyperLogLog sketch estimating the number of distinct integer keys added to it.
+ * @note Sketches of the same precision merge by taking the larger register, so the union of any set of
+ *       segments is counted in the same fixed memory as one segment.
+ */
+struct HyperLogLog {
+    std::vector<uint8_t> registers; /**< 2^precision registers, each the longest run of leading zeros seen plus one. */
+    uint32_t precision;             /**< Bits of the hash that select a register. */
+};
+
+/**
+ * @brief Creates an empty HyperLogLog sketch.
+ * @param precision Register index bits, from 4 to 16 (12 gives 4096 registers and about 1.6% standard error).
+ * @return HyperLogLog The empty sketch.
+ */
+HyperLogLog makeHyperLogLog(uint32_t precision = 12);
+
+/**
+ * @brief Adds a key to a sketch.
+ * @param h The sketch.
+ * @param key The key to add.
+ */
+void hllAdd(HyperLogLog& h, int64_t key);
+
+/**
+ * @brief Merges one sketch into another, so it counts the union of both.
+ * @param into The sketch to update.
+ * @param h The sketch to merge; ignored unless it has the same precision.
+ * @return bool False if the precisions differ.
+ */
+bool hllMerge(HyperLogLog& into, const HyperLogLog& h);
+
+/**
+ * @brief Estimates the number of distinct keys added to a sketch.
+ * @param h The sketch.
+ * @return long long The estimate, rounded to the nearest key.
+ */
+long long hllEstimate(const HyperLogLog& h);
+
+/**
+ * @brief Appends the binary form of a sketch to a buffer.
+ * @param h The sketch.
+ * @param out The output buffer.
+ */
+void serializeHyperLogLog(const HyperLogLog& h, std::string& out);
+
+/**
+ * @brief Reads a sketch written by serializeHyperLogLog.
+ * @param buf The input buffer.
+ * @param pos The read offset, advanced past the sketch on success.
+ * @param h Receives the sketch.
+ * @return bool True if a complete sketch was read.
+ */
+bool deserializeHyperLogLog(const std::string& buf, size_t& pos, HyperLogLog& h);
+
+#endif // HYPER_LOG_LOG_H
@@ -0,0 +1,887 @@
+// Inventory.cpp (implementation)
+#include "Inventory.h"
+#include "Service.h"
+#include "ChangeFeed.h"
+#include "Storage.h"
+#include "HistoryArchive.h"
+#include "HistoryPartition.h"
+#include "Lifecycle.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef TEST_MODE
+const std::string PARTS_FILE = "tests/test_parts.txt";
+const std::string SERVICE_PARTS_FILE = "tests/test_service_parts.txt";
+const std::string RESERVATION_FILE = "tests/test_part_reservations.txt";
+#else
+const std::string PARTS_FILE = "parts.txt";
+const std::string SERVICE_PARTS_FILE = "service_parts.txt";
+const std::string RESERVATION_FILE = "part_reservations.txt";
+#endif
+
+/**
+ * @brief Units of one part a booking needs or holds.
+ */
+struct PartQuantity {
+    int partId;
+    int quantity;
+};
+
+/**
+ * @brief Units of a part consumed on each of the last USAGE_WINDOW_DAYS days, as a ring indexed by day number.
+ */
+struct UsageWindow {
+    std::array<int, USAGE_WINDOW_DAYS> units{};
+    long long newestDay = 0;    // Day number (days since 1970-01-01) of the newest slot
+    long long total = 0;        // Sum of units
+
+    /** Moves the window forward to a day, clearing the slots of the days that fall out of it. */
+    void advance(long long day) {
+        if (day <= newestDay) return;
+        for (long long d = std::max(newestDay + 1, day - USAGE_WINDOW_DAYS + 1); d <= day; ++d) {
+            int& slot = units[static_cast<size_t>(d % USAGE_WINDOW_DAYS)];
+            total -= slot;
+            slot = 0;
+        }
+        newestDay = day;
+    }
+    /** Records units consumed on a day; days older than the window are ignored. */
+    void add(long long day, int quantity) {
+        advance(day);
+        if (day <= newestDay - USAGE_WINDOW_DAYS) return;
+        units[static_cast<size_t>(day % USAGE_WINDOW_DAYS)] += quantity;
+        total += quantity;
+    }
+};
+
+/**
+ * @brief The inventory as kept in memory: stock by part, bills of materials by service and open reservations.
+ */
+struct InventoryIndex {
+    bool loaded = false;
+    std::vector<Part> parts;                                    // Ordered by ID
+    std::vector<int> reserved;                                  // Units reserved, parallel to parts
+    std::unordered_map<int, size_t> slotOf;                     // Part ID -> index into parts
+    std::vector<ServicePart> bom;                               // Ordered by service, then part
+    std::unordered_map<int, std::pair<size_t, size_t>> bomOf;   // Service ID -> [begin, end) of bom
+    std::unordered_map<int, std::vector<PartQuantity>> reservations; // History ID -> parts held
+    std::unordered_map<int, UsageWindow> usage;                 // Part ID -> recent consumption
+    std::map<int, ReorderLine> reorder;                         // Part ID -> parts at their reorder point
+};
+
+static std::mutex inventoryMutex; // Never held while taking dataFileMutex
+static InventoryIndex inventory;  // Guarded by inventoryMutex
+
+// ---- Files ----
+
+/**
+ * @brief Parses one line of the parts file.
+ * @param line The raw line in "id|name|onHand[|leadTimeDays|safetyStock]" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parsePartLine(const std::string& line, Part& out) {
+    if (line.empty()) return false;
+    std::istringstream ss(line);
+    std::string idStr, name, onHandStr, leadStr, safetyStr;
+    if (!std::getline(ss, idStr, '|')) return false;
+    try {
+        Part p;
+        p.id = std::stoi(idStr);
+        std::getline(ss, name, '|');
+        std::getline(ss, onHandStr, '|');
+        p.name = name;
+        p.onHand = std::stoi(onHandStr);
+        if (std::getline(ss, leadStr, '|')) p.leadTimeDays = std::stoi(leadStr);
+        if (std::getline(ss, safetyStr, '|')) p.safetyStock = std::stoi(safetyStr);
+        out = p;
+        return true;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
+/**
+ * @brief Formats a part as its line in the parts file.
+ * @param p The part.
+ * @return std::string The line (without the newline), as parsePartLine() reads it; the reorder policy is
+ *         appended only when it differs from the default.
+ */
+std::string formatPartLine(const Part& p) {
+    std::ostringstream line;
+    line << p.id << '|' << p.name << '|' << p.onHand;
+    if (p.leadTimeDays != DEFAULT_LEAD_TIME_DAYS || p.safetyStock != 0) line << '|' << p.leadTimeDays << '|' << p.safetyStock;
+    return line.str();
+}
+
+/**
+ * @brief Parses one "serviceId|partId|quantity" line of the bill of materials file.
+ * @param line The raw line.
+ * @param out Receives the parsed line on success.
+ * @return bool True if the line was parsed and its quantity is positive.
+ */
+bool parseServicePartLine(const std::string& line, ServicePart& out) {
+    if (line.empty()) return false;
+    std::istringstream ss(line);
+    std::string serviceStr, partStr, qtyStr;
+    std::getline(ss, serviceStr, '|');
+    std::getline(ss, partStr, '|');
+    std::getline(ss, qtyStr, '|');
+    try {
+        out = {std::stoi(serviceStr), std::stoi(partStr), std::stoi(qtyStr)};
+        return out.quantity > 0;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
+/**
+ * @brief Formats a bill of materials line as "serviceId|partId|quantity".
+ * @param sp The line.
+ * @return std::string The line (without the newline), as parseServicePartLine() reads it.
+ */
+std::string formatServicePartLine(const ServicePart& sp) {
+    return std::to_string(sp.serviceId) + '|' + std::to_string(sp.partId) + '|' + std::to_string(sp.quantity);
+}
+
+/**
+ * @brief Formats a reservation as a "R|historyId|partId:units,..." line of the reservation log.
+ */
+static std::string formatReservationLine(int historyId, const std::vector<PartQuantity>& held) {
+    std::string line = "R|" + std::to_string(historyId) + '|';
+    for (size_t i = 0; i < held.size(); ++i) {
+        if (i) line += ',';
+        line += std::to_string(held[i].partId) + ':' + std::to_string(held[i].quantity);
+    }
+    return line;
+}
+
+/**
+ * @brief Appends one line to the reservation log.
+ * @note Not synced: a reservation or release lost in a crash belongs to a booking that is re-checked at startup.
+ */
+static void appendReservationLog(const std::string& line) {
+    std::ofstream ofs(RESERVATION_FILE, std::ios::app | std::ios::binary);
+    ofs << line << '\n';
+}
+
+static void writePartsLocked() {
+    std::string out;
+    for (const auto& p : inventory.parts) {
+        out += formatPartLine(p);
+        out += '\n';
+    }
+    replaceFileAtomically(PARTS_FILE, out);
+}
+
+/**
+ * @brief Queues the parts that differ between two versions of some rows for the change feed.
+ * @return long long The sequence number to pass to flushChanges(), or 0 if nothing changed.
+ */
+static long long publishPartChanges(const std::vector<Part>& before, const std::vector<Part>& after,
+                                    std::vector<ChangeEvent> changes = {}) {
+    diffTableChanges("part", before, after, [](const Part& p) { return p.id; }, formatPartLine, changes);
+    return changes.empty() ? 0 : publishChanges(std::move(changes));
+}
+
+/**
+ * @brief Rewrites the reservation log with just the open reservations, ordered by booking.
+ */
+static void writeReservationsLocked() {
+    std::map<int, const std::vector<PartQuantity>*> ordered;
+    for (const auto& r : inventory.reservations) ordered[r.first] = &r.second;
+    std::string out;
+    for (const auto& r : ordered) {
+        out += formatReservationLine(r.first, *r.second);
+        out += '\n';
+    }
+    replaceFileAtomically(RESERVATION_FILE, out);
+}
+
+// ---- Reorder points ----
+
+/**
+ * @brief Converts a "YYYY-MM-DD..." date to its day number, or -1 if it is malformed.
+ */
+static long long dayNumber(const std::string& date) {
+    long long seconds;
+    if (date.size() < 10 || !dateTimeToSeconds(date.substr(0, 10) + " 00:00:00", seconds)) return -1;
+    return seconds / 86400;
+}
+
+/**
+ * @brief Re-evaluates one part against its reorder point and updates the reorder list.
+ */
+static void evaluatePartLocked(size_t slot, long long today) {
+    const Part& p = inventory.parts[slot];
+    UsageWindow& w = inventory.usage[p.id];
+    w.advance(today);
+    double rate = static_cast<double>(w.total) / USAGE_WINDOW_DAYS;
+    int available = p.onHand - inventory.reserved[slot];
+    int reorderPoint = static_cast<int>(std::ceil(rate * p.leadTimeDays)) + p.safetyStock;
+    int quantity = static_cast<int>(std::ceil(rate * (p.leadTimeDays + REORDER_COVER_DAYS))) + p.safetyStock - available;
+    if (available <= reorderPoint && quantity > 0) {
+        inventory.reorder[p.id] = {p.id, p.name, available, rate, reorderPoint, quantity};
+    } else {
+        inventory.reorder.erase(p.id);
+    }
+}
+
+/**
+ * @brief Re-evaluates the parts a change touched.
+ */
+static void evaluatePartsLocked(const std::vector<PartQuantity>& touched) {
+    long long today = dayNumber(currentDateTime());
+    for (const auto& q : touched) {
+        auto slot = inventory.slotOf.find(q.partId);
+        if (slot != inventory.slotOf.end()) evaluatePartLocked(slot->second, today);
+    }
+}
+
+/**
+ * @brief Re-evaluates every part, after the stock table itself changed.
+ */
+static void evaluateAllPartsLocked() {
+    long long today = dayNumber(currentDateTime());
+    inventory.reorder.clear();
+    for (size_t i = 0; i < inventory.parts.size(); ++i) evaluatePartLocked(i, today);
+}
+
+// ---- Index ----
+
+/**
+ * @brief Rebuilds the part slots and recomputes the reserved units from the open reservations.
+ */
+static void indexPartsLocked() {
+    auto& inv = inventory;
+    std::sort(inv.parts.begin(), inv.parts.end(), [](const Part& a, const Part& b) { return a.id < b.id; });
+    inv.slotOf.clear();
+    for (size_t i = 0; i < inv.parts.size(); ++i) inv.slotOf[inv.parts[i].id] = i;
+    inv.reserved.assign(inv.parts.size(), 0);
+    for (const auto& r : inv.reservations) {
+        for (const auto& q : r.second) {
+            auto slot = inv.slotOf.find(q.partId);
+            if (slot != inv.slotOf.end()) inv.reserved[slot->second] += q.quantity;
+        }
+    }
+}
+
+/**
+ * @brief Sorts the bill of materials and rebuilds the per-service ranges.
+ */
+static void indexBomLocked() {
+    auto& inv = inventory;
+    std::sort(inv.bom.begin(), inv.bom.end(), [](const ServicePart& a, const ServicePart& b) {
+        return a.serviceId != b.serviceId ? a.serviceId < b.serviceId : a.partId < b.partId;
+    });
+    inv.bomOf.clear();
+    for (size_t i = 0; i < inv.bom.size();) {
+        size_t j = i;
+        while (j < inv.bom.size() && inv.bom[j].serviceId == inv.bom[i].serviceId) ++j;
+        inv.bomOf[inv.bom[i].serviceId] = {i, j};
+        i = j;
+    }
+}
+
+/**
+ * @brief Applies one reservation log line: R opens a reservation, C (consumed) and X (released) close it.
+ * @note Only the reservations change; the caller re-indexes the reserved units.
+ */
+static void replayReservationLineLocked(const std::string& line) {
+    if (line.size() < 3 || line[1] != '|') return;
+    std::istringstream ss(line.substr(2));
+    std::string idStr, list, entry;
+    std::getline(ss, idStr, '|');
+    std::getline(ss, list, '|');
+    try {
+        int historyId = std::stoi(idStr);
+        if (line[0] != 'R') {
+            inventory.reservations.erase(historyId);
+            return;
+        }
+        std::vector<PartQuantity> held;
+        std::istringstream es(list);
+        while (std::getline(es, entry, ',')) {
+            size_t colon = entry.find(':');
+            if (colon == std::string::npos) continue;
+            held.push_back({std::stoi(entry.substr(0, colon)), std::stoi(entry.substr(colon + 1))});
+        }
+        inventory.reservations[historyId] = std::move(held);
+    } catch (...) {} // Torn last line
+}
+
+/**
+ * @brief Loads the parts, bills of materials and reservation log on first use.
+ */
+static void loadInventoryLocked() {
+    auto& inv = inventory;
+    if (inv.loaded) return;
+    inv = InventoryIndex();
+    std::string line;
+    std::ifstream parts(PARTS_FILE);
+    Part p;
+    while (std::getline(parts, line)) {
+        if (parsePartLine(line, p)) inv.parts.push_back(p); // Skip empty or malformed
+    }
+    std::ifstream bom(SERVICE_PARTS_FILE);
+    ServicePart sp;
+    while (std::getline(bom, line)) {
+        if (parseServicePartLine(line, sp)) inv.bom.push_back(sp);
+    }
+
+    std::ifstream log(RESERVATION_FILE);
+    while (std::getline(log, line)) replayReservationLineLocked(line);
+    indexPartsLocked();
+    indexBomLocked();
+    inv.loaded = true;
+    evaluateAllPartsLocked();
+}
+
+/**
+ * @brief Adds up the parts a set of services needs, one entry per part.
+ */
+static void partsNeededLocked(const std::vector<int>& serviceIds, std::vector<PartQuantity>& needs) {
+    needs.clear();
+    for (int sid : serviceIds) {
+        auto range = inventory.bomOf.find(sid);
+        if (range == inventory.bomOf.end()) continue;
+        for (size_t i = range->second.first; i < range->second.second; ++i) {
+            const ServicePart& line = inventory.bom[i];
+            auto it = std::find_if(needs.begin(), needs.end(), [&](const PartQuantity& q) { return q.partId == line.partId; });
+            if (it == needs.end()) needs.push_back({line.partId, line.quantity});
+            else it->quantity += line.quantity;
+        }
+    }
+}
+
+/**
+ * @brief Appends every part whose need exceeds its available units.
+ */
+static bool findShortagesLocked(const std::vector<PartQuantity>& needs, std::vector<PartShortage>& shortages) {
+    shortages.clear();
+    for (const auto& q : needs) {
+        auto slot = inventory.slotOf.find(q.partId);
+        if (slot == inventory.slotOf.end()) {
+            shortages.push_back({q.partId, "#" + std::to_string(q.partId), q.quantity, 0});
+            continue;
+        }
+        const Part& p = inventory.parts[slot->second];
+        int available = p.onHand - inventory.reserved[slot->second];
+        if (q.quantity > available) shortages.push_back({p.id, p.name, q.quantity, std::max(0, available)});
+    }
+    return shortages.empty();
+}
+
+/**
+ * @brief Closes a reservation, optionally taking its units out of stock.
+ */
+static bool closeReservationLocked(int historyId, bool consume) {
+    loadInventoryLocked();
+    auto it = inventory.reservations.find(historyId);
+    if (it == inventory.reservations.end()) return false;
+    long long today = dayNumber(currentDateTime());
+    std::vector<Part> before, after;
+    for (const auto& q : it->second) {
+        if (consume) inventory.usage[q.partId].add(today, q.quantity);
+        auto slot = inventory.slotOf.find(q.partId);
+        if (slot == inventory.slotOf.end()) continue;
+        inventory.reserved[slot->second] -= q.quantity;
+        if (!consume) continue;
+        before.push_back(inventory.parts[slot->second]);
+        inventory.parts[slot->second].onHand -= q.quantity;
+        after.push_back(inventory.parts[slot->second]);
+    }
+    std::vector<PartQuantity> held = std::move(it->second);
+    inventory.reservations.erase(it);
+    evaluatePartsLocked(held);
+    std::string line = std::string(consume ? "C|" : "X|") + std::to_string(historyId);
+    if (consume) {
+        // Stock first, then a synced close line: the booking's status is logged only after this returns, so
+        // a lost line would reopen the reservation and let the restarted booking consume it again.
+        writePartsLocked();
+        appendFileDurably(RESERVATION_FILE, line + '\n');
+    } else {
+        appendReservationLog(line);
+    }
+    publishPartChanges(before, after, {{0, "reservation", "delete", formatReservationLine(historyId, held), ""}});
+    return true;
+}
+
+// ---- Queries and updates ----
+
+/**
+ * @brief Returns all parts with their stock levels.
+ * @return std::vector<Part> The parts, ordered by ID.
+ */
+std::vector<Part> loadParts() {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    return inventory.parts;
+}
+
+/**
+ * @brief Saves the parts, keeping the first occurrence of each ID, and updates the in-memory inventory.
+ * @param list The parts.
+ */
+void saveParts(const std::vector<Part>& list) {
+    std::map<int, Part> unique;
+    for (const auto& p : list) unique.emplace(p.id, p);
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    std::vector<Part> before = std::move(inventory.parts);
+    inventory.parts.clear();
+    for (const auto& p : unique) inventory.parts.push_back(p.second);
+    indexPartsLocked();
+    evaluateAllPartsLocked();
+    writePartsLocked();
+    if (long long seq = publishPartChanges(before, inventory.parts)) flushChanges(seq);
+}
+
+/**
+ * @brief Returns every service's bill of materials.
+ * @return std::vector<ServicePart> The lines, ordered by service then part.
+ */
+std::vector<ServicePart> loadServiceParts() {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    return inventory.bom;
+}
+
+/**
+ * @brief Saves the bills of materials, keeping the first line of each service and part pair.
+ * @param list The lines; lines with a quantity of 0 or less are dropped.
+ */
+void saveServiceParts(const std::vector<ServicePart>& list) {
+    std::map<std::pair<int, int>, ServicePart> unique;
+    for (const auto& sp : list) {
+        if (sp.quantity > 0) unique.emplace(std::make_pair(sp.serviceId, sp.partId), sp);
+    }
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    std::map<std::pair<int, int>, std::string> old;
+    for (const auto& sp : inventory.bom) old.emplace(std::make_pair(sp.serviceId, sp.partId), formatServicePartLine(sp));
+    inventory.bom.clear();
+    std::string out;
+    std::vector<ChangeEvent> changes;
+    for (const auto& p : unique) {
+        inventory.bom.push_back(p.second);
+        std::string line = formatServicePartLine(p.second);
+        out += line + '\n';
+        auto it = old.find(p.first);
+        if (it == old.end()) {
+            changes.push_back({0, "service_part", "insert", "", line});
+        } else {
+            if (it->second != line) changes.push_back({0, "service_part", "update", it->second, line});
+            old.erase(it);
+        }
+    }
+    for (const auto& o : old) changes.push_back({0, "service_part", "delete", o.second, ""});
+    indexBomLocked();
+    replaceFileAtomically(SERVICE_PARTS_FILE, out);
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
+}
+
+/**
+ * @brief Adds received units to a part's stock.
+ * @param partId The part.
+ * @param units The units received (negative to write off stock).
+ * @return bool True if the part exists.
+ */
+bool receiveParts(int partId, int units) {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    auto slot = inventory.slotOf.find(partId);
+    if (slot == inventory.slotOf.end()) return false;
+    Part before = inventory.parts[slot->second];
+    inventory.parts[slot->second].onHand += units;
+    evaluatePartsLocked({{partId, units}});
+    writePartsLocked();
+    if (long long seq = publishPartChanges({before}, {inventory.parts[slot->second]})) flushChanges(seq);
+    return true;
+}
+
+/**
+ * @brief Returns the units of a part that are on hand and not reserved.
+ * @param partId The part.
+ * @return int The available units, or 0 for an unknown part.
+ */
+int availableParts(int partId) {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    auto slot = inventory.slotOf.find(partId);
+    return slot == inventory.slotOf.end() ? 0 : inventory.parts[slot->second].onHand - inventory.reserved[slot->second];
+}
+
+/**
+ * @brief Returns the units of a part reserved by pending bookings.
+ * @param partId The part.
+ * @return int The reserved units.
+ */
+int reservedParts(int partId) {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    auto slot = inventory.slotOf.find(partId);
+    return slot == inventory.slotOf.end() ? 0 : inventory.reserved[slot->second];
+}
+
+/**
+ * @brief Checks that the parts of a set of services are available, without reserving them.
+ * @param serviceIds The services (a service may repeat).
+ * @param shortages Receives every part that is short.
+ * @return bool True if nothing is short.
+ */
+bool checkPartsAvailable(const std::vector<int>& serviceIds, std::vector<PartShortage>& shortages) {
+    thread_local std::vector<PartQuantity> needs;
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    partsNeededLocked(serviceIds, needs);
+    return findShortagesLocked(needs, shortages);
+}
+
+/**
+ * @brief Reserves the parts of a booking's services: all of them, or none if any is short.
+ * @param historyId The booking the reservation belongs to.
+ * @param serviceIds The booked services.
+ * @param shortages Receives every part that is short if the reservation is refused.
+ * @return bool True if the parts were reserved (or none are needed).
+ */
+bool reserveParts(int historyId, const std::vector<int>& serviceIds, std::vector<PartShortage>& shortages) {
+    std::vector<PartQuantity> needs;
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    if (inventory.reservations.count(historyId)) closeReservationLocked(historyId, false); // Re-booked ID
+    partsNeededLocked(serviceIds, needs);
+    if (!findShortagesLocked(needs, shortages)) return false;
+    if (needs.empty()) return true;
+    for (const auto& q : needs) inventory.reserved[inventory.slotOf[q.partId]] += q.quantity;
+    evaluatePartsLocked(needs);
+    std::string line = formatReservationLine(historyId, needs);
+    appendReservationLog(line);
+    publishChanges({{0, "reservation", "insert", "", line}}); // Written to the feed with the booking's changes
+    inventory.reservations[historyId] = std::move(needs);
+    return true;
+}
+
+/**
+ * @brief Takes a completed booking's reserved parts out of stock.
+ * @param historyId The booking.
+ * @return bool True if the booking had a reservation.
+ */
+bool consumeParts(int historyId) {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    return closeReservationLocked(historyId, true);
+}
+
+/**
+ * @brief Returns a booking's reserved parts to the available stock.
+ * @param historyId The booking.
+ * @return bool True if the booking had a reservation.
+ */
+bool releaseParts(int historyId) {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    return closeReservationLocked(historyId, false);
+}
+
+/**
+ * @brief Drops the reservations of bookings that are no longer pending and rewrites the reservation log.
+ * @return int The number of reservations dropped.
+ */
+int reconcilePartReservations() {
+    std::unordered_map<int, bool> pending; // History ID -> still awaiting completion
+    for (const auto& h : loadHistory()) pending[h.historyId] = isOpenStatus(h.status); // Last occurrence wins
+
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    int dropped = 0;
+    std::vector<ChangeEvent> changes;
+    for (auto it = inventory.reservations.begin(); it != inventory.reservations.end();) {
+        auto p = pending.find(it->first);
+        if (p != pending.end() && p->second) {
+            ++it;
+        } else {
+            changes.push_back({0, "reservation", "delete", formatReservationLine(it->first, it->second), ""});
+            it = inventory.reservations.erase(it);
+            ++dropped;
+        }
+    }
+    indexPartsLocked();
+    evaluateAllPartsLocked();
+    writeReservationsLocked();
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
+    return dropped;
+}
+
+/**
+ * @brief Returns the open reservations as reservation log lines.
+ * @return std::vector<std::string> One "R|historyId|partId:units,..." line per reservation, ordered by booking.
+ */
+std::vector<std::string> loadPartReservationLines() {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    std::map<int, const std::vector<PartQuantity>*> ordered;
+    for (const auto& r : inventory.reservations) ordered[r.first] = &r.second;
+    std::vector<std::string> lines;
+    for (const auto& r : ordered) lines.push_back(formatReservationLine(r.first, *r.second));
+    return lines;
+}
+
+/**
+ * @brief Opens and closes reservations from reservation log lines, without changing the stock.
+ * @param lines "R|..." lines open (or replace) a booking's reservation; any other line closes it.
+ * @param replace True to drop every other reservation first.
+ */
+void applyPartReservationLines(const std::vector<std::string>& lines, bool replace) {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    if (replace) inventory.reservations.clear();
+    for (const auto& line : lines) replayReservationLineLocked(line);
+    indexPartsLocked();
+    evaluateAllPartsLocked();
+    if (replace) {
+        writeReservationsLocked();
+        return;
+    }
+    for (const auto& line : lines) appendReservationLog(line);
+}
+
+/**
+ * @brief Rebuilds each part's consumption window from the completed bookings of the last USAGE_WINDOW_DAYS days.
+ * @param today The current date in "YYYY-MM-DD" format.
+ * @return int The number of bookings counted.
+ */
+int refreshPartUsage(const std::string& today) {
+    long long day = dayNumber(today);
+    if (day < 0) return 0;
+    std::string from = secondsToDateTime((day - USAGE_WINDOW_DAYS + 1) * 86400).substr(0, 10);
+    std::vector<ServiceHistory> rows = loadHistoryBetween(from, today.substr(0, 10)); // Before locking: takes dataFileMutex
+
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    inventory.usage.clear();
+    int counted = 0;
+    std::vector<PartQuantity> needs;
+    for (const auto& h : rows) {
+        if (!isDoneStatus(h.status)) continue;
+        long long used = dayNumber(h.dateTime); // The booking date stands in for the completion date
+        if (used < 0) continue;
+        partsNeededLocked(h.serviceIds, needs);
+        for (const auto& q : needs) inventory.usage[q.partId].add(used, q.quantity);
+        ++counted;
+    }
+    for (auto& u : inventory.usage) u.second.advance(day);
+    inventory.reorder.clear();
+    for (size_t i = 0; i < inventory.parts.size(); ++i) evaluatePartLocked(i, day);
+    return counted;
+}
+
+/**
+ * @brief Returns the parts at or below their reorder point.
+ * @return std::vector<ReorderLine> The parts, ordered by ID.
+ */
+std::vector<ReorderLine> reorderList() {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    std::vector<ReorderLine> list;
+    for (const auto& r : inventory.reorder) list.push_back(r.second);
+    return list;
+}
+
+/**
+ * @brief Returns the parts used by a set of services that are at or below their reorder point.
+ * @param serviceIds The services.
+ * @return std::vector<ReorderLine> The parts, ordered by ID.
+ */
+std::vector<ReorderLine> lowStockFor(const std::vector<int>& serviceIds) {
+    std::vector<PartQuantity> needs;
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    loadInventoryLocked();
+    partsNeededLocked(serviceIds, needs);
+    std::vector<ReorderLine> list;
+    for (const auto& q : needs) {
+        auto r = inventory.reorder.find(q.partId);
+        if (r != inventory.reorder.end()) list.push_back(r->second);
+    }
+    std::sort(list.begin(), list.end(), [](const ReorderLine& a, const ReorderLine& b) { return a.partId < b.partId; });
+    return list;
+}
+
+/**
+ * @brief Discards the in-memory inventory so the next call reloads it from the files.
+ */
+void reloadInventory() {
+    std::lock_guard<std::mutex> lock(inventoryMutex);
+    inventory = InventoryIndex();
+}
+
+/**
+ * @brief Describes shortages for an error message, e.g. "insufficient stock: Oil Filter (need 2, have 1)".
+ * @param shortages The shortages.
+ * @return std::string The description.
+ */
+std::string describeShortages(const std::vector<PartShortage>& shortages) {
+    std::string out = "insufficient stock:";
+    for (size_t i = 0; i < shortages.size(); ++i) {
+        const auto& s = shortages[i];
+        out += (i ? ", " : " ") + s.name + " (need " + std::to_string(s.needed) + ", have " + std::to_string(s.available) + ")";
+    }
+    return out;
+}
+
+// ---- Console ----
+
+/**
+ * @brief Displays the parts with their on-hand, reserved and available units.
+ */
+void viewParts() {
+    std::vector<Part> parts;
+    std::vector<int> reserved;
+    {
+        std::lock_guard<std::mutex> lock(inventoryMutex);
+        loadInventoryLocked();
+        parts = inventory.parts;
+        reserved = inventory.reserved;
+    }
+    if (parts.empty()) {
+        std::cout << "No parts found.\n";
+        return;
+    }
+    size_t maxName = 4; // "Name"
+    for (const auto& p : parts) maxName = std::max(maxName, p.name.length());
+    std::cout << std::left << std::setw(6) << "ID" << std::setw(maxName + 2) << "Name" << std::right
+              << std::setw(9) << "On hand" << std::setw(10) << "Reserved" << std::setw(11) << "Available" << "\n";
+    std::cout << std::string(maxName + 38, '-') << "\n";
+    for (size_t i = 0; i < parts.size(); ++i) {
+        std::cout << std::left << std::setw(6) << parts[i].id << std::setw(maxName + 2) << parts[i].name << std::right
+                  << std::setw(9) << parts[i].onHand << std::setw(10) << reserved[i]
+                  << std::setw(11) << parts[i].onHand - reserved[i] << "\n";
+    }
+}
+
+/**
+ * @brief Displays every service's bill of materials.
+ */
+void viewServiceParts() {
+    auto bom = loadServiceParts();
+    if (bom.empty()) {
+        std::cout << "No service uses parts.\n";
+        return;
+    }
+    std::map<int, std::string> services, parts;
+    for (const auto& s : loadServices()) services[s.id] = s.name;
+    for (const auto& p : loadParts()) parts[p.id] = p.name;
+    int current = -1;
+    for (const auto& sp : bom) {
+        if (sp.serviceId != current) {
+            current = sp.serviceId;
+            auto s = services.find(current);
+            std::cout << current << ". " << (s == services.end() ? "(deleted service)" : s->second) << "\n";
+        }
+        auto p = parts.find(sp.partId);
+        std::cout << "   " << sp.quantity << " x " << (p == parts.end() ? "#" + std::to_string(sp.partId) : p->second) << "\n";
+    }
+}
+
+/**
+ * @brief Interactively adds a new part with its opening stock.
+ */
+void addPartInteractive() {
+    auto list = loadParts();
+    Part p;
+    p.id = list.empty() ? 1 : list.back().id + 1;
+    std::cout << "Enter part name: "; std::getline(std::cin, p.name);
+    std::cout << "Enter opening stock: "; std::cin >> p.onHand; std::cin.ignore();
+    if (!std::cin || p.onHand < 0) {
+        std::cin.clear();
+        std::cout << "Invalid stock.\n";
+        return;
+    }
+    list.push_back(p);
+    saveParts(list);
+    std::cout << "Part added with ID: " << p.id << "\n";
+}
+
+/**
+ * @brief Interactively adds received units to a part's stock.
+ */
+void receiveStockInteractive() {
+    viewParts();
+    std::cout << "Enter part ID: "; int id; std::cin >> id;
+    std::cout << "Enter units received: "; int units; std::cin >> units; std::cin.ignore();
+    if (!receiveParts(id, units)) {
+        std::cout << "Part not found.\n";
+        return;
+    }
+    std::cout << "Stock updated; " << availableParts(id) << " available.\n";
+}
+
+/**
+ * @brief Interactively sets the units of a part a service consumes (0 removes the line).
+ */
+void setServicePartInteractive() {
+    viewServiceParts();
+    ServicePart sp;
+    std::cout << "Enter service ID: "; std::cin >> sp.serviceId;
+    std::cout << "Enter part ID: "; std::cin >> sp.partId;
+    std::cout << "Enter units per service (0 to remove): "; std::cin >> sp.quantity; std::cin.ignore();
+    auto bom = loadServiceParts();
+    bom.erase(std::remove_if(bom.begin(), bom.end(), [&](const ServicePart& b) {
+        return b.serviceId == sp.serviceId && b.partId == sp.partId;
+    }), bom.end());
+    bom.push_back(sp);
+    saveServiceParts(bom);
+    std::cout << "Bill of materials updated.\n";
+}
+
+/**
+ * @brief Displays the parts to reorder with their usage, reorder point and suggested quantity.
+ */
+void viewReorderList() {
+    auto list = reorderList();
+    if (list.empty()) {
+        std::cout << "No parts need reordering.\n";
+        return;
+    }
+    size_t maxName = 4; // "Name"
+    for (const auto& r : list) maxName = std::max(maxName, r.name.length());
+    std::cout << std::left << std::setw(6) << "ID" << std::setw(maxName + 2) << "Name" << std::right
+              << std::setw(11) << "Available" << std::setw(10) << "Per day" << std::setw(15) << "Reorder point"
+              << std::setw(8) << "Order" << "\n";
+    std::cout << std::string(maxName + 52, '-') << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& r : list) {
+        std::cout << std::left << std::setw(6) << r.partId << std::setw(maxName + 2) << r.name << std::right
+                  << std::setw(11) << r.available << std::setw(10) << r.dailyUsage << std::setw(15) << r.reorderPoint
+                  << std::setw(8) << r.orderQuantity << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+}
+
+/**
+ * @brief Interactively sets a part's lead time and safety stock.
+ */
+void setReorderPolicyInteractive() {
+    auto list = loadParts();
+    std::cout << "Enter part ID: "; int id; std::cin >> id; std::cin.ignore();
+    for (auto& p : list) {
+        if (p.id != id) continue;
+        std::cout << "Enter lead time in days (currently " << p.leadTimeDays << "): "; std::cin >> p.leadTimeDays;
+        std::cout << "Enter safety stock (currently " << p.safetyStock << "): "; std::cin >> p.safetyStock; std::cin.ignore();
+        if (!std::cin || p.leadTimeDays < 0 || p.safetyStock < 0) {
+            std::cin.clear();
+            std::cout << "Invalid policy.\n";
+            return;
+        }
+        saveParts(list);
+        std::cout << "Reorder policy updated.\n";
+        return;
+    }
+    std::cout << "Part not found.\n";
+}
@@ -0,0 +1,275 @@
+// Inventory.h
+#ifndef INVENTORY_H
+#define INVENTORY_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Days of consumption the reorder calculation averages over.
+ */
+const int USAGE_WINDOW_DAYS = 28;
+
+/**
+ * @brief Days of consumption a suggested order covers beyond the lead time.
+ */
+const int REORDER_COVER_DAYS = 14;
+
+/**
+ * @brief Supplier lead time assumed for parts that do not set one.
+ */
+const int DEFAULT_LEAD_TIME_DAYS = 7;
+
+/**
+ * @brief A spare part or consumable kept in stock.
+ */
+struct Part {
+    int id;             /**< Unique identifier for the part. */
+    std::string name;   /**< Name of the part, e.g. "Oil Filter". */
+    int onHand;         /**< Units physically in stock, including those reserved for pending bookings. */
+    int leadTimeDays = DEFAULT_LEAD_TIME_DAYS; /**< Days from ordering the part to receiving it. */
+    int safetyStock = 0; /**< Units to keep beyond the expected use during the lead time. */
+};
+
+/**
+ * @brief One line of a service's bill of materials.
+ */
+struct ServicePart {
+    int serviceId;      /**< The service that consumes the part. */
+    int partId;         /**< The part. */
+    int quantity;       /**< Units consumed each time the service is performed. */
+};
+
+/**
+ * @brief A part a booking needs more of than is available.
+ */
+struct PartShortage {
+    int partId;         /**< The part. */
+    std::string name;   /**< Its name. */
+    int needed;         /**< Units the booking needs. */
+    int available;      /**< Units on hand and not reserved. */
+};
+
+/**
+ * @brief A part that has fallen to its reorder point.
+ */
+struct ReorderLine {
+    int partId;         /**< The part. */
+    std::string name;   /**< Its name. */
+    int available;      /**< Units on hand and not reserved. */
+    double dailyUsage;  /**< Units consumed per day over the last USAGE_WINDOW_DAYS days. */
+    int reorderPoint;   /**< Expected use during the lead time plus the safety stock. */
+    int orderQuantity;  /**< Units to order to cover the lead time and REORDER_COVER_DAYS more. */
+};
+
+/**
+ * @brief Parses one line of the parts file.
+ * @param line The raw line in "id|name|onHand[|leadTimeDays|safetyStock]" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parsePartLine(const std::string& line, Part& out);
+
+/**
+ * @brief Formats a part as its line in the parts file.
+ * @param p The part.
+ * @return std::string The line (without the newline).
+ */
+std::string formatPartLine(const Part& p);
+
+/**
+ * @brief Parses one "serviceId|partId|quantity" line of the bill of materials file.
+ * @param line The raw line.
+ * @param out Receives the parsed line on success.
+ * @return bool True if the line was parsed and its quantity is positive.
+ */
+bool parseServicePartLine(const std::string& line, ServicePart& out);
+
+/**
+ * @brief Formats a bill of materials line as "serviceId|partId|quantity".
+ * @param sp The line.
+ * @return std::string The line (without the newline).
+ */
+std::string formatServicePartLine(const ServicePart& sp);
+
+/**
+ * @brief Returns all parts with their stock levels.
+ * @return std::vector<Part> The parts, ordered by ID.
+ */
+std::vector<Part> loadParts();
+
+/**
+ * @brief Saves the parts, keeping the first occurrence of each ID, and updates the in-memory inventory.
+ * @param list The parts.
+ * @note Outstanding reservations are kept, including those of parts no longer listed. The rows that changed
+ *       are published to the change feed.
+ */
+void saveParts(const std::vector<Part>& list);
+
+/**
+ * @brief Returns every service's bill of materials.
+ * @return std::vector<ServicePart> The lines, ordered by service then part.
+ */
+std::vector<ServicePart> loadServiceParts();
+
+/**
+ * @brief Saves the bills of materials, keeping the first line of each service and part pair.
+ * @param list The lines; lines with a quantity of 0 or less are dropped.
+ * @note The lines that changed are published to the change feed as "service_part" events.
+ */
+void saveServiceParts(const std::vector<ServicePart>& list);
+
+/**
+ * @brief Adds received units to a part's stock.
+ * @param partId The part.
+ * @param units The units received (negative to write off stock).
+ * @return bool True if the part exists.
+ */
+bool receiveParts(int partId, int units);
+
+/**
+ * @brief Returns the units of a part that are on hand and not reserved.
+ * @param partId The part.
+ * @return int The available units, or 0 for an unknown part.
+ */
+int availableParts(int partId);
+
+/**
+ * @brief Returns the units of a part reserved by pending bookings.
+ * @param partId The part.
+ * @return int The reserved units.
+ */
+int reservedParts(int partId);
+
+/**
+ * @brief Checks that the parts of a set of services are available, without reserving them.
+ * @param serviceIds The services (a service may repeat).
+ * @param shortages Receives every part that is short.
+ * @return bool True if nothing is short.
+ * @note Answered from the in-memory index: one hash lookup per service and one per part it uses.
+ */
+bool checkPartsAvailable(const std::vector<int>& serviceIds, std::vector<PartShortage>& shortages);
+
+/**
+ * @brief Reserves the parts of a booking's services: all of them, or none if any is short.
+ * @param historyId The booking the reservation belongs to.
+ * @param serviceIds The booked services.
+ * @param shortages Receives every part that is short if the reservation is refused.
+ * @return bool True if the parts were reserved (or none are needed).
+ * @note Checking and reserving happen under one lock, so concurrent bookings cannot both take the last unit.
+ *       The reservation is appended to the reservation log and queued for the change feed; it is written
+ *       there with the booking's own changes.
+ */
+bool reserveParts(int historyId, const std::vector<int>& serviceIds, std::vector<PartShortage>& shortages);
+
+/**
+ * @brief Takes a completed booking's reserved parts out of stock.
+ * @param historyId The booking.
+ * @return bool True if the booking had a reservation.
+ * @note The parts and the closed reservation are queued for the change feed ahead of the booking's change.
+ */
+bool consumeParts(int historyId);
+
+/**
+ * @brief Returns a booking's reserved parts to the available stock.
+ * @param historyId The booking.
+ * @return bool True if the booking had a reservation.
+ */
+bool releaseParts(int historyId);
+
+/**
+ * @brief Drops the reservations of jobs that are no longer open and rewrites the reservation log.
+ * @return int The number of reservations dropped.
+ * @note Run at startup after the history log is recovered. Reservations of bookings that never reached the
+ *       history (a crash between reserving and logging) or were cancelled are released; those of completed bookings are dropped
+ *       without changing the stock, since consumption rewrites the parts file and syncs its close line before
+ *       the status is logged.
+ */
+int reconcilePartReservations();
+
+/**
+ * @brief Returns the open reservations as reservation log lines.
+ * @return std::vector<std::string> One "R|historyId|partId:units,..." line per reservation, ordered by booking.
+ */
+std::vector<std::string> loadPartReservationLines();
+
+/**
+ * @brief Opens and closes reservations from reservation log lines, without changing the stock.
+ * @param lines "R|..." lines open (or replace) a booking's reservation; any other line closes it.
+ * @param replace True to drop every other reservation first and rewrite the log; otherwise the lines are appended.
+ * @note Used by standbys: the stock the primary consumed arrives as part rows of its own.
+ */
+void applyPartReservationLines(const std::vector<std::string>& lines, bool replace);
+
+/**
+ * @brief Rebuilds each part's consumption window from the completed bookings of the last USAGE_WINDOW_DAYS days.
+ * @param today The current date in "YYYY-MM-DD" format.
+ * @return int The number of bookings counted.
+ * @note Only the history partitions inside the window are read. Run at startup; afterwards consumeParts() keeps
+ *       the windows current.
+ */
+int refreshPartUsage(const std::string& today);
+
+/**
+ * @brief Returns the parts at or below their reorder point.
+ * @return std::vector<ReorderLine> The parts, ordered by ID.
+ * @note Kept up to date incrementally: reserving, consuming, releasing or receiving a part re-evaluates just that
+ *       part, so the list is returned without scanning the stock table or the history.
+ */
+std::vector<ReorderLine> reorderList();
+
+/**
+ * @brief Returns the parts used by a set of services that are at or below their reorder point.
+ * @param serviceIds The services.
+ * @return std::vector<ReorderLine> The parts, ordered by ID.
+ */
+std::vector<ReorderLine> lowStockFor(const std::vector<int>& serviceIds);
+
+/**
+ * @brief Discards the in-memory inventory so the next call reloads it from the files.
+ */
+void reloadInventory();
+
+/**
+ * @brief Describes shortages for an error message, e.g. "insufficient stock: Oil Filter (need 2, have 1)".
+ * @param shortages The shortages.
+ * @return std::string The description.
+ */
+std::string describeShortages(const std::vector<PartShortage>& shortages);
+
+/**
+ * @brief Displays the parts with their on-hand, reserved and available units.
+ */
+void viewParts();
+
+/**
+ * @brief Displays every service's bill of materials.
+ */
+void viewServiceParts();
+
+/**
+ * @brief Interactively adds a new part with its opening stock.
+ */
+void addPartInteractive();
+
+/**
+ * @brief Interactively adds received units to a part's stock.
+ */
+void receiveStockInteractive();
+
+/**
+ * @brief Interactively sets the units of a part a service consumes (0 removes the line).
+ */
+void setServicePartInteractive();
+
+/**
+ * @brief Displays the parts to reorder with their usage, reorder point and suggested quantity.
+ */
+void viewReorderList();
+
+/**
+ * @brief Interactively sets a part's lead time and safety stock.
+ */
+void setReorderPolicyInteractive();
+
+#endif // INVENTORY_H
@@ -0,0 +1,281 @@
+// Invoice.cpp (implementation)
+#include "Invoice.h"
+#include "HistoryPartition.h"
+#include "HistoryArchive.h"
+#include "ThreadPool.h"
+#include "Tax.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#ifdef TEST_MODE
+const std::string INVOICE_DIR = "tests/test_invoices";
+const std::string TEMPLATE_DIR = "tests/test_templates";
+#else
+const std::string INVOICE_DIR = "invoices";
+const std::string TEMPLATE_DIR = "templates";
+#endif
+
+/**
+ * @brief Invoices rendered by one pool task before it takes the next group.
+ */
+const size_t INVOICES_PER_TASK = 64;
+
+/**
+ * @brief Returns the default directory batch invoices are written under.
+ * @return const std::string& The directory path.
+ */
+const std::string& invoiceDir() {
+    return INVOICE_DIR;
+}
+
+/**
+ * @brief Loads the services, customers and vehicles referenced by invoices.
+ * @return InvoiceContext The lookup tables.
+ */
+InvoiceContext loadInvoiceContext() {
+    InvoiceContext ctx;
+    for (const auto& s : loadServices()) ctx.services.emplace(s.id, s);
+    for (const auto& c : loadCustomers()) ctx.customers.emplace(c.id, c);
+    for (const auto& v : loadVehicles()) ctx.vehicles.emplace(v.id, v);
+    return ctx;
+}
+
+/**
+ * @brief Loads just the service, customer and vehicle rows one booking refers to.
+ * @param h The booking.
+ * @return InvoiceContext The lookup tables.
+ */
+InvoiceContext loadInvoiceContextFor(const ServiceHistory& h) {
+    InvoiceContext ctx;
+    for (const auto& s : loadServices()) {
+        if (std::find(h.serviceIds.begin(), h.serviceIds.end(), s.id) != h.serviceIds.end()) ctx.services.emplace(s.id, s);
+    }
+    for (const auto& c : loadCustomers()) {
+        if (c.id == h.customerId) ctx.customers.emplace(c.id, c);
+    }
+    for (const auto& v : loadVehicles()) {
+        if (v.id == h.vehicleId) ctx.vehicles.emplace(v.id, v);
+    }
+    return ctx;
+}
+
+/**
+ * @brief Returns the file name of a booking's invoice, e.g. "INV-000042.txt".
+ * @param historyId The booking.
+ * @param format The layout.
+ * @return std::string The file name.
+ */
+std::string invoiceFileName(int historyId, InvoiceFormat format) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "INV-%06d.%s", historyId, format == InvoiceFormat::Html ? "html" : "txt");
+    return name;
+}
+
+// ---- Rendering ----
+
+static std::mutex templateMutex;
+static std::shared_ptr<const BillTemplate> templates[2]; // Indexed by InvoiceFormat; guarded by templateMutex
+
+static size_t formatIndex(InvoiceFormat format) {
+    return format == InvoiceFormat::Html ? 1 : 0;
+}
+
+/**
+ * @brief Returns the template used for a layout, compiling it on first use.
+ * @param format The layout.
+ * @return std::shared_ptr<const BillTemplate> The compiled template.
+ */
+std::shared_ptr<const BillTemplate> invoiceTemplate(InvoiceFormat format) {
+    std::lock_guard<std::mutex> lock(templateMutex);
+    auto& slot = templates[formatIndex(format)];
+    if (slot) return slot;
+    bool html = format == InvoiceFormat::Html;
+    auto t = std::make_shared<BillTemplate>();
+    std::string path = TEMPLATE_DIR + (html ? "/bill.html" : "/bill.txt"), error;
+    bool loaded = false;
+    std::ifstream ifs(path, std::ios::binary);
+    if (ifs) {
+        std::ostringstream source;
+        source << ifs.rdbuf();
+        loaded = compileBillTemplate(source.str(), html, *t, error);
+        if (!loaded) std::cout << "Ignoring " << path << ": " << error << "\n";
+    }
+    if (!loaded) compileBillTemplate(builtinBillTemplate(html), html, *t, error);
+    slot = t;
+    return slot;
+}
+
+/**
+ * @brief Replaces the template used for a layout.
+ * @param format The layout.
+ * @param source The template source (see compileBillTemplate()).
+ * @param error Receives the problem if the template does not compile.
+ * @return bool True if the template compiled and is now in use.
+ */
+bool setInvoiceTemplate(InvoiceFormat format, const std::string& source, std::string& error) {
+    auto t = std::make_shared<BillTemplate>();
+    if (!compileBillTemplate(source, format == InvoiceFormat::Html, *t, error)) return false;
+    std::lock_guard<std::mutex> lock(templateMutex);
+    templates[formatIndex(format)] = t;
+    return true;
+}
+
+/**
+ * @brief Renders the invoice of one booking with a given template.
+ * @param t The compiled template.
+ * @param h The booking.
+ * @param ctx The lookup tables.
+ * @param out The invoice is appended here.
+ */
+void renderInvoice(const BillTemplate& t, const ServiceHistory& h, const InvoiceContext& ctx, std::string& out) {
+    thread_local BillData d; // Reused so its item and tax lists keep their capacity
+    d.booking = &h;
+    auto c = ctx.customers.find(h.customerId);
+    d.customer = c == ctx.customers.end() ? nullptr : &c->second;
+    auto v = ctx.vehicles.find(h.vehicleId);
+    d.vehicle = v == ctx.vehicles.end() ? nullptr : &v->second;
+    d.items.clear();
+    for (int sid : h.serviceIds) {
+        auto s = ctx.services.find(sid);
+        if (s != ctx.services.end()) d.items.push_back(&s->second);
+    }
+    d.taxes.clear();
+    for (const auto& tx : h.taxes) {
+        long long cgst, sgst;
+        splitGst(tx, cgst, sgst);
+        int cgstRate = tx.rateBasisPoints / 2, sgstRate = tx.rateBasisPoints - cgstRate;
+        d.taxes.push_back({"CGST " + formatRate(cgstRate), cgstRate / 100.0, cgst / 100.0});
+        d.taxes.push_back({"SGST " + formatRate(sgstRate), sgstRate / 100.0, sgst / 100.0});
+    }
+    renderBill(t, d, out);
+}
+
+/**
+ * @brief Renders the invoice of one booking.
+ * @param h The booking.
+ * @param ctx The lookup tables.
+ * @param format The layout.
+ * @param out The invoice is appended here.
+ */
+void renderInvoice(const ServiceHistory& h, const InvoiceContext& ctx, InvoiceFormat format, std::string& out) {
+    renderInvoice(*invoiceTemplate(format), h, ctx, out);
+}
+
+// ---- Batches ----
+
+/**
+ * @brief Loads the hot and archived bookings whose history ID falls within an inclusive range.
+ * @param fromId First history ID.
+ * @param toId Last history ID.
+ * @return std::vector<ServiceHistory> The bookings, ordered by history ID.
+ */
+std::vector<ServiceHistory> loadHistoryByIdRange(int fromId, int toId) {
+    std::vector<ServiceHistory> list;
+    for (const auto& a : loadArchiveIndex()) {
+        if (a.summary.rows == 0 || a.maxHistoryId < fromId || a.minHistoryId > toId) continue;
+        for (auto& h : loadArchiveSegment(a.summary.key)) {
+            if (h.historyId >= fromId && h.historyId <= toId) list.push_back(std::move(h));
+        }
+    }
+    for (const auto& h : loadHistory()) {
+        if (h.historyId >= fromId && h.historyId <= toId) list.push_back(h);
+    }
+    std::sort(list.begin(), list.end(), [](const ServiceHistory& a, const ServiceHistory& b) { return a.historyId < b.historyId; });
+    return list;
+}
+
+/**
+ * @brief Renders and writes one invoice file per booking, in parallel on the shared thread pool.
+ * @param rows The bookings.
+ * @param format The layout.
+ * @param directory Directory to write to; created if missing. Existing invoices are overwritten.
+ * @return InvoiceBatchReport Counts, bytes and elapsed time.
+ */
+InvoiceBatchReport writeInvoices(const std::vector<ServiceHistory>& rows, InvoiceFormat format, const std::string& directory) {
+    auto start = std::chrono::steady_clock::now();
+    InvoiceBatchReport report{directory, 0, 0, 0, 0};
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    InvoiceContext ctx = loadInvoiceContext();
+    auto tmpl = invoiceTemplate(format);
+
+    std::atomic<int> written{0}, failed{0};
+    std::atomic<long long> bytes{0};
+    size_t tasks = (rows.size() + INVOICES_PER_TASK - 1) / INVOICES_PER_TASK;
+    parallelFor(tasks, [&](size_t t) {
+        std::string buf, path;
+        buf.reserve(4096);
+        size_t end = std::min(rows.size(), (t + 1) * INVOICES_PER_TASK);
+        int ok = 0, bad = 0;
+        long long n = 0;
+        for (size_t i = t * INVOICES_PER_TASK; i < end; ++i) {
+            buf.clear();
+            renderInvoice(*tmpl, rows[i], ctx, buf);
+            path = directory;
+            path += '/';
+            path += invoiceFileName(rows[i].historyId, format);
+            std::FILE* f = std::fopen(path.c_str(), "wb");
+            if (f && std::fwrite(buf.data(), 1, buf.size(), f) == buf.size() && std::fclose(f) == 0) {
+                ++ok;
+                n += static_cast<long long>(buf.size());
+            } else {
+                if (f) std::fclose(f);
+                ++bad;
+            }
+        }
+        written += ok;
+        failed += bad;
+        bytes += n;
+    });
+    report.invoices = written;
+    report.failed = failed;
+    report.bytes = bytes;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+/**
+ * @brief Interactively generates invoices for a history ID range or a date range.
+ */
+void generateInvoicesInteractive() {
+    std::cout << "Select by 1. History ID range  2. Date range: ";
+    int by; std::cin >> by; std::cin.ignore();
+    std::vector<ServiceHistory> rows;
+    std::string label;
+    if (by == 1) {
+        int fromId, toId;
+        std::cout << "Enter first history ID: "; std::cin >> fromId;
+        std::cout << "Enter last history ID: "; std::cin >> toId; std::cin.ignore();
+        rows = loadHistoryByIdRange(fromId, toId);
+        label = "id_" + std::to_string(fromId) + "_" + std::to_string(toId);
+    } else if (by == 2) {
+        std::string from, to;
+        std::cout << "Enter start date (YYYY-MM-DD): "; std::getline(std::cin, from);
+        std::cout << "Enter end date (YYYY-MM-DD): "; std::getline(std::cin, to);
+        rows = loadHistoryBetween(from, to);
+        label = from + "_" + to;
+    } else {
+        std::cout << "Invalid option.\n";
+        return;
+    }
+    if (rows.empty()) {
+        std::cout << "No bookings in that range.\n";
+        return;
+    }
+    std::cout << "Format 1. Text  2. HTML: ";
+    int fmt; std::cin >> fmt; std::cin.ignore();
+    auto report = writeInvoices(rows, fmt == 2 ? InvoiceFormat::Html : InvoiceFormat::Text, INVOICE_DIR + "/" + label);
+    std::cout << "Wrote " << report.invoices << " invoice(s) to " << report.directory << " ("
+              << report.bytes / 1024 << " KiB in " << std::fixed << std::setprecision(2) << report.seconds * 1e3 << " ms)";
+    std::cout.unsetf(std::ios::fixed);
+    if (report.failed) std::cout << ", " << report.failed << " failed";
+    std::cout << ".\n";
+}
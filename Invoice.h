@@ -0,0 +1,132 @@
+// Invoice.h
+#ifndef INVOICE_H
+#define INVOICE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+#include "BillTemplate.h"
+
+/**
+ * @brief Layout an invoice is rendered in.
+ */
+enum class InvoiceFormat {
+    Text,   /**< Plain text, one file per invoice ending in ".txt". */
+    Html    /**< A standalone HTML page, one file per invoice ending in ".html". */
+};
+
+/**
+ * @brief Lookup tables an invoice needs besides its history row, loaded once per batch.
+ */
+struct InvoiceContext {
+    std::unordered_map<int, ServiceItem> services;  /**< Services by ID. */
+    std::unordered_map<int, Customer> customers;    /**< Customers by ID. */
+    std::unordered_map<int, Vehicle> vehicles;      /**< Vehicles by ID. */
+};
+
+/**
+ * @brief Outcome of one batch invoicing run.
+ */
+struct InvoiceBatchReport {
+    std::string directory;  /**< Directory the invoices were written to. */
+    int invoices;           /**< Invoices written. */
+    int failed;             /**< Invoices that could not be written. */
+    long long bytes;        /**< Bytes written. */
+    double seconds;         /**< Wall-clock time of the run. */
+};
+
+/**
+ * @brief Returns the default directory batch invoices are written under.
+ * @return const std::string& The directory path.
+ */
+const std::string& invoiceDir();
+
+/**
+ * @brief Loads the services, customers and vehicles referenced by invoices.
+ * @return InvoiceContext The lookup tables.
+ */
+InvoiceContext loadInvoiceContext();
+
+/**
+ * @brief Loads just the service, customer and vehicle rows one booking refers to.
+ * @param h The booking.
+ * @return InvoiceContext The lookup tables.
+ * @note For single bills (console and HTTP), where building the full tables would cost more than rendering.
+ */
+InvoiceContext loadInvoiceContextFor(const ServiceHistory& h);
+
+/**
+ * @brief Returns the template used for a layout, compiling it on first use.
+ * @param format The layout.
+ * @return std::shared_ptr<const BillTemplate> The compiled template.
+ * @note Uses templates/bill.txt or templates/bill.html if present (a file that does not compile is reported
+ *       and ignored), otherwise the built-in layout. The pointer stays valid if the template is replaced.
+ */
+std::shared_ptr<const BillTemplate> invoiceTemplate(InvoiceFormat format);
+
+/**
+ * @brief Replaces the template used for a layout.
+ * @param format The layout.
+ * @param source The template source (see compileBillTemplate()).
+ * @param error Receives the problem if the template does not compile.
+ * @return bool True if the template compiled and is now in use.
+ */
+bool setInvoiceTemplate(InvoiceFormat format, const std::string& source, std::string& error);
+
+/**
+ * @brief Returns the file name of a booking's invoice, e.g. "INV-000042.txt".
+ * @param historyId The booking.
+ * @param format The layout.
+ * @return std::string The file name.
+ */
+std::string invoiceFileName(int historyId, InvoiceFormat format);
+
+/**
+ * @brief Renders the invoice of one booking with a given template.
+ * @param t The compiled template.
+ * @param h The booking.
+ * @param ctx The lookup tables.
+ * @param out The invoice is appended here.
+ */
+void renderInvoice(const BillTemplate& t, const ServiceHistory& h, const InvoiceContext& ctx, std::string& out);
+
+/**
+ * @brief Renders the invoice of one booking with the current template of a layout.
+ * @param h The booking.
+ * @param ctx The lookup tables.
+ * @param format The layout.
+ * @param out The invoice is appended here.
+ * @note Customers and vehicles deleted since the booking are shown by ID only.
+ */
+void renderInvoice(const ServiceHistory& h, const InvoiceContext& ctx, InvoiceFormat format, std::string& out);
+
+/**
+ * @brief Loads the hot and archived bookings whose history ID falls within an inclusive range.
+ * @param fromId First history ID.
+ * @param toId Last history ID.
+ * @return std::vector<ServiceHistory> The bookings, ordered by history ID.
+ * @note Only archive segments whose ID range overlaps the request are decompressed.
+ */
+std::vector<ServiceHistory> loadHistoryByIdRange(int fromId, int toId);
+
+/**
+ * @brief Renders and writes one invoice file per booking, in parallel on the shared thread pool.
+ * @param rows The bookings.
+ * @param format The layout.
+ * @param directory Directory to write to; created if missing. Existing invoices are overwritten.
+ * @return InvoiceBatchReport Counts, bytes and elapsed time.
+ * @note The template is fetched once per batch. Each task renders into a buffer it reuses for every invoice and
+ *       writes each file with a single call.
+ */
+InvoiceBatchReport writeInvoices(const std::vector<ServiceHistory>& rows, InvoiceFormat format, const std::string& directory);
+
+/**
+ * @brief Interactively generates invoices for a history ID range or a date range.
+ */
+void generateInvoicesInteractive();
+
+#endif // INVOICE_H
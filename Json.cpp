@@ -0,0 +1,226 @@
+// Json.cpp (implementation)
+#include "Json.h"
+#include <cctype>
+#include <charconv>
+#include <cmath>
+
+/**
+ * @brief Appends a string as a quoted, escaped JSON string.
+ * @param out The buffer to append to.
+ * @param s The string.
+ * @note Runs of characters that need no escaping are copied in one append.
+ */
+void appendJsonString(std::string& out, const std::string& s) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(s, run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 15];
+        }
+    }
+    out.append(s, run, std::string::npos);
+    out += '"';
+}
+
+/**
+ * @brief Appends an integer as a JSON number.
+ * @param out The buffer to append to.
+ * @param v The value.
+ */
+void appendJsonNumber(std::string& out, long long v) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+}
+
+/**
+ * @brief Appends a floating-point value as the shortest JSON number that reads back exactly.
+ * @param out The buffer to append to.
+ * @param v The value.
+ */
+void appendJsonNumber(std::string& out, double v) {
+    if (!std::isfinite(v)) {
+        out += '0';
+        return;
+    }
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+}
+
+/**
+ * @brief Appends a member name and colon, preceded by a comma unless it is the first member.
+ * @param out The buffer to append to.
+ * @param key The member name.
+ * @param first True for the first member.
+ */
+void appendJsonKey(std::string& out, const char* key, bool first) {
+    if (!first) out += ',';
+    out += '"';
+    out += key;
+    out += "\":";
+}
+
+static void skipSpace(const std::string& t, size_t& i) {
+    while (i < t.size() && std::isspace(static_cast<unsigned char>(t[i]))) ++i;
+}
+
+/**
+ * @brief Reads a JSON string starting at its opening quote.
+ */
+static bool readJsonString(const std::string& t, size_t& i, std::string& out) {
+    if (i >= t.size() || t[i] != '"') return false;
+    for (++i; i < t.size(); ++i) {
+        char c = t[i];
+        if (c == '"') { ++i; return true; }
+        if (c != '\\') { out += c; continue; }
+        if (++i >= t.size()) return false;
+        switch (t[i]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                if (i + 4 >= t.size()) return false;
+                unsigned code = 0;
+                auto r = std::from_chars(t.data() + i + 1, t.data() + i + 5, code, 16);
+                if (r.ptr != t.data() + i + 5) return false;
+                i += 4;
+                // Encode as UTF-8 (surrogate pairs are left as two separate code points)
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Skips over any JSON value, leaving i just past it.
+ */
+static bool skipJsonValue(const std::string& t, size_t& i) {
+    skipSpace(t, i);
+    if (i >= t.size()) return false;
+    if (t[i] == '"') {
+        std::string ignored;
+        return readJsonString(t, i, ignored);
+    }
+    if (t[i] == '{' || t[i] == '[') {
+        char close = t[i] == '{' ? '}' : ']';
+        ++i;
+        skipSpace(t, i);
+        if (i < t.size() && t[i] == close) { ++i; return true; }
+        for (;;) {
+            if (close == '}') {
+                std::string key;
+                skipSpace(t, i);
+                if (!readJsonString(t, i, key)) return false;
+                skipSpace(t, i);
+                if (i >= t.size() || t[i++] != ':') return false;
+            }
+            if (!skipJsonValue(t, i)) return false;
+            skipSpace(t, i);
+            if (i >= t.size()) return false;
+            if (t[i] == ',') { ++i; continue; }
+            if (t[i] == close) { ++i; return true; }
+            return false;
+        }
+    }
+    size_t start = i; // Number, true, false or null
+    while (i < t.size() && (std::isalnum(static_cast<unsigned char>(t[i])) || t[i] == '-' || t[i] == '+' || t[i] == '.')) ++i;
+    return i > start;
+}
+
+/**
+ * @brief Parses a flat JSON object into member values.
+ * @param text The JSON text.
+ * @param fields Receives each member.
+ * @return bool False if the text is not a single JSON object.
+ */
+bool parseJsonObject(const std::string& text, std::map<std::string, std::string>& fields) {
+    size_t i = 0;
+    skipSpace(text, i);
+    if (i >= text.size() || text[i++] != '{') return false;
+    skipSpace(text, i);
+    if (i < text.size() && text[i] == '}') {
+        ++i;
+    } else {
+        for (;;) {
+            std::string key;
+            skipSpace(text, i);
+            if (!readJsonString(text, i, key)) return false;
+            skipSpace(text, i);
+            if (i >= text.size() || text[i++] != ':') return false;
+            skipSpace(text, i);
+            std::string value;
+            if (i < text.size() && text[i] == '"') {
+                if (!readJsonString(text, i, value)) return false;
+            } else {
+                size_t start = i;
+                if (!skipJsonValue(text, i)) return false;
+                value = text.substr(start, i - start);
+            }
+            fields[key] = value;
+            skipSpace(text, i);
+            if (i >= text.size()) return false;
+            if (text[i] == ',') { ++i; continue; }
+            if (text[i++] == '}') break;
+            return false;
+        }
+    }
+    skipSpace(text, i);
+    return i == text.size();
+}
+
+/**
+ * @brief Parses a raw JSON array of integers.
+ * @param raw The array text.
+ * @param out Receives the integers.
+ * @return bool False if the text is not an array of integers.
+ */
+bool parseJsonIntArray(const std::string& raw, std::vector<int>& out) {
+    size_t i = 0;
+    skipSpace(raw, i);
+    if (i >= raw.size() || raw[i++] != '[') return false;
+    skipSpace(raw, i);
+    if (i < raw.size() && raw[i] == ']') return true;
+    for (;;) {
+        skipSpace(raw, i);
+        int v;
+        auto r = std::from_chars(raw.data() + i, raw.data() + raw.size(), v);
+        if (r.ec != std::errc()) return false;
+        out.push_back(v);
+        i = static_cast<size_t>(r.ptr - raw.data());
+        skipSpace(raw, i);
+        if (i >= raw.size()) return false;
+        if (raw[i] == ',') { ++i; continue; }
+        return raw[i] == ']';
+    }
+}
@@ -0,0 +1,55 @@
+// Json.h
+#ifndef JSON_H
+#define JSON_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Appends a string as a quoted, escaped JSON string.
+ * @param out The buffer to append to.
+ * @param s The string (UTF-8; control characters are escaped).
+ */
+void appendJsonString(std::string& out, const std::string& s);
+
+/**
+ * @brief Appends an integer as a JSON number.
+ * @param out The buffer to append to.
+ * @param v The value.
+ */
+void appendJsonNumber(std::string& out, long long v);
+
+/**
+ * @brief Appends a floating-point value as the shortest JSON number that reads back exactly.
+ * @param out The buffer to append to.
+ * @param v The value; NaN and infinities are written as 0.
+ */
+void appendJsonNumber(std::string& out, double v);
+
+/**
+ * @brief Appends ",\"key\":" (or "\"key\":" for the first member of an object).
+ * @param out The buffer to append to.
+ * @param key The member name (written as is; must not need escaping).
+ * @param first True for the first member.
+ */
+void appendJsonKey(std::string& out, const char* key, bool first = false);
+
+/**
+ * @brief Parses a flat JSON object into member values.
+ * @param text The JSON text.
+ * @param fields Receives each member: strings unescaped, any other value as its raw JSON text.
+ * @return bool False if the text is not a single JSON object.
+ * @note Nested objects and arrays are accepted and returned raw.
+ */
+bool parseJsonObject(const std::string& text, std::map<std::string, std::string>& fields);
+
+/**
+ * @brief Parses a raw JSON array of integers, such as a member returned by parseJsonObject().
+ * @param raw The array text, e.g. "[1, 2, 3]".
+ * @param out Receives the integers.
+ * @return bool False if the text is not an array of integers.
+ */
+bool parseJsonIntArray(const std::string& raw, std::vector<int>& out);
+
+#endif // JSON_H
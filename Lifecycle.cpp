@@ -0,0 +1,505 @@
+// Lifecycle.cpp (implementation)
+#include "Lifecycle.h"
+#include "Storage.h"
+#include "HistoryArchive.h"
+#include "HistoryPartition.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+
+/**
+ * @brief Status names by stage; Booked is stored as "Pending".
+ */
+static const char* const STAGE_NAMES[] = {"Pending", "CheckedIn", "InProgress", "QualityCheck", "Completed", "Delivered", "Cancelled"};
+
+/**
+ * @brief Cached statistics of the finished jobs booked in one month.
+ */
+struct MonthStats {
+    TurnaroundHistogram turnaround;                          /**< Turnaround of every job. */
+    std::map<std::tuple<int, int, int>, JobTimeStats> days;  /**< (day, branch, service or 0 for all) -> times. */
+    std::map<std::pair<int, int>, JobTimeStats> whole;       /**< (branch, service or 0 for all) -> times. */
+};
+
+static std::mutex turnaroundMutex;                   // Taken after dataFileMutex, never before
+static std::map<std::string, MonthStats> monthStats; // Month key -> statistics of its bookings
+
+// ---- Stages ----
+
+/**
+ * @brief Reads a status name as a stage; "Booked" and "Pending" both mean Booked.
+ * @param status The status.
+ * @param out Receives the stage.
+ * @return bool False for an unknown status.
+ */
+bool parseJobStage(const std::string& status, JobStage& out) {
+    if (status == "Booked") {
+        out = JobStage::Booked;
+        return true;
+    }
+    for (int i = 0; i <= static_cast<int>(JobStage::Cancelled); ++i) {
+        if (status == STAGE_NAMES[i]) {
+            out = static_cast<JobStage>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the status name stored for a stage.
+ * @param stage The stage.
+ * @return std::string The name ("Pending" for Booked).
+ */
+std::string jobStageStatus(JobStage stage) {
+    return STAGE_NAMES[static_cast<int>(stage)];
+}
+
+/**
+ * @brief Checks whether a job may move from one stage to another.
+ * @param from The current stage.
+ * @param to The requested stage.
+ * @return bool True for a move forward along the lifecycle or a cancellation of a job not yet completed.
+ */
+bool canTransition(JobStage from, JobStage to) {
+    if (from == JobStage::Cancelled || from == JobStage::Delivered) return false; // Final
+    if (to == JobStage::Cancelled) return from < JobStage::Completed;
+    return to > from;
+}
+
+/**
+ * @brief Checks a status change against the lifecycle.
+ * @param from The current status.
+ * @param to The requested status.
+ * @param error Receives the reason if the change is refused.
+ * @return bool True if the change is allowed.
+ */
+bool checkStatusChange(const std::string& from, const std::string& to, std::string& error) {
+    JobStage a, b;
+    if (!parseJobStage(to, b)) {
+        error = "unknown status " + to;
+        return false;
+    }
+    if (!parseJobStage(from, a)) return true; // A status from outside the lifecycle may move anywhere
+    if (canTransition(a, b)) return true;
+    error = "cannot change status from " + from + " to " + to;
+    return false;
+}
+
+/**
+ * @brief Returns whether a status is a job still in the workshop (Booked through QualityCheck).
+ */
+bool isOpenStatus(const std::string& status) {
+    JobStage s;
+    return parseJobStage(status, s) && s < JobStage::Completed;
+}
+
+/**
+ * @brief Returns whether a status is a finished job (Completed or Delivered).
+ */
+bool isDoneStatus(const std::string& status) {
+    return status == "Completed" || status == "Delivered";
+}
+
+/**
+ * @brief Returns when a booking reached a stage.
+ * @param h The booking.
+ * @param stage The stage; Booked is the booking's dateTime.
+ * @param seconds Receives the time in seconds since the epoch.
+ * @return bool False if the stage was not reached or its time was not recorded.
+ */
+bool stageReachedAt(const ServiceHistory& h, JobStage stage, long long& seconds) {
+    long long booked;
+    if (!dateTimeToSeconds(h.dateTime, booked)) return false;
+    if (stage == JobStage::Booked) {
+        seconds = booked;
+        return true;
+    }
+    for (const auto& t : h.stages) {
+        if (t.stage != static_cast<int>(stage)) continue;
+        seconds = booked + t.offsetSeconds;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Returns a finished job's turnaround: from check-in (or booking) to completion.
+ * @param h The booking.
+ * @param minutes Receives the turnaround, rounded down to whole minutes.
+ * @return bool False if the job has no recorded completion time.
+ */
+bool turnaroundMinutes(const ServiceHistory& h, long long& minutes) {
+    long long start, end;
+    if (!stageReachedAt(h, JobStage::Completed, end)) return false;
+    if (!stageReachedAt(h, JobStage::CheckedIn, start) && !stageReachedAt(h, JobStage::Booked, start)) return false;
+    minutes = std::max(0LL, end - start) / 60;
+    return true;
+}
+
+/**
+ * @brief Returns how long a job waited: from check-in (or booking) until work started.
+ * @param h The booking.
+ * @param minutes Receives the wait, rounded down to whole minutes.
+ * @return bool False if the job has no recorded start of work.
+ */
+bool waitMinutes(const ServiceHistory& h, long long& minutes) {
+    long long start, end;
+    if (!stageReachedAt(h, JobStage::InProgress, end)) return false;
+    if (!stageReachedAt(h, JobStage::CheckedIn, start) && !stageReachedAt(h, JobStage::Booked, start)) return false;
+    minutes = std::max(0LL, end - start) / 60;
+    return true;
+}
+
+/**
+ * @brief Returns how long a job was worked on: from the start of work until completion.
+ * @param h The booking.
+ * @param minutes Receives the work time, rounded down to whole minutes.
+ * @return bool False if the start of work or the completion was not recorded.
+ */
+bool workMinutes(const ServiceHistory& h, long long& minutes) {
+    long long start, end;
+    if (!stageReachedAt(h, JobStage::InProgress, start) || !stageReachedAt(h, JobStage::Completed, end)) return false;
+    minutes = std::max(0LL, end - start) / 60;
+    return true;
+}
+
+// ---- Histograms and sketches ----
+
+/**
+ * @brief Returns the bucket of a turnaround.
+ */
+static size_t bucketOf(long long minutes) {
+    if (minutes < 240) return static_cast<size_t>(minutes);
+    if (minutes < 1440) return static_cast<size_t>(240 + (minutes - 240) / 5);
+    if (minutes < 20160) return static_cast<size_t>(480 + (minutes - 1440) / 30);
+    return TURNAROUND_BUCKETS - 1;
+}
+
+/**
+ * @brief Returns the longest turnaround a bucket holds.
+ */
+static long long bucketUpperBound(size_t bucket) {
+    long long b = static_cast<long long>(bucket);
+    if (b < 240) return b;
+    if (b < 480) return 240 + (b - 240) * 5 + 4;
+    return 1440 + (b - 480) * 30 + 29;
+}
+
+/**
+ * @brief Adds one turnaround to a histogram.
+ * @param hist The histogram.
+ * @param minutes The turnaround.
+ */
+void addTurnaround(TurnaroundHistogram& hist, long long minutes) {
+    minutes = std::max(0LL, minutes);
+    hist.counts[bucketOf(minutes)]++;
+    hist.jobs++;
+    hist.totalMinutes += minutes;
+    hist.maxMinutes = std::max(hist.maxMinutes, minutes);
+}
+
+/**
+ * @brief Adds the counts of one histogram into another.
+ * @param into The histogram to update.
+ * @param hist The histogram to add.
+ */
+void mergeTurnaround(TurnaroundHistogram& into, const TurnaroundHistogram& hist) {
+    for (size_t i = 0; i < TURNAROUND_BUCKETS; ++i) into.counts[i] += hist.counts[i];
+    into.jobs += hist.jobs;
+    into.totalMinutes += hist.totalMinutes;
+    into.maxMinutes = std::max(into.maxMinutes, hist.maxMinutes);
+}
+
+/**
+ * @brief Adds a finished job's wait, work and turnaround times to a set of sketches.
+ * @param stats The sketches.
+ * @param h The booking; times it did not record are skipped.
+ */
+void addJobTimes(JobTimeStats& stats, const ServiceHistory& h) {
+    long long minutes;
+    if (waitMinutes(h, minutes)) sketchAdd(stats.wait, static_cast<double>(minutes));
+    if (workMinutes(h, minutes)) sketchAdd(stats.work, static_cast<double>(minutes));
+    if (turnaroundMinutes(h, minutes)) sketchAdd(stats.turnaround, static_cast<double>(minutes));
+}
+
+/**
+ * @brief Adds one set of sketches into another.
+ * @param into The sketches to update.
+ * @param stats The sketches to add.
+ */
+void mergeJobTimes(JobTimeStats& into, const JobTimeStats& stats) {
+    sketchMerge(into.wait, stats.wait);
+    sketchMerge(into.work, stats.work);
+    sketchMerge(into.turnaround, stats.turnaround);
+}
+
+/**
+ * @brief Returns a percentile of a histogram.
+ * @param hist The histogram.
+ * @param percent The percentile, from 0 to 100.
+ * @return long long The upper bound of the bucket holding it, in minutes; 0 if empty.
+ */
+long long turnaroundPercentile(const TurnaroundHistogram& hist, double percent) {
+    if (hist.jobs == 0) return 0;
+    long long rank = std::max(1LL, static_cast<long long>(std::ceil(percent / 100.0 * static_cast<double>(hist.jobs))));
+    long long seen = 0;
+    for (size_t i = 0; i < TURNAROUND_BUCKETS; ++i) {
+        seen += hist.counts[i];
+        if (seen >= rank) return std::min(hist.maxMinutes, i + 1 == TURNAROUND_BUCKETS ? hist.maxMinutes : bucketUpperBound(i));
+    }
+    return hist.maxMinutes;
+}
+
+// ---- Reports ----
+
+/**
+ * @brief Returns the months in a range that have a hot partition or an archive segment.
+ * @param fromMonth First month in "YYYY-MM" format.
+ * @param toMonth Last month in "YYYY-MM" format.
+ * @return std::vector<std::string> The month keys, ascending.
+ * @note A query walks these instead of every calendar month, so a range spanning centuries costs no more than
+ *       the months that hold bookings.
+ */
+static std::vector<std::string> monthsWithData(const std::string& fromMonth, const std::string& toMonth) {
+    std::set<std::string> keys;
+    for (const auto& s : loadPartitionSummaries()) {
+        if (s.key != "undated" && s.key >= fromMonth && s.key <= toMonth) keys.insert(s.key);
+    }
+    for (const auto& a : loadArchiveIndex()) {
+        if (a.summary.key >= fromMonth && a.summary.key <= toMonth) keys.insert(a.summary.key);
+    }
+    return {keys.begin(), keys.end()};
+}
+
+/**
+ * @brief Returns the day of the month of a booking date, or 0 if it has none.
+ */
+static int dayOfMonth(const std::string& dateTime) {
+    if (dateTime.size() < 10 || !std::isdigit(static_cast<unsigned char>(dateTime[8])) ||
+        !std::isdigit(static_cast<unsigned char>(dateTime[9]))) return 0;
+    return (dateTime[8] - '0') * 10 + (dateTime[9] - '0');
+}
+
+/**
+ * @brief Adds a finished job to its month's statistics: the turnaround histogram, and the sketches of its day
+ *        and branch for all services and for each service it includes.
+ * @param month The month's statistics.
+ * @param h The booking.
+ */
+static void addToMonth(MonthStats& month, const ServiceHistory& h) {
+    long long minutes;
+    if (turnaroundMinutes(h, minutes)) addTurnaround(month.turnaround, minutes);
+    JobTimeStats job;
+    addJobTimes(job, h);
+    int day = dayOfMonth(h.dateTime);
+    std::set<int> services(h.serviceIds.begin(), h.serviceIds.end());
+    services.insert(0);
+    for (int id : services) {
+        mergeJobTimes(month.days[{day, h.branchId, id}], job);
+        mergeJobTimes(month.whole[{h.branchId, id}], job);
+    }
+}
+
+/**
+ * @brief Builds a month's statistics from its bookings, hot and archived, unless they are cached.
+ * @param key The month key in "YYYY-MM" format.
+ * @return const MonthStats* The cached statistics, or null if the month has no bookings (nothing is cached).
+ * @note Called with the data file mutex held, so no completion lands while the month is built. Cached months
+ *       are never dropped, so the pointer stays valid until resetTurnaroundStats().
+ */
+static const MonthStats* ensureMonthStats(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> statsLock(turnaroundMutex);
+        auto it = monthStats.find(key);
+        if (it != monthStats.end()) return &it->second;
+    }
+    auto rows = loadHistoryBetween(key + "-01", key + "-31");
+    if (rows.empty()) return nullptr;
+    MonthStats month;
+    for (const auto& h : rows) {
+        if (isDoneStatus(h.status)) addToMonth(month, h);
+    }
+    std::lock_guard<std::mutex> statsLock(turnaroundMutex);
+    return &monthStats.emplace(key, std::move(month)).first->second;
+}
+
+/**
+ * @brief Returns the turnaround distribution of the jobs booked in a range of months, hot and archived.
+ * @param fromMonth First month in "YYYY-MM" format.
+ * @param toMonth Last month in "YYYY-MM" format.
+ * @return TurnaroundHistogram The merged histogram.
+ */
+TurnaroundHistogram turnaroundBetween(const std::string& fromMonth, const std::string& toMonth) {
+    TurnaroundHistogram total;
+    if (partitionKeyFor(fromMonth) != fromMonth || partitionKeyFor(toMonth) != toMonth) return total;
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    for (const auto& key : monthsWithData(fromMonth, toMonth)) {
+        const MonthStats* month = ensureMonthStats(key);
+        if (!month) continue;
+        std::lock_guard<std::mutex> statsLock(turnaroundMutex);
+        mergeTurnaround(total, month->turnaround);
+    }
+    return total;
+}
+
+/**
+ * @brief Returns the wait, work and turnaround distributions of the jobs booked in a range of days.
+ * @param fromDate First day in "YYYY-MM-DD" format.
+ * @param toDate Last day in "YYYY-MM-DD" format.
+ * @param serviceId Only jobs that include this service, or 0 for every job.
+ * @param branchId Only jobs of this branch, or -1 for every branch.
+ * @return JobTimeStats The merged sketches; empty if a date is malformed.
+ */
+JobTimeStats jobTimesBetween(const std::string& fromDate, const std::string& toDate, int serviceId, int branchId) {
+    JobTimeStats total;
+    int firstDay = dayOfMonth(fromDate), lastDay = dayOfMonth(toDate);
+    if (fromDate.size() != 10 || toDate.size() != 10 || firstDay == 0 || lastDay == 0 ||
+        partitionKeyFor(fromDate) == "undated" || partitionKeyFor(toDate) == "undated") return total;
+    std::string fromMonth = fromDate.substr(0, 7), toMonth = toDate.substr(0, 7);
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    for (const auto& key : monthsWithData(fromMonth, toMonth)) {
+        const MonthStats* stats = ensureMonthStats(key);
+        if (!stats) continue;
+        int lo = key == fromMonth ? firstDay : 1, hi = key == toMonth ? lastDay : 31;
+        std::lock_guard<std::mutex> statsLock(turnaroundMutex);
+        const MonthStats& month = *stats;
+        if (lo == 1 && hi == 31) { // Whole months merge their month sketches, partial ones their days
+            for (const auto& [k, times] : month.whole) {
+                if (k.second == serviceId && (branchId < 0 || k.first == branchId)) mergeJobTimes(total, times);
+            }
+            continue;
+        }
+        for (const auto& [k, times] : month.days) {
+            auto [day, branch, service] = k;
+            if (day >= lo && day <= hi && service == serviceId && (branchId < 0 || branch == branchId)) {
+                mergeJobTimes(total, times);
+            }
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Adds a job that has just been completed to its month's cached histogram and sketches.
+ * @param h The booking, with its completion time recorded.
+ */
+void recordCompletedJob(const ServiceHistory& h) {
+    std::lock_guard<std::mutex> lock(turnaroundMutex);
+    auto it = monthStats.find(partitionKeyFor(h.dateTime));
+    if (it != monthStats.end()) addToMonth(it->second, h); // Months not built yet will read it
+}
+
+/**
+ * @brief Discards the cached turnaround histograms and job time sketches, after the history was replaced.
+ */
+void resetTurnaroundStats() {
+    std::lock_guard<std::mutex> lock(turnaroundMutex);
+    monthStats.clear();
+}
+
+// ---- Console ----
+
+/**
+ * @brief Formats minutes as hours and minutes, e.g. "2h05m".
+ */
+static std::string formatMinutes(long long minutes) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%lldh%02lldm", minutes / 60, minutes % 60);
+    return buf;
+}
+
+/**
+ * @brief Interactively moves a job to its next stage (or any later one, or Cancelled).
+ */
+void updateJobStatusInteractive() {
+    std::cout << "Enter history ID: ";
+    int id; std::cin >> id; std::cin.ignore();
+    ServiceHistory h;
+    if (!findHistoryById(id, h)) {
+        std::cout << "History entry not found.\n";
+        return;
+    }
+    JobStage current;
+    if (!parseJobStage(h.status, current)) current = JobStage::Booked;
+    std::cout << "Current status: " << h.status << "\n";
+    for (int i = 0; i <= static_cast<int>(JobStage::Cancelled); ++i) {
+        long long at;
+        if (i <= static_cast<int>(current) && stageReachedAt(h, static_cast<JobStage>(i), at)) {
+            std::cout << "  " << std::left << std::setw(14) << STAGE_NAMES[i] << secondsToDateTime(at) << "\n";
+        }
+    }
+    std::vector<JobStage> next;
+    for (int i = 0; i <= static_cast<int>(JobStage::Cancelled); ++i) {
+        if (canTransition(current, static_cast<JobStage>(i))) next.push_back(static_cast<JobStage>(i));
+    }
+    if (next.empty()) {
+        std::cout << "The job is closed.\n";
+        return;
+    }
+    for (size_t i = 0; i < next.size(); ++i) std::cout << i + 1 << ". " << jobStageStatus(next[i]) << "\n";
+    std::cout << "Select new status (0 to cancel): ";
+    size_t choice; std::cin >> choice; std::cin.ignore();
+    if (choice == 0 || choice > next.size()) return;
+    if (setHistoryStatus(id, jobStageStatus(next[choice - 1]))) std::cout << "Status changed to " << jobStageStatus(next[choice - 1]) << ".\n";
+    else std::cout << "Failed to change the status.\n";
+}
+
+/**
+ * @brief Interactively prints turnaround percentiles for a range of months.
+ */
+void viewTurnaroundReport() {
+    std::string from, to;
+    std::cout << "Enter first month (YYYY-MM): "; std::getline(std::cin, from);
+    std::cout << "Enter last month (YYYY-MM): "; std::getline(std::cin, to);
+    TurnaroundHistogram hist = turnaroundBetween(from, to);
+    std::cout << "--- Turnaround " << from << " to " << to << " (check-in to completion) ---\n";
+    if (hist.jobs == 0) {
+        std::cout << "No completed jobs with recorded times in that range.\n";
+        return;
+    }
+    std::cout << "Jobs: " << hist.jobs << "\n";
+    std::cout << "Mean: " << formatMinutes(hist.totalMinutes / hist.jobs) << "\n";
+    for (double p : {50.0, 90.0, 95.0, 99.0}) {
+        std::cout << "p" << static_cast<int>(p) << ":  " << formatMinutes(turnaroundPercentile(hist, p)) << "\n";
+    }
+    std::cout << "Max:  " << formatMinutes(hist.maxMinutes) << "\n";
+}
+
+/**
+ * @brief Interactively prints wait, work and turnaround percentiles for a range of days, optionally for one
+ *        service or branch.
+ */
+void viewJobTimeReport() {
+    std::string from, to;
+    std::cout << "Enter first date (YYYY-MM-DD): "; std::getline(std::cin, from);
+    std::cout << "Enter last date (YYYY-MM-DD): "; std::getline(std::cin, to);
+    std::cout << "Enter service ID (0 for all): ";
+    int serviceId; std::cin >> serviceId;
+    std::cout << "Enter branch ID (-1 for all): ";
+    int branchId; std::cin >> branchId; std::cin.ignore();
+    JobTimeStats stats = jobTimesBetween(from, to, serviceId, branchId);
+    if (stats.turnaround.count == 0 && stats.wait.count == 0) {
+        std::cout << "No completed jobs with recorded times in that range.\n";
+        return;
+    }
+    std::cout << "--- Job times " << from << " to " << to << " (estimated) ---\n";
+    std::cout << std::left << std::setw(12) << "" << std::setw(8) << "Jobs" << std::setw(10) << "p50"
+              << std::setw(10) << "p90" << std::setw(10) << "p99" << "Max\n";
+    const std::pair<const char*, const QuantileSketch*> rows[] = {
+        {"Wait", &stats.wait}, {"Work", &stats.work}, {"Turnaround", &stats.turnaround}};
+    for (const auto& [name, sketch] : rows) {
+        std::cout << std::left << std::setw(12) << name << std::setw(8) << sketch->count;
+        for (double q : {0.5, 0.9, 0.99}) {
+            std::cout << std::setw(10) << formatMinutes(static_cast<long long>(sketchQuantile(*sketch, q)));
+        }
+        std::cout << formatMinutes(static_cast<long long>(sketch->maxValue)) << "\n";
+    }
+}
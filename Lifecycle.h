@@ -0,0 +1,209 @@
+// Lifecycle.h
+#ifndef LIFECYCLE_H
+#define LIFECYCLE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Service.h"
+#include "QuantileSketch.h"
+
+/**
+ * @brief Stages of a job, in the order a job moves through them; Cancelled ends a job early.
+ * @note Stored in the status field by name, except Booked, which keeps the original name "Pending".
+ */
+enum class JobStage { Booked = 0, CheckedIn, InProgress, QualityCheck, Completed, Delivered, Cancelled };
+
+/**
+ * @brief Buckets of a turnaround histogram: one per minute up to 4 hours, per 5 minutes up to a day, per 30
+ *        minutes up to 14 days, and one for anything longer.
+ */
+const size_t TURNAROUND_BUCKETS = 240 + 240 + 624 + 1;
+
+/**
+ * @brief Distribution of job turnaround times, in minutes.
+ */
+struct TurnaroundHistogram {
+    std::array<uint32_t, TURNAROUND_BUCKETS> counts{}; /**< Jobs per bucket. */
+    long long jobs = 0;         /**< Jobs counted. */
+    long long totalMinutes = 0; /**< Sum of the turnarounds, for the mean. */
+    long long maxMinutes = 0;   /**< Longest turnaround. */
+};
+
+/**
+ * @brief Distributions of the times of finished jobs, in minutes.
+ */
+struct JobTimeStats {
+    QuantileSketch wait;       /**< Check-in (or booking) to the start of work. */
+    QuantileSketch work;       /**< Start of work to completion. */
+    QuantileSketch turnaround; /**< Check-in (or booking) to completion. */
+};
+
+/**
+ * @brief Reads a status name as a stage; "Booked" and "Pending" both mean Booked.
+ * @param status The status.
+ * @param out Receives the stage.
+ * @return bool False for an unknown status.
+ */
+bool parseJobStage(const std::string& status, JobStage& out);
+
+/**
+ * @brief Returns the status name stored for a stage.
+ * @param stage The stage.
+ * @return std::string The name ("Pending" for Booked).
+ */
+std::string jobStageStatus(JobStage stage);
+
+/**
+ * @brief Checks whether a job may move from one stage to another.
+ * @param from The current stage.
+ * @param to The requested stage.
+ * @return bool True for a move forward along the lifecycle (stages may be skipped) or a cancellation of a job
+ *         that is not yet completed.
+ */
+bool canTransition(JobStage from, JobStage to);
+
+/**
+ * @brief Checks a status change against the lifecycle.
+ * @param from The current status.
+ * @param to The requested status.
+ * @param error Receives the reason if the change is refused.
+ * @return bool True if the change is allowed.
+ */
+bool checkStatusChange(const std::string& from, const std::string& to, std::string& error);
+
+/**
+ * @brief Returns whether a status is a job still in the workshop (Booked through QualityCheck).
+ */
+bool isOpenStatus(const std::string& status);
+
+/**
+ * @brief Returns whether a status is a finished job (Completed or Delivered).
+ */
+bool isDoneStatus(const std::string& status);
+
+/**
+ * @brief Returns when a booking reached a stage.
+ * @param h The booking.
+ * @param stage The stage; Booked is the booking's dateTime.
+ * @param seconds Receives the time in seconds since the epoch.
+ * @return bool False if the stage was not reached or its time was not recorded.
+ */
+bool stageReachedAt(const ServiceHistory& h, JobStage stage, long long& seconds);
+
+/**
+ * @brief Returns a finished job's turnaround: from check-in (or booking, if the check-in was not recorded) to
+ *        completion.
+ * @param h The booking.
+ * @param minutes Receives the turnaround, rounded down to whole minutes.
+ * @return bool False if the job has no recorded completion time.
+ */
+bool turnaroundMinutes(const ServiceHistory& h, long long& minutes);
+
+/**
+ * @brief Returns how long a job waited: from check-in (or booking) until work started.
+ * @param h The booking.
+ * @param minutes Receives the wait, rounded down to whole minutes.
+ * @return bool False if the job has no recorded start of work.
+ */
+bool waitMinutes(const ServiceHistory& h, long long& minutes);
+
+/**
+ * @brief Returns how long a job was worked on: from the start of work until completion.
+ * @param h The booking.
+ * @param minutes Receives the work time, rounded down to whole minutes.
+ * @return bool False if the start of work or the completion was not recorded.
+ */
+bool workMinutes(const ServiceHistory& h, long long& minutes);
+
+/**
+ * @brief Adds a finished job's wait, work and turnaround times to a set of sketches.
+ * @param stats The sketches.
+ * @param h The booking; times it did not record are skipped.
+ */
+void addJobTimes(JobTimeStats& stats, const ServiceHistory& h);
+
+/**
+ * @brief Adds one set of sketches into another.
+ * @param into The sketches to update.
+ * @param stats The sketches to add.
+ */
+void mergeJobTimes(JobTimeStats& into, const JobTimeStats& stats);
+
+/**
+ * @brief Adds one turnaround to a histogram.
+ * @param hist The histogram.
+ * @param minutes The turnaround.
+ */
+void addTurnaround(TurnaroundHistogram& hist, long long minutes);
+
+/**
+ * @brief Adds the counts of one histogram into another.
+ * @param into The histogram to update.
+ * @param hist The histogram to add.
+ */
+void mergeTurnaround(TurnaroundHistogram& into, const TurnaroundHistogram& hist);
+
+/**
+ * @brief Returns a percentile of a histogram.
+ * @param hist The histogram.
+ * @param percent The percentile, from 0 to 100.
+ * @return long long The upper bound of the bucket holding it, in minutes (exact below 4 hours); 0 if empty.
+ */
+long long turnaroundPercentile(const TurnaroundHistogram& hist, double percent);
+
+/**
+ * @brief Returns the turnaround distribution of the jobs booked in a range of months, hot and archived.
+ * @param fromMonth First month in "YYYY-MM" format.
+ * @param toMonth Last month in "YYYY-MM" format.
+ * @return TurnaroundHistogram The merged histogram.
+ * @note Each month's histogram is built once and then kept current: logHistoryChanges() adds every job that
+ *       is completed, so repeated reports only merge the cached months. Only months with a hot partition or
+ *       an archive segment are visited, and months without bookings are not cached.
+ */
+TurnaroundHistogram turnaroundBetween(const std::string& fromMonth, const std::string& toMonth);
+
+/**
+ * @brief Returns the wait, work and turnaround distributions of the jobs booked in a range of days.
+ * @param fromDate First day in "YYYY-MM-DD" format.
+ * @param toDate Last day in "YYYY-MM-DD" format.
+ * @param serviceId Only jobs that include this service, or 0 for every job.
+ * @param branchId Only jobs of this branch, or -1 for every branch.
+ * @return JobTimeStats The merged sketches; empty if a date is malformed.
+ * @note Each month keeps sketches per day, branch and service (service 0 standing for all), rolled up per
+ *       branch and service for the whole month, built and kept current alongside the turnaround histograms. A
+ *       query merges the month sketches of the months it covers and the day sketches of partial months instead
+ *       of sorting the history. As for turnaroundBetween(), only months holding bookings are visited.
+ */
+JobTimeStats jobTimesBetween(const std::string& fromDate, const std::string& toDate, int serviceId = 0, int branchId = -1);
+
+/**
+ * @brief Adds a job that has just been completed to its month's cached histogram and sketches.
+ * @param h The booking, with its completion time recorded.
+ * @note Called with the data file mutex held.
+ */
+void recordCompletedJob(const ServiceHistory& h);
+
+/**
+ * @brief Discards the cached turnaround histograms and job time sketches, after the history was replaced.
+ */
+void resetTurnaroundStats();
+
+/**
+ * @brief Interactively moves a job to its next stage (or any later one, or Cancelled).
+ */
+void updateJobStatusInteractive();
+
+/**
+ * @brief Interactively prints turnaround percentiles for a range of months.
+ */
+void viewTurnaroundReport();
+
+/**
+ * @brief Interactively prints wait, work and turnaround percentiles for a range of days, optionally for one
+ *        service or branch.
+ */
+void viewJobTimeReport();
+
+#endif // LIFECYCLE_H
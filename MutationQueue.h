@@ -0,0 +1,106 @@
+// MutationQueue.h
+#ifndef MUTATION_QUEUE_H
+#define MUTATION_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief One slot of an MpscQueue: a value and the sequence number that says who may touch it next.
+ */
+template <typename T>
+struct MpscSlot {
+    std::atomic<size_t> seq;    /**< pos when free for the producer of pos, pos + 1 once published. */
+    T value;                    /**< The queued value. */
+};
+
+/**
+ * @brief Bounded lock-free queue for many producer threads and a single consumer thread.
+ * @note A producer claims a slot by advancing head with a compare-and-swap, writes the value and publishes
+ *       it by bumping the slot's sequence; the consumer takes slots in order and hands each back by advancing
+ *       its sequence a full lap. No call ever waits for another thread, so a full queue is reported to the
+ *       producer instead of blocking it.
+ */
+template <typename T>
+struct MpscQueue {
+    std::unique_ptr<MpscSlot<T>[]> slots;       /**< Ring of slots; the size is a power of two. */
+    size_t mask = 0;                            /**< Slot count minus one. */
+    alignas(64) std::atomic<size_t> head{0};    /**< Next position a producer claims. */
+    alignas(64) std::atomic<size_t> tail{0};    /**< Next position the consumer reads. */
+};
+
+/**
+ * @brief Allocates a queue's slots; call once before any push or pop.
+ * @param q The queue.
+ * @param capacity Minimum number of slots; rounded up to a power of two (at least 2).
+ */
+template <typename T>
+void initMpscQueue(MpscQueue<T>& q, size_t capacity) {
+    size_t n = 2;
+    while (n < capacity) n <<= 1;
+    q.mask = n - 1;
+    q.slots.reset(new MpscSlot<T>[n]);
+    for (size_t i = 0; i < n; ++i) q.slots[i].seq.store(i, std::memory_order_relaxed);
+    q.head.store(0, std::memory_order_relaxed);
+    q.tail.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds a value if there is room (any thread).
+ * @param q The queue.
+ * @param value The value; moved from only on success.
+ * @return bool False if the queue is full.
+ */
+template <typename T>
+bool mpscTryPush(MpscQueue<T>& q, T& value) {
+    size_t pos = q.head.load(std::memory_order_relaxed);
+    for (;;) {
+        MpscSlot<T>& slot = q.slots[pos & q.mask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (q.head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.value = std::move(value);
+                slot.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // The consumer has not yet freed this slot: full
+        } else {
+            pos = q.head.load(std::memory_order_relaxed); // Another producer took it; retry
+        }
+    }
+}
+
+/**
+ * @brief Removes the oldest published value (consumer thread only).
+ * @param q The queue.
+ * @param out Receives the value.
+ * @return bool False if the queue is empty.
+ */
+template <typename T>
+bool mpscTryPop(MpscQueue<T>& q, T& out) {
+    size_t pos = q.tail.load(std::memory_order_relaxed);
+    MpscSlot<T>& slot = q.slots[pos & q.mask];
+    if (slot.seq.load(std::memory_order_acquire) != pos + 1) return false;
+    out = std::move(slot.value);
+    slot.seq.store(pos + q.mask + 1, std::memory_order_release);
+    q.tail.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Returns the number of queued values; exact only when no thread is pushing or popping.
+ * @param q The queue.
+ * @return size_t The approximate depth.
+ */
+template <typename T>
+size_t mpscSizeApprox(const MpscQueue<T>& q) {
+    size_t head = q.head.load(std::memory_order_acquire);
+    size_t tail = q.tail.load(std::memory_order_acquire);
+    return head > tail ? head - tail : 0;
+}
+
+#endif // MUTATION_QUEUE_H
@@ -0,0 +1,123 @@
+// QuantileSketch.cpp (implementation)
+#include "QuantileSketch.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief Returns the capacity of a level, shrinking by 2/3 per level below the top.
+ * @param s The sketch.
+ * @param level The level.
+ * @return size_t The capacity, at least 2.
+ */
+static size_t levelCapacity(const QuantileSketch& s, size_t level) {
+    double capacity = s.k;
+    for (size_t depth = s.levels.size() - 1 - level; depth > 0 && capacity >= 2; --depth) capacity *= 2.0 / 3.0;
+    return std::max<size_t>(2, static_cast<size_t>(capacity));
+}
+
+/**
+ * @brief Returns the capacity of the whole sketch at its current height.
+ */
+static size_t totalCapacity(const QuantileSketch& s) {
+    size_t total = 0;
+    for (size_t h = 0; h < s.levels.size(); ++h) total += levelCapacity(s, h);
+    return total;
+}
+
+/**
+ * @brief Returns the number of values a sketch retains.
+ * @param s The sketch.
+ * @return size_t The retained values across all levels.
+ */
+size_t sketchRetained(const QuantileSketch& s) {
+    size_t n = 0;
+    for (const auto& level : s.levels) n += level.size();
+    return n;
+}
+
+/**
+ * @brief Halves the lowest full level into the one above until the sketch fits its capacity.
+ * @param s The sketch.
+ */
+static void compress(QuantileSketch& s) {
+    while (sketchRetained(s) > totalCapacity(s)) {
+        size_t h = 0;
+        while (s.levels[h].size() < levelCapacity(s, h)) ++h; // Some level is full when the sketch is over capacity
+        if (h + 1 == s.levels.size()) s.levels.emplace_back();
+        auto& level = s.levels[h];
+        if (h == 0) std::sort(level.begin(), level.end()); // Higher levels are kept sorted
+        s.coin ^= s.coin << 13; s.coin ^= s.coin >> 7; s.coin ^= s.coin << 17;
+        size_t pairs = level.size() / 2;
+        size_t offset = s.coin & 1;
+        auto& up = s.levels[h + 1];
+        size_t before = up.size();
+        for (size_t i = 0; i < pairs; ++i) up.push_back(level[2 * i + offset]);
+        std::inplace_merge(up.begin(), up.begin() + before, up.end());
+        double odd = level.back();
+        bool keepOdd = level.size() % 2 == 1;
+        level.clear();
+        if (keepOdd) level.push_back(odd); // The largest value stays behind unpaired
+    }
+}
+
+/**
+ * @brief Adds a value to a sketch.
+ * @param s The sketch.
+ * @param value The value.
+ */
+void sketchAdd(QuantileSketch& s, double value) {
+    if (s.levels.empty()) s.levels.emplace_back();
+    if (s.count == 0 || value < s.minValue) s.minValue = value;
+    if (s.count == 0 || value > s.maxValue) s.maxValue = value;
+    s.count++;
+    s.levels[0].push_back(value);
+    if (s.levels[0].size() >= levelCapacity(s, 0)) compress(s);
+}
+
+/**
+ * @brief Adds the values summarized by one sketch into another.
+ * @param into The sketch to update.
+ * @param s The sketch to add.
+ */
+void sketchMerge(QuantileSketch& into, const QuantileSketch& s) {
+    if (s.count == 0) return;
+    if (into.count == 0 || s.minValue < into.minValue) into.minValue = s.minValue;
+    if (into.count == 0 || s.maxValue > into.maxValue) into.maxValue = s.maxValue;
+    into.count += s.count;
+    if (into.levels.size() < s.levels.size()) into.levels.resize(s.levels.size());
+    for (size_t h = 0; h < s.levels.size(); ++h) {
+        auto& level = into.levels[h];
+        size_t before = level.size();
+        level.insert(level.end(), s.levels[h].begin(), s.levels[h].end());
+        if (h > 0) std::inplace_merge(level.begin(), level.begin() + before, level.end());
+    }
+    compress(into);
+}
+
+/**
+ * @brief Returns an estimated quantile.
+ * @param s The sketch.
+ * @param q The quantile, from 0 to 1.
+ * @return double The value with about q * count values at or below it; 0 if the sketch is empty.
+ */
+double sketchQuantile(const QuantileSketch& s, double q) {
+    if (s.count == 0) return 0;
+    if (q <= 0) return s.minValue;
+    if (q >= 1) return s.maxValue;
+    std::vector<std::pair<double, uint64_t>> weighted;
+    weighted.reserve(sketchRetained(s));
+    uint64_t total = 0;
+    for (size_t h = 0; h < s.levels.size(); ++h) {
+        for (double v : s.levels[h]) weighted.emplace_back(v, uint64_t(1) << h);
+        total += s.levels[h].size() << h;
+    }
+    std::sort(weighted.begin(), weighted.end());
+    double rank = std::ceil(q * static_cast<double>(total));
+    uint64_t seen = 0;
+    for (const auto& [value, weight] : weighted) {
+        seen += weight;
+        if (static_cast<double>(seen) >= rank) return value;
+    }
+    return s.maxValue;
+}
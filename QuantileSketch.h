@@ -0,0 +1,58 @@
+// QuantileSketch.h
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Default accuracy parameter of a quantile sketch; 200 keeps the rank error near 1%.
+ */
+const uint32_t QUANTILE_SKETCH_K = 200;
+
+/**
+ * @brief A mergeable streaming quantile sketch (KLL) over numeric values.
+ * @note Level h holds sampled values that each stand for 2^h of the values added. When a level fills up it is
+ *       sorted and every other value moves up a level, so the sketch keeps O(k log(n/k)) values however many
+ *       are added, and two sketches merge by concatenating their levels.
+ */
+struct QuantileSketch {
+    std::vector<std::vector<double>> levels; /**< Sampled values by level; sorted above level 0. */
+    uint32_t k = QUANTILE_SKETCH_K;          /**< Capacity of the top level. */
+    uint64_t count = 0;                      /**< Values added. */
+    double minValue = 0;                     /**< Smallest value added. */
+    double maxValue = 0;                     /**< Largest value added. */
+    uint64_t coin = 0x9E3779B97F4A7C15ULL;   /**< Picks which half of a level survives a compaction. */
+};
+
+/**
+ * @brief Adds a value to a sketch.
+ * @param s The sketch.
+ * @param value The value.
+ */
+void sketchAdd(QuantileSketch& s, double value);
+
+/**
+ * @brief Adds the values summarized by one sketch into another.
+ * @param into The sketch to update.
+ * @param s The sketch to add.
+ */
+void sketchMerge(QuantileSketch& into, const QuantileSketch& s);
+
+/**
+ * @brief Returns an estimated quantile.
+ * @param s The sketch.
+ * @param q The quantile, from 0 (the minimum) to 1 (the maximum).
+ * @return double The value with about q * count values at or below it; 0 if the sketch is empty.
+ */
+double sketchQuantile(const QuantileSketch& s, double q);
+
+/**
+ * @brief Returns the number of values a sketch retains.
+ * @param s The sketch.
+ * @return size_t The retained values across all levels.
+ */
+size_t sketchRetained(const QuantileSketch& s);
+
+#endif // QUANTILE_SKETCH_H
@@ -0,0 +1,591 @@
+// Replication.cpp (implementation)
+#include "Replication.h"
+#include "ChangeFeed.h"
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+#include "Discount.h"
+#include "Tax.h"
+#include "Inventory.h"
+#include "Calendar.h"
+#include "HistoryArchive.h"
+#include "HistoryLog.h"
+#include "Storage.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef TEST_MODE
+const std::string REPLICATION_SOCKET = "tests/test_replication.sock";
+const std::string REPLICA_SEQ_FILE = "tests/test_replica.seq";
+#else
+const std::string REPLICATION_SOCKET = "replication.sock";
+const std::string REPLICA_SEQ_FILE = "replica.seq";
+#endif
+
+/**
+ * @brief Delay between attempts to reach a primary that is not accepting connections.
+ */
+const int STANDBY_RETRY_MILLIS = 200;
+
+static long long nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Returns the default path of the primary's replication socket.
+ * @return const std::string& The socket path.
+ */
+const std::string& replicationSocketPath() {
+    return REPLICATION_SOCKET;
+}
+
+// ---- Applying changes on the standby ----
+
+/**
+ * @brief Returns the key a replicated row is identified by: its ID, or the service and part of a bill of materials line.
+ */
+template <typename T>
+static int rowKey(const T& r) {
+    return r.id;
+}
+
+static std::pair<int, int> rowKey(const ServicePart& r) {
+    return {r.serviceId, r.partId};
+}
+
+/**
+ * @brief Replaces, inserts or deletes rows of one table by key, then saves the table once.
+ * @param events The table's events in feed order.
+ * @param parse Parses a data file line.
+ * @param load Loads the table.
+ * @param save Saves the table.
+ * @note Events assign whole rows, so applying one that the table already reflects changes nothing.
+ */
+template <typename T, typename Parse, typename Load, typename Save>
+static void applyTableEvents(const std::vector<const ChangeEvent*>& events, Parse parse, Load load, Save save) {
+    if (events.empty()) return;
+    std::map<decltype(rowKey(std::declval<T>())), T> rows;
+    for (const auto& r : load()) rows.emplace(rowKey(r), r);
+    for (const ChangeEvent* e : events) {
+        T row;
+        if (e->op == "delete") {
+            if (parse(e->before, row)) rows.erase(rowKey(row));
+        } else if (parse(e->after, row)) {
+            rows[rowKey(row)] = row;
+        }
+    }
+    std::vector<T> list;
+    list.reserve(rows.size());
+    for (auto& p : rows) list.push_back(std::move(p.second));
+    save(list);
+}
+
+/**
+ * @brief Turns reservation or appointment events into log lines: the row for an insert or update, an "X" line for a delete.
+ */
+static std::vector<std::string> logLinesOf(const std::vector<const ChangeEvent*>& events) {
+    std::vector<std::string> lines;
+    for (const ChangeEvent* e : events) {
+        if (e->op != "delete") lines.push_back(e->after);
+        else if (!e->before.empty()) lines.push_back("X" + e->before.substr(1));
+    }
+    return lines;
+}
+
+/**
+ * @brief Applies a run of table and booking events that contains no archive run.
+ * @param events The events in feed order.
+ * @return bool True once every booking change is durable.
+ * @note Each table is saved once and all booking changes share one log sync. Stock, reservations and
+ *       appointments are applied after the bookings: a booking completed or cancelled here closes its
+ *       reservation and appointment locally, and the primary's rows then overwrite whatever that changed.
+ */
+static bool applyEventRun(const std::vector<const ChangeEvent*>& events) {
+    std::map<std::string, std::vector<const ChangeEvent*>> byEntity;
+    for (const ChangeEvent* e : events) byEntity[e->entity].push_back(e);
+    applyTableEvents<Customer>(byEntity["customer"], parseCustomerLine, loadCustomers, saveCustomers);
+    applyTableEvents<Vehicle>(byEntity["vehicle"], parseVehicleLine, loadVehicles, saveVehicles);
+    applyTableEvents<ServiceItem>(byEntity["service"], parseServiceLine, loadServices, saveServices);
+    applyTableEvents<Discount>(byEntity["discount"], parseDiscountLine, loadDiscounts, saveDiscounts);
+    applyTableEvents<TaxClass>(byEntity["tax_class"], parseTaxClassLine, loadTaxClasses, saveTaxClasses);
+    std::vector<std::string> records;
+    for (const ChangeEvent* e : byEntity["booking"]) {
+        ServiceHistory h;
+        if (e->op != "delete" && parseHistoryLine(e->after, h)) records.push_back(historyInsertRecord(h));
+    }
+    bool ok = logHistoryChanges(records);
+    applyTableEvents<Part>(byEntity["part"], parsePartLine, loadParts, saveParts);
+    applyTableEvents<ServicePart>(byEntity["service_part"], parseServicePartLine, loadServiceParts, saveServiceParts);
+    if (!byEntity["reservation"].empty()) applyPartReservationLines(logLinesOf(byEntity["reservation"]), false);
+    if (!byEntity["appointment"].empty()) applyAppointmentLines(logLinesOf(byEntity["appointment"]), false);
+    return ok;
+}
+
+/**
+ * @brief Applies a batch of change events to the local data files.
+ * @param events The events in feed order.
+ * @return bool True once every booking change is durable.
+ * @note The events between archive runs are applied together; an archive run is repeated here only once the
+ *       bookings before it are applied and before any after it, so it moves exactly the rows it moved on the
+ *       primary.
+ */
+static bool applyChangeEvents(const std::vector<ChangeEvent>& events) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::vector<const ChangeEvent*> run;
+    bool ok = true;
+    for (const auto& e : events) {
+        if (e.entity != "archive") {
+            run.push_back(&e);
+            continue;
+        }
+        ok = applyEventRun(run) && ok;
+        run.clear();
+        if (e.op == "run") archiveCompletedHistory(e.after);
+    }
+    return applyEventRun(run) && ok;
+}
+
+/**
+ * @brief Replaces every local table with a snapshot from the primary.
+ * @param rows The snapshot rows, as insert events.
+ * @note The archive is replaced before the hot history, so no booking is missing from both at any point.
+ */
+static void applySnapshot(const std::vector<ChangeEvent>& rows) {
+    std::vector<Customer> customers;
+    std::vector<Vehicle> vehicles;
+    std::vector<ServiceItem> services;
+    std::vector<Discount> discounts;
+    std::vector<TaxClass> taxClasses;
+    std::vector<Part> parts;
+    std::vector<ServicePart> bom;
+    std::vector<std::string> reservations, appointments;
+    std::vector<ServiceHistory> history, archived;
+    for (const auto& e : rows) {
+        Customer c; Vehicle v; ServiceItem s; Discount d; TaxClass t; Part p; ServicePart sp; ServiceHistory h;
+        if (e.entity == "customer" && parseCustomerLine(e.after, c)) customers.push_back(c);
+        else if (e.entity == "vehicle" && parseVehicleLine(e.after, v)) vehicles.push_back(v);
+        else if (e.entity == "service" && parseServiceLine(e.after, s)) services.push_back(s);
+        else if (e.entity == "discount" && parseDiscountLine(e.after, d)) discounts.push_back(d);
+        else if (e.entity == "tax_class" && parseTaxClassLine(e.after, t)) taxClasses.push_back(t);
+        else if (e.entity == "part" && parsePartLine(e.after, p)) parts.push_back(p);
+        else if (e.entity == "service_part" && parseServicePartLine(e.after, sp)) bom.push_back(sp);
+        else if (e.entity == "reservation") reservations.push_back(e.after);
+        else if (e.entity == "appointment") appointments.push_back(e.after);
+        else if (e.entity == "booking" && parseHistoryLine(e.after, h)) history.push_back(h);
+        else if (e.entity == "archive" && parseHistoryLine(e.after, h)) archived.push_back(h);
+    }
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    saveCustomers(customers);
+    saveVehicles(vehicles);
+    saveServices(services);
+    saveDiscounts(discounts);
+    saveTaxClasses(taxClasses);
+    if (!replaceArchivedHistory(archived)) std::cout << "Failed to copy the archive from the primary.\n";
+    saveHistory(history);
+    saveParts(parts);
+    saveServiceParts(bom);
+    applyPartReservationLines(reservations, true);
+    applyAppointmentLines(appointments, true);
+}
+
+#ifdef _WIN32
+
+bool startReplicationSource(const std::string&) {
+    std::cout << "Replication needs Unix sockets and is not available on this platform.\n";
+    return false;
+}
+
+void stopReplicationSource() {}
+
+size_t replicationStandbyCount() {
+    return 0;
+}
+
+bool startStandby(const std::string&) {
+    std::cout << "Replication needs Unix sockets and is not available on this platform.\n";
+    return false;
+}
+
+long long promoteStandby() {
+    return 0;
+}
+
+ReplicationStats replicationStats() {
+    return {false, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+}
+
+#else
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one newline-terminated line from a blocking socket.
+ * @param fd The socket.
+ * @param buf Bytes received but not yet consumed; kept between calls.
+ * @param line Receives the line without the newline.
+ * @return bool False once the connection is closed.
+ */
+static bool readLine(int fd, std::string& buf, std::string& line) {
+    size_t nl;
+    while ((nl = buf.find('\n')) == std::string::npos) {
+        char chunk[64 * 1024];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buf.append(chunk, static_cast<size_t>(n));
+    }
+    line.assign(buf, 0, nl);
+    buf.erase(0, nl + 1);
+    return true;
+}
+
+static bool unixAddress(const std::string& path, sockaddr_un& addr) {
+    addr = sockaddr_un{};
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, path.size());
+    return true;
+}
+
+// ---- Primary: shipping the change feed ----
+
+static std::mutex sourceMutex;          // Guards the fields below
+static std::thread acceptThread;
+static std::vector<std::thread> streamThreads;
+static std::vector<int> standbyFds;
+static std::atomic<bool> sourceStopping{false};
+static std::atomic<size_t> standbyCount{0};
+static int sourceListenFd = -1;
+static std::string sourcePath;
+
+/**
+ * @brief Sends every table as a snapshot: "SNAPSHOT <seq> <rows>" followed by one insert event per row.
+ *        Archived bookings are sent as "archive" inserts, open reservations and appointments as their log lines.
+ * @param fd The standby's socket.
+ * @param seq Receives the feed position the snapshot reflects; streaming continues after it.
+ * @return bool False if the standby went away.
+ * @note Changes numbered but not yet durable when the tables are copied are in the copy and will be shipped
+ *       again; applying them twice is harmless because events assign whole rows.
+ */
+static bool sendSnapshot(int fd, long long& seq) {
+    std::vector<ChangeEvent> rows;
+    {
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        seq = lastChangeSeq();
+        for (const auto& c : loadCustomers()) rows.push_back({seq, "customer", "insert", "", formatCustomerLine(c)});
+        for (const auto& v : loadVehicles()) rows.push_back({seq, "vehicle", "insert", "", formatVehicleLine(v)});
+        for (const auto& s : loadServices()) rows.push_back({seq, "service", "insert", "", formatServiceLine(s)});
+        for (const auto& d : loadDiscounts()) rows.push_back({seq, "discount", "insert", "", formatDiscountLine(d)});
+        for (const auto& t : loadTaxClasses()) rows.push_back({seq, "tax_class", "insert", "", formatTaxClassLine(t)});
+        for (const auto& p : loadParts()) rows.push_back({seq, "part", "insert", "", formatPartLine(p)});
+        for (const auto& sp : loadServiceParts()) rows.push_back({seq, "service_part", "insert", "", formatServicePartLine(sp)});
+        for (const auto& r : loadPartReservationLines()) rows.push_back({seq, "reservation", "insert", "", r});
+        for (const auto& a : loadAppointmentLines()) rows.push_back({seq, "appointment", "insert", "", a});
+        for (const auto& h : loadHistory()) rows.push_back({seq, "booking", "insert", "", formatHistoryLine(h)});
+        for (const auto& a : loadArchiveIndex()) {
+            for (const auto& h : loadArchiveSegment(a.summary.key)) rows.push_back({seq, "archive", "insert", "", formatHistoryLine(h)});
+        }
+    }
+    std::string out = "SNAPSHOT " + std::to_string(seq) + ' ' + std::to_string(rows.size()) + '\n';
+    for (const auto& r : rows) {
+        out += formatChangeEvent(r);
+        out += '\n';
+    }
+    return sendAll(fd, out);
+}
+
+/**
+ * @brief Streams the change feed to one standby until it disconnects or the source stops.
+ * @note The standby opens with "FROM <seq>" (0 for a snapshot). Batches are sent as
+ *       "BATCH <events> <primarySeq> <sentMillis>" followed by the events; an idle primary sends an empty
+ *       batch every REPLICATION_HEARTBEAT_MILLIS.
+ */
+static void streamToStandby(int fd) {
+    std::string buf, line;
+    long long next = 0;
+    if (readLine(fd, buf, line) && line.compare(0, 5, "FROM ") == 0) {
+        try { next = std::stoll(line.substr(5)); } catch (...) { next = 0; }
+        bool snapshot = next <= 0;
+        while (!sourceStopping) {
+            if (snapshot) {
+                long long seq;
+                if (!sendSnapshot(fd, seq)) break;
+                next = seq + 1;
+                snapshot = false;
+            }
+            long long head = lastChangeSeq(); // Taken first: the file holds at least this much
+            auto events = readChanges(next, REPLICATION_BATCH_EVENTS);
+            if ((!events.empty() && events[0].seq != next) || (events.empty() && head >= next)) {
+                snapshot = true; // The feed no longer holds what the standby needs
+                continue;
+            }
+            if (events.empty()) {
+                if (waitForChanges(next - 1, REPLICATION_HEARTBEAT_MILLIS)) continue;
+                if (!sendAll(fd, "BATCH 0 " + std::to_string(head) + ' ' + std::to_string(nowMillis()) + '\n')) break;
+                continue;
+            }
+            std::string out = "BATCH " + std::to_string(events.size()) + ' ' +
+                              std::to_string(std::max(head, events.back().seq)) + ' ' + std::to_string(nowMillis()) + '\n';
+            for (const auto& e : events) {
+                out += formatChangeEvent(e);
+                out += '\n';
+            }
+            if (!sendAll(fd, out)) break;
+            next = events.back().seq + 1;
+        }
+    }
+    std::lock_guard<std::mutex> lock(sourceMutex);
+    standbyFds.erase(std::remove(standbyFds.begin(), standbyFds.end(), fd), standbyFds.end());
+    close(fd);
+    standbyCount--;
+}
+
+static void acceptStandbys() {
+    while (!sourceStopping) {
+        pollfd p{sourceListenFd, POLLIN, 0};
+        if (poll(&p, 1, REPLICATION_HEARTBEAT_MILLIS) <= 0) continue;
+        int fd = accept(sourceListenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        std::lock_guard<std::mutex> lock(sourceMutex);
+        if (sourceStopping) {
+            close(fd);
+            break;
+        }
+        standbyFds.push_back(fd);
+        standbyCount++;
+        streamThreads.emplace_back(streamToStandby, fd);
+    }
+}
+
+/**
+ * @brief Starts shipping the change feed to standbys that connect to a Unix socket.
+ * @param socketPath Path of the socket.
+ * @return bool False if the source is already running or the socket cannot be opened.
+ */
+bool startReplicationSource(const std::string& socketPath) {
+    std::lock_guard<std::mutex> lock(sourceMutex);
+    sockaddr_un addr;
+    if (sourceListenFd >= 0 || !unixAddress(socketPath, addr)) return false;
+    unlink(socketPath.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    sourceListenFd = fd;
+    sourcePath = socketPath;
+    sourceStopping = false;
+    acceptThread = std::thread(acceptStandbys);
+    return true;
+}
+
+/**
+ * @brief Disconnects every standby and stops accepting new ones.
+ */
+void stopReplicationSource() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(sourceMutex);
+        if (sourceListenFd < 0) return;
+        sourceStopping = true;
+        for (int fd : standbyFds) shutdown(fd, SHUT_RDWR); // Wakes streamers blocked on the socket
+    }
+    acceptThread.join();
+    {
+        std::lock_guard<std::mutex> lock(sourceMutex);
+        threads.swap(streamThreads);
+    }
+    for (auto& t : threads) t.join();
+    std::lock_guard<std::mutex> lock(sourceMutex);
+    close(sourceListenFd);
+    sourceListenFd = -1;
+    unlink(sourcePath.c_str());
+}
+
+/**
+ * @brief Returns the number of standbys currently connected to this primary.
+ * @return size_t The number of standbys.
+ */
+size_t replicationStandbyCount() {
+    return standbyCount;
+}
+
+// ---- Standby: following the primary ----
+
+static std::mutex standbyMutex;         // Guards standbyThread and standbyFd
+static std::thread standbyThread;
+static int standbyFd = -1;
+static std::atomic<bool> standbyStopping{false};
+static std::atomic<bool> standbyConnected{false};
+static std::atomic<long long> appliedSeq{0}, primarySeq{0}, lagMillis{0}, lastContact{0};
+static std::atomic<long long> snapshots{0}, eventsApplied{0}, batches{0}, reconnects{0};
+
+/**
+ * @brief Records the last applied primary sequence number durably, so a restarted standby resumes after it.
+ */
+static bool storeAppliedSeq(long long seq) {
+    if (!writeFileDurably(REPLICA_SEQ_FILE, std::to_string(seq) + '\n')) return false;
+    appliedSeq = seq;
+    return true;
+}
+
+/**
+ * @brief Reads the events of a snapshot or batch that follow its header line.
+ */
+static bool readEvents(int fd, std::string& buf, size_t count, std::vector<ChangeEvent>& out) {
+    std::string line;
+    out.clear();
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ChangeEvent e;
+        if (!readLine(fd, buf, line) || !parseChangeEvent(line, e)) return false;
+        out.push_back(std::move(e));
+    }
+    return true;
+}
+
+/**
+ * @brief Applies what the primary sends over one connection until it drops or the standby stops.
+ */
+static void followPrimary(int fd) {
+    long long from = appliedSeq > 0 ? appliedSeq + 1 : 0;
+    if (!sendAll(fd, "FROM " + std::to_string(from) + '\n')) return;
+    std::string buf, line;
+    std::vector<ChangeEvent> events;
+    while (!standbyStopping && readLine(fd, buf, line)) {
+        lastContact = nowMillis();
+        std::istringstream header(line);
+        std::string kind;
+        long long seq = 0, sentMillis = 0;
+        size_t count = 0;
+        header >> kind;
+        if (kind == "SNAPSHOT") {
+            if (!(header >> seq >> count) || !readEvents(fd, buf, count, events)) return;
+            applySnapshot(events);
+            if (!storeAppliedSeq(seq)) return;
+            primarySeq = std::max<long long>(primarySeq, seq);
+            snapshots++;
+        } else if (kind == "BATCH") {
+            if (!(header >> count >> seq >> sentMillis) || !readEvents(fd, buf, count, events)) return;
+            primarySeq = seq;
+            if (!events.empty()) {
+                if (events[0].seq != appliedSeq + 1) return; // Out of step; reconnect and resume
+                if (!applyChangeEvents(events) || !storeAppliedSeq(events.back().seq)) return;
+                eventsApplied += static_cast<long long>(events.size());
+                batches++;
+            }
+            lagMillis = events.empty() && appliedSeq >= seq ? 0 : std::max(0LL, nowMillis() - sentMillis);
+        } else {
+            return;
+        }
+    }
+}
+
+static void standbyLoop(std::string primaryPath) {
+    bool wasConnected = false;
+    while (!standbyStopping) {
+        sockaddr_un addr;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && unixAddress(primaryPath, addr) &&
+            connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            {
+                std::lock_guard<std::mutex> lock(standbyMutex);
+                standbyFd = fd;
+            }
+            if (wasConnected) reconnects++;
+            wasConnected = true;
+            standbyConnected = true;
+            if (!standbyStopping) followPrimary(fd);
+            standbyConnected = false;
+            std::lock_guard<std::mutex> lock(standbyMutex);
+            standbyFd = -1;
+        }
+        if (fd >= 0) close(fd);
+        if (!standbyStopping) std::this_thread::sleep_for(std::chrono::milliseconds(STANDBY_RETRY_MILLIS));
+    }
+}
+
+/**
+ * @brief Starts following a primary: applies its changes to this process's data files as they arrive.
+ * @param primarySocketPath The primary's replication socket.
+ * @return bool False if this process is already a standby.
+ */
+bool startStandby(const std::string& primarySocketPath) {
+    std::lock_guard<std::mutex> lock(standbyMutex);
+    if (standbyThread.joinable()) return false;
+    long long seq = 0;
+    std::ifstream in(REPLICA_SEQ_FILE);
+    in >> seq;
+    appliedSeq = seq > 0 ? seq : 0;
+    lastContact = nowMillis();
+    standbyStopping = false;
+    standbyThread = std::thread(standbyLoop, primarySocketPath);
+    return true;
+}
+
+/**
+ * @brief Stops following the primary so this process can take over as the primary.
+ * @return long long The last primary sequence number applied.
+ * @note A batch being applied is finished first; one still in flight from the primary is dropped.
+ */
+long long promoteStandby() {
+    {
+        std::lock_guard<std::mutex> lock(standbyMutex);
+        if (!standbyThread.joinable()) return appliedSeq;
+        standbyStopping = true;
+        if (standbyFd >= 0) shutdown(standbyFd, SHUT_RDWR);
+    }
+    standbyThread.join();
+    return appliedSeq;
+}
+
+/**
+ * @brief Returns the replication state of this standby.
+ * @return ReplicationStats The current state.
+ */
+ReplicationStats replicationStats() {
+    long long applied = appliedSeq, head = std::max<long long>(primarySeq, applied);
+    return {standbyConnected, applied, head, head - applied, lagMillis,
+            std::max(0LL, nowMillis() - lastContact), snapshots, eventsApplied, batches, reconnects};
+}
+
+#endif
+
+/**
+ * @brief Prints the replication state of this standby.
+ * @param s The state.
+ */
+void printReplicationStats(const ReplicationStats& s) {
+    std::cout << "--- Replication ---\n"
+              << (s.connected ? "Connected" : "Disconnected") << ", last heard from primary " << s.silentMillis
+              << " ms ago\n"
+              << "Applied: " << s.appliedSeq << " of " << s.primarySeq << " (" << s.eventsBehind << " behind, lag "
+              << s.lagMillis << " ms)\n"
+              << "Events: " << s.eventsApplied << " in " << s.batches << " batches, snapshots: " << s.snapshots
+              << ", reconnects: " << s.reconnects << "\n";
+}
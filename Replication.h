@@ -0,0 +1,90 @@
+// Replication.h
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief How often an idle primary tells its standbys it is alive and how far its change feed has reached.
+ */
+const int REPLICATION_HEARTBEAT_MILLIS = 500;
+
+/**
+ * @brief Most change feed events shipped to a standby in one batch.
+ */
+const size_t REPLICATION_BATCH_EVENTS = 1000;
+
+/**
+ * @brief Replication state of a standby since it was started.
+ */
+struct ReplicationStats {
+    bool connected;             /**< Whether the standby is connected to the primary. */
+    long long appliedSeq;       /**< Last primary change feed sequence number applied and durable here. */
+    long long primarySeq;       /**< Last sequence number the primary reported as durable. */
+    long long eventsBehind;     /**< Changes the primary has made that are not applied here yet. */
+    long long lagMillis;        /**< Time from the primary sending the last batch to it being durable here. */
+    long long silentMillis;     /**< Time since the last message from the primary. */
+    long long snapshots;        /**< Full copies of the tables received. */
+    long long eventsApplied;    /**< Change events applied. */
+    long long batches;          /**< Batches applied, each with one save per table and one log sync. */
+    long long reconnects;       /**< Times the connection to the primary was lost. */
+};
+
+/**
+ * @brief Returns the default path of the primary's replication socket.
+ * @return const std::string& The socket path.
+ */
+const std::string& replicationSocketPath();
+
+/**
+ * @brief Starts shipping the change feed to standbys that connect to a Unix socket.
+ * @param socketPath Path of the socket; an existing file at that path is replaced.
+ * @return bool False if the source is already running, the socket cannot be opened or the platform has no
+ *       Unix sockets.
+ * @note Each standby gets its own thread. A standby with nothing applied, or one asking for changes the feed
+ *       no longer holds, first receives a copy of every table taken under dataFileMutex().
+ */
+bool startReplicationSource(const std::string& socketPath);
+
+/**
+ * @brief Disconnects every standby and stops accepting new ones.
+ */
+void stopReplicationSource();
+
+/**
+ * @brief Returns the number of standbys currently connected to this primary.
+ * @return size_t The number of standbys.
+ */
+size_t replicationStandbyCount();
+
+/**
+ * @brief Starts following a primary: applies its changes to this process's data files as they arrive.
+ * @param primarySocketPath The primary's replication socket.
+ * @return bool False if this process is already a standby or the platform has no Unix sockets.
+ * @note The standby reconnects whenever the connection drops and resumes after the last change it applied,
+ *       which is kept durably in a file beside the data files. Run it from its own working directory so its
+ *       data files are separate from the primary's.
+ */
+bool startStandby(const std::string& primarySocketPath);
+
+/**
+ * @brief Stops following the primary so this process can take over as the primary.
+ * @return long long The last primary sequence number applied.
+ * @note Every change received before the call is applied and durable when it returns.
+ */
+long long promoteStandby();
+
+/**
+ * @brief Returns the replication state of this standby.
+ * @return ReplicationStats The current state.
+ */
+ReplicationStats replicationStats();
+
+/**
+ * @brief Prints the replication state of this standby.
+ * @param s The state.
+ */
+void printReplicationStats(const ReplicationStats& s);
+
+#endif // REPLICATION_H
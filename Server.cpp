@@ -0,0 +1,679 @@
+// Server.cpp (implementation)
+#include "Server.h"
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+#include "Discount.h"
+#include "HistoryPartition.h"
+#include "StorageWriter.h"
+#include "HttpApi.h"
+#include "Lifecycle.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sstream>
+
+#ifdef TEST_MODE
+const std::string SERVER_SOCKET = "tests/test_server.sock";
+#else
+const std::string SERVER_SOCKET = "autoservice.sock";
+#endif
+
+/**
+ * @brief Storage writer queue capacity used when the server has to start the writer itself.
+ */
+const size_t SERVER_WRITER_CAPACITY = 4096;
+
+/**
+ * @brief Longest request line accepted; a connection sending a longer one is closed.
+ */
+const size_t SERVER_MAX_LINE = 64 * 1024;
+
+/**
+ * @brief Most unparsed input buffered per connection; reading pauses while a connection holds more.
+ */
+const size_t SERVER_MAX_BUFFERED = 1024 * 1024;
+
+static std::atomic<long long> accepted{0}, requests{0}, deferred{0}, busyRejects{0};
+static std::atomic<size_t> openConnections{0}, peakConnections{0};
+
+/**
+ * @brief Returns the default path of the kiosk server's Unix socket.
+ * @return const std::string& The socket path.
+ */
+const std::string& serverSocketPath() {
+    return SERVER_SOCKET;
+}
+
+/**
+ * @brief Returns the server counters.
+ * @return ServerStats The current statistics.
+ */
+ServerStats serverStats() {
+    return {accepted, requests, deferred, busyRejects, openConnections, peakConnections};
+}
+
+/**
+ * @brief Prints the server counters.
+ * @param s The statistics.
+ */
+void printServerStats(const ServerStats& s) {
+    std::cout << "--- Server ---\n"
+              << "Connections: " << s.openConnections << " open, " << s.peakConnections << " peak, "
+              << s.accepted << " accepted\n"
+              << "Requests: " << s.requests << ", deferred: " << s.deferred
+              << ", refused while busy: " << s.busyRejects << "\n";
+}
+
+#ifdef _WIN32
+
+bool startServer(const std::string&, int) {
+    std::cout << "Server mode needs Unix sockets and is not available on this platform.\n";
+    return false;
+}
+
+void stopServer() {}
+
+int serverHttpPort() {
+    return -1;
+}
+
+#else
+
+#include <cerrno>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/**
+ * @brief Wire protocol of a connection, fixed by the listener that accepted it.
+ */
+enum class Protocol {
+    Line,   /**< Kiosk protocol: one request per line. */
+    Http    /**< HTTP/1.1 with JSON bodies. */
+};
+
+/**
+ * @brief One reply slot; replies are written in request order, so a slot waiting for the storage writer
+ *        holds back the replies behind it.
+ */
+struct Reply {
+    bool ready = false;     /**< True once text is final. */
+    std::string text;       /**< Reply bytes, exactly as sent. */
+};
+
+/**
+ * @brief State of one client connection (event loop thread only).
+ * @note Requests are handled in order as their lines arrive. A booking or status change leaves its reply slot
+ *       pending and the connection waits (without blocking the loop) until the storage writer's completion
+ *       arrives; pipelined lines behind it stay buffered, so later requests see the write.
+ */
+struct Connection {
+    int fd = -1;                                    /**< Socket. */
+    unsigned long long id = 0;                      /**< Unique ID; fds are reused, IDs are not. */
+    Protocol protocol = Protocol::Line;             /**< Wire protocol. */
+    std::string in;                                 /**< Bytes received but not yet parsed into requests. */
+    std::string out;                                /**< Reply bytes not yet sent. */
+    std::deque<std::shared_ptr<Reply>> replies;     /**< Reply slots in request order. */
+    bool peerClosed = false;                        /**< The client shut down its side; close once answered. */
+    bool closeAfterReplies = false;                 /**< Close once answered, ignoring further requests. */
+    bool watchingRead = true;                       /**< Registered for readability. */
+    bool watchingWrite = false;                     /**< Registered for writability. */
+};
+
+/**
+ * @brief A reply finished on another thread, waiting to be handed to the event loop.
+ */
+struct Completion {
+    int fd;                         /**< Connection socket. */
+    unsigned long long connId;      /**< Connection ID, to detect a closed and reused fd. */
+    std::shared_ptr<Reply> reply;   /**< The slot to fill. */
+    std::string text;               /**< The reply bytes. */
+};
+
+static std::mutex lifecycleMutex;
+static std::thread loopThread;
+static std::atomic<bool> stopping{false};
+static int listenFd = -1, httpFd = -1, httpPort = -1, wakeRead = -1, wakeWrite = -1;
+static std::string listenPath;
+static std::unordered_map<int, Connection> connections;
+static unsigned long long nextConnectionId = 1;
+static std::mutex completionMutex;
+static std::vector<Completion> completions;
+
+// ---- Readiness polling: epoll on Linux, poll() elsewhere ----
+
+/**
+ * @brief One descriptor reported ready by the poller.
+ */
+struct ReadyFd {
+    int fd;
+    bool readable;
+    bool writable;
+    bool failed;
+};
+
+#ifdef __linux__
+
+static int epollFd = -1;
+
+static bool pollerOpen() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    return epollFd >= 0;
+}
+
+static void pollerClose() {
+    if (epollFd >= 0) close(epollFd);
+    epollFd = -1;
+}
+
+static void pollerWatch(int fd, bool wantRead, bool wantWrite, bool add) {
+    epoll_event ev{};
+    ev.events = (wantRead ? static_cast<uint32_t>(EPOLLIN) : 0u) | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.fd = fd;
+    epoll_ctl(epollFd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev);
+}
+
+static void pollerForget(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+static void pollerWait(std::vector<ReadyFd>& ready) {
+    epoll_event events[256];
+    ready.clear();
+    int n = epoll_wait(epollFd, events, 256, -1);
+    for (int i = 0; i < n; ++i) {
+        ready.push_back({events[i].data.fd, (events[i].events & EPOLLIN) != 0, (events[i].events & EPOLLOUT) != 0,
+                         (events[i].events & (EPOLLERR | EPOLLHUP)) != 0});
+    }
+}
+
+#else
+
+static std::unordered_map<int, short> watched;
+
+static bool pollerOpen() {
+    watched.clear();
+    return true;
+}
+
+static void pollerClose() {
+    watched.clear();
+}
+
+static void pollerWatch(int fd, bool wantRead, bool wantWrite, bool) {
+    watched[fd] = (wantRead ? POLLIN : 0) | (wantWrite ? POLLOUT : 0);
+}
+
+static void pollerForget(int fd) {
+    watched.erase(fd);
+}
+
+static void pollerWait(std::vector<ReadyFd>& ready) {
+    std::vector<pollfd> fds;
+    for (const auto& w : watched) fds.push_back({w.first, w.second, 0});
+    ready.clear();
+    if (poll(fds.data(), fds.size(), -1) <= 0) return;
+    for (const auto& p : fds) {
+        if (p.revents == 0) continue;
+        ready.push_back({p.fd, (p.revents & POLLIN) != 0, (p.revents & POLLOUT) != 0,
+                         (p.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0});
+    }
+}
+
+#endif
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// ---- Request handling ----
+
+/**
+ * @brief Hands a reply finished on another thread to the event loop and wakes it.
+ */
+static void postCompletion(int fd, unsigned long long connId, const std::shared_ptr<Reply>& reply, const std::string& text) {
+    std::lock_guard<std::mutex> lock(completionMutex);
+    if (wakeWrite < 0) return; // The server stopped while the write was in flight
+    completions.push_back({fd, connId, reply, text});
+    char b = 1;
+    if (write(wakeWrite, &b, 1) < 0) {} // A full pipe already guarantees a wake-up
+}
+
+/**
+ * @brief Parses a comma-separated list of IDs.
+ */
+static bool parseIdList(const std::string& csv, std::vector<int>& out) {
+    std::stringstream ss(csv);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        try {
+            out.push_back(std::stoi(item));
+        } catch (...) {
+            return false;
+        }
+    }
+    return !out.empty();
+}
+
+/**
+ * @brief Validates and prices a booking request, then queues it on the storage writer.
+ * @return std::string An immediate error reply, or an empty string if the reply is deferred.
+ */
+static std::string handleBook(std::istringstream& args, const Connection& c, const std::shared_ptr<Reply>& reply) {
+    int customerId, vehicleId, discountId = 0;
+    std::string serviceCsv;
+    std::vector<int> serviceIds;
+    if (!(args >> customerId >> vehicleId >> serviceCsv) || !parseIdList(serviceCsv, serviceIds)) {
+        return "ERR usage: BOOK <customerId> <vehicleId> <serviceId,...> [discountId]";
+    }
+    args >> discountId;
+
+    Mutation m;
+    std::string error;
+    if (!prepareBooking(customerId, vehicleId, serviceIds, discountId, m.booking, error)) return "ERR " + error;
+    m.type = MutationType::AddBooking;
+    int fd = c.fd;
+    unsigned long long connId = c.id;
+    m.done = [fd, connId, reply](bool ok, int historyId, const std::string&) {
+        postCompletion(fd, connId, reply, ok ? "OK " + std::to_string(historyId) + "\n" : "ERR write failed\n");
+    };
+    if (!submitMutation(std::move(m), false)) { // Never block the loop; the kiosk may retry
+        busyRejects++;
+        return "ERR busy";
+    }
+    deferred++;
+    return "";
+}
+
+/**
+ * @brief Queues a status change on the storage writer.
+ * @return std::string An immediate error reply, or an empty string if the reply is deferred.
+ */
+static std::string handleStatus(std::istringstream& args, const Connection& c, const std::shared_ptr<Reply>& reply) {
+    int historyId;
+    std::string status;
+    if (!(args >> historyId >> status)) return "ERR usage: STATUS <historyId> <status>";
+    ServiceHistory h;
+    if (!findHistoryById(historyId, h)) return "ERR history not found";
+    std::string error;
+    JobStage stage;
+    if (!checkStatusChange(h.status, status, error)) return "ERR " + error; // Checked again by the writer
+    parseJobStage(status, stage);
+
+    Mutation m;
+    m.type = MutationType::SetStatus;
+    m.historyId = historyId;
+    m.status = jobStageStatus(stage);
+    int fd = c.fd;
+    unsigned long long connId = c.id;
+    m.done = [fd, connId, reply](bool ok, int id, const std::string& error) {
+        std::string line = ok ? "OK " + std::to_string(id) : error.empty() ? "ERR write failed" : "ERR " + error;
+        postCompletion(fd, connId, reply, line + "\n");
+    };
+    if (!submitMutation(std::move(m), false)) {
+        busyRejects++;
+        return "ERR busy";
+    }
+    deferred++;
+    return "";
+}
+
+/**
+ * @brief Handles one HTTP request and appends its reply slot to the connection.
+ * @note A request without keep-alive is the connection's last; pipelined requests after it are ignored.
+ */
+static void handleHttpRequest(Connection& c, const HttpRequest& req) {
+    requests++;
+    auto reply = std::make_shared<Reply>();
+    c.replies.push_back(reply);
+    bool keepAlive = req.keepAlive;
+    if (!keepAlive) c.closeAfterReplies = true;
+    int fd = c.fd;
+    unsigned long long connId = c.id;
+    int status;
+    std::string body;
+    bool answered = routeHttpRequest(req, status, body, [fd, connId, reply, keepAlive](int st, const std::string& b) {
+        postCompletion(fd, connId, reply, formatHttpResponse(st, b, keepAlive));
+    });
+    if (!answered) {
+        deferred++;
+        return;
+    }
+    if (status == 503) busyRejects++;
+    reply->text = formatHttpResponse(status, body, keepAlive, httpContentType(req, status));
+    reply->ready = true;
+}
+
+/**
+ * @brief Handles one request line and appends its reply slot to the connection.
+ * @note Lookups are answered at once from the cached tables; writes leave the slot pending.
+ */
+static void handleRequest(Connection& c, const std::string& line) {
+    requests++;
+    auto reply = std::make_shared<Reply>();
+    c.replies.push_back(reply);
+    std::istringstream args(line);
+    std::string verb, text;
+    args >> verb;
+    if (verb == "PING") {
+        text = "OK PONG";
+    } else if (verb == "CUSTOMER") {
+        int id;
+        auto customers = loadCustomers();
+        Customer* cu = (args >> id) ? findCustomerById(customers, id) : nullptr;
+        if (cu) text = "OK " + std::to_string(cu->id) + '|' + cu->name + '|' + cu->phone + '|' + cu->email;
+        else text = "ERR customer not found";
+    } else if (verb == "HISTORY") {
+        int id;
+        if (args >> id) {
+            auto rows = findHistoryRows(HistoryKey::CustomerId, id);
+            text = "OK " + std::to_string(rows.size());
+            for (const auto& h : rows) text += "\n" + formatHistoryLine(h);
+        } else {
+            text = "ERR usage: HISTORY <customerId>";
+        }
+    } else if (verb == "BOOK") {
+        text = handleBook(args, c, reply);
+    } else if (verb == "STATUS") {
+        text = handleStatus(args, c, reply);
+    } else {
+        text = "ERR unknown command";
+    }
+    if (!text.empty()) {
+        reply->text = text + "\n";
+        reply->ready = true;
+    }
+}
+
+// ---- Connection I/O ----
+
+static void closeConnection(int fd) {
+    pollerForget(fd);
+    close(fd);
+    connections.erase(fd);
+    openConnections--;
+}
+
+/**
+ * @brief Moves ready replies to the output buffer and sends as much as the socket takes.
+ * @return bool False if the connection was closed.
+ */
+static bool flushConnection(Connection& c) {
+    while (!c.replies.empty() && c.replies.front()->ready) {
+        c.out += c.replies.front()->text;
+        c.replies.pop_front();
+    }
+    size_t sent = 0;
+    while (sent < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) { sent += static_cast<size_t>(n); continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closeConnection(c.fd);
+        return false;
+    }
+    c.out.erase(0, sent);
+    if ((c.peerClosed || c.closeAfterReplies) && c.out.empty() && c.replies.empty()) {
+        closeConnection(c.fd);
+        return false;
+    }
+    // Stop reading after end of stream (a level-triggered poller would report it again and again) and while
+    // too much input is buffered behind a pending write
+    bool wantRead = !c.peerClosed && c.in.size() < SERVER_MAX_BUFFERED, wantWrite = !c.out.empty();
+    if (wantRead != c.watchingRead || wantWrite != c.watchingWrite) {
+        pollerWatch(c.fd, wantRead, wantWrite, false);
+        c.watchingRead = wantRead;
+        c.watchingWrite = wantWrite;
+    }
+    return true;
+}
+
+/**
+ * @brief Handles buffered request lines in order until one has to wait for the storage writer.
+ */
+static void processInput(Connection& c) {
+    size_t start = 0;
+    while ((c.replies.empty() || c.replies.back()->ready) && !c.closeAfterReplies) {
+        if (c.protocol == Protocol::Line) {
+            size_t nl = c.in.find('\n', start);
+            if (nl == std::string::npos) break;
+            std::string line = c.in.substr(start, nl - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) handleRequest(c, line);
+            start = nl + 1;
+        } else {
+            HttpRequest req;
+            size_t end = start;
+            HttpParseResult r = parseHttpRequest(c.in, start, req, end);
+            if (r == HttpParseResult::Incomplete) break;
+            if (r == HttpParseResult::Invalid) {
+                auto reply = std::make_shared<Reply>();
+                reply->text = formatHttpResponse(400, "{\"error\":\"bad request\"}", false);
+                reply->ready = true;
+                c.replies.push_back(reply);
+                c.closeAfterReplies = true;
+                start = c.in.size();
+                break;
+            }
+            handleHttpRequest(c, req);
+            start = end;
+        }
+    }
+    c.in.erase(0, start);
+}
+
+/**
+ * @brief Reads what is available, handles the complete request lines and sends the replies that are ready.
+ */
+static void readConnection(Connection& c) {
+    char buf[16 * 1024];
+    while (c.in.size() < SERVER_MAX_BUFFERED) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) { c.in.append(buf, static_cast<size_t>(n)); continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0) c.peerClosed = true;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) { closeConnection(c.fd); return; }
+        break;
+    }
+    processInput(c);
+    if (c.protocol == Protocol::Line && c.in.size() > SERVER_MAX_LINE && c.in.find('\n') == std::string::npos) {
+        closeConnection(c.fd); // A line this long is not a request
+        return;
+    }
+    flushConnection(c);
+}
+
+static void acceptConnections(int listener, Protocol protocol) {
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN, or out of descriptors: try again on the next readiness event
+        }
+        if (!setNonBlocking(fd)) { close(fd); continue; }
+        if (protocol == Protocol::Http) {
+            int one = 1; // Small responses must not wait for the previous one's ACK
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        Connection& c = connections[fd];
+        c = Connection();
+        c.fd = fd;
+        c.id = nextConnectionId++;
+        c.protocol = protocol;
+        pollerWatch(fd, true, false, true);
+        accepted++;
+        size_t open = ++openConnections, peak = peakConnections.load();
+        while (open > peak && !peakConnections.compare_exchange_weak(peak, open)) {}
+    }
+}
+
+/**
+ * @brief Fills the reply slots finished by the storage writer and resumes their connections.
+ */
+static void drainCompletions() {
+    char buf[256];
+    while (read(wakeRead, buf, sizeof(buf)) > 0) {}
+    std::vector<Completion> done;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        done.swap(completions);
+    }
+    for (auto& d : done) {
+        d.reply->text = d.text;
+        d.reply->ready = true;
+        auto it = connections.find(d.fd);
+        if (it == connections.end() || it->second.id != d.connId) continue;
+        processInput(it->second); // Resume the requests that were waiting behind this one
+        flushConnection(it->second);
+    }
+}
+
+/**
+ * @brief Event loop: waits for readiness and runs each ready connection's state machine.
+ */
+static void serverLoop() {
+    std::vector<ReadyFd> ready;
+    while (!stopping) {
+        pollerWait(ready);
+        for (const auto& r : ready) {
+            if (r.fd == wakeRead) {
+                drainCompletions();
+            } else if (r.fd == listenFd) {
+                acceptConnections(listenFd, Protocol::Line);
+            } else if (r.fd == httpFd) {
+                acceptConnections(httpFd, Protocol::Http);
+            } else {
+                auto it = connections.find(r.fd);
+                if (it == connections.end()) continue;
+                if (r.failed && it->second.peerClosed) closeConnection(r.fd); // Gone for good: drop pending replies
+                else if (r.readable || r.failed) readConnection(it->second); // A hang-up reads as end of stream
+                else if (r.writable) flushConnection(it->second);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Opens a non-blocking TCP listener on 127.0.0.1.
+ * @param port The port, or 0 for any free port.
+ * @return int The socket, or -1 on failure; httpPort receives the bound port.
+ */
+static int openHttpListener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // The portal's backend runs on the same host
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    socklen_t len = sizeof(addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0 ||
+        !setNonBlocking(fd) || getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    httpPort = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * @brief Starts the kiosk server on a Unix socket and, optionally, the HTTP API on localhost.
+ * @param socketPath Path of the socket to listen on.
+ * @param port HTTP port on 127.0.0.1, 0 for any free port, or -1 for no HTTP API.
+ * @return bool False if the server is already running or a socket cannot be opened.
+ */
+bool startServer(const std::string& socketPath, int port) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (loopThread.joinable()) return false;
+    sockaddr_un addr{};
+    if (socketPath.size() >= sizeof(addr.sun_path)) return false;
+    addr.sun_family = AF_UNIX;
+    socketPath.copy(addr.sun_path, socketPath.size());
+
+    unlink(socketPath.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    httpFd = port >= 0 ? openHttpListener(port) : -1;
+    int pipeFds[2] = {-1, -1};
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0 || !setNonBlocking(listenFd) || (port >= 0 && httpFd < 0) ||
+        pipe(pipeFds) != 0 || !pollerOpen()) {
+        for (int fd : {listenFd, httpFd, pipeFds[0], pipeFds[1]}) {
+            if (fd >= 0) close(fd);
+        }
+        listenFd = httpFd = httpPort = -1;
+        return false;
+    }
+    setNonBlocking(pipeFds[0]);
+    setNonBlocking(pipeFds[1]);
+    wakeRead = pipeFds[0];
+    {
+        std::lock_guard<std::mutex> completionLock(completionMutex);
+        wakeWrite = pipeFds[1];
+    }
+    pollerWatch(listenFd, true, false, true);
+    if (httpFd >= 0) pollerWatch(httpFd, true, false, true);
+    pollerWatch(wakeRead, true, false, true);
+    listenPath = socketPath;
+    startStorageWriter(SERVER_WRITER_CAPACITY); // Does nothing if the writer is already running
+    stopping = false;
+    loopThread = std::thread(serverLoop);
+    return true;
+}
+
+/**
+ * @brief Returns the port the HTTP API listens on.
+ * @return int The port, or -1 if the HTTP API is not running.
+ */
+int serverHttpPort() {
+    return httpPort;
+}
+
+/**
+ * @brief Stops the server and closes every connection.
+ */
+void stopServer() {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (!loopThread.joinable()) return;
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> completionLock(completionMutex);
+        char b = 1;
+        if (write(wakeWrite, &b, 1) < 0) {}
+    }
+    loopThread.join();
+    while (!connections.empty()) closeConnection(connections.begin()->first);
+    pollerClose();
+    close(listenFd);
+    if (httpFd >= 0) close(httpFd);
+    close(wakeRead);
+    listenFd = httpFd = httpPort = wakeRead = -1;
+    unlink(listenPath.c_str());
+    std::lock_guard<std::mutex> completionLock(completionMutex);
+    close(wakeWrite);
+    wakeWrite = -1;
+    completions.clear();
+}
+
+#endif
@@ -0,0 +1,74 @@
+// Server.h
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief HTTP API port used by "main --serve" when none is given.
+ */
+const int DEFAULT_HTTP_PORT = 8080;
+
+/**
+ * @brief Counters of the kiosk and HTTP server since it was started.
+ */
+struct ServerStats {
+    long long accepted;         /**< Connections accepted. */
+    long long requests;         /**< Requests handled. */
+    long long deferred;         /**< Requests answered later: writes once durable, reports once built. */
+    long long busyRejects;      /**< Requests refused because the storage writer queue was full. */
+    size_t openConnections;     /**< Connections currently open. */
+    size_t peakConnections;     /**< Most connections open at once. */
+};
+
+/**
+ * @brief Returns the default path of the kiosk server's Unix socket.
+ * @return const std::string& The socket path.
+ */
+const std::string& serverSocketPath();
+
+/**
+ * @brief Starts the kiosk server, and optionally the HTTP API, on one event loop thread.
+ * @param socketPath Path of the kiosk Unix socket; an existing file at that path is replaced.
+ * @param httpPort Port for the HTTP API on 127.0.0.1, 0 for any free port, or -1 for no HTTP API.
+ * @return bool False if the server is already running, a socket cannot be opened or the platform has no
+ *         Unix sockets.
+ * @note The kiosk protocol is one request per line, answered in order. Requests may be pipelined; a request sent
+ *       behind a booking or status change on the same connection is handled once that write is durable:
+ *       "PING" -> "OK PONG";
+ *       "CUSTOMER <id>" -> "OK <customer line>";
+ *       "HISTORY <customerId>" -> "OK <n>" followed by n history lines;
+ *       "BOOK <customerId> <vehicleId> <serviceId,...> [discountId]" -> "OK <historyId>" once durable;
+ *       "STATUS <historyId> <status>" -> "OK <historyId>" once durable.
+ *       Errors are answered with "ERR <reason>". The HTTP API (see routeHttpRequest()) follows the same rules
+ *       with keep-alive and pipelining. Writes go through the storage writer, which the server starts if it is
+ *       not already running.
+ */
+bool startServer(const std::string& socketPath, int httpPort = -1);
+
+/**
+ * @brief Returns the port the HTTP API listens on.
+ * @return int The port, or -1 if the HTTP API is not running.
+ */
+int serverHttpPort();
+
+/**
+ * @brief Stops the server: closes every connection, removes the socket and joins the event loop thread.
+ * @note Replies still waiting for the storage writer are dropped; the writes themselves still complete.
+ */
+void stopServer();
+
+/**
+ * @brief Returns the server counters.
+ * @return ServerStats The current statistics.
+ */
+ServerStats serverStats();
+
+/**
+ * @brief Prints the server counters.
+ * @param s The statistics.
+ */
+void printServerStats(const ServerStats& s);
+
+#endif // SERVER_H
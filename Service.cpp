@@ -1,14 +1,31 @@
 // Service.cpp (implementation)
 #include "Service.h"
+#include "Storage.h"
+#include "ChangeFeed.h"
+#include "Snapshot.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <charconv>
 #include <ctime>
 #include <iomanip>
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
+#include <limits>
+#include "HistoryPartition.h"
+#include "HistoryArchive.h"
+#include "HistoryLog.h"
+#include "BranchStore.h"
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Discount.h"
+#include "Tax.h"
+#include "Inventory.h"
+#include "Calendar.h"
+#include "Lifecycle.h"
 
 #ifdef TEST_MODE
 const std::string SERVICES_FILE = "tests/test_services.txt";
@@ -41,11 +58,13 @@ int nextServiceId() {
 /**
  * @brief Determines the next available service history ID by finding the maximum ID in the history file and incrementing it.
  * @return int The next available service history ID.
- * @note Reads from HISTORY_FILE and handles malformed or empty lines gracefully.
+ * @note Reads from HISTORY_FILE and handles malformed or empty lines gracefully. IDs already used by
+ *       archived entries or by bookings still in the history log are never reissued.
  */
 int nextHistoryId() {
     std::ifstream ifs(HISTORY_FILE);
-    int maxId = 0; std::string ln;
+    int maxId = archivedMaxHistoryId(); std::string ln;
+    for (const auto& h : loadHistory()) maxId = std::max(maxId, h.historyId);
     while (std::getline(ifs, ln)) {
         if (ln.empty()) continue;
         std::istringstream ss(ln);
@@ -58,6 +77,33 @@ int nextHistoryId() {
     return maxId + 1;
 }
 
+/**
+ * @brief Parses one line of the service file.
+ * @param line The raw line in "id|name|price[|taxClass[|durationMinutes]]" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseServiceLine(const std::string& line, ServiceItem& out) {
+    if (line.empty()) return false;
+    std::istringstream ss(line);
+    std::string idStr, name, priceStr, classStr, durationStr;
+    if (!std::getline(ss, idStr, '|')) return false;
+    try {
+        ServiceItem s;
+        s.id = std::stoi(idStr);
+        std::getline(ss, name, '|');
+        std::getline(ss, priceStr, '|');
+        s.name = name;
+        s.price = std::stod(priceStr);
+        s.taxClass = std::getline(ss, classStr, '|') ? std::stoi(classStr) : 0;
+        s.durationMinutes = std::getline(ss, durationStr, '|') ? std::stoi(durationStr) : 0;
+        out = s;
+        return true;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
 /**
  * @brief Loads all services from the services file into a vector.
  * @return std::vector<ServiceItem> A vector containing all valid service records.
@@ -65,45 +111,60 @@ int nextHistoryId() {
  */
 std::vector<ServiceItem> loadServices() {
     std::vector<ServiceItem> list;
+    if (lookupCachedTable(SERVICES_FILE, list)) return list;
     std::ifstream ifs(SERVICES_FILE);
     std::string line;
+    ServiceItem item;
     while (std::getline(ifs, line)) {
-        if (line.empty()) continue;
-        std::istringstream ss(line);
-        std::string idStr, name, priceStr;
-        if (!std::getline(ss, idStr, '|')) continue;
-        try {
-            ServiceItem s;
-            s.id = std::stoi(idStr);
-            std::getline(ss, name, '|');
-            std::getline(ss, priceStr, '|');
-            s.name = name;
-            s.price = std::stod(priceStr);
-            list.push_back(s);
-        } catch (...) {
-            continue; // Skip malformed
-        }
+        if (parseServiceLine(line, item)) list.push_back(item); // Skip empty or malformed
     }
+    storeCachedTable(SERVICES_FILE, list);
     return list;
 }
 
+/**
+ * @brief Formats a service as its line in the service file.
+ * @param s The service.
+ * @return std::string The line (without the newline), as parseServiceLine() reads it.
+ */
+std::string formatServiceLine(const ServiceItem& s) {
+    std::ostringstream line;
+    line << s.id << '|' << s.name << '|' << s.price;
+    if (s.taxClass != 0 || s.durationMinutes != 0) line << '|' << s.taxClass; // Untaxed services keep the original format
+    if (s.durationMinutes != 0) line << '|' << s.durationMinutes;
+    return line.str();
+}
+
 /**
  * @brief Saves a list of services to the services file, ensuring unique IDs.
  * @param list A vector of ServiceItem objects to save.
- * @note Overwrites the existing file and keeps only the first occurrence of each service ID.
+ * @note Overwrites the existing file and keeps only the first occurrence of each service ID, then publishes the
+ *       inserted, updated and deleted services to the change feed.
  */
 void saveServices(const std::vector<ServiceItem>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::vector<ServiceItem> before = loadServices();
     std::map<int, ServiceItem> unique;
     for (const auto& s : list) {
         if (unique.count(s.id) == 0) {
             unique[s.id] = s;
         }
     }
-    std::ofstream ofs(SERVICES_FILE, std::ios::trunc);
-    for (const auto& p : unique) {
-        const auto& s = p.second;
-        ofs << s.id << '|' << s.name << '|' << s.price << '\n';
+    std::vector<ServiceItem> written;
+    {
+        std::ofstream ofs(SERVICES_FILE, std::ios::trunc);
+        for (const auto& p : unique) {
+            const auto& s = p.second;
+            std::string line = formatServiceLine(s);
+            ofs << line << '\n';
+            ServiceItem row;
+            if (parseServiceLine(line, row)) written.push_back(row); // Cache exactly what the loader reads back
+        }
     }
+    storeCachedTable(SERVICES_FILE, written);
+    std::vector<ChangeEvent> changes;
+    diffTableChanges("service", before, written, [](const ServiceItem& r) { return r.id; }, formatServiceLine, changes);
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
 }
 
 /**
@@ -114,12 +175,12 @@ void ensureDefaultServices() {
     auto list = loadServices();
     if (!list.empty()) return;
     // Add defaults including General Service
-    list.push_back({1, "Oil Change", 1200});
-    list.push_back({2, "Brake Inspection", 800});
-    list.push_back({3, "Wheel Alignment", 600});
-    list.push_back({4, "Car Wash", 500});
-    list.push_back({5, "Engine Tune-up", 2000});
-    list.push_back({6, "General Service", 1500});
+    list.push_back({1, "Oil Change", 1200, TAX_CLASS_SERVICES, 30});
+    list.push_back({2, "Brake Inspection", 800, TAX_CLASS_SERVICES, 60});
+    list.push_back({3, "Wheel Alignment", 600, TAX_CLASS_SERVICES, 60});
+    list.push_back({4, "Car Wash", 500, TAX_CLASS_SERVICES, 30});
+    list.push_back({5, "Engine Tune-up", 2000, TAX_CLASS_SERVICES, 120});
+    list.push_back({6, "General Service", 1500, TAX_CLASS_SERVICES, 180});
     saveServices(list);
 }
 
@@ -149,6 +210,37 @@ void addServiceInteractive() {
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
         }
     }
+
+    viewTaxClasses();
+    while (true) {
+        std::cout << "Enter tax class ID (0 for untaxed, blank for " << TAX_CLASS_SERVICES << "): ";
+        std::string input;
+        std::getline(std::cin, input);
+        std::istringstream iss(input);
+        int taxClass;
+        if (input.empty()) {
+            s.taxClass = TAX_CLASS_SERVICES;
+            break;
+        } else if (iss >> taxClass && iss.eof() && taxClass >= 0) {
+            s.taxClass = taxClass;
+            break;
+        }
+        std::cout << "Invalid tax class. Please enter a valid ID (>= 0).\n";
+    }
+
+    while (true) {
+        std::cout << "Enter duration in minutes (blank for 60): ";
+        std::string input;
+        std::getline(std::cin, input);
+        std::istringstream iss(input);
+        int minutes;
+        if (input.empty()) break;
+        if (iss >> minutes && iss.eof() && minutes > 0) {
+            s.durationMinutes = minutes;
+            break;
+        }
+        std::cout << "Invalid duration. Please enter a whole number of minutes (> 0).\n";
+    }
     
     list.push_back(s);
     saveServices(list);
@@ -198,6 +290,17 @@ void updateService() {
                 double p;
                 if (input.empty() || (iss >> p && iss.eof() && p >= 0)) { // Allow empty input or valid number
                     if (!input.empty()) s.price = p; // Update price only if input is not empty and valid
+                    std::cout << "Enter new tax class ID (leave blank to keep " << s.taxClass << "): ";
+                    std::getline(std::cin, input);
+                    std::istringstream cls(input);
+                    int taxClass;
+                    if (cls >> taxClass && cls.eof() && taxClass >= 0) s.taxClass = taxClass;
+                    std::cout << "Enter new duration in minutes (leave blank to keep "
+                              << (s.durationMinutes > 0 ? s.durationMinutes : 60) << "): ";
+                    std::getline(std::cin, input);
+                    std::istringstream dur(input);
+                    int minutes;
+                    if (dur >> minutes && dur.eof() && minutes > 0) s.durationMinutes = minutes;
                     saveServices(list);
                     std::cout << "Service updated.\n";
                     return;
@@ -230,61 +333,268 @@ void deleteService() {
     }
 }
 
+/**
+ * @brief Parses one "stage:offsetSeconds" entry of a history line.
+ */
+static bool parseStageEntry(const std::string& token, StageTime& t) {
+    const char* end = token.data() + token.size();
+    auto r = std::from_chars(token.data(), end, t.stage);
+    if (r.ec != std::errc() || r.ptr == end || *r.ptr != ':') return false;
+    r = std::from_chars(r.ptr + 1, end, t.offsetSeconds);
+    return r.ec == std::errc() && r.ptr == end;
+}
+
+/**
+ * @brief Parses one "class:rateBasisPoints:taxablePaise:taxPaise" entry of a history line.
+ */
+static bool parseTaxEntry(const std::string& token, TaxLine& t) {
+    const char* p = token.data();
+    const char* end = p + token.size();
+    auto field = [&](auto& v, bool last) {
+        auto r = std::from_chars(p, end, v);
+        if (r.ec != std::errc() || (last ? r.ptr != end : (r.ptr == end || *r.ptr != ':'))) return false;
+        p = r.ptr + 1;
+        return true;
+    };
+    return field(t.taxClass, false) && field(t.rateBasisPoints, false) && field(t.taxablePaise, false) &&
+           field(t.taxPaise, true);
+}
+
+/**
+ * @brief Parses one line of the history file into a ServiceHistory entry.
+ * @param ln The raw line in "id|cust|veh|sids|dateTime|subtotal|discId|discPct|total|status[|branchId[|taxes]]"
+ *        format, taxes being "class:rateBasisPoints:taxablePaise:taxPaise" entries separated by commas.
+ * @param out Receives the parsed entry on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseHistoryLine(const std::string& ln, ServiceHistory& out) {
+    if (ln.empty()) return false;
+    std::istringstream ss(ln);
+    std::string sid, sids, subtotalStr, discIdStr, discPctStr, totalStr;
+    try {
+        std::getline(ss, sid, '|'); int historyId = std::stoi(sid);
+        std::getline(ss, sid, '|'); int customerId = std::stoi(sid);
+        std::getline(ss, sid, '|'); int vehicleId = std::stoi(sid);
+        std::getline(ss, sids, '|');
+        std::vector<int> serviceIds;
+        std::istringstream sss(sids);
+        std::string token;
+        while (std::getline(sss, token, ',')) {
+            if (!token.empty()) serviceIds.push_back(std::stoi(token));
+        }
+        std::string dateTime;
+        std::getline(ss, dateTime, '|');
+        std::getline(ss, subtotalStr, '|'); double subtotal = std::stod(subtotalStr);
+        std::getline(ss, discIdStr, '|'); int discountId = std::stoi(discIdStr);
+        std::getline(ss, discPctStr, '|'); double discountPercent = std::stod(discPctStr);
+        std::getline(ss, totalStr, '|'); double total = std::stod(totalStr);
+        std::string status, branch, taxStr, stageStr;
+        std::getline(ss, status, '|');
+        int branchId = std::getline(ss, branch, '|') ? std::stoi(branch) : 0;
+        std::vector<TaxLine> taxes;
+        if (std::getline(ss, taxStr, '|')) {
+            std::istringstream ts(taxStr);
+            while (std::getline(ts, token, ',')) {
+                TaxLine t;
+                if (!parseTaxEntry(token, t)) return false;
+                taxes.push_back(t);
+            }
+        }
+        std::vector<StageTime> stages;
+        if (std::getline(ss, stageStr, '|')) {
+            std::istringstream ts(stageStr);
+            while (std::getline(ts, token, ',')) {
+                StageTime t;
+                if (!parseStageEntry(token, t)) return false;
+                stages.push_back(t);
+            }
+        }
+        out = {historyId, customerId, vehicleId, serviceIds, dateTime, subtotal, discountId, discountPercent, total, status,
+               branchId, std::move(taxes), std::move(stages)};
+        return true;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
+/**
+ * @brief Formats a service history entry as one line of the history file (without the trailing newline).
+ * @param h The ServiceHistory object to format.
+ * @return std::string The pipe-separated line, with service IDs as a comma-separated list, the branch ID
+ *         appended only when it is not 0 or taxes follow, the tax lines appended only when there are any, and
+ *         the stage times (as "stage:offsetSeconds" entries) only once the job has moved past booking.
+ */
+std::string formatHistoryLine(const ServiceHistory& h) {
+    std::ostringstream ofs;
+    ofs << h.historyId << '|' << h.customerId << '|' << h.vehicleId << '|';
+    for (size_t i=0;i<h.serviceIds.size();++i) {
+        if (i) ofs << ',';
+        ofs << h.serviceIds[i];
+    }
+    ofs << '|' << h.dateTime << '|' << h.subtotal << '|' << h.discountId << '|' << h.discountPercent << '|' << h.total << '|' << h.status;
+    if (h.branchId != 0 || !h.taxes.empty() || !h.stages.empty()) ofs << '|' << h.branchId; // Untaxed main workshop rows keep the original format
+    if (h.taxes.empty() && !h.stages.empty()) ofs << '|';
+    for (size_t i = 0; i < h.taxes.size(); ++i) {
+        const TaxLine& t = h.taxes[i];
+        ofs << (i ? ',' : '|') << t.taxClass << ':' << t.rateBasisPoints << ':' << t.taxablePaise << ':' << t.taxPaise;
+    }
+    for (size_t i = 0; i < h.stages.size(); ++i) {
+        ofs << (i ? ',' : '|') << h.stages[i].stage << ':' << h.stages[i].offsetSeconds;
+    }
+    return ofs.str();
+}
+
 /**
  * @brief Loads all service history entries from the history file into a vector.
  * @return std::vector<ServiceHistory> A vector containing all valid service history records.
- * @note Skips empty or malformed lines and parses comma-separated service IDs.
+ * @note Skips empty or malformed lines and parses comma-separated service IDs, then replays the
+ *       bookings and status changes logged since the last checkpoint.
  */
 std::vector<ServiceHistory> loadHistory() {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex()); // Read the file and its log as a pair
     std::vector<ServiceHistory> list;
-    std::ifstream ifs(HISTORY_FILE);
+    if (lookupCachedTable(HISTORY_FILE, list, historyLogPath())) return list;
+    std::ifstream ifs(HISTORY_FILE, std::ios::binary);
+    std::ostringstream raw;
+    raw << ifs.rdbuf();
+    std::string content = raw.str();
+    std::istringstream in(content);
     std::string ln;
-    while (std::getline(ifs, ln)) {
-        if (ln.empty()) continue;
-        std::istringstream ss(ln);
-        std::string sid, sids, subtotalStr, discIdStr, discPctStr, totalStr;
-        try {
-            std::getline(ss, sid, '|'); int historyId = std::stoi(sid);
-            std::getline(ss, sid, '|'); int customerId = std::stoi(sid);
-            std::getline(ss, sid, '|'); int vehicleId = std::stoi(sid);
-            std::getline(ss, sids, '|');
-            std::vector<int> serviceIds;
-            std::istringstream sss(sids);
-            std::string token;
-            while (std::getline(sss, token, ',')) {
-                if (!token.empty()) serviceIds.push_back(std::stoi(token));
-            }
-            std::string dateTime;
-            std::getline(ss, dateTime, '|');
-            std::getline(ss, subtotalStr, '|'); double subtotal = std::stod(subtotalStr);
-            std::getline(ss, discIdStr, '|'); int discountId = std::stoi(discIdStr);
-            std::getline(ss, discPctStr, '|'); double discountPercent = std::stod(discPctStr);
-            std::getline(ss, totalStr, '|'); double total = std::stod(totalStr);
-            std::string status;
-            std::getline(ss, status, '|');
-            list.push_back({historyId, customerId, vehicleId, serviceIds, dateTime, subtotal, discountId, discountPercent, total, status});
-        } catch (...) {
-            continue; // Skip malformed
-        }
+    ServiceHistory h;
+    while (std::getline(in, ln)) {
+        if (!ln.empty() && ln.back() == '\r') ln.pop_back();
+        if (parseHistoryLine(ln, h)) list.push_back(h); // Skip malformed
     }
+    std::lock_guard<std::mutex> logLock(historyLogMutex()); // No batch lands between replay and stamping
+    replayHistoryLog(content, list);
+    storeCachedTable(HISTORY_FILE, list, historyLogPath());
     return list;
 }
 
 /**
  * @brief Saves a list of service history entries to the history file.
  * @param list A vector of ServiceHistory objects to save.
- * @note Overwrites the existing file, storing service IDs as a comma-separated list.
+ * @note Replaces the existing file atomically, storing service IDs as a comma-separated list, empties the
+ *       history log (the list already holds everything it recorded) and rebuilds the monthly partition
+ *       segments and the branch history files from the same list.
  */
 void saveHistory(const std::vector<ServiceHistory>& list) {
-    std::ofstream ofs(HISTORY_FILE, std::ios::trunc);
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::vector<ServiceHistory> written;
+    std::string content;
     for (auto &h : list) {
-        ofs << h.historyId << '|' << h.customerId << '|' << h.vehicleId << '|';
-        for (size_t i=0;i<h.serviceIds.size();++i) {
-            if (i) ofs << ',';
-            ofs << h.serviceIds[i];
+        std::string ln = formatHistoryLine(h);
+        content += ln + '\n';
+        ServiceHistory row;
+        if (parseHistoryLine(ln, row)) written.push_back(row); // Cache exactly what the loader reads back
+    }
+    if (!installHistoryBase(content, false)) {
+        std::cout << "Failed to save service history.\n";
+        return;
+    }
+    storeCachedTable(HISTORY_FILE, written, historyLogPath());
+    writeHistoryPartitions(list);
+    writeBranchHistory(written);
+    resetTurnaroundStats();
+}
+
+/**
+ * @brief Queues records for the history log, applies them to the cached history, marks the partitions they
+ *        touch for refresh, and waits until they are durable.
+ * @param records History log records (bookings and status changes), in order.
+ * @param refused Optional; receives the reason each refused status change was skipped, empty if applied.
+ * @return bool True once every applied record is durable.
+ * @note Status changes are checked against the row as it stands under the mutex, so two changes racing on one
+ *       booking cannot both pass a check made on the same stale status. The data file mutex is released before waiting, so concurrent callers join the same group commit. The
+ *       bookings inserted and updated are numbered in the change feed under the mutex and written to it once
+ *       the log is durable. A booking that is completed takes its reserved parts out of stock and is added to
+ *       the turnaround statistics; one that is cancelled releases its parts and its appointment.
+ */
+bool logHistoryChanges(const std::vector<std::string>& records, std::vector<std::string>* refused) {
+    if (refused) refused->assign(records.size(), "");
+    if (records.empty()) return true;
+    std::vector<std::shared_ptr<HistoryLogBatch>> batches;
+    long long changeSeq = 0;
+    {
+        std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+        std::vector<int> ids;
+        std::set<int> touched;
+        for (const auto& record : records) {
+            size_t bar = record.find('|', 2);
+            int id = -1;
+            try { id = std::stoi(record.substr(2, bar - 2)); } catch (...) {}
+            ids.push_back(id);
+            touched.insert(id);
+        }
+
+        // Track just the touched rows to describe each record's before and after state
+        std::map<int, ServiceHistory> rows;
+        auto collect = [&](const std::vector<ServiceHistory>& list) {
+            for (const auto& h : list) {
+                if (touched.count(h.historyId)) rows[h.historyId] = h; // Last occurrence wins
+            }
+        };
+        if (!updateCachedTable<ServiceHistory>(HISTORY_FILE, collect, historyLogPath())) collect(loadHistory());
+        std::set<std::string> keys;
+        for (const auto& r : rows) keys.insert(partitionKeyFor(r.second.dateTime));
+        std::vector<std::string> accepted;
+        std::vector<ChangeEvent> changes;
+        std::vector<ServiceHistory> changed;
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (refused && records[i].compare(0, 2, "S|") == 0) {
+                // Checked against the row as it stands now, after any earlier change in this batch
+                size_t from = records[i].find('|', 2) + 1;
+                std::string status = records[i].substr(from, records[i].find('|', from) - from);
+                auto it = rows.find(ids[i]);
+                std::string& error = (*refused)[i];
+                if (it == rows.end()) error = "history not found";
+                else checkStatusChange(it->second.status, status, error);
+                if (!error.empty()) continue;
+            }
+            auto batch = enqueueHistoryLog(records[i]); // Queued under the mutex, so log order matches apply order
+            if (batches.empty() || batches.back() != batch) batches.push_back(batch);
+            accepted.push_back(records[i]);
+
+            std::vector<ServiceHistory> row;
+            auto it = rows.find(ids[i]);
+            if (it != rows.end()) row.push_back(it->second);
+            std::string before = row.empty() ? "" : formatHistoryLine(row[0]);
+            bool wasDone = !row.empty() && isDoneStatus(row[0].status);
+            bool wasCancelled = !row.empty() && row[0].status == "Cancelled";
+            if (!applyHistoryRecord(row, records[i]) || row.empty()) continue;
+            if (!wasDone && isDoneStatus(row[0].status)) {
+                consumeParts(row[0].historyId);
+                recordCompletedJob(row[0]);
+            }
+            if (!wasCancelled && row[0].status == "Cancelled") {
+                releaseParts(row[0].historyId);
+                cancelAppointment(row[0].historyId);
+            }
+            rows[row[0].historyId] = row[0];
+            keys.insert(partitionKeyFor(row[0].dateTime));
+            std::string after = formatHistoryLine(row[0]);
+            if (after == before) continue;
+            changes.push_back({0, "booking", before.empty() ? "insert" : "update", before, after});
+            changed.push_back(row[0]);
+        }
+        // Applied to the cached rows in place; copying the whole history here would serialise every booking
+        auto apply = [&](std::vector<ServiceHistory>& list) {
+            for (const auto& record : accepted) applyHistoryRecord(list, record);
+        };
+        if (!updateCachedTable<ServiceHistory>(HISTORY_FILE, apply, historyLogPath())) {
+            auto list = loadHistory(); // Already holds the queued records; applying them again is harmless
+            apply(list);
+            storeCachedTable(HISTORY_FILE, list, historyLogPath());
         }
-        ofs << '|' << h.dateTime << '|' << h.subtotal << '|' << h.discountId << '|' << h.discountPercent << '|' << h.total << '|' << h.status << '\n';
+        appendBranchHistory(changed);
+        if (!changes.empty()) changeSeq = publishChanges(std::move(changes));
+        deferHistoryPartitionRefresh(keys); // Rewritten by the next partition reader or checkpoint, not per booking
     }
+    bool ok = true;
+    for (const auto& batch : batches) ok = waitHistoryLogDurable(batch) && ok;
+    if (!ok) std::cout << "Failed to write the history log.\n";
+    if (ok && changeSeq > 0) flushChanges(changeSeq); // Only changes that are durable reach the feed
+    return ok;
 }
 
 /**
@@ -301,12 +611,74 @@ std::string currentDateTime() {
 /**
  * @brief Adds a new service history entry to the history file.
  * @param h The ServiceHistory object to add.
- * @note Loads the existing history, appends the new entry, and saves the updated list.
+ * @note Appends the entry to the history log (synced before returning) and refreshes its month's
+ *       partition; the history file itself is rewritten by the next checkpoint.
  */
 void addHistoryEntry(const ServiceHistory& h) {
-    auto list = loadHistory();
-    list.push_back(h);
-    saveHistory(list);
+    logHistoryChanges({historyInsertRecord(h)});
+}
+
+/**
+ * @brief Changes the status of a service history entry.
+ * @param historyId The history ID.
+ * @param status The new status.
+ * @return bool True if the entry exists in the hot history, the lifecycle allows the change and it was logged.
+ */
+bool setHistoryStatus(int historyId, const std::string& status) {
+    JobStage stage;
+    if (!parseJobStage(status, stage)) return false;
+    std::vector<std::string> refused;
+    bool ok = logHistoryChanges({historyStatusRecord(historyId, jobStageStatus(stage))}, &refused);
+    return ok && refused[0].empty();
+}
+
+/**
+ * @brief Validates and prices a new booking.
+ * @param customerId The customer ID.
+ * @param vehicleId The vehicle ID (must belong to the customer).
+ * @param serviceIds The chosen service IDs.
+ * @param discountId The discount ID, or 0 (or -1) for none.
+ * @param out Receives the priced entry.
+ * @param error Receives the reason if the booking is rejected.
+ * @return bool True if the booking is valid.
+ * @note Used by the kiosk and HTTP front ends; prices the same way as the interactive booking flow.
+ */
+bool prepareBooking(int customerId, int vehicleId, const std::vector<int>& serviceIds, int discountId,
+                    ServiceHistory& out, std::string& error) {
+    auto customers = loadCustomers();
+    Customer* customer = findCustomerById(customers, customerId);
+    if (!customer) { error = "customer not found"; return false; }
+    auto vehicles = loadVehicles();
+    bool owned = std::any_of(vehicles.begin(), vehicles.end(), [&](const Vehicle& v) {
+        return v.id == vehicleId && v.customerId == customerId;
+    });
+    if (!owned) { error = "vehicle not found or not owned by customer"; return false; }
+    if (serviceIds.empty()) { error = "no services selected"; return false; }
+
+    double subtotal = 0;
+    auto services = loadServices();
+    std::vector<ServiceItem> booked;
+    for (int id : serviceIds) {
+        auto it = std::find_if(services.begin(), services.end(), [id](const ServiceItem& s) { return s.id == id; });
+        if (it == services.end()) { error = "invalid service id " + std::to_string(id); return false; }
+        subtotal += it->price;
+        booked.push_back(*it);
+    }
+    std::vector<PartShortage> shortages;
+    if (!checkPartsAvailable(serviceIds, shortages)) { error = describeShortages(shortages); return false; }
+    double percent = 0;
+    if (discountId > 0) {
+        auto discounts = loadDiscounts();
+        auto it = std::find_if(discounts.begin(), discounts.end(), [discountId](const Discount& d) { return d.id == discountId; });
+        if (it == discounts.end()) { error = "invalid discount id"; return false; }
+        percent = it->percent;
+    } else {
+        discountId = -1;
+    }
+    out = {0, customerId, vehicleId, serviceIds, "", subtotal, discountId, percent,
+           subtotal - subtotal * (percent / 100.0), "Pending", customer->branchId,
+           computeBookingTaxes(booked, percent, loadTaxClasses())};
+    return true;
 }
 
 /**
@@ -383,19 +755,14 @@ void viewServiceHistory() {
 
 /**
  * @brief Marks a service history entry as completed by ID.
- * @note Prompts for a history ID, updates the status to "Completed" if found, and saves the updated list.
+ * @note Prompts for a history ID and logs the status change to "Completed" if found.
  */
 void markHistoryCompleted() {
-    auto list = loadHistory();
     std::cout << "Enter history ID to mark completed: ";
     int id; std::cin >> id; std::cin.ignore();
-    for (auto &h : list) {
-        if (h.historyId == id) {
-            h.status = "Completed";
-            saveHistory(list);
-            std::cout << "Marked completed.\n";
-            return;
-        }
+    if (setHistoryStatus(id, "Completed")) {
+        std::cout << "Marked completed.\n";
+        return;
     }
-    std::cout << "History entry not found.\n";
+    std::cout << "History entry not found or already closed.\n";
 }
\ No newline at end of file
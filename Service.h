@@ -12,6 +12,26 @@ struct ServiceItem {
     int id;             /**< Unique identifier for the service. */
     std::string name;   /**< Name of the service. */
     double price;       /**< Price of the service in rupees. */
+    int taxClass = 0;   /**< GST class of the service (see Tax.h); 0 for untaxed. */
+    int durationMinutes = 0; /**< Bay time the service takes; 0 for the default of one hour. */
+};
+
+/**
+ * @brief GST charged on the services of one tax class in a booking.
+ */
+struct TaxLine {
+    int taxClass;           /**< The tax class. */
+    int rateBasisPoints;    /**< GST rate when the booking was made, in hundredths of a percent (1800 = 18%). */
+    long long taxablePaise; /**< Value of the class's services after the booking's discount, in paise. */
+    long long taxPaise;     /**< GST on that value, in paise (CGST and SGST together). */
+};
+
+/**
+ * @brief When a booking reached one stage of its job lifecycle (see Lifecycle.h).
+ */
+struct StageTime {
+    int stage;              /**< The JobStage reached. */
+    long long offsetSeconds; /**< Seconds after the booking's dateTime. */
 };
 
 /**
@@ -27,9 +47,27 @@ struct ServiceHistory {
     int discountId;                /**< ID of the applied discount (-1 for none). */
     double discountPercent;        /**< Percentage of the applied discount. */
     double total;                  /**< Total cost after applying the discount. */
-    std::string status;           /**< Status of the service ("Pending" or "Completed"). */
+    std::string status;           /**< Job status ("Pending" while booked, then "CheckedIn" through "Delivered", or "Cancelled"). */
+    int branchId = 0;              /**< Service centre that took the booking (0 for the main workshop). */
+    std::vector<TaxLine> taxes{};  /**< GST per tax class, charged on top of total. */
+    std::vector<StageTime> stages{}; /**< When each stage after booking was reached, in order. */
 };
 
+/**
+ * @brief Parses one line of the service file.
+ * @param line The raw pipe-separated line.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseServiceLine(const std::string& line, ServiceItem& out);
+
+/**
+ * @brief Formats a service as its line in the service file.
+ * @param s The service.
+ * @return std::string The line (without the newline).
+ */
+std::string formatServiceLine(const ServiceItem& s);
+
 /**
  * @brief Loads all services from the services file.
  * @return std::vector<ServiceItem> A vector containing all valid service records.
@@ -85,6 +123,21 @@ void deleteService();
  */
 std::vector<ServiceHistory> loadHistory();
 
+/**
+ * @brief Parses one line of the history file into a ServiceHistory entry.
+ * @param ln The raw pipe-separated line.
+ * @param out Receives the parsed entry on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseHistoryLine(const std::string& ln, ServiceHistory& out);
+
+/**
+ * @brief Formats a service history entry as one pipe-separated line (without newline).
+ * @param h The ServiceHistory object to format.
+ * @return std::string The formatted line.
+ */
+std::string formatHistoryLine(const ServiceHistory& h);
+
 /**
  * @brief Saves a list of service history entries to the history file.
  * @param list A vector of ServiceHistory objects to save.
@@ -103,6 +156,36 @@ std::string currentDateTime();
  */
 void addHistoryEntry(const ServiceHistory& h);
 
+/**
+ * @brief Records a sequence of history log records (bookings and status changes) in one group commit.
+ * @param records Records built with historyInsertRecord() or historyStatusRecord(), in order.
+ * @param refused Optional; when given, each status change is checked against the lifecycle under the data lock
+ *                and a refused one is skipped, with its reason at the record's index (empty if applied).
+ * @return bool True once every applied record is durable.
+ */
+bool logHistoryChanges(const std::vector<std::string>& records, std::vector<std::string>* refused = nullptr);
+
+/**
+ * @brief Changes the status of a service history entry.
+ * @param historyId The history ID.
+ * @param status The new status.
+ * @return bool True if the entry was found, the lifecycle allows the change and it was recorded.
+ */
+bool setHistoryStatus(int historyId, const std::string& status);
+
+/**
+ * @brief Validates and prices a new booking.
+ * @param customerId The customer ID.
+ * @param vehicleId The vehicle ID (must belong to the customer).
+ * @param serviceIds The chosen service IDs.
+ * @param discountId The discount ID, or 0 (or -1) for none.
+ * @param out Receives the priced entry: ID 0, empty dateTime, status "Pending" and the GST of each tax class.
+ * @param error Receives the reason if the booking is rejected.
+ * @return bool True if the booking is valid.
+ */
+bool prepareBooking(int customerId, int vehicleId, const std::vector<int>& serviceIds, int discountId,
+                    ServiceHistory& out, std::string& error);
+
 /**
  * @brief Displays all service history entries in a formatted table.
  */
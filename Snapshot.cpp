@@ -0,0 +1,333 @@
+// Snapshot.cpp (implementation)
+#include "Snapshot.h"
+#include "ColumnCodec.h"
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+#include "Discount.h"
+#include "Tax.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef TEST_MODE
+const std::string SNAPSHOT_FILE = "tests/test_snapshot.img";
+#else
+const std::string SNAPSHOT_FILE = "snapshot.img";
+#endif
+
+/**
+ * @brief Magic bytes opening a snapshot image; the trailing digit is the format version.
+ * @note Version 2 added the log path and stamp to each table, version 3 the branch IDs, version 4 the tax
+ *       classes and tax lines, version 5 the service durations and version 6 the job stage times. Images of
+ *       other versions are ignored.
+ */
+const std::string SNAPSHOT_MAGIC = "CSS6";
+
+/**
+ * @brief Tags identifying each table inside a snapshot image.
+ */
+enum SnapshotTable : uint8_t { TABLE_CUSTOMERS = 1, TABLE_VEHICLES, TABLE_SERVICES, TABLE_DISCOUNTS, TABLE_HISTORY,
+                                    TABLE_TAX_CLASSES };
+
+static std::atomic<bool> cacheEnabled{false};
+
+template <typename T>
+TableCache<T>& tableCache() {
+    static TableCache<T> cache;
+    return cache;
+}
+
+template TableCache<Customer>& tableCache<Customer>();
+template TableCache<Vehicle>& tableCache<Vehicle>();
+template TableCache<ServiceItem>& tableCache<ServiceItem>();
+template TableCache<Discount>& tableCache<Discount>();
+template TableCache<ServiceHistory>& tableCache<ServiceHistory>();
+template TableCache<TaxClass>& tableCache<TaxClass>();
+
+/**
+ * @brief Drops every cached table, forcing the next loads to parse the text files.
+ */
+void clearStoreCache() {
+    invalidateCachedTable<Customer>();
+    invalidateCachedTable<Vehicle>();
+    invalidateCachedTable<ServiceItem>();
+    invalidateCachedTable<Discount>();
+    invalidateCachedTable<ServiceHistory>();
+    invalidateCachedTable<TaxClass>();
+}
+
+/**
+ * @brief Enables or disables serving loads from the in-memory table caches.
+ * @param enabled True to enable. Disabling also drops every cached table.
+ */
+void setStoreCacheEnabled(bool enabled) {
+    cacheEnabled = enabled;
+    if (!enabled) clearStoreCache();
+}
+
+/**
+ * @brief Reports whether loads may be served from the in-memory table caches.
+ * @return bool True if the caches are enabled.
+ */
+bool storeCacheEnabled() {
+    return cacheEnabled;
+}
+
+// 📌 Row Encoding
+
+static void putInt(std::string& out, long long v) {
+    appendVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); // Zigzag
+}
+
+static void putDouble(std::string& out, double v) {
+    char raw[sizeof(double)];
+    std::memcpy(raw, &v, sizeof(double));
+    out.append(raw, sizeof(double));
+}
+
+static void putString(std::string& out, const std::string& s) {
+    appendVarint(out, s.size());
+    out += s;
+}
+
+/**
+ * @brief Sequential reader over a snapshot image; any short read makes every later read fail.
+ */
+struct SnapshotReader {
+    const std::string& buf;
+    size_t pos;
+    bool ok;
+
+    bool getUnsigned(uint64_t& v) { return ok = ok && readVarint(buf, pos, v); }
+    bool getInt(long long& v) {
+        uint64_t u;
+        if (!getUnsigned(u)) return false;
+        v = static_cast<long long>((u >> 1) ^ (~(u & 1) + 1));
+        return true;
+    }
+    bool getInt(int& v) {
+        long long w;
+        if (!getInt(w)) return false;
+        v = static_cast<int>(w);
+        return true;
+    }
+    bool getDouble(double& v) {
+        if (!ok || buf.size() - pos < sizeof(double)) return ok = false;
+        std::memcpy(&v, buf.data() + pos, sizeof(double));
+        pos += sizeof(double);
+        return true;
+    }
+    bool getString(std::string& s) {
+        uint64_t n;
+        if (!getUnsigned(n) || buf.size() - pos < n) return ok = false;
+        s.assign(buf, pos, n);
+        pos += n;
+        return true;
+    }
+};
+
+static void putRow(std::string& out, const Customer& c) {
+    putInt(out, c.id); putString(out, c.name); putString(out, c.phone); putString(out, c.email);
+    putInt(out, c.branchId);
+}
+static bool getRow(SnapshotReader& r, Customer& c) {
+    return r.getInt(c.id) && r.getString(c.name) && r.getString(c.phone) && r.getString(c.email) &&
+           r.getInt(c.branchId);
+}
+
+static void putRow(std::string& out, const Vehicle& v) {
+    putInt(out, v.id); putInt(out, v.customerId);
+    putString(out, v.regNo); putString(out, v.model); putString(out, v.color); putInt(out, v.branchId);
+}
+static bool getRow(SnapshotReader& r, Vehicle& v) {
+    return r.getInt(v.id) && r.getInt(v.customerId) && r.getString(v.regNo) && r.getString(v.model) &&
+           r.getString(v.color) && r.getInt(v.branchId);
+}
+
+static void putRow(std::string& out, const ServiceItem& s) {
+    putInt(out, s.id); putString(out, s.name); putDouble(out, s.price); putInt(out, s.taxClass); putInt(out, s.durationMinutes);
+}
+static bool getRow(SnapshotReader& r, ServiceItem& s) {
+    return r.getInt(s.id) && r.getString(s.name) && r.getDouble(s.price) && r.getInt(s.taxClass) && r.getInt(s.durationMinutes);
+}
+
+static void putRow(std::string& out, const Discount& d) {
+    putInt(out, d.id); putString(out, d.name); putDouble(out, d.percent); putString(out, d.note);
+}
+static bool getRow(SnapshotReader& r, Discount& d) {
+    return r.getInt(d.id) && r.getString(d.name) && r.getDouble(d.percent) && r.getString(d.note);
+}
+
+static void putRow(std::string& out, const ServiceHistory& h) {
+    putInt(out, h.historyId); putInt(out, h.customerId); putInt(out, h.vehicleId);
+    appendVarint(out, h.serviceIds.size());
+    for (int id : h.serviceIds) putInt(out, id);
+    putString(out, h.dateTime); putDouble(out, h.subtotal); putInt(out, h.discountId);
+    putDouble(out, h.discountPercent); putDouble(out, h.total); putString(out, h.status);
+    putInt(out, h.branchId);
+    appendVarint(out, h.taxes.size());
+    for (const auto& t : h.taxes) {
+        putInt(out, t.taxClass); putInt(out, t.rateBasisPoints); putInt(out, t.taxablePaise); putInt(out, t.taxPaise);
+    }
+    appendVarint(out, h.stages.size());
+    for (const auto& t : h.stages) {
+        putInt(out, t.stage); putInt(out, t.offsetSeconds);
+    }
+}
+static bool getRow(SnapshotReader& r, ServiceHistory& h) {
+    uint64_t n;
+    if (!(r.getInt(h.historyId) && r.getInt(h.customerId) && r.getInt(h.vehicleId) && r.getUnsigned(n))) return false;
+    if (n > r.buf.size() - r.pos) return r.ok = false; // Each ID takes at least one byte
+    h.serviceIds.resize(n);
+    for (auto& id : h.serviceIds) if (!r.getInt(id)) return false;
+    if (!(r.getString(h.dateTime) && r.getDouble(h.subtotal) && r.getInt(h.discountId) &&
+          r.getDouble(h.discountPercent) && r.getDouble(h.total) && r.getString(h.status) && r.getInt(h.branchId) &&
+          r.getUnsigned(n))) return false;
+    if (n > r.buf.size() - r.pos) return r.ok = false;
+    h.taxes.resize(n);
+    for (auto& t : h.taxes) {
+        if (!(r.getInt(t.taxClass) && r.getInt(t.rateBasisPoints) && r.getInt(t.taxablePaise) && r.getInt(t.taxPaise))) return false;
+    }
+    if (!r.getUnsigned(n)) return false;
+    if (n > r.buf.size() - r.pos) return r.ok = false;
+    h.stages.resize(n);
+    for (auto& t : h.stages) {
+        if (!(r.getInt(t.stage) && r.getInt(t.offsetSeconds))) return false;
+    }
+    return true;
+}
+
+static void putRow(std::string& out, const TaxClass& t) {
+    putInt(out, t.id); putString(out, t.name); putInt(out, t.rateBasisPoints);
+}
+static bool getRow(SnapshotReader& r, TaxClass& t) {
+    return r.getInt(t.id) && r.getString(t.name) && r.getInt(t.rateBasisPoints);
+}
+
+// 📌 Image Read/Write
+
+static void putStamp(std::string& out, const FileStamp& s) {
+    appendVarint(out, s.exists ? 1 : 0);
+    appendVarint(out, s.size);
+    putInt(out, static_cast<long long>(s.modified.time_since_epoch().count()));
+}
+
+/**
+ * @brief Appends one cached table (tag, path, file stamp, log path, log stamp, rows) to an image.
+ * @return bool False if the table is not cached.
+ */
+template <typename T>
+static bool putTable(std::string& out, SnapshotTable tag) {
+    TableCache<T>& c = tableCache<T>();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (!c.valid || !c.stamp.exists) return false;
+    out += static_cast<char>(tag);
+    putString(out, c.path);
+    putStamp(out, c.stamp);
+    putString(out, c.logPath);
+    putStamp(out, c.logStamp);
+    appendVarint(out, c.rows.size());
+    for (const auto& row : c.rows) putRow(out, row);
+    return true;
+}
+
+static bool getStamp(SnapshotReader& r, FileStamp& s) {
+    uint64_t exists, size;
+    long long ticks;
+    if (!(r.getUnsigned(exists) && r.getUnsigned(size) && r.getInt(ticks))) return false;
+    s = {exists != 0, size, std::filesystem::file_time_type(std::filesystem::file_time_type::duration(ticks))};
+    return true;
+}
+
+/**
+ * @brief Reads one table body from an image and primes its cache if the data file is unchanged.
+ * @return int 1 if the cache was primed, 0 if the file changed since the image was written, -1 if the image is corrupt.
+ */
+template <typename T>
+static int getTable(SnapshotReader& r) {
+    std::string path, logPath;
+    FileStamp imaged, imagedLog;
+    uint64_t count;
+    if (!(r.getString(path) && getStamp(r, imaged) && r.getString(logPath) && getStamp(r, imagedLog) &&
+          r.getUnsigned(count))) return -1;
+    if (count > r.buf.size() - r.pos) return -1; // Each row takes at least one byte
+    std::vector<T> rows(count);
+    for (auto& row : rows) if (!getRow(r, row)) return -1;
+
+    FileStamp current = fileStamp(path);
+    FileStamp currentLog = logPath.empty() ? FileStamp{false, 0, {}} : fileStamp(logPath);
+    if (current != imaged || currentLog != imagedLog) return 0; // Stale: the loader will rebuild from text
+    TableCache<T>& c = tableCache<T>();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.valid = true;
+    c.path = path;
+    c.stamp = current;
+    c.logPath = logPath;
+    c.logStamp = currentLog;
+    c.rows = std::move(rows);
+    return 1;
+}
+
+/**
+ * @brief Writes a binary image of every cached table to the snapshot file.
+ * @return bool True if the image was written.
+ * @note Each table is loaded first (a cache hit when it is already current), so the image always matches
+ *       the text files. Has no effect while the caches are disabled.
+ */
+bool writeSnapshotImage() {
+    if (!storeCacheEnabled()) return false;
+    loadCustomers();
+    loadVehicles();
+    loadServices();
+    loadDiscounts();
+    loadHistory();
+    loadTaxClasses();
+
+    std::string out = SNAPSHOT_MAGIC;
+    putTable<Customer>(out, TABLE_CUSTOMERS);
+    putTable<Vehicle>(out, TABLE_VEHICLES);
+    putTable<ServiceItem>(out, TABLE_SERVICES);
+    putTable<Discount>(out, TABLE_DISCOUNTS);
+    putTable<ServiceHistory>(out, TABLE_HISTORY);
+    putTable<TaxClass>(out, TABLE_TAX_CLASSES);
+    return replaceFileAtomically(SNAPSHOT_FILE, out);
+}
+
+/**
+ * @brief Restores the table caches from the snapshot file.
+ * @return int The number of tables restored.
+ * @note The image is read in a single pass and decoded straight into the caches. A table whose data file
+ *       no longer matches the stamp recorded in the image is skipped, and a corrupt or foreign image is
+ *       ignored entirely; in both cases the loaders fall back to parsing the text files.
+ */
+int restoreSnapshotImage() {
+    if (!storeCacheEnabled()) return 0;
+    std::ifstream ifs(SNAPSHOT_FILE, std::ios::binary);
+    if (!ifs) return 0;
+    std::ostringstream raw;
+    raw << ifs.rdbuf();
+    std::string buf = raw.str();
+    if (buf.compare(0, SNAPSHOT_MAGIC.size(), SNAPSHOT_MAGIC) != 0) return 0;
+
+    SnapshotReader r{buf, SNAPSHOT_MAGIC.size(), true};
+    int restored = 0;
+    while (r.pos < buf.size()) {
+        int result = -1;
+        switch (static_cast<uint8_t>(buf[r.pos++])) {
+            case TABLE_CUSTOMERS: result = getTable<Customer>(r); break;
+            case TABLE_VEHICLES:  result = getTable<Vehicle>(r); break;
+            case TABLE_SERVICES:  result = getTable<ServiceItem>(r); break;
+            case TABLE_DISCOUNTS: result = getTable<Discount>(r); break;
+            case TABLE_HISTORY:   result = getTable<ServiceHistory>(r); break;
+            case TABLE_TAX_CLASSES: result = getTable<TaxClass>(r); break;
+        }
+        if (result < 0) {
+            clearStoreCache(); // Corrupt image: trust nothing it primed
+            return 0;
+        }
+        restored += result;
+    }
+    return restored;
+}
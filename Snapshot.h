@@ -0,0 +1,147 @@
+// Snapshot.h
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Storage.h"
+
+/**
+ * @brief In-memory copy of one data file's parsed rows, valid while the file's stamp is unchanged.
+ */
+template <typename T>
+struct TableCache {
+    std::mutex mutex;       /**< Guards the fields below. */
+    bool valid = false;     /**< Whether rows and stamp describe a loaded file. */
+    std::string path;       /**< The data file the rows were loaded from. */
+    FileStamp stamp{};      /**< The file's stamp when the rows were loaded or saved. */
+    std::string logPath;    /**< Log replayed on top of the file, or empty if the table has none. */
+    FileStamp logStamp{};   /**< The log's stamp when the rows were loaded or saved. */
+    std::vector<T> rows;    /**< The parsed rows, in loader order. */
+};
+
+/**
+ * @brief Returns the process-wide cache for one row type.
+ * @return TableCache<T>& The cache (instantiated for Customer, Vehicle, ServiceItem, Discount, ServiceHistory and TaxClass).
+ */
+template <typename T>
+TableCache<T>& tableCache();
+
+/**
+ * @brief Enables or disables serving loads from the in-memory table caches.
+ * @param enabled True to enable. Disabling also drops every cached table.
+ * @note Disabled by default so that tools and tests which edit the files directly always see fresh data.
+ */
+void setStoreCacheEnabled(bool enabled);
+
+/**
+ * @brief Reports whether loads may be served from the in-memory table caches.
+ * @return bool True if the caches are enabled.
+ */
+bool storeCacheEnabled();
+
+/**
+ * @brief Drops every cached table, forcing the next loads to parse the text files.
+ */
+void clearStoreCache();
+
+/**
+ * @brief Copies a table's cached rows if the cache is enabled and the file is unchanged.
+ * @param path The data file.
+ * @param out Receives the rows on a hit.
+ * @param logPath The log replayed on top of the data file, if any; it must be unchanged too.
+ * @return bool True on a cache hit.
+ */
+template <typename T>
+bool lookupCachedTable(const std::string& path, std::vector<T>& out, const std::string& logPath = "") {
+    if (!storeCacheEnabled()) return false;
+    TableCache<T>& c = tableCache<T>();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (!c.valid || c.path != path || c.stamp != fileStamp(path)) return false;
+    if (c.logPath != logPath || (!logPath.empty() && c.logStamp != fileStamp(logPath))) return false;
+    out = c.rows;
+    return true;
+}
+
+/**
+ * @brief Records a table's rows as the cached content of its data file.
+ * @param path The data file, just loaded or written.
+ * @param rows The rows the file now holds, in loader order.
+ * @param logPath The log replayed on top of the data file, if any.
+ */
+template <typename T>
+void storeCachedTable(const std::string& path, const std::vector<T>& rows, const std::string& logPath = "") {
+    if (!storeCacheEnabled()) return;
+    TableCache<T>& c = tableCache<T>();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.valid = true;
+    c.path = path;
+    c.stamp = fileStamp(path);
+    c.logPath = logPath;
+    c.logStamp = logPath.empty() ? FileStamp{false, 0, {}} : fileStamp(logPath);
+    c.rows = rows;
+}
+
+/**
+ * @brief Runs a function on a table's cached rows in place, without copying them out.
+ * @param path The data file.
+ * @param fn Called with the cached rows on a hit; it may read or update them.
+ * @param logPath The log replayed on top of the data file, if any.
+ * @return bool True on a cache hit, false if fn was not called.
+ * @note The log may only have grown since it was stamped: the callers hold the data file mutex, and every
+ *       record appended to the log was applied to the cache under that mutex before being queued, even if
+ *       the group commit leader has not re-stamped it yet. The log is re-stamped on a hit.
+ */
+template <typename T, typename Fn>
+bool updateCachedTable(const std::string& path, Fn fn, const std::string& logPath = "") {
+    if (!storeCacheEnabled()) return false;
+    TableCache<T>& c = tableCache<T>();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (!c.valid || c.path != path || c.stamp != fileStamp(path) || c.logPath != logPath) return false;
+    if (!logPath.empty()) {
+        FileStamp now = fileStamp(logPath);
+        if (c.logStamp.exists && (!now.exists || now.size < c.logStamp.size)) return false;
+        c.logStamp = now;
+    }
+    fn(c.rows);
+    return true;
+}
+
+/**
+ * @brief Re-stamps a cached table's log after records the cache already holds were appended to it.
+ */
+template <typename T>
+void refreshCachedLogStamp() {
+    TableCache<T>& c = tableCache<T>();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (c.valid && !c.logPath.empty()) c.logStamp = fileStamp(c.logPath);
+}
+
+/**
+ * @brief Drops one table's cached rows, forcing its next load to parse the text file.
+ */
+template <typename T>
+void invalidateCachedTable() {
+    TableCache<T>& c = tableCache<T>();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.valid = false;
+    c.rows.clear();
+    c.rows.shrink_to_fit();
+}
+
+/**
+ * @brief Writes a binary image of every cached table to the snapshot file.
+ * @return bool True if the image was written.
+ * @note Tables are loaded first, so the image always matches the current text files.
+ */
+bool writeSnapshotImage();
+
+/**
+ * @brief Restores the table caches from the snapshot file.
+ * @return int The number of tables restored; tables whose file changed since the image was written
+ *         are skipped and rebuilt from text on first use.
+ */
+int restoreSnapshotImage();
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,94 @@
+// Storage.cpp (implementation)
+#include "Storage.h"
+#include <cstdio>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Returns the current stamp of a file.
+ * @param path The file path.
+ * @return FileStamp The stamp; exists is false (and the other fields zero) if the file is missing.
+ */
+FileStamp fileStamp(const std::string& path) {
+    std::error_code ec;
+    FileStamp s{false, 0, fs::file_time_type()};
+    uintmax_t size = fs::file_size(path, ec);
+    if (ec) return s;
+    fs::file_time_type modified = fs::last_write_time(path, ec);
+    if (ec) return s;
+    return {true, size, modified};
+}
+
+/**
+ * @brief Mutex serializing rewrites of the text data files.
+ * @return std::recursive_mutex& The process-wide data file mutex.
+ */
+std::recursive_mutex& dataFileMutex() {
+    static std::recursive_mutex m;
+    return m;
+}
+
+/**
+ * @brief Atomically replaces a file with new content (write to a temporary file, then rename).
+ * @param path The file to replace.
+ * @param content The new content.
+ * @return bool True if the file was replaced; on failure the original file is left untouched.
+ */
+bool replaceFileAtomically(const std::string& path, const std::string& content) {
+    std::string tmp = path + ".tmp";
+    if (!writeFileDurably(tmp, content)) return false;
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes bytes to an open stream, then flushes the C library buffer and the OS cache.
+ * @param f The stream.
+ * @param data The bytes to write.
+ * @return bool True if every step succeeded.
+ */
+static bool writeAndSync(std::FILE* f, const std::string& data) {
+    if (std::fwrite(data.data(), 1, data.size(), f) != data.size()) return false;
+    if (std::fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+/**
+ * @brief Writes a file and flushes it to stable storage before returning.
+ * @param path The file to create or truncate.
+ * @param content The new content.
+ * @return bool True if the content was written and synced.
+ */
+bool writeFileDurably(const std::string& path, const std::string& content) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = writeAndSync(f, content);
+    return std::fclose(f) == 0 && ok;
+}
+
+/**
+ * @brief Appends to a file and flushes it to stable storage before returning.
+ * @param path The file to append to (created if missing).
+ * @param data The bytes to append.
+ * @return bool True if the bytes were written and synced.
+ */
+bool appendFileDurably(const std::string& path, const std::string& data) {
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    if (!f) return false;
+    bool ok = writeAndSync(f, data);
+    return std::fclose(f) == 0 && ok;
+}
@@ -0,0 +1,63 @@
+// Storage.h
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Size and modification time of a data file, used to detect changes between two points in time.
+ */
+struct FileStamp {
+    bool exists;                                 /**< Whether the file existed when stamped. */
+    uintmax_t size;                              /**< File size in bytes. */
+    std::filesystem::file_time_type modified;    /**< Last modification time. */
+
+    bool operator==(const FileStamp& o) const {
+        return exists == o.exists && size == o.size && modified == o.modified;
+    }
+    bool operator!=(const FileStamp& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Returns the current stamp of a file.
+ * @param path The file path.
+ * @return FileStamp The stamp; exists is false if the file is missing.
+ */
+FileStamp fileStamp(const std::string& path);
+
+/**
+ * @brief Mutex serializing rewrites of the text data files.
+ * @return std::recursive_mutex& The process-wide data file mutex.
+ * @note Held while a file is rewritten, replaced or appended to. The history loader also holds it so the base
+ *       file and its log are read as a consistent pair; it is recursive so writers can reload under it.
+ */
+std::recursive_mutex& dataFileMutex();
+
+/**
+ * @brief Atomically replaces a file with new content (write to a temporary file, then rename).
+ * @param path The file to replace.
+ * @param content The new content.
+ * @return bool True if the file was replaced.
+ */
+bool replaceFileAtomically(const std::string& path, const std::string& content);
+
+/**
+ * @brief Writes a file and flushes it to stable storage before returning.
+ * @param path The file to create or truncate.
+ * @param content The new content.
+ * @return bool True if the content was written and synced.
+ */
+bool writeFileDurably(const std::string& path, const std::string& content);
+
+/**
+ * @brief Appends to a file and flushes it to stable storage before returning.
+ * @param path The file to append to (created if missing).
+ * @param data The bytes to append.
+ * @return bool True if the bytes were written and synced.
+ */
+bool appendFileDurably(const std::string& path, const std::string& data);
+
+#endif // STORAGE_H
@@ -0,0 +1,282 @@
+// StorageWriter.cpp (implementation)
+#include "StorageWriter.h"
+#include "MutationQueue.h"
+#include "HistoryLog.h"
+#include "Inventory.h"
+#include "Calendar.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Most mutations the writer takes from the queue for one batch.
+ */
+const size_t WRITER_MAX_BATCH = 1024;
+
+static MpscQueue<Mutation> queue;
+static std::thread writer;
+static std::atomic<bool> accepting{false};
+static std::atomic<bool> stopping{false};
+static std::atomic<int> activeSubmits{0};
+
+// Parking for an idle writer; producers only touch the mutex when the writer is asleep
+static std::mutex wakeMutex;
+static std::condition_variable wake;
+static std::atomic<bool> writerIdle{false};
+
+// Counters (producers and the writer update them concurrently)
+static std::atomic<long long> submitted{0}, written{0}, failed{0}, batches{0}, fullRejects{0}, blockedMicros{0};
+static std::atomic<size_t> maxDepth{0};
+static std::array<std::atomic<long long>, LATENCY_BUCKETS> latency{};
+
+/**
+ * @brief Records one submit-to-durable latency in the histogram.
+ */
+static void recordLatency(std::chrono::steady_clock::duration d) {
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    size_t bucket = 0;
+    while (bucket + 1 < LATENCY_BUCKETS && us >= (1LL << bucket)) bucket++;
+    latency[bucket]++;
+}
+
+/**
+ * @brief Writes one batch: all customer additions and all vehicle additions with a single file rewrite each,
+ *        and all bookings and status changes with a single group commit of the history log.
+ * @param batch The mutations, in queue order.
+ * @note Each booking reserves its parts and books its appointment once it has an ID; a booking whose parts ran out
+ *       or whose slot was taken is reported as failed.
+ */
+static void writeMutationBatch(std::vector<Mutation>& batch) {
+    bool customersOk = true, vehiclesOk = true, historyOk = true;
+    bool anyCustomers = std::any_of(batch.begin(), batch.end(), [](const Mutation& m) { return m.type == MutationType::AddCustomer; });
+    if (anyCustomers) {
+        auto list = loadCustomers();
+        int next = nextCustomerId();
+        for (auto& m : batch) {
+            if (m.type != MutationType::AddCustomer) continue;
+            if (m.customer.id <= 0) m.customer.id = next;
+            next = std::max(next, m.customer.id + 1);
+            list.push_back(m.customer);
+        }
+        saveCustomers(list);
+    }
+
+    std::vector<bool> rejected(batch.size(), false);
+    bool anyVehicles = std::any_of(batch.begin(), batch.end(), [](const Mutation& m) { return m.type == MutationType::AddVehicle; });
+    if (anyVehicles) {
+        auto customers = loadCustomers(); // After this batch's customers, so a new owner can register a vehicle at once
+        auto list = loadVehicles();
+        int next = nextVehicleId();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            Mutation& m = batch[i];
+            if (m.type != MutationType::AddVehicle) continue;
+            Customer* owner = findCustomerById(customers, m.vehicle.customerId);
+            if (!owner) {
+                rejected[i] = true; // The owner was deleted since the request was checked
+                continue;
+            }
+            m.vehicle.branchId = owner->branchId; // Serviced where the owner is
+            if (m.vehicle.id <= 0) m.vehicle.id = next;
+            next = std::max(next, m.vehicle.id + 1);
+            list.push_back(m.vehicle);
+        }
+        saveVehicles(list);
+    }
+
+    std::vector<std::string> records;
+    std::vector<size_t> recordOf(batch.size(), SIZE_MAX);
+    std::vector<PartShortage> shortages;
+    Appointment appt;
+    std::string error;
+    int nextId = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Mutation& m = batch[i];
+        if (m.type == MutationType::AddBooking) {
+            if (m.booking.historyId <= 0) {
+                if (nextId == 0) nextId = nextHistoryId();
+                m.booking.historyId = nextId++;
+            }
+            if (m.booking.dateTime.empty()) m.booking.dateTime = currentDateTime();
+            if (!reserveParts(m.booking.historyId, m.booking.serviceIds, shortages)) {
+                rejected[i] = true; // Stock ran out since the booking was checked
+                continue;
+            }
+            if (!m.appointmentStart.empty() &&
+                !bookAppointment(m.booking.historyId, slotsForServices(m.booking.serviceIds), m.appointmentStart, appt, error)) {
+                releaseParts(m.booking.historyId);
+                rejected[i] = true; // Another booking took the slot
+                continue;
+            }
+            records.push_back(historyInsertRecord(m.booking));
+        } else if (m.type == MutationType::SetStatus) {
+            recordOf[i] = records.size();
+            records.push_back(historyStatusRecord(m.historyId, m.status));
+        }
+    }
+    std::vector<std::string> refused;
+    if (!records.empty()) historyOk = logHistoryChanges(records, &refused);
+    std::vector<std::string> reasons(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (recordOf[i] == SIZE_MAX || refused[recordOf[i]].empty()) continue;
+        reasons[i] = refused[recordOf[i]];
+        rejected[i] = true; // Another change moved the booking on since the status was checked
+    }
+    if (!historyOk) {
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (batch[i].type != MutationType::AddBooking || rejected[i]) continue;
+            releaseParts(batch[i].booking.historyId);
+            cancelAppointment(batch[i].booking.historyId);
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Mutation& m = batch[i];
+        bool ok = !rejected[i] && (m.type == MutationType::AddCustomer ? customersOk
+                                 : m.type == MutationType::AddVehicle ? vehiclesOk : historyOk);
+        (ok ? written : failed)++;
+        recordLatency(now - m.submitted);
+        int id = m.type == MutationType::AddCustomer ? m.customer.id
+               : m.type == MutationType::AddVehicle ? m.vehicle.id
+               : m.type == MutationType::AddBooking ? m.booking.historyId : m.historyId;
+        if (m.done) m.done(ok, id, reasons[i]);
+    }
+    batches++;
+}
+
+/**
+ * @brief Writer thread body: drains the queue in batches and parks briefly when it is empty.
+ */
+static void writerLoop() {
+    std::vector<Mutation> batch;
+    Mutation m;
+    for (;;) {
+        while (batch.size() < WRITER_MAX_BATCH && mpscTryPop(queue, m)) batch.push_back(std::move(m));
+        if (!batch.empty()) {
+            writeMutationBatch(batch);
+            batch.clear();
+            continue;
+        }
+        if (stopping && mpscSizeApprox(queue) == 0) return;
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        writerIdle = true;
+        wake.wait_for(lock, std::chrono::milliseconds(1), [] { return mpscSizeApprox(queue) > 0 || stopping; });
+        writerIdle = false;
+    }
+}
+
+/**
+ * @brief Starts the storage writer thread with a queue of the given capacity.
+ * @param capacity Minimum queue capacity (rounded up to a power of two).
+ * @return bool False if the writer is already running.
+ */
+bool startStorageWriter(size_t capacity) {
+    if (writer.joinable()) return false;
+    initMpscQueue(queue, capacity);
+    stopping = false;
+    accepting = true;
+    writer = std::thread(writerLoop);
+    return true;
+}
+
+/**
+ * @brief Stops accepting mutations, writes everything still queued and joins the writer thread.
+ */
+void stopStorageWriter() {
+    if (!writer.joinable()) return;
+    accepting = false;
+    while (activeSubmits > 0) std::this_thread::yield(); // Let submits already past the check finish pushing
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+/**
+ * @brief Hands a mutation to the storage writer without waiting for any file I/O.
+ * @param m The mutation.
+ * @param waitForRoom True to wait (yielding) while the queue is full; false to give up at once.
+ * @return bool True if the mutation was queued.
+ * @note A full queue is the backpressure signal: it is counted, and the time spent waiting for room is
+ *       added to the blocked total.
+ */
+bool submitMutation(Mutation m, bool waitForRoom) {
+    activeSubmits++;
+    if (!accepting) {
+        activeSubmits--;
+        return false;
+    }
+    m.submitted = std::chrono::steady_clock::now();
+    bool queued = mpscTryPush(queue, m);
+    if (!queued) {
+        fullRejects++;
+        if (waitForRoom) {
+            auto start = std::chrono::steady_clock::now();
+            while (!(queued = mpscTryPush(queue, m))) std::this_thread::yield();
+            blockedMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    activeSubmits--;
+    if (!queued) return false;
+
+    submitted++;
+    size_t depth = mpscSizeApprox(queue);
+    size_t seen = maxDepth.load();
+    while (depth > seen && !maxDepth.compare_exchange_weak(seen, depth)) {}
+    if (writerIdle) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wake.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Returns a copy of the storage writer's counters and histogram.
+ * @return StorageWriterStats The current statistics.
+ */
+StorageWriterStats storageWriterStats() {
+    StorageWriterStats s{submitted, written, failed, batches, fullRejects, blockedMicros, maxDepth,
+                         queue.slots ? queue.mask + 1 : 0, {}};
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) s.latency[i] = latency[i];
+    return s;
+}
+
+/**
+ * @brief Estimates a latency percentile from the histogram.
+ * @param s The statistics.
+ * @param p The percentile as a fraction (e.g. 0.99).
+ * @return long long Upper bound in microseconds of the bucket holding the percentile.
+ */
+long long latencyPercentileMicros(const StorageWriterStats& s, double p) {
+    long long total = 0;
+    for (long long c : s.latency) total += c;
+    if (total == 0) return 0;
+    long long rank = static_cast<long long>(p * total + 0.5), seen = 0;
+    if (rank < 1) rank = 1;
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += s.latency[i];
+        if (seen >= rank) return i == 0 ? 1 : (1LL << i);
+    }
+    return 1LL << (LATENCY_BUCKETS - 1);
+}
+
+/**
+ * @brief Prints the storage writer's counters, backpressure and latency percentiles.
+ * @param s The statistics.
+ */
+void printStorageWriterStats(const StorageWriterStats& s) {
+    std::cout << "--- Storage Writer ---\n"
+              << "Submitted: " << s.submitted << ", written: " << s.written << ", failed: " << s.failed
+              << ", batches: " << s.batches << "\n"
+              << "Queue: capacity " << s.capacity << ", max depth " << s.maxDepth << ", full " << s.fullRejects
+              << " time(s), producers blocked " << s.blockedMicros << " us\n"
+              << "Latency (us): p50 <= " << latencyPercentileMicros(s, 0.50) << ", p99 <= "
+              << latencyPercentileMicros(s, 0.99) << ", p999 <= " << latencyPercentileMicros(s, 0.999) << "\n";
+}
@@ -0,0 +1,101 @@
+// StorageWriter.h
+#ifndef STORAGE_WRITER_H
+#define STORAGE_WRITER_H
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <string>
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Service.h"
+
+/**
+ * @brief Kinds of change a request thread can hand to the storage writer.
+ */
+enum class MutationType {
+    AddCustomer,    /**< Append a customer record. */
+    AddVehicle,     /**< Append a vehicle record. */
+    AddBooking,     /**< Append a service history entry. */
+    SetStatus       /**< Change the status of a service history entry. */
+};
+
+/**
+ * @brief One change queued for the storage writer.
+ */
+struct Mutation {
+    MutationType type = MutationType::AddCustomer;      /**< What to do. */
+    Customer customer{0, "", "", ""};                   /**< AddCustomer: the record; an id of 0 is assigned by the writer. */
+    Vehicle vehicle{0, 0, "", "", ""};                  /**< AddVehicle: the record; an id of 0 is assigned by the writer,
+                                                             and the branch is taken from the owner. */
+    ServiceHistory booking{0, 0, 0, {}, "", 0, -1, 0, 0, "Pending"}; /**< AddBooking: the entry; id 0 and an empty dateTime are filled in by the writer. */
+    std::string appointmentStart;                       /**< AddBooking: requested start ("YYYY-MM-DD HH:MM"), or empty for a walk-in. */
+    int historyId = 0;                                  /**< SetStatus: the history ID. */
+    std::string status;                                 /**< SetStatus: the new status. */
+    std::chrono::steady_clock::time_point submitted;    /**< Set by submitMutation(); used for latency. */
+    std::function<void(bool, int, const std::string&)> done; /**< Optional; called on the writer thread with the outcome, the
+                                                             customer, vehicle or history ID and, for a refused status change,
+                                                             the reason, once durable (or failed). */
+};
+
+/**
+ * @brief Number of power-of-two buckets in the submit-to-durable latency histogram.
+ */
+const size_t LATENCY_BUCKETS = 32;
+
+/**
+ * @brief Counters and latency histogram of the storage writer.
+ */
+struct StorageWriterStats {
+    long long submitted;        /**< Mutations accepted into the queue. */
+    long long written;          /**< Mutations made durable. */
+    long long failed;           /**< Mutations whose write failed. */
+    long long batches;          /**< Batches written. */
+    long long fullRejects;      /**< Pushes that found the queue full (backpressure events). */
+    long long blockedMicros;    /**< Total time producers spent waiting for room. */
+    size_t maxDepth;            /**< Deepest the queue has been. */
+    size_t capacity;            /**< Queue capacity. */
+    std::array<long long, LATENCY_BUCKETS> latency; /**< Bucket 0: under 1 us; bucket i: under 2^i us. */
+};
+
+/**
+ * @brief Starts the storage writer thread with a queue of the given capacity.
+ * @param capacity Minimum queue capacity (rounded up to a power of two).
+ * @return bool False if the writer is already running.
+ */
+bool startStorageWriter(size_t capacity);
+
+/**
+ * @brief Stops accepting mutations, writes everything still queued and joins the writer thread.
+ */
+void stopStorageWriter();
+
+/**
+ * @brief Hands a mutation to the storage writer without waiting for any file I/O.
+ * @param m The mutation.
+ * @param waitForRoom True to wait (yielding) while the queue is full; false to give up at once.
+ * @return bool True if the mutation was queued; false if the writer is stopped or the queue was full.
+ */
+bool submitMutation(Mutation m, bool waitForRoom = true);
+
+/**
+ * @brief Returns a copy of the storage writer's counters and histogram.
+ * @return StorageWriterStats The current statistics.
+ */
+StorageWriterStats storageWriterStats();
+
+/**
+ * @brief Estimates a latency percentile from the histogram.
+ * @param s The statistics.
+ * @param p The percentile as a fraction (e.g. 0.99).
+ * @return long long Upper bound in microseconds of the bucket holding the percentile (0 if nothing was written).
+ */
+long long latencyPercentileMicros(const StorageWriterStats& s, double p);
+
+/**
+ * @brief Prints the storage writer's counters, backpressure and latency percentiles.
+ * @param s The statistics.
+ */
+void printStorageWriterStats(const StorageWriterStats& s);
+
+#endif // STORAGE_WRITER_H
@@ -0,0 +1,305 @@
+// Tax.cpp (implementation)
+#include "Tax.h"
+#include "Storage.h"
+#include "ChangeFeed.h"
+#include "Snapshot.h"
+#include "HistoryPartition.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#ifdef TEST_MODE
+const std::string TAX_CLASS_FILE = "tests/test_tax_classes.txt";
+#else
+const std::string TAX_CLASS_FILE = "tax_classes.txt";
+#endif
+
+/**
+ * @brief Parses one line of the tax class file.
+ * @param line The raw line in "id|name|rateBasisPoints" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseTaxClassLine(const std::string& line, TaxClass& out) {
+    if (line.empty()) return false;
+    std::istringstream ss(line);
+    std::string idStr, name, rateStr;
+    if (!std::getline(ss, idStr, '|')) return false;
+    try {
+        TaxClass t;
+        t.id = std::stoi(idStr);
+        std::getline(ss, name, '|');
+        std::getline(ss, rateStr, '|');
+        t.name = name;
+        t.rateBasisPoints = std::stoi(rateStr);
+        if (t.id <= 0 || t.rateBasisPoints < 0) return false;
+        out = t;
+        return true;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
+/**
+ * @brief Formats a tax class as its line in the tax class file.
+ * @param t The tax class.
+ * @return std::string The line (without the newline), as parseTaxClassLine() reads it.
+ */
+std::string formatTaxClassLine(const TaxClass& t) {
+    std::ostringstream line;
+    line << t.id << '|' << t.name << '|' << t.rateBasisPoints;
+    return line.str();
+}
+
+/**
+ * @brief Loads all tax classes from the tax class file.
+ * @return std::vector<TaxClass> The tax classes.
+ * @note Skips empty or malformed lines in the file.
+ */
+std::vector<TaxClass> loadTaxClasses() {
+    std::vector<TaxClass> list;
+    if (lookupCachedTable(TAX_CLASS_FILE, list)) return list;
+    std::ifstream ifs(TAX_CLASS_FILE);
+    std::string line;
+    TaxClass item;
+    while (std::getline(ifs, line)) {
+        if (parseTaxClassLine(line, item)) list.push_back(item); // Skip empty or malformed
+    }
+    storeCachedTable(TAX_CLASS_FILE, list);
+    return list;
+}
+
+/**
+ * @brief Saves the tax classes, keeping the first occurrence of each ID.
+ * @param list The tax classes.
+ * @note Publishes the inserted, updated and deleted classes to the change feed.
+ */
+void saveTaxClasses(const std::vector<TaxClass>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::vector<TaxClass> before = loadTaxClasses();
+    std::map<int, TaxClass> unique;
+    for (const auto& t : list) unique.emplace(t.id, t);
+    std::vector<TaxClass> written;
+    {
+        std::ofstream ofs(TAX_CLASS_FILE, std::ios::trunc);
+        for (const auto& p : unique) {
+            std::string line = formatTaxClassLine(p.second);
+            ofs << line << '\n';
+            TaxClass row;
+            if (parseTaxClassLine(line, row)) written.push_back(row); // Cache exactly what the loader reads back
+        }
+    }
+    storeCachedTable(TAX_CLASS_FILE, written);
+    std::vector<ChangeEvent> changes;
+    diffTableChanges("tax_class", before, written, [](const TaxClass& r) { return r.id; }, formatTaxClassLine, changes);
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
+}
+
+/**
+ * @brief Ensures the default tax classes (services 18%, parts 28%) exist.
+ */
+void ensureDefaultTaxClasses() {
+    auto list = loadTaxClasses();
+    if (!list.empty()) return;
+    list.push_back({TAX_CLASS_SERVICES, "Services", 1800});
+    list.push_back({TAX_CLASS_PARTS, "Parts", 2800});
+    list.push_back({3, "Reduced", 500});
+    saveTaxClasses(list);
+}
+
+// ---- Computation ----
+
+/**
+ * @brief Converts rupees to paise, rounding to the nearest paisa.
+ * @param rupees The amount in rupees.
+ * @return long long The amount in paise.
+ */
+long long toPaise(double rupees) {
+    return std::llround(rupees * 100.0);
+}
+
+/**
+ * @brief Divides a non-negative amount by 10000, rounding half up.
+ */
+static long long divRound10000(long long v) {
+    return (v + 5000) / 10000;
+}
+
+/**
+ * @brief Computes the GST of a booking, one line per tax class in order of first appearance.
+ * @param items The booked services.
+ * @param discountPercent The booking's discount, applied to each class's value before tax.
+ * @param classes The tax classes.
+ * @return std::vector<TaxLine> The tax lines; services that are untaxed or of an unknown class get none.
+ */
+std::vector<TaxLine> computeBookingTaxes(const std::vector<ServiceItem>& items, double discountPercent,
+                                         const std::vector<TaxClass>& classes) {
+    std::vector<TaxLine> lines;
+    for (const auto& s : items) {
+        if (s.taxClass == 0) continue;
+        auto cls = std::find_if(classes.begin(), classes.end(), [&](const TaxClass& c) { return c.id == s.taxClass; });
+        if (cls == classes.end()) continue;
+        auto line = std::find_if(lines.begin(), lines.end(), [&](const TaxLine& t) { return t.taxClass == s.taxClass; });
+        if (line == lines.end()) {
+            lines.push_back({s.taxClass, cls->rateBasisPoints, 0, 0});
+            line = lines.end() - 1;
+        }
+        line->taxablePaise += toPaise(s.price); // Gross value for now
+    }
+    long long discountBasisPoints = std::clamp<long long>(std::llround(discountPercent * 100.0), 0, 10000);
+    for (auto& t : lines) {
+        t.taxablePaise -= divRound10000(t.taxablePaise * discountBasisPoints);
+        t.taxPaise = divRound10000(t.taxablePaise * t.rateBasisPoints);
+    }
+    return lines;
+}
+
+/**
+ * @brief Splits the GST of a line into its central and state halves.
+ * @param t The tax line.
+ * @param cgst Receives the central half, in paise.
+ * @param sgst Receives the state half (the odd paisa goes here), in paise.
+ */
+void splitGst(const TaxLine& t, long long& cgst, long long& sgst) {
+    cgst = t.taxPaise / 2;
+    sgst = t.taxPaise - cgst;
+}
+
+/**
+ * @brief Returns the GST of a booking.
+ * @param h The booking.
+ * @return long long The total tax, in paise.
+ */
+long long bookingTaxPaise(const ServiceHistory& h) {
+    long long sum = 0;
+    for (const auto& t : h.taxes) sum += t.taxPaise;
+    return sum;
+}
+
+/**
+ * @brief Formats a rate in basis points as a percentage, e.g. "18%" or "2.5%".
+ * @param basisPoints The rate.
+ * @return std::string The percentage.
+ */
+std::string formatRate(int basisPoints) {
+    std::string s = std::to_string(basisPoints / 100);
+    int frac = basisPoints % 100;
+    if (frac != 0) {
+        s += '.';
+        s += static_cast<char>('0' + frac / 10);
+        if (frac % 10) s += static_cast<char>('0' + frac % 10);
+    }
+    return s + '%';
+}
+
+// ---- Reports ----
+
+/**
+ * @brief Aggregates the GST of a set of bookings by tax class and rate.
+ * @param rows The bookings.
+ * @return std::vector<TaxReportRow> One row per class and rate, ordered by class then rate.
+ */
+std::vector<TaxReportRow> buildTaxReport(const std::vector<ServiceHistory>& rows) {
+    // Gather the tax lines into flat columns, tagging each with its group
+    std::vector<uint32_t> group;
+    std::vector<long long> taxable, tax;
+    std::vector<std::pair<int, int>> keys; // (class, rate) of each group
+    std::map<std::pair<int, int>, uint32_t> groupOf;
+    for (const auto& h : rows) {
+        for (const auto& t : h.taxes) {
+            auto it = groupOf.emplace(std::make_pair(t.taxClass, t.rateBasisPoints), static_cast<uint32_t>(keys.size())).first;
+            if (it->second == keys.size()) keys.push_back(it->first);
+            group.push_back(it->second);
+            taxable.push_back(t.taxablePaise);
+            tax.push_back(t.taxPaise);
+        }
+    }
+
+    // One pass over the columns; a booking has at most one line per class, so each line is one booking
+    std::vector<TaxReportRow> report(keys.size());
+    for (size_t g = 0; g < keys.size(); ++g) report[g] = {keys[g].first, keys[g].second, 0, 0, 0, 0};
+    for (size_t i = 0; i < group.size(); ++i) {
+        TaxReportRow& r = report[group[i]];
+        long long cgst = tax[i] / 2;
+        ++r.bookings;
+        r.taxablePaise += taxable[i];
+        r.cgstPaise += cgst;
+        r.sgstPaise += tax[i] - cgst;
+    }
+    std::sort(report.begin(), report.end(), [](const TaxReportRow& a, const TaxReportRow& b) {
+        return a.taxClass != b.taxClass ? a.taxClass < b.taxClass : a.rateBasisPoints < b.rateBasisPoints;
+    });
+    return report;
+}
+
+/**
+ * @brief Aggregates the GST of the bookings in a date range, hot and archived.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<TaxReportRow> One row per class and rate.
+ */
+std::vector<TaxReportRow> taxReportBetween(const std::string& from, const std::string& to) {
+    return buildTaxReport(loadHistoryBetween(from, to));
+}
+
+/**
+ * @brief Formats paise as rupees with two decimals.
+ */
+static std::string formatPaise(long long paise) {
+    std::ostringstream s;
+    s << (paise < 0 ? "-" : "") << std::llabs(paise) / 100 << '.' << std::setw(2) << std::setfill('0') << std::llabs(paise) % 100;
+    return s.str();
+}
+
+/**
+ * @brief Interactively prints the GST report for a date range.
+ */
+void viewTaxReport() {
+    std::string from, to;
+    std::cout << "Enter start date (YYYY-MM-DD): "; std::getline(std::cin, from);
+    std::cout << "Enter end date (YYYY-MM-DD): "; std::getline(std::cin, to);
+    auto report = taxReportBetween(from, to);
+    std::cout << "--- GST Report " << from << " to " << to << " ---\n";
+    if (report.empty()) {
+        std::cout << "No taxed bookings in that range.\n";
+        return;
+    }
+    std::map<int, std::string> names;
+    for (const auto& c : loadTaxClasses()) names[c.id] = c.name;
+    std::cout << std::left << std::setw(14) << "Class" << std::setw(8) << "Rate" << std::setw(10) << "Bookings"
+              << std::right << std::setw(16) << "Taxable" << std::setw(14) << "CGST" << std::setw(14) << "SGST" << "\n";
+    std::cout << std::string(76, '-') << "\n";
+    long long taxable = 0, cgst = 0, sgst = 0;
+    for (const auto& r : report) {
+        auto n = names.find(r.taxClass);
+        std::string name = n == names.end() ? "#" + std::to_string(r.taxClass) : n->second;
+        std::cout << std::left << std::setw(14) << name << std::setw(8) << formatRate(r.rateBasisPoints)
+                  << std::setw(10) << r.bookings << std::right << std::setw(16) << formatPaise(r.taxablePaise)
+                  << std::setw(14) << formatPaise(r.cgstPaise) << std::setw(14) << formatPaise(r.sgstPaise) << "\n";
+        taxable += r.taxablePaise;
+        cgst += r.cgstPaise;
+        sgst += r.sgstPaise;
+    }
+    std::cout << std::string(76, '-') << "\n";
+    std::cout << std::left << std::setw(32) << "Total" << std::right << std::setw(16) << formatPaise(taxable)
+              << std::setw(14) << formatPaise(cgst) << std::setw(14) << formatPaise(sgst) << "\n";
+    std::cout << "Total GST: Rs." << formatPaise(cgst + sgst) << "\n";
+}
+
+/**
+ * @brief Displays the tax classes.
+ */
+void viewTaxClasses() {
+    ensureDefaultTaxClasses();
+    auto list = loadTaxClasses();
+    std::cout << std::left << std::setw(6) << "ID" << std::setw(16) << "Name" << "Rate\n";
+    std::cout << std::string(30, '-') << "\n";
+    for (const auto& t : list) {
+        std::cout << std::left << std::setw(6) << t.id << std::setw(16) << t.name << formatRate(t.rateBasisPoints) << "\n";
+    }
+}
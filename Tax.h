@@ -0,0 +1,139 @@
+// Tax.h
+#ifndef TAX_H
+#define TAX_H
+
+#include <string>
+#include <vector>
+#include "Service.h"
+
+/**
+ * @brief Tax class of labour and servicing (GST 18%), the default for services.
+ */
+const int TAX_CLASS_SERVICES = 1;
+
+/**
+ * @brief Tax class of spare parts (GST 28%).
+ */
+const int TAX_CLASS_PARTS = 2;
+
+/**
+ * @brief A GST rate that services are assigned to.
+ */
+struct TaxClass {
+    int id;                 /**< Unique identifier; services refer to it. */
+    std::string name;       /**< Name shown in reports, e.g. "Services". */
+    int rateBasisPoints;    /**< GST rate in hundredths of a percent (1800 = 18%), split equally into CGST and SGST. */
+};
+
+/**
+ * @brief GST collected for one tax class and rate over a set of bookings.
+ */
+struct TaxReportRow {
+    int taxClass;           /**< The tax class. */
+    int rateBasisPoints;    /**< The rate charged. */
+    long long bookings;     /**< Bookings with services of this class at this rate. */
+    long long taxablePaise; /**< Taxable value, in paise. */
+    long long cgstPaise;    /**< Central GST, in paise. */
+    long long sgstPaise;    /**< State GST, in paise. */
+};
+
+/**
+ * @brief Parses one line of the tax class file.
+ * @param line The raw line in "id|name|rateBasisPoints" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseTaxClassLine(const std::string& line, TaxClass& out);
+
+/**
+ * @brief Formats a tax class as its line in the tax class file.
+ * @param t The tax class.
+ * @return std::string The line (without the newline).
+ */
+std::string formatTaxClassLine(const TaxClass& t);
+
+/**
+ * @brief Loads all tax classes from the tax class file.
+ * @return std::vector<TaxClass> The tax classes.
+ */
+std::vector<TaxClass> loadTaxClasses();
+
+/**
+ * @brief Saves the tax classes, keeping the first occurrence of each ID.
+ * @param list The tax classes.
+ * @note Changing a rate only affects later bookings; each booking stores the rate it was charged.
+ */
+void saveTaxClasses(const std::vector<TaxClass>& list);
+
+/**
+ * @brief Ensures the default tax classes (services 18%, parts 28%) exist.
+ */
+void ensureDefaultTaxClasses();
+
+/**
+ * @brief Converts rupees to paise, rounding to the nearest paisa.
+ * @param rupees The amount in rupees.
+ * @return long long The amount in paise.
+ */
+long long toPaise(double rupees);
+
+/**
+ * @brief Computes the GST of a booking, one line per tax class in order of first appearance.
+ * @param items The booked services.
+ * @param discountPercent The booking's discount, applied to each class's value before tax.
+ * @param classes The tax classes.
+ * @return std::vector<TaxLine> The tax lines; services that are untaxed or of an unknown class get none.
+ * @note Integer arithmetic in paise: the discount and the tax are each rounded half up once per class.
+ */
+std::vector<TaxLine> computeBookingTaxes(const std::vector<ServiceItem>& items, double discountPercent,
+                                         const std::vector<TaxClass>& classes);
+
+/**
+ * @brief Splits the GST of a line into its central and state halves.
+ * @param t The tax line.
+ * @param cgst Receives the central half, in paise.
+ * @param sgst Receives the state half (the odd paisa goes here), in paise.
+ */
+void splitGst(const TaxLine& t, long long& cgst, long long& sgst);
+
+/**
+ * @brief Returns the GST of a booking.
+ * @param h The booking.
+ * @return long long The total tax, in paise.
+ */
+long long bookingTaxPaise(const ServiceHistory& h);
+
+/**
+ * @brief Formats a rate in basis points as a percentage, e.g. "18%" or "2.5%".
+ * @param basisPoints The rate.
+ * @return std::string The percentage.
+ */
+std::string formatRate(int basisPoints);
+
+/**
+ * @brief Aggregates the GST of a set of bookings by tax class and rate.
+ * @param rows The bookings.
+ * @return std::vector<TaxReportRow> One row per class and rate, ordered by class then rate.
+ * @note The tax lines are first gathered into flat columns, then summed in a single pass over them.
+ */
+std::vector<TaxReportRow> buildTaxReport(const std::vector<ServiceHistory>& rows);
+
+/**
+ * @brief Aggregates the GST of the bookings in a date range, hot and archived.
+ * @param from Start date in "YYYY-MM-DD" format.
+ * @param to End date in "YYYY-MM-DD" format.
+ * @return std::vector<TaxReportRow> One row per class and rate.
+ */
+std::vector<TaxReportRow> taxReportBetween(const std::string& from, const std::string& to);
+
+/**
+ * @brief Interactively prints the GST report for a date range.
+ */
+void viewTaxReport();
+
+/**
+ * @brief Displays the tax classes.
+ */
+void viewTaxClasses();
+
+#endif // TAX_H
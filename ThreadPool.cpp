@@ -0,0 +1,270 @@
+// ThreadPool.cpp (implementation)
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Shared state of one submitted task.
+ */
+struct PoolTask {
+    TaskFunction fn;                    /**< The task body. */
+    std::atomic<bool> cancelled{false}; /**< Set by cancelTask(). */
+    std::mutex mutex;                   /**< Guards the fields below. */
+    std::condition_variable finishedCv; /**< Signalled when the task finishes. */
+    bool finished = false;              /**< True once run or skipped. */
+    bool completed = false;             /**< True if it ran to the end without being cancelled. */
+    std::exception_ptr error;           /**< Exception thrown by the body, if any. */
+};
+
+/**
+ * @brief One worker's task deque: the owner works at the back, thieves take from the front.
+ */
+struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<TaskHandle> tasks;
+};
+
+static std::mutex lifecycleMutex;                    // Serialises start and stop
+static std::atomic<bool> running{false};
+static std::vector<std::unique_ptr<WorkerQueue>> queues;
+static std::vector<std::thread> workers;
+static std::atomic<size_t> nextQueue{0};
+static std::atomic<long long> queued{0};
+static std::mutex sleepMutex;
+static std::condition_variable sleepCv;
+static bool shuttingDown = false;                   // Guarded by sleepMutex
+static thread_local int workerIndex = -1;           // Index of the worker running on this thread, or -1
+
+static std::atomic<long long> executed{0}, stolen{0}, skipped{0};
+
+/**
+ * @brief Runs a task (or skips it if cancelled) and wakes its waiters.
+ */
+static void runTask(const TaskHandle& task) {
+    bool completed = false;
+    std::exception_ptr error;
+    if (task->cancelled) {
+        skipped++;
+    } else {
+        try {
+            task->fn(task->cancelled);
+            completed = !task->cancelled;
+        } catch (...) {
+            error = std::current_exception();
+        }
+        executed++;
+    }
+    task->fn = nullptr; // Release captures now rather than when the last handle goes
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->finished = true;
+        task->completed = completed;
+        task->error = error;
+    }
+    task->finishedCv.notify_all();
+}
+
+/**
+ * @brief Takes one queued task: from the back of the own queue first, otherwise from the front of another.
+ * @param self The calling worker's index, or -1 for a thread outside the pool.
+ * @param out Receives the task.
+ * @return bool False if every queue was empty.
+ */
+static bool takeTask(int self, TaskHandle& out) {
+    if (self >= 0) {
+        WorkerQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            out = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    size_t n = queues.size();
+    size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t victim = (start + i) % n;
+        if (static_cast<int>(victim) == self) continue;
+        WorkerQueue& q = *queues[victim];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        out = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        queued--;
+        if (self >= 0) stolen++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Worker thread body: runs tasks until the pool stops and nothing is left.
+ */
+static void workerLoop(int index) {
+    workerIndex = index;
+    TaskHandle task;
+    for (;;) {
+        if (takeTask(index, task)) {
+            runTask(task);
+            task.reset();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCv.wait(lock, [] { return queued > 0 || shuttingDown; });
+        if (shuttingDown && queued <= 0) return;
+    }
+}
+
+/**
+ * @brief Starts the shared thread pool.
+ * @param count Number of worker threads; 0 uses one per hardware thread.
+ */
+void startThreadPool(size_t count) {
+    static bool exitHookRegistered = false;
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (running) return;
+    if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+    {
+        std::lock_guard<std::mutex> sleepLock(sleepMutex);
+        shuttingDown = false;
+    }
+    queues.clear();
+    for (size_t i = 0; i < count; ++i) queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue));
+    for (size_t i = 0; i < count; ++i) workers.emplace_back(workerLoop, static_cast<int>(i));
+    running = true;
+    if (!exitHookRegistered) {
+        std::atexit(stopThreadPool); // Workers must be joined before the globals above are destroyed
+        exitHookRegistered = true;
+    }
+}
+
+/**
+ * @brief Runs every queued task and joins the workers.
+ */
+void stopThreadPool() {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> sleepLock(sleepMutex);
+        shuttingDown = true;
+    }
+    sleepCv.notify_all();
+    for (auto& w : workers) w.join();
+    workers.clear();
+    running = false;
+}
+
+/**
+ * @brief Returns the number of worker threads, starting the pool if needed.
+ * @return size_t The worker count.
+ */
+size_t threadPoolSize() {
+    if (!running) startThreadPool();
+    return queues.size();
+}
+
+/**
+ * @brief Queues a task on the shared pool.
+ * @param fn The task body.
+ * @return TaskHandle Handle to wait for or cancel the task.
+ */
+TaskHandle submitTask(TaskFunction fn) {
+    if (!running) startThreadPool();
+    TaskHandle task = std::make_shared<PoolTask>();
+    task->fn = std::move(fn);
+    size_t target = workerIndex >= 0 ? static_cast<size_t>(workerIndex) : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(task);
+    }
+    queued++;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex); // Pairs with the predicate check so the wake is not lost
+    }
+    sleepCv.notify_one();
+    return task;
+}
+
+/**
+ * @brief Cancels a task: a queued task is skipped, a running task sees its cancelled flag set.
+ * @param task The task.
+ */
+void cancelTask(const TaskHandle& task) {
+    if (task) task->cancelled = true;
+}
+
+/**
+ * @brief Waits for a task to finish (or be skipped).
+ * @param task The task.
+ * @return bool True if the task ran to the end without being cancelled.
+ */
+bool waitTask(const TaskHandle& task) {
+    std::unique_lock<std::mutex> lock(task->mutex);
+    while (!task->finished) {
+        if (workerIndex >= 0) {
+            // A worker must keep working while it waits, or nested tasks could starve the pool
+            lock.unlock();
+            TaskHandle other;
+            bool ran = takeTask(workerIndex, other);
+            if (ran) runTask(other);
+            lock.lock();
+            if (ran) continue;
+            task->finishedCv.wait_for(lock, std::chrono::microseconds(200));
+        } else {
+            task->finishedCv.wait(lock);
+        }
+    }
+    if (task->error) std::rethrow_exception(task->error);
+    return task->completed;
+}
+
+/**
+ * @brief Runs body(i) for every i in [0, count) on the shared pool and waits for all of them.
+ * @param count Number of iterations.
+ * @param body The loop body.
+ */
+void parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) return;
+    size_t chunks = std::min(count, threadPoolSize() * 4);
+    if (chunks <= 1 || threadPoolSize() == 1) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+    std::vector<TaskHandle> tasks;
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t begin = count * c / chunks, end = count * (c + 1) / chunks;
+        tasks.push_back(submitTask([&body, begin, end](const std::atomic<bool>&) {
+            for (size_t i = begin; i < end; ++i) body(i);
+        }));
+    }
+    std::exception_ptr error;
+    try {
+        for (size_t i = 0; i < count / chunks; ++i) body(i); // The caller takes the first chunk
+    } catch (...) {
+        error = std::current_exception(); // Still wait: the other chunks refer to body
+    }
+    for (auto& t : tasks) {
+        try {
+            waitTask(t);
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief Returns the pool counters.
+ * @return ThreadPoolStats Tasks executed, stolen and cancelled.
+ */
+ThreadPoolStats threadPoolStats() {
+    return {executed, stolen, skipped};
+}
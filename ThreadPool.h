@@ -0,0 +1,91 @@
+// ThreadPool.h
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief A task submitted to the shared thread pool (opaque).
+ */
+struct PoolTask;
+
+/**
+ * @brief Handle used to wait for or cancel a submitted task.
+ */
+using TaskHandle = std::shared_ptr<PoolTask>;
+
+/**
+ * @brief Body of a pool task; long-running bodies should return early once the flag is set.
+ */
+using TaskFunction = std::function<void(const std::atomic<bool>& cancelled)>;
+
+/**
+ * @brief Counters of the shared thread pool since the process started.
+ */
+struct ThreadPoolStats {
+    long long executed;     /**< Tasks run to the end. */
+    long long stolen;       /**< Tasks taken from another worker's queue. */
+    long long cancelled;    /**< Tasks cancelled before they started. */
+};
+
+/**
+ * @brief Starts the shared thread pool.
+ * @param workers Number of worker threads; 0 uses one per hardware thread.
+ * @note The pool starts by itself with the default size on first use. Starting a running pool does nothing.
+ */
+void startThreadPool(size_t workers = 0);
+
+/**
+ * @brief Runs every queued task and joins the workers.
+ * @note Must not be called while other threads are still submitting. Registered with atexit on first start.
+ */
+void stopThreadPool();
+
+/**
+ * @brief Returns the number of worker threads, starting the pool if needed.
+ * @return size_t The worker count.
+ */
+size_t threadPoolSize();
+
+/**
+ * @brief Queues a task on the shared pool.
+ * @param fn The task body.
+ * @return TaskHandle Handle to wait for or cancel the task.
+ * @note A task submitted from a worker goes to that worker's own queue; idle workers steal from the others.
+ */
+TaskHandle submitTask(TaskFunction fn);
+
+/**
+ * @brief Cancels a task: a queued task is skipped, a running task sees its cancelled flag set.
+ * @param task The task.
+ */
+void cancelTask(const TaskHandle& task);
+
+/**
+ * @brief Waits for a task to finish (or be skipped).
+ * @param task The task.
+ * @return bool True if the task ran to the end without being cancelled.
+ * @note A worker that waits runs other queued tasks meanwhile, so tasks may wait on tasks they submit.
+ *       An exception thrown by the task is rethrown here.
+ */
+bool waitTask(const TaskHandle& task);
+
+/**
+ * @brief Runs body(i) for every i in [0, count) on the shared pool and waits for all of them.
+ * @param count Number of iterations.
+ * @param body The loop body; iterations may run in any order and concurrently.
+ * @note Iterations are grouped into a few tasks per worker. With one worker or one iteration the loop
+ *       runs on the calling thread.
+ */
+void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+/**
+ * @brief Returns the pool counters.
+ * @return ThreadPoolStats Tasks executed, stolen and cancelled.
+ */
+ThreadPoolStats threadPoolStats();
+
+#endif // THREAD_POOL_H
@@ -1,5 +1,10 @@
 // Vehicle.cpp (implementation)
 #include "Vehicle.h"
+#include "Customer.h"
+#include "Storage.h"
+#include "ChangeFeed.h"
+#include "Snapshot.h"
+#include "BranchStore.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -36,6 +41,35 @@ int nextVehicleId() {
     return maxId + 1;
 }
 
+/**
+ * @brief Parses one line of the vehicle file.
+ * @param line The raw line in "id|customerId|regNo|model|color" format.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseVehicleLine(const std::string& line, Vehicle& out) {
+    if (line.empty()) return false;
+    std::istringstream ss(line);
+    std::string idStr, cid, regNo, model, color, branch;
+    if (!std::getline(ss, idStr, '|')) return false;
+    try {
+        Vehicle v;
+        v.id = std::stoi(idStr);
+        std::getline(ss, cid, '|'); v.customerId = std::stoi(cid);
+        std::getline(ss, regNo, '|');
+        std::getline(ss, model, '|');
+        std::getline(ss, color, '|');
+        if (std::getline(ss, branch, '|')) v.branchId = std::stoi(branch);
+        v.regNo = regNo;
+        v.model = model;
+        v.color = color;
+        out = v;
+        return true;
+    } catch (...) {
+        return false; // Malformed
+    }
+}
+
 /**
  * @brief Loads all vehicles from the vehicle file into a vector.
  * @return std::vector<Vehicle> A vector containing all valid vehicle records.
@@ -43,48 +77,61 @@ int nextVehicleId() {
  */
 std::vector<Vehicle> loadVehicles() {
     std::vector<Vehicle> list;
+    if (lookupCachedTable(VEHICLE_FILE, list)) return list;
     std::ifstream ifs(VEHICLE_FILE);
     std::string line;
+    Vehicle item;
     while (std::getline(ifs, line)) {
-        if (line.empty()) continue;
-        std::istringstream ss(line);
-        std::string idStr, cid, regNo, model, color;
-        if (!std::getline(ss, idStr, '|')) continue;
-        try {
-            Vehicle v;
-            v.id = std::stoi(idStr);
-            std::getline(ss, cid, '|'); v.customerId = std::stoi(cid);
-            std::getline(ss, regNo, '|');
-            std::getline(ss, model, '|');
-            std::getline(ss, color, '|');
-            v.regNo = regNo;
-            v.model = model;
-            v.color = color;
-            list.push_back(v);
-        } catch (...) {
-            continue; // Skip malformed
-        }
+        if (parseVehicleLine(line, item)) list.push_back(item); // Skip empty or malformed
     }
+    storeCachedTable(VEHICLE_FILE, list);
     return list;
 }
 
+/**
+ * @brief Formats a vehicle as its line in the vehicle file.
+ * @param v The vehicle.
+ * @return std::string The line (without the newline), as parseVehicleLine() reads it; the branch ID is
+ *         appended only when it is not 0.
+ */
+std::string formatVehicleLine(const Vehicle& v) {
+    std::ostringstream line;
+    line << v.id << '|' << v.customerId << '|' << v.regNo << '|' << v.model << '|' << v.color;
+    if (v.branchId != 0) line << '|' << v.branchId;
+    return line.str();
+}
+
 /**
  * @brief Saves a list of vehicles to the vehicle file, ensuring unique IDs.
  * @param list A vector of Vehicle objects to save.
- * @note Overwrites the existing file and keeps only the first occurrence of each vehicle ID.
+ * @note Overwrites the existing file and keeps only the first occurrence of each vehicle ID, then publishes the
+ *       inserted, updated and deleted vehicles to the change feed.
  */
 void saveVehicles(const std::vector<Vehicle>& list) {
+    std::lock_guard<std::recursive_mutex> lock(dataFileMutex());
+    std::vector<Vehicle> before = loadVehicles();
     std::map<int, Vehicle> unique;
     for (const auto& v : list) {
         if (unique.count(v.id) == 0) {
             unique[v.id] = v;
         }
     }
-    std::ofstream ofs(VEHICLE_FILE, std::ios::trunc);
-    for (const auto& p : unique) {
-        const auto& v = p.second;
-        ofs << v.id << '|' << v.customerId << '|' << v.regNo << '|' << v.model << '|' << v.color << '\n';
+    std::vector<Vehicle> written;
+    {
+        std::ofstream ofs(VEHICLE_FILE, std::ios::trunc);
+        for (const auto& p : unique) {
+            const auto& v = p.second;
+            std::string line = formatVehicleLine(v);
+            ofs << line << '\n';
+            Vehicle row;
+            if (parseVehicleLine(line, row)) written.push_back(row); // Cache exactly what the loader reads back
+        }
     }
+    storeCachedTable(VEHICLE_FILE, written);
+    writeBranchVehicles(written);
+    std::vector<ChangeEvent> changes;
+    diffTableChanges("vehicle", before, written, [](const Vehicle& r) { return r.id; }, formatVehicleLine, changes);
+    if (!changes.empty()) flushChanges(publishChanges(std::move(changes)));
 }
 
 /**
@@ -99,6 +146,8 @@ void registerVehicleInteractive() {
     std::cout << "Enter registration number: "; std::getline(std::cin, v.regNo);
     std::cout << "Enter model: "; std::getline(std::cin, v.model);
     std::cout << "Enter color: "; std::getline(std::cin, v.color);
+    auto customers = loadCustomers();
+    if (Customer* owner = findCustomerById(customers, v.customerId)) v.branchId = owner->branchId; // Serviced where the owner is
     list.push_back(v);
     saveVehicles(list);
     std::cout << "Vehicle registered with ID: " << v.id << "\n";
@@ -14,8 +14,24 @@ struct Vehicle {
     std::string regNo;      /**< Registration number of the vehicle. */
     std::string model;      /**< Model of the vehicle. */
     std::string color;      /**< Color of the vehicle. */
+    int branchId = 0;       /**< Service centre of the owner (0 for the main workshop). */
 };
 
+/**
+ * @brief Parses one line of the vehicle file.
+ * @param line The raw pipe-separated line.
+ * @param out Receives the parsed record on success.
+ * @return bool True if the line was parsed, false if it is empty or malformed.
+ */
+bool parseVehicleLine(const std::string& line, Vehicle& out);
+
+/**
+ * @brief Formats a vehicle as its line in the vehicle file.
+ * @param v The vehicle.
+ * @return std::string The line (without the newline).
+ */
+std::string formatVehicleLine(const Vehicle& v);
+
 /**
  * @brief Loads all vehicles from the vehicle file.
  * @return std::vector<Vehicle> A vector containing all valid vehicle records.
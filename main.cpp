@@ -6,10 +6,29 @@
 #include <iomanip>
 #include <fstream>
 #include <ctime>
+#include <cstdlib>
 #include "Customer.h"
 #include "Service.h"
 #include "Vehicle.h"
 #include "Discount.h"
+#include "HistoryPartition.h"
+#include "HistoryArchive.h"
+#include "Compaction.h"
+#include "Snapshot.h"
+#include "HistoryLog.h"
+#include "StorageWriter.h"
+#include "Server.h"
+#include "Replication.h"
+#include "ChangeFeed.h"
+#include "BranchStore.h"
+#include "Invoice.h"
+#include "Tax.h"
+#include "Inventory.h"
+#include "Calendar.h"
+#include "Lifecycle.h"
+#include "Cohort.h"
+#include <future>
+#include <chrono>
 #include <algorithm>
 
 /**
@@ -54,7 +73,7 @@ Discount* findDiscountById(std::vector<Discount>& list, int id) {
 
 /**
  * @brief Displays the main menu and captures user input.
- * @return int The selected menu option (0 to 14).
+ * @return int The selected menu option (0 to 27).
  * @note Prompts the user to choose an action for the car service management system.
  */
 int mainMenu() {
@@ -73,6 +92,19 @@ int mainMenu() {
     std::cout << "12. Update Vehicle\n";
     std::cout << "13. Delete Vehicle\n";
     std::cout << "14. Services (manage)\n";
+    std::cout << "15. Revenue Report (date range)\n";
+    std::cout << "16. Archive Completed History\n";
+    std::cout << "17. Customer Statement\n";
+    std::cout << "18. Vehicle Service History\n";
+    std::cout << "19. Compact Data Files (background)\n";
+    std::cout << "20. Branch Report (date range)\n";
+    std::cout << "21. Batch Invoices (text/HTML)\n";
+    std::cout << "22. GST Report (date range)\n";
+    std::cout << "23. Parts & Inventory (manage)\n";
+    std::cout << "24. Appointments (calendar)\n";
+    std::cout << "25. Job Status (update / turnaround)\n";
+    std::cout << "26. Unique Customers & Vehicles (months)\n";
+    std::cout << "27. Customer Retention (cohorts)\n";
     std::cout << "0. Exit (mark customer service completed)\n";
     std::cout << "Enter option: ";
     int opt; std::cin >> opt; std::cin.ignore();
@@ -82,18 +114,21 @@ int mainMenu() {
 /**
  * @brief Manages the service booking process interactively.
  * @note Prompts for customer and vehicle IDs, allows selection of services and an optional discount,
- *       calculates the total cost, and saves the service history entry with a "Pending" status.
+ *       checks and reserves the parts they use, optionally books a start time on the calendar, calculates the total
+ *       cost and GST, and saves the service history entry with a "Pending" status.
  */
 void bookServiceFlow() {
     ensureDefaultServices();
     ensureDefaultDiscounts();
+    ensureDefaultTaxClasses();
     auto services = loadServicesLocal();
     auto discounts = loadDiscountsLocal();
     auto customers = loadCustomers();
     auto vehicles = loadVehicles();
 
     std::cout << "Enter Customer ID: "; int custId; std::cin >> custId; std::cin.ignore();
-    if (findCustomerById(customers, custId) == nullptr) {
+    Customer* customer = findCustomerById(customers, custId);
+    if (customer == nullptr) {
         std::cout << "Customer not found.\n"; return;
     }
     std::cout << "Enter Vehicle ID: "; int vehId; std::cin >> vehId; std::cin.ignore();
@@ -125,6 +160,22 @@ void bookServiceFlow() {
         std::cout << "No services selected. Aborting.\n";
         return;
     }
+    std::vector<PartShortage> shortages;
+    if (!checkPartsAvailable(chosen, shortages)) {
+        std::cout << "Cannot book: " << describeShortages(shortages) << ".\n";
+        return;
+    }
+
+    int slots = slotsForServices(chosen);
+    std::cout << "Next free start times (" << slots * SLOT_MINUTES << " minutes):\n";
+    for (const auto& o : nextFreeSlots(slots, currentDateTime(), 5)) std::cout << "  " << o.start << "\n";
+    std::string start, error;
+    while (true) {
+        std::cout << "Requested start (YYYY-MM-DD HH:MM, blank for walk-in): ";
+        std::getline(std::cin, start);
+        if (start.empty() || validAppointmentStart(start, slots, error)) break;
+        std::cout << "Invalid start: " << error << ".\n";
+    }
 
     double subtotal = 0;
     for (int id : chosen) {
@@ -151,10 +202,24 @@ void bookServiceFlow() {
 
     double discountAmount = subtotal * (discPct / 100.0);
     double total = subtotal - discountAmount;
+    std::vector<ServiceItem> booked;
+    for (int id : chosen) booked.push_back(*findServiceById(services, id));
+    std::vector<TaxLine> taxes = computeBookingTaxes(booked, discPct, loadTaxClasses());
 
     std::cout << std::fixed << std::setprecision(2);
     std::cout << "Discount: " << discPct << "% -> -Rs." << discountAmount << "\n";
     std::cout << "Total: Rs." << total << "\n";
+    if (!taxes.empty()) {
+        long long taxPaise = 0;
+        for (const auto& t : taxes) {
+            long long cgst, sgst;
+            splitGst(t, cgst, sgst);
+            taxPaise += t.taxPaise;
+            std::cout << "CGST " << formatRate(t.rateBasisPoints / 2) << ": Rs." << cgst / 100.0 << "\n";
+            std::cout << "SGST " << formatRate(t.rateBasisPoints - t.rateBasisPoints / 2) << ": Rs." << sgst / 100.0 << "\n";
+        }
+        std::cout << "Amount due: Rs." << (toPaise(total) + taxPaise) / 100.0 << "\n";
+    }
 
     // Create history entry
     ServiceHistory h;
@@ -166,45 +231,86 @@ void bookServiceFlow() {
     h.discountPercent = discPct;
     h.total = total;
     h.status = "Pending";
+    h.branchId = customer->branchId;
+    h.taxes = taxes;
+    if (!reserveParts(h.historyId, chosen, shortages)) {
+        std::cout << "Cannot book: " << describeShortages(shortages) << ".\n";
+        return;
+    }
+    Appointment appt;
+    if (!start.empty() && !bookAppointment(h.historyId, slots, start, appt, error)) {
+        releaseParts(h.historyId);
+        std::cout << "Cannot book: " << error << ".\n";
+        return;
+    }
     addHistoryEntry(h);
 
     std::cout << "Booking saved with History ID: " << h.historyId << "\n";
+    if (!start.empty()) std::cout << "Appointment: " << appt.start << " in bay " << appt.bay << "\n";
+    for (const auto& r : lowStockFor(chosen)) {
+        std::cout << "Low stock: " << r.name << " (" << r.available << " available, reorder " << r.orderQuantity << ")\n";
+    }
 }
 
 /**
  * @brief Generates and displays a bill for a specified service history entry.
- * @note Prompts for a history ID and prints details including customer ID, vehicle ID, services, costs, and status.
+ * @note Prompts for a history ID and prints the bill with the text invoice template (customer, vehicle, services,
+ *       costs and status). The entry is located through the per-segment Bloom filters, so only segments that may hold it are read.
  */
 void generateBillForHistory() {
-    auto histories = loadHistory();
-
-    if (histories.empty()) {
+    if (loadPartitionSummaries().empty() && loadArchiveIndex().empty()) {
         std::cout << "No history entries.\n"; return;
     }
     std::cout << "Enter History ID to generate bill: ";
     int hid; std::cin >> hid; std::cin.ignore();
-    for (auto &h : histories) {
-        if (h.historyId == hid) {
-            // print bill
-            std::cout << "\n--- BILL ---\n";
-            std::cout << "History ID: " << h.historyId << "\n";
-            std::cout << "Customer ID: " << h.customerId << "\n";
-            std::cout << "Vehicle ID: " << h.vehicleId << "\n";
-            std::cout << "Date: " << h.dateTime << "\n";
-            auto services = loadServicesLocal();
-            std::cout << "Services:\n";
-            for (int sid : h.serviceIds) {
-                ServiceItem* s = findServiceById(services, sid);
-                if (s) std::cout << " - " << s->name << " : Rs." << s->price << "\n";
-            }
-            std::cout << "Subtotal: Rs." << h.subtotal << "\n";
-            std::cout << "Discount: " << h.discountPercent << "%\n";
-            std::cout << "Total: Rs." << h.total << "\n";
-            std::cout << "Status: " << h.status << "\n";
-            return;
-        }
+    ServiceHistory h;
+    if (!findHistoryById(hid, h)) {
+        std::cout << "History ID not found.\n";
+        return;
+    }
+    std::string bill = "\n";
+    renderInvoice(h, loadInvoiceContextFor(h), InvoiceFormat::Text, bill);
+    std::cout << bill;
+}
+
+/**
+ * @brief Prints a list of history entries with a running total.
+ * @param title The heading to print.
+ * @param rows The history entries to print.
+ */
+void printHistoryStatement(const std::string& title, const std::vector<ServiceHistory>& rows) {
+    std::cout << "\n--- " << title << " ---\n";
+    if (rows.empty()) {
+        std::cout << "No service history found.\n";
+        return;
+    }
+    double total = 0;
+    for (const auto& h : rows) {
+        std::cout << "#" << h.historyId << "  " << h.dateTime << "  Vehicle " << h.vehicleId
+                  << "  Rs." << h.total << "  " << h.status << "\n";
+        total += h.total;
     }
-    std::cout << "History ID not found.\n";
+    std::cout << "Entries: " << rows.size() << ", Total billed: Rs." << total << "\n";
+}
+
+/**
+ * @brief Displays the statement (all bookings and amount billed) for a customer.
+ * @note Prompts for a customer ID; segments whose customer filter rules the ID out are skipped.
+ */
+void viewCustomerStatement() {
+    std::cout << "Enter customer ID: ";
+    int cid; std::cin >> cid; std::cin.ignore();
+    printHistoryStatement("Statement for customer " + std::to_string(cid), findHistoryRows(HistoryKey::CustomerId, cid));
+}
+
+/**
+ * @brief Displays the service history of a vehicle.
+ * @note Prompts for a vehicle ID; segments whose vehicle filter rules the ID out are skipped.
+ */
+void viewVehicleHistory() {
+    std::cout << "Enter vehicle ID: ";
+    int vid; std::cin >> vid; std::cin.ignore();
+    printHistoryStatement("Service history for vehicle " + std::to_string(vid), findHistoryRows(HistoryKey::VehicleId, vid));
 }
 
 /**
@@ -224,17 +330,103 @@ void deleteVehiclesForCustomer(int customerId) {
     }
 }
 
+/**
+ * @brief Folds the history log into the history file and writes a fresh snapshot image before exit.
+ */
+void closeStores() {
+    stopHistoryCheckpointer();
+    checkpointHistory();
+    writeSnapshotImage();
+}
+
+/**
+ * @brief Serves kiosk clients on the Unix socket and the HTTP API on localhost until "quit" or end of input.
+ * @param httpPort The HTTP API port.
+ * @return int Exit code (1 if the server could not start).
+ */
+int runServerMode(int httpPort) {
+    if (!startServer(serverSocketPath(), httpPort)) {
+        std::cout << "Could not start the server on " << serverSocketPath() << " and port " << httpPort << ".\n";
+        return 1;
+    }
+    bool replicating = startReplicationSource(replicationSocketPath());
+    std::cout << "Serving kiosks on " << serverSocketPath() << " and HTTP on 127.0.0.1:" << serverHttpPort()
+              << (replicating ? ", standbys on " + replicationSocketPath() : std::string()) << ". Type \"stats\" or \"quit\".\n";
+    std::string cmd;
+    while (std::getline(std::cin, cmd) && cmd != "quit") {
+        if (cmd == "stats") {
+            printServerStats(serverStats());
+            printStorageWriterStats(storageWriterStats());
+            std::cout << "Standbys connected: " << replicationStandbyCount() << ", change feed at " << lastChangeSeq() << "\n";
+        }
+    }
+    stopReplicationSource();
+    stopServer();
+    stopStorageWriter(); // Writes every booking still queued
+    printServerStats(serverStats());
+    closeStores();
+    return 0;
+}
+
+/**
+ * @brief Follows a primary as a hot standby until "promote" (take over and serve) or "quit".
+ * @param primarySocket The primary's replication socket.
+ * @param httpPort The HTTP API port to serve on after promotion.
+ * @return int Exit code.
+ */
+int runStandbyMode(const std::string& primarySocket, int httpPort) {
+    if (!startStandby(primarySocket)) return 1;
+    std::cout << "Following the primary on " << primarySocket << ". Type \"stats\", \"promote\" or \"quit\".\n";
+    std::string cmd;
+    while (std::getline(std::cin, cmd) && cmd != "quit") {
+        if (cmd == "stats") printReplicationStats(replicationStats());
+        if (cmd == "promote") {
+            std::cout << "Promoted at change " << promoteStandby() << ".\n";
+            return runServerMode(httpPort);
+        }
+    }
+    promoteStandby();
+    closeStores();
+    return 0;
+}
+
 /**
  * @brief Main entry point for the car service management application.
+ * @param argc Argument count.
+ * @param argv Arguments; "--serve [httpPort]" runs the kiosk server and HTTP API instead of the menu, and
+ *             "--standby <primarySocket> [httpPort]" follows a primary until promoted.
  * @return int Exit code (0 for successful termination).
- * @note Initializes default services and discounts, then runs the main menu loop to handle user interactions.
+ * @note Restores the snapshot image (if still current), initializes default services and discounts, builds missing
+ *       history partitions and recovers the history log, then runs the main menu loop to handle user interactions.
+ *       History changes are logged and folded into the history file by a background checkpointer.
+ *       A background compaction started from the menu is reported when it finishes. On exit the log is
+ *       checkpointed and a fresh image is written.
  */
-int main() {
+int main(int argc, char* argv[]) {
+    // Serve loads from memory; tables unchanged since the last run come straight from the image
+    setStoreCacheEnabled(true);
+    restoreSnapshotImage();
+
     // Ensure default data
     ensureDefaultServices();
     ensureDefaultDiscounts();
+    ensureDefaultTaxClasses();
+    ensureHistoryPartitions();
+    if (int replayed = recoverHistoryLog()) std::cout << "Recovered " << replayed << " logged history change(s).\n";
+    reconcilePartReservations();
+    refreshPartUsage(currentDateTime());
+    reconcileAppointments(currentDateTime());
+    ensureBranchStores();
+    startHistoryCheckpointer(HISTORY_LOG_CHECKPOINT_BYTES, HISTORY_LOG_CHECKPOINT_SECONDS);
+    if (argc > 1 && std::string(argv[1]) == "--serve") return runServerMode(argc > 2 ? std::atoi(argv[2]) : DEFAULT_HTTP_PORT);
+    if (argc > 2 && std::string(argv[1]) == "--standby") return runStandbyMode(argv[2], argc > 3 ? std::atoi(argv[3]) : DEFAULT_HTTP_PORT);
+    std::future<std::vector<CompactionReport>> compaction;
 
     while (true) {
+        // Report a finished background compaction before showing the menu again
+        if (compaction.valid() && compaction.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            printCompactionReports(compaction.get());
+        }
         int opt = mainMenu();
         switch (opt) {
             case 1: addCustomerInteractive(); break;
@@ -269,21 +461,67 @@ int main() {
                 else if (sopt==4) deleteService();
                 break;
             }
+            case 15: viewRevenueReport(); break;
+            case 16: archiveHistoryInteractive(); break;
+            case 17: viewCustomerStatement(); break;
+            case 18: viewVehicleHistory(); break;
+            case 19:
+                if (compaction.valid()) {
+                    std::cout << "Compaction is already running.\n";
+                } else {
+                    compaction = startBackgroundCompaction();
+                    std::cout << "Compaction started in the background.\n";
+                }
+                break;
+            case 20: viewBranchReport(); break;
+            case 21: generateInvoicesInteractive(); break;
+            case 22: viewTaxReport(); break;
+            case 23: {
+                std::cout << "\n--- Inventory Menu ---\n";
+                std::cout << "1. View Parts\n2. Add Part\n3. Receive Stock\n4. View Service Parts\n5. Set Service Part\n"
+                             "6. Reorder List\n7. Set Reorder Policy\n0. Back\nEnter: ";
+                int iopt; std::cin >> iopt; std::cin.ignore();
+                if (iopt==1) viewParts();
+                else if (iopt==2) addPartInteractive();
+                else if (iopt==3) receiveStockInteractive();
+                else if (iopt==4) viewServiceParts();
+                else if (iopt==5) setServicePartInteractive();
+                else if (iopt==6) viewReorderList();
+                else if (iopt==7) setReorderPolicyInteractive();
+                break;
+            }
+            case 24: {
+                std::cout << "\n--- Appointments Menu ---\n";
+                std::cout << "1. View Day Schedule\n2. Find Free Slots\n0. Back\nEnter: ";
+                int aopt; std::cin >> aopt; std::cin.ignore();
+                if (aopt==1) viewDayScheduleInteractive();
+                else if (aopt==2) findFreeSlotsInteractive();
+                break;
+            }
+            case 25: {
+                std::cout << "\n--- Job Status Menu ---\n";
+                std::cout << "1. Update Job Status\n2. Turnaround Report\n3. Job Time Percentiles\n0. Back\nEnter: ";
+                int jopt; std::cin >> jopt; std::cin.ignore();
+                if (jopt==1) updateJobStatusInteractive();
+                else if (jopt==2) viewTurnaroundReport();
+                else if (jopt==3) viewJobTimeReport();
+                break;
+            }
+            case 26: viewDistinctReport(); break;
+            case 27: viewRetentionReport(); break;
             case 0: {
                 std::cout << "Before exit, enter customer ID to mark their service(s) as completed (or 0 to skip): ";
                 int cid; std::cin >> cid; std::cin.ignore();
                 if (cid > 0) {
-                    auto list = loadHistory();
                     bool found = false;
-                    for (auto &h: list) {
-                        if (h.customerId == cid && h.status == "Pending") {
-                            h.status = "Completed";
+                    for (const auto &h: loadHistory()) {
+                        if (h.customerId == cid && isOpenStatus(h.status)) {
+                            setHistoryStatus(h.historyId, "Completed");
                             found = true;
                         }
                     }
                     if (found) {
-                        saveHistory(list);
-                        std::cout << "Marked all pending services for customer " << cid << " as Completed.\n";
+                        std::cout << "Marked all open services for customer " << cid << " as Completed.\n";
                         // Delete all vehicles for this customer
                         deleteVehiclesForCustomer(cid);
                         // Delete the customer
@@ -297,9 +535,11 @@ int main() {
                             std::cout << "Customer " << cid << " not found.\n";
                         }
                     } else {
-                        std::cout << "No pending services found for customer " << cid << ".\n";
+                        std::cout << "No open services found for customer " << cid << ".\n";
                     }
                 }
+                if (compaction.valid()) compaction.wait(); // Let the compactor finish before imaging the files
+                closeStores();
                 std::cout << "Exiting...\n";
                 return 0;
             }
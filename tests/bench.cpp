@@ -0,0 +1,608 @@
+// bench.cpp - Micro-benchmarks for storage and reporting kernels
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ColumnCodec.h"
+#include "Service.h"
+#include "Snapshot.h"
+#include "HistoryLog.h"
+#include "MutationQueue.h"
+#include "StorageWriter.h"
+#include "ThreadPool.h"
+#include "HistoryPartition.h"
+#include "Server.h"
+#include "Customer.h"
+#include "Vehicle.h"
+#include "Invoice.h"
+#include "Inventory.h"
+#include "Calendar.h"
+#include "QuantileSketch.h"
+#include "HyperLogLog.h"
+#include "Cohort.h"
+#include "HistoryArchive.h"
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+#include <thread>
+#include <unordered_set>
+#include <fstream>
+#include <filesystem>
+
+/**
+ * @brief Runs a function repeatedly and returns the best wall-clock time of one run in seconds.
+ * @param runs The number of runs.
+ * @param fn The function to time.
+ * @return double The fastest run in seconds.
+ */
+template <typename Fn>
+double bestOf(int runs, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        if (d.count() < best) best = d.count();
+    }
+    return best;
+}
+
+// =============================
+// 📌 Column Codec Benchmarks
+// =============================
+
+/**
+ * @brief Measures delta column decode throughput on history-like ID and timestamp columns.
+ * @note Throughput is reported as decoded bytes (8 per value) per second, next to the encoded size per value.
+ */
+void bench_deltaColumnDecode() {
+    const size_t n = 10000000;
+    std::vector<int64_t> ids(n), stamps(n);
+    uint64_t rng = 88172645463325252ULL;
+    int64_t ts = 1600000000;
+    for (size_t i = 0; i < n; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        ids[i] = static_cast<int64_t>(i + 1);
+        ts += static_cast<int64_t>(rng % 900); // Bookings a few minutes apart
+        stamps[i] = ts;
+    }
+    for (const auto* column : {&ids, &stamps}) {
+        std::string buf;
+        encodeDeltaColumn(*column, buf);
+        std::vector<int64_t> out;
+        double secs = bestOf(5, [&] {
+            size_t pos = 0;
+            decodeDeltaColumn(buf, pos, out);
+        });
+        if (out != *column) { std::cout << "decode mismatch\n"; return; }
+        std::cout << std::left << std::setw(28) << (column == &ids ? "deltaColumn decode ids" : "deltaColumn decode stamps")
+                  << std::fixed << std::setprecision(2)
+                  << (static_cast<double>(n) * sizeof(int64_t) / secs / 1e9) << " GB/s, "
+                  << (static_cast<double>(buf.size()) * 8 / n) << " bits/value\n";
+    }
+}
+
+// =============================
+// 📌 Startup Benchmarks
+// =============================
+
+/**
+ * @brief Compares rebuilding the history table from text with restoring it from the snapshot image.
+ * @note Uses a synthetic history file; the test data files are truncated afterwards.
+ */
+void bench_snapshotRestore() {
+    const int n = 500000;
+    {
+        std::ofstream ofs("tests/test_service_history.txt", std::ios::trunc);
+        for (int i = 1; i <= n; ++i) {
+            ServiceHistory h{i, i % 5000 + 1, i % 7000 + 1, {1, 3}, "2024-03-15 10:30:00", 2300, -1, 0, 2300, "Completed"};
+            ofs << formatHistoryLine(h) << '\n';
+        }
+    }
+    setStoreCacheEnabled(true);
+    double text = bestOf(3, [] { clearStoreCache(); loadHistory(); });
+    writeSnapshotImage();
+    double image = bestOf(3, [] { clearStoreCache(); restoreSnapshotImage(); });
+    std::cout << std::left << std::setw(28) << "startup text rebuild" << std::fixed << std::setprecision(1)
+              << text * 1e3 << " ms (" << n << " history rows)\n";
+    std::cout << std::left << std::setw(28) << "startup snapshot restore" << image * 1e3 << " ms\n";
+    setStoreCacheEnabled(false);
+    std::ofstream("tests/test_service_history.txt", std::ios::trunc);
+    std::remove("tests/test_snapshot.img");
+}
+
+// =============================
+// 📌 Group Commit Benchmarks
+// =============================
+
+/**
+ * @brief Measures durable history log appends per second with one writer and with many concurrent writers.
+ * @note Every append returns only after its record is synced, so the single-writer rate is bounded by the
+ *       disk's sync latency; concurrent writers share syncs through the group commit.
+ */
+void bench_groupCommit() {
+    const int perWriter = 200;
+    std::ofstream("tests/test_service_history.txt", std::ios::trunc);
+    for (int writers : {1, 4, 16, 64}) {
+        std::remove("tests/test_history.wal");
+        HistoryLogCommitStats before = historyLogCommitStats();
+        double secs = bestOf(1, [&] {
+            std::vector<std::thread> threads;
+            for (int w = 0; w < writers; ++w) {
+                threads.emplace_back([w] {
+                    for (int i = 0; i < perWriter; ++i) appendHistoryLog(historyStatusRecord(w * perWriter + i, "Completed"));
+                });
+            }
+            for (auto& t : threads) t.join();
+        });
+        HistoryLogCommitStats after = historyLogCommitStats();
+        long long records = after.records - before.records, batches = after.batches - before.batches;
+        std::cout << std::left << std::setw(28) << ("group commit " + std::to_string(writers) + " writers")
+                  << std::fixed << std::setprecision(0) << records / secs << " durable appends/s, "
+                  << std::setprecision(1) << static_cast<double>(records) / batches << " records/sync\n";
+    }
+    std::remove("tests/test_history.wal");
+
+    // Whole bookings: the in-memory apply, partition bookkeeping and change feed around each log append, with
+    // the table cache on as when serving
+    setStoreCacheEnabled(true);
+    int nextId = 1;
+    for (int writers : {1, 4, 16}) {
+        HistoryLogCommitStats before = historyLogCommitStats();
+        double secs = bestOf(1, [&] {
+            std::vector<std::thread> threads;
+            for (int w = 0; w < writers; ++w) {
+                int first = nextId + w * perWriter;
+                threads.emplace_back([first, perWriter] {
+                    for (int i = 0; i < perWriter; ++i) {
+                        addHistoryEntry({first + i, 1, 1, {1}, "2024-05-01 10:00:00", 1200, -1, 0, 1200, "Pending"});
+                    }
+                });
+            }
+            for (auto& t : threads) t.join();
+        });
+        nextId += writers * perWriter;
+        HistoryLogCommitStats after = historyLogCommitStats();
+        long long records = after.records - before.records, batches = after.batches - before.batches;
+        std::cout << std::left << std::setw(28) << ("booking commit " + std::to_string(writers) + " writers")
+                  << std::fixed << std::setprecision(0) << records / secs << " bookings/s, "
+                  << std::setprecision(1) << static_cast<double>(records) / batches << " records/sync\n";
+    }
+    setStoreCacheEnabled(false);
+    std::ofstream("tests/test_service_history.txt", std::ios::trunc);
+    std::remove("tests/test_history.wal");
+    clearStoreCache();
+}
+
+/**
+ * @brief Measures raw queue hand-off throughput, then booking latency through the storage writer.
+ */
+void bench_storageWriter() {
+    const int perProducer = 250000;
+    for (int producers : {1, 4}) {
+        MpscQueue<int> q;
+        initMpscQueue(q, 4096);
+        double secs = bestOf(1, [&] {
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p) {
+                threads.emplace_back([&q] {
+                    for (int i = 0; i < perProducer; ++i) {
+                        while (!mpscTryPush(q, i)) std::this_thread::yield();
+                    }
+                });
+            }
+            int v;
+            for (int received = 0; received < producers * perProducer;) {
+                if (mpscTryPop(q, v)) received++;
+            }
+            for (auto& t : threads) t.join();
+        });
+        std::cout << std::left << std::setw(28) << ("mpsc queue " + std::to_string(producers) + " producers")
+                  << std::fixed << std::setprecision(0) << producers * perProducer / secs << " items/s\n";
+    }
+
+    const int desks = 16, perDesk = 200;
+    std::ofstream("tests/test_service_history.txt", std::ios::trunc);
+    std::remove("tests/test_history.wal");
+    startStorageWriter(256);
+    double secs = bestOf(1, [&] {
+        std::vector<std::thread> threads;
+        for (int d = 0; d < desks; ++d) {
+            threads.emplace_back([d] {
+                for (int i = 0; i < perDesk; ++i) {
+                    Mutation m;
+                    m.type = MutationType::AddBooking;
+                    m.booking = {0, d + 1, d + 1, {1}, "2023-12-01 10:00:00", 1000, -1, 0, 1000, "Pending"};
+                    submitMutation(m);
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        stopStorageWriter();
+    });
+    StorageWriterStats s = storageWriterStats();
+    std::cout << std::left << std::setw(28) << ("storage writer " + std::to_string(desks) + " desks")
+              << std::fixed << std::setprecision(0) << desks * perDesk / secs << " bookings/s, "
+              << std::setprecision(1) << static_cast<double>(s.written) / s.batches << " per batch, p50 <= "
+              << latencyPercentileMicros(s, 0.5) << " us, p99 <= " << latencyPercentileMicros(s, 0.99) << " us\n";
+    std::remove("tests/test_history.wal");
+}
+
+/**
+ * @brief Measures how the history aggregation scan scales with the number of pool workers.
+ */
+void bench_threadPoolScaling() {
+    const int months = 48, perMonth = 10000;
+    std::vector<ServiceHistory> rows;
+    rows.reserve(months * perMonth);
+    for (int m = 0; m < months; ++m) {
+        char date[32];
+        std::snprintf(date, sizeof(date), "%04d-%02d-15 10:00:00", 2020 + m / 12, m % 12 + 1);
+        for (int i = 0; i < perMonth; ++i) {
+            int id = m * perMonth + i + 1;
+            rows.push_back({id, id % 5000 + 1, id % 7000 + 1, {1, 2}, date, 1500, -1, 0, 1500, i % 3 ? "Completed" : "Pending"});
+        }
+    }
+    writeHistoryPartitions(rows);
+
+    double baseline = 0;
+    for (size_t workers : {1, 2, 4, 8}) {
+        stopThreadPool();
+        startThreadPool(workers);
+        PartitionSummary total;
+        double secs = bestOf(3, [&] {
+            total = emptyPartitionSummary("all");
+            for (const auto& h : loadHistoryBetween("2020-01-01", "2023-12-31")) addToPartitionSummary(total, h);
+        });
+        if (workers == 1) baseline = secs;
+        std::cout << std::left << std::setw(28) << ("aggregate scan " + std::to_string(workers) + " workers")
+                  << std::fixed << std::setprecision(0) << total.rows / secs << " rows/s, "
+                  << std::setprecision(2) << baseline / secs << "x\n";
+    }
+    stopThreadPool();
+    writeHistoryPartitions({});
+}
+
+/**
+ * @brief Measures batch invoicing: render and write one file per booking, text and HTML.
+ */
+void bench_batchInvoices() {
+    auto services = loadServices();
+    saveServices({{1, "Oil Change", 1500}, {2, "Brake Check", 800}, {3, "Car Wash", 300}});
+    std::vector<Customer> customers;
+    std::vector<Vehicle> vehicles;
+    for (int i = 1; i <= 1000; ++i) {
+        customers.push_back({i, "Customer " + std::to_string(i), "98" + std::to_string(10000000 + i), "c@x.com"});
+        vehicles.push_back({i, i, "KA01AB" + std::to_string(1000 + i), "Swift", "Red"});
+    }
+    saveCustomers(customers);
+    saveVehicles(vehicles);
+    const int count = 10000;
+    std::vector<ServiceHistory> rows;
+    for (int id = 1; id <= count; ++id) {
+        rows.push_back({id, id % 1000 + 1, id % 1000 + 1, {1, 2, 3}, "2024-03-15 10:00:00", 2600, 1, 10, 2340, "Completed"});
+    }
+    InvoiceContext ctx = loadInvoiceContext();
+    auto tmpl = invoiceTemplate(InvoiceFormat::Text);
+    std::string buf;
+    double render = bestOf(3, [&] {
+        for (const auto& h : rows) {
+            buf.clear();
+            renderInvoice(*tmpl, h, ctx, buf);
+        }
+    });
+    std::cout << std::left << std::setw(28) << "bill template render" << std::fixed << std::setprecision(0)
+              << count / render << " bills/s\n";
+    for (InvoiceFormat format : {InvoiceFormat::Text, InvoiceFormat::Html}) {
+        InvoiceBatchReport report{};
+        double secs = bestOf(3, [&] { report = writeInvoices(rows, format, invoiceDir() + "/bench"); });
+        std::cout << std::left << std::setw(28) << (format == InvoiceFormat::Text ? "batch invoices text" : "batch invoices html")
+                  << std::fixed << std::setprecision(0) << report.invoices / secs << " invoices/s, "
+                  << std::setprecision(1) << report.bytes / secs / (1 << 20) << " MiB/s\n";
+    }
+    std::filesystem::remove_all(invoiceDir());
+    saveServices(services);
+    saveCustomers({});
+    saveVehicles({});
+}
+
+/**
+ * @brief Measures the parts availability check made for every booking, against the in-memory inventory.
+ */
+void bench_partsAvailability() {
+    std::vector<Part> parts;
+    std::vector<ServicePart> bom;
+    for (int id = 1; id <= 1000; ++id) parts.push_back({id, "Part " + std::to_string(id), 1000000});
+    for (int sid = 1; sid <= 200; ++sid) {
+        for (int k = 0; k < 5; ++k) bom.push_back({sid, (sid * 7 + k * 131) % 1000 + 1, k + 1});
+    }
+    saveParts(parts);
+    saveServiceParts(bom);
+    const int count = 1000000;
+    std::vector<PartShortage> shortages;
+    int available = 0;
+    double secs = bestOf(3, [&] {
+        for (int i = 0; i < count; ++i) {
+            std::vector<int> services{i % 200 + 1, (i * 31) % 200 + 1, (i * 17) % 200 + 1};
+            available += checkPartsAvailable(services, shortages);
+        }
+    });
+    std::cout << std::left << std::setw(28) << "parts availability check" << std::fixed << std::setprecision(0)
+              << secs / count * 1e9 << " ns/check (" << available / 3 << " ok)\n";
+    for (const char* f : {"tests/test_parts.txt", "tests/test_service_parts.txt", "tests/test_part_reservations.txt"}) {
+        std::filesystem::remove(f);
+    }
+    reloadInventory();
+}
+
+/**
+ * @brief Measures the "next 5 free slots" query against a calendar whose first weeks are nearly full.
+ */
+void bench_nextFreeSlots() {
+    // Book every bay solid for 20 days, leaving one free hour a day in the last bay
+    Appointment appt;
+    std::string error;
+    int historyId = 1;
+    long long base;
+    dateTimeToSeconds("2030-01-01 00:00:00", base);
+    for (int d = 0; d < 20; ++d) {
+        std::string date = secondsToDateTime(base + d * 86400LL).substr(0, 10);
+        for (int bay = 1; bay <= SERVICE_BAYS; ++bay) {
+            for (int slot = 0; slot < static_cast<int>(SLOTS_PER_DAY); slot += 2) {
+                if (bay == SERVICE_BAYS && slot == 8) continue;
+                int minutes = OPENING_HOUR * 60 + slot * SLOT_MINUTES;
+                char start[32];
+                std::snprintf(start, sizeof(start), "%s %02d:%02d", date.c_str(), minutes / 60, minutes % 60);
+                bookAppointment(historyId++, 2, start, appt, error);
+            }
+        }
+    }
+    const int count = 100000;
+    size_t found = 0;
+    double secs = bestOf(3, [&] {
+        for (int i = 0; i < count; ++i) found += nextFreeSlots(5, "2030-01-01 09:00", 5).size();
+    });
+    std::cout << std::left << std::setw(28) << "next 5 free slots" << std::fixed << std::setprecision(2)
+              << secs / count * 1e6 << " us/query (" << found / count / 3 << " offers, " << historyId - 1 << " booked)\n";
+    std::filesystem::remove("tests/test_appointments.txt");
+    reloadCalendar();
+}
+
+/**
+ * @brief Measures p50/p90/p99 of a year of work times for one service across branches, answered by merging the
+ *        month sketches that the job time statistics roll up from their day sketches, against sorting the times.
+ */
+void bench_quantileSketches() {
+    const int months = 12, daysPerMonth = 30, branches = 3, jobsPerDay = 40;
+    std::vector<QuantileSketch> monthSketches(months * branches);
+    std::vector<double> raw;
+    uint64_t rng = 88172645463325252ULL;
+    for (auto& month : monthSketches) {
+        for (int d = 0; d < daysPerMonth; ++d) {
+            QuantileSketch day;
+            for (int j = 0; j < jobsPerDay; ++j) {
+                rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+                double minutes = static_cast<double>(30 + rng % 240);
+                sketchAdd(day, minutes);
+                raw.push_back(minutes);
+            }
+            sketchMerge(month, day);
+        }
+    }
+    volatile double sink = 0;
+    double sketchSecs = bestOf(5, [&] {
+        QuantileSketch year;
+        for (const auto& month : monthSketches) sketchMerge(year, month);
+        sink = sketchQuantile(year, 0.5) + sketchQuantile(year, 0.9) + sketchQuantile(year, 0.99);
+    });
+    double sortSecs = bestOf(5, [&] {
+        std::vector<double> copy = raw;
+        std::sort(copy.begin(), copy.end());
+        sink = copy[copy.size() / 2] + copy[copy.size() * 9 / 10] + copy[copy.size() * 99 / 100];
+    });
+    std::cout << std::left << std::setw(28) << "job time percentiles" << std::fixed << std::setprecision(2)
+              << sketchSecs * 1e6 << " us merging " << monthSketches.size() << " sketches vs " << sortSecs * 1e6
+              << " us sorting " << raw.size() << " times\n";
+}
+
+/**
+ * @brief Measures distinct vehicles over three years of three branches, answered by merging the per-segment
+ *        HyperLogLog sketches, against an exact hash set over every booking.
+ */
+void bench_distinctCounts() {
+    const int segments = 36 * 3, bookingsPerSegment = 20000, fleet = 500000;
+    std::vector<HyperLogLog> sketches;
+    std::vector<int> vehicleIds;
+    uint64_t rng = 88172645463325252ULL;
+    for (int s = 0; s < segments; ++s) {
+        HyperLogLog h = makeHyperLogLog();
+        for (int j = 0; j < bookingsPerSegment; ++j) {
+            rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+            int id = static_cast<int>(rng % fleet);
+            hllAdd(h, id);
+            vehicleIds.push_back(id);
+        }
+        sketches.push_back(std::move(h));
+    }
+    long long estimate = 0;
+    size_t exact = 0;
+    double sketchSecs = bestOf(5, [&] {
+        HyperLogLog all = makeHyperLogLog();
+        for (const auto& h : sketches) hllMerge(all, h);
+        estimate = hllEstimate(all);
+    });
+    double setSecs = bestOf(3, [&] {
+        std::unordered_set<int> seen(vehicleIds.begin(), vehicleIds.end());
+        exact = seen.size();
+    });
+    std::cout << std::left << std::setw(28) << "distinct vehicles" << std::fixed << std::setprecision(2)
+              << sketchSecs * 1e3 << " ms merging " << segments << " sketches vs " << setSecs * 1e3
+              << " ms hashing " << vehicleIds.size() << " bookings (" << estimate << " est, " << exact << " exact)\n";
+}
+
+/**
+ * @brief Measures a three-year retention matrix over one million customers: building the per-customer visit
+ *        timelines from unsorted visits, then counting the 36 cohorts.
+ */
+void bench_cohortRetention() {
+    const int customers = 1000000, months = 36, base = 2030 * 12;
+    std::vector<std::pair<int, int>> visits;
+    visits.reserve(customers * 4);
+    uint64_t rng = 88172645463325252ULL;
+    auto next = [&] { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; };
+    for (int c = 1; c <= customers; ++c) {
+        int first = base + static_cast<int>(next() % months);
+        visits.emplace_back(c, first);
+        for (int m = first + 1; m < first + 24; ++m) {
+            if (next() % 100 < 12) visits.emplace_back(c, m); // About three returns in two years
+        }
+    }
+    // Visits arrive in booking order, not grouped by customer
+    for (size_t i = visits.size() - 1; i > 0; --i) std::swap(visits[i], visits[next() % (i + 1)]);
+
+    VisitTimeline timeline;
+    RetentionMatrix matrix;
+    double buildSecs = bestOf(3, [&] { timeline = buildVisitTimeline(visits); });
+    double matrixSecs = bestOf(3, [&] { matrix = cohortRetention(timeline, base, base + months - 1); });
+    std::cout << std::left << std::setw(28) << "cohort retention (36 x 12)" << std::fixed << std::setprecision(1)
+              << (buildSecs + matrixSecs) * 1e3 << " ms (" << buildSecs * 1e3 << " ms timelines, " << matrixSecs * 1e3
+              << " ms matrix; " << visits.size() << " visits, " << customers << " customers, M+1 "
+              << 100.0 * matrix.returned[0][0] / matrix.sizes[0] << "%)\n";
+}
+
+#ifndef _WIN32
+/**
+ * @brief Opens a client connection to the test server socket.
+ * @return int The connected socket, or -1 on failure.
+ */
+int connectBenchServer() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::string path = "tests/test_server.sock";
+    path.copy(addr.sun_path, path.size());
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Measures lookup round trips on the event loop server while it also holds thousands of idle connections.
+ */
+void bench_serverIdleConnections() {
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com"}});
+    startServer("tests/test_server.sock");
+    const int clients = 32, perClient = 2000;
+    for (int idleCount : {0, 5000}) {
+        std::vector<int> idle;
+        for (int i = 0; i < idleCount; ++i) idle.push_back(connectBenchServer());
+        double secs = bestOf(1, [&] {
+            std::vector<std::thread> threads;
+            for (int c = 0; c < clients; ++c) {
+                threads.emplace_back([] {
+                    int fd = connectBenchServer();
+                    const std::string req = "CUSTOMER 1\n";
+                    char buf[256];
+                    for (int i = 0; i < perClient; ++i) {
+                        if (send(fd, req.data(), req.size(), 0) < 0) break;
+                        ssize_t n = 0;
+                        do { n = recv(fd, buf, sizeof(buf), 0); } while (n > 0 && buf[n - 1] != '\n');
+                    }
+                    close(fd);
+                });
+            }
+            for (auto& t : threads) t.join();
+        });
+        std::cout << std::left << std::setw(28) << ("server " + std::to_string(serverStats().openConnections) + " open conns")
+                  << std::fixed << std::setprecision(0) << clients * perClient / secs << " lookups/s\n";
+        for (int fd : idle) close(fd);
+    }
+    stopServer();
+    stopStorageWriter();
+}
+
+/**
+ * @brief Measures keep-alive HTTP lookups, one request per round trip and pipelined 16 deep.
+ */
+void bench_httpRequests() {
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com"}});
+    startServer("tests/test_server.sock", 0);
+    const int port = serverHttpPort();
+    const int clients = 8, perClient = 4000;
+    for (int depth : {1, 16}) {
+        double secs = bestOf(1, [&] {
+            std::vector<std::thread> threads;
+            for (int c = 0; c < clients; ++c) {
+                threads.emplace_back([&] {
+                    int fd = socket(AF_INET, SOCK_STREAM, 0);
+                    sockaddr_in addr{};
+                    addr.sin_family = AF_INET;
+                    addr.sin_port = htons(static_cast<uint16_t>(port));
+                    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                        close(fd);
+                        return;
+                    }
+                    int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    std::string batch;
+                    for (int i = 0; i < depth; ++i) batch += "GET /customers/1 HTTP/1.1\r\nHost: bench\r\n\r\n";
+                    char buf[16384];
+                    for (int i = 0; i < perClient / depth; ++i) {
+                        if (send(fd, batch.data(), batch.size(), 0) < 0) break;
+                        // Every response ends with the customer object's closing brace
+                        int seen = 0;
+                        while (seen < depth) {
+                            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                            if (n <= 0) break;
+                            for (ssize_t k = 0; k < n; ++k) seen += buf[k] == '}';
+                        }
+                    }
+                    close(fd);
+                });
+            }
+            for (auto& t : threads) t.join();
+        });
+        std::cout << std::left << std::setw(28) << ("http keep-alive depth " + std::to_string(depth))
+                  << std::fixed << std::setprecision(0) << clients * perClient / secs << " requests/s\n";
+    }
+    stopServer();
+    stopStorageWriter();
+}
+#endif
+
+/**
+ * @brief Main entry point for the benchmark suite.
+ * @return int Exit code (0 for successful completion).
+ */
+int main() {
+    std::cout << "===== Auto Service Management Benchmarks =====" << std::endl;
+    bench_deltaColumnDecode();
+    bench_snapshotRestore();
+    bench_groupCommit();
+    bench_storageWriter();
+    bench_threadPoolScaling();
+    bench_batchInvoices();
+    bench_partsAvailability();
+    bench_nextFreeSlots();
+    bench_quantileSketches();
+    bench_distinctCounts();
+    bench_cohortRetention();
+#ifndef _WIN32
+    bench_serverIdleConnections();
+    bench_httpRequests();
+#endif
+    std::cout << "=========== Benchmarks Completed ===========" << std::endl;
+    return 0;
+}
@@ -1,6 +1,11 @@
 // test.cpp - The unit test suite
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
 #include <fstream>
+#include <future>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -10,6 +15,41 @@
 #include "Vehicle.h"
 #include "Service.h"
 #include "Discount.h"
+#include "HistoryPartition.h"
+#include "HistoryArchive.h"
+#include "ColumnCodec.h"
+#include "BloomFilter.h"
+#include "Compaction.h"
+#include "Snapshot.h"
+#include "HistoryLog.h"
+#include "MutationQueue.h"
+#include "StorageWriter.h"
+#include "ThreadPool.h"
+#include "Server.h"
+#include "HttpApi.h"
+#include "Json.h"
+#include "ChangeFeed.h"
+#include "Replication.h"
+#include "BranchStore.h"
+#include "Invoice.h"
+#include "Tax.h"
+#include "Inventory.h"
+#include "Calendar.h"
+#include "Lifecycle.h"
+#include "QuantileSketch.h"
+#include "HyperLogLog.h"
+#include "Cohort.h"
+#include <climits>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
 
 // Define file paths for testing
 #define CUSTOMER_FILE "tests/test_customers.txt"
@@ -17,6 +57,21 @@
 #define SERVICES_FILE "tests/test_services.txt"
 #define DISCOUNT_FILE "tests/test_discounts.txt"
 #define HISTORY_FILE "tests/test_service_history.txt"
+#define PARTITION_DIR "tests/test_history_partitions"
+#define ARCHIVE_DIR "tests/test_history_archive"
+#define SNAPSHOT_FILE "tests/test_snapshot.img"
+#define HISTORY_LOG_FILE "tests/test_history.wal"
+#define SERVER_SOCKET "tests/test_server.sock"
+#define CHANGE_FEED_FILE "tests/test_changes.jsonl"
+#define REPLICATION_SOCKET "tests/test_replication.sock"
+#define STANDBY_DIR "tests/standby"
+#define BRANCH_DIR "tests/test_branches"
+#define INVOICE_DIR "tests/test_invoices"
+#define TAX_CLASS_FILE "tests/test_tax_classes.txt"
+#define PARTS_FILE "tests/test_parts.txt"
+#define SERVICE_PARTS_FILE "tests/test_service_parts.txt"
+#define RESERVATION_FILE "tests/test_part_reservations.txt"
+#define APPOINTMENT_FILE "tests/test_appointments.txt"
 
 // Global silent mode flag
 bool silentMode = false;
@@ -32,6 +87,26 @@ void clearTestFiles() {
     ofs.open(SERVICES_FILE, std::ios::trunc); ofs.close();
     ofs.open(DISCOUNT_FILE, std::ios::trunc); ofs.close();
     ofs.open(HISTORY_FILE, std::ios::trunc); ofs.close();
+    std::filesystem::remove_all(PARTITION_DIR);
+    std::filesystem::remove_all(ARCHIVE_DIR);
+    std::filesystem::remove_all(BRANCH_DIR);
+    std::filesystem::remove_all(INVOICE_DIR);
+    std::filesystem::remove(SNAPSHOT_FILE);
+    std::filesystem::remove(CHANGE_FEED_FILE);
+    std::filesystem::remove(TAX_CLASS_FILE);
+    std::filesystem::remove(PARTS_FILE);
+    std::filesystem::remove(SERVICE_PARTS_FILE);
+    std::filesystem::remove(RESERVATION_FILE);
+    reloadInventory();
+    std::filesystem::remove(APPOINTMENT_FILE);
+    reloadCalendar();
+    resetTurnaroundStats();
+    std::filesystem::remove(HISTORY_LOG_FILE);
+    std::filesystem::remove(std::string(HISTORY_LOG_FILE) + ".next");
+    std::filesystem::remove(std::string(HISTORY_FILE) + ".tmp");
+    for (const char* f : {CUSTOMER_FILE, VEHICLE_FILE, SERVICES_FILE, DISCOUNT_FILE, HISTORY_FILE}) {
+        std::filesystem::remove(std::string(f) + ".quarantine");
+    }
 }
 
 /**
@@ -765,6 +840,939 @@ void test_addHistoryEntry_emptyServiceIds() {
     if (!silentMode) std::cout << "[PASS] test_addHistoryEntry_emptyServiceIds\n";
 }
 
+// =============================
+// 📌 History Partition Test Functions
+// =============================
+
+/**
+ * @brief Tests that saving history splits rows into monthly segments with summary headers.
+ * @note Verifies segment count, header row counts, revenue sums and status counts.
+ * @throws std::runtime_error If partitions or summaries do not match expected values.
+ */
+void test_historyPartitions_summaries() {
+    clearTestFiles();
+    saveHistory({
+        {1, 1, 1, {1}, "2023-10-10 10:00:00", 1200, -1, 0, 1200, "Completed"},
+        {2, 2, 2, {3}, "2023-10-20 11:00:00", 600, -1, 0, 600, "Pending"},
+        {3, 1, 1, {2}, "2023-11-01 09:00:00", 800, 1, 10, 720, "Completed"}
+    });
+    auto parts = loadPartitionSummaries();
+    if (parts.size() != 2) throw std::runtime_error("Should create two monthly partitions");
+    if (parts[0].key != "2023-10" || parts[1].key != "2023-11") throw std::runtime_error("Partition keys should be YYYY-MM");
+    if (parts[0].rows != 2 || parts[0].totalSum != 1800) throw std::runtime_error("October summary should match");
+    if (parts[0].pendingCount != 1 || parts[0].completedCount != 1) throw std::runtime_error("Status counts should match");
+    if (parts[0].minDate != "2023-10-10 10:00:00" || parts[0].maxDate != "2023-10-20 11:00:00") throw std::runtime_error("Date span should match");
+    if (!silentMode) std::cout << "[PASS] test_historyPartitions_summaries\n";
+}
+
+/**
+ * @brief Tests date-bounded loads and aggregates over partitions.
+ * @note Verifies that only rows in range are returned and that aggregates combine headers and boundary scans.
+ * @throws std::runtime_error If range results do not match expected values.
+ */
+void test_historyPartitions_dateRange() {
+    clearTestFiles();
+    saveHistory({
+        {1, 1, 1, {1}, "2023-10-10 10:00:00", 1200, -1, 0, 1200, "Completed"},
+        {2, 2, 2, {3}, "2023-10-20 11:00:00", 600, -1, 0, 600, "Pending"},
+        {3, 1, 1, {2}, "2023-11-01 09:00:00", 800, 1, 10, 720, "Completed"}
+    });
+    auto rows = loadHistoryBetween("2023-10-15", "2023-12-31");
+    if (rows.size() != 2) throw std::runtime_error("Should load two rows in range");
+    if (rows[0].historyId != 2 || rows[1].historyId != 3) throw std::runtime_error("Rows in range should match");
+    auto s = summarizeHistoryBetween("2023-10-15", "2023-12-31");
+    if (s.rows != 2 || s.totalSum != 1320) throw std::runtime_error("Range aggregate should match");
+    if (!loadHistoryBetween("2024-01-01", "2024-12-31").empty()) throw std::runtime_error("Out of range should be empty");
+    if (!silentMode) std::cout << "[PASS] test_historyPartitions_dateRange\n";
+}
+
+/**
+ * @brief Tests that partition header sums keep every paisa of a large, non-round total.
+ * @note A fully covered month is answered from its header alone, so the header must round-trip the sums.
+ * @throws std::runtime_error If the aggregate differs from the exact total.
+ */
+void test_historyPartitions_sumPrecision() {
+    clearTestFiles();
+    std::vector<ServiceHistory> list;
+    for (int i = 1; i <= 1500; ++i) list.push_back({i, 1, 1, {1}, "2023-10-10 10:00:00", 999.99, -1, 0, 999.99, "Completed"});
+    saveHistory(list);
+    auto s = summarizeHistoryBetween("2023-10-01", "2023-10-31");
+    if (s.rows != 1500 || std::fabs(s.totalSum - 1499985) > 0.005 || std::fabs(s.subtotalSum - 1499985) > 0.005)
+        throw std::runtime_error("Header sums should keep the paise");
+    if (!silentMode) std::cout << "[PASS] test_historyPartitions_sumPrecision\n";
+}
+
+// =============================
+// 📌 History Archive Test Functions
+// =============================
+
+/**
+ * @brief Tests that an archive segment decodes back to the rows it was encoded from.
+ * @note Covers repeated IDs, empty and shared service lists, fractional money values and mixed statuses.
+ * @throws std::runtime_error If any decoded field differs from the original.
+ */
+void test_archiveSegment_roundTrip() {
+    std::vector<ServiceHistory> rows = {
+        {1, 1, 1, {1, 2}, "2023-10-10 10:00:00", 2000, -1, 0, 2000, "Completed"},
+        {1, 1, 1, {}, "2023-10-10 10:00:00", 0, -1, 0, 0, "Completed"},
+        {3, 3, 3, {1, 2}, "2023-10-14 11:45:33", 1200, 2, 2, 1176, "Completed"},
+        {4, 2, 2, {2, 2}, "2023-10-31 23:59:59", 800, 2, 2.5, 780.1234, "Pending"}
+    };
+    std::vector<ServiceHistory> decoded;
+    if (!decodeArchiveSegment(encodeArchiveSegment(rows), decoded)) throw std::runtime_error("Segment should decode");
+    if (decoded.size() != rows.size()) throw std::runtime_error("Row count should match");
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (formatHistoryLine(decoded[i]) != formatHistoryLine(rows[i])) throw std::runtime_error("Row " + std::to_string(i) + " should round-trip");
+    }
+    if (decodeArchiveSegment("CSA", decoded)) throw std::runtime_error("Truncated segment should be rejected");
+    if (!silentMode) std::cout << "[PASS] test_archiveSegment_roundTrip\n";
+}
+
+/**
+ * @brief Tests that delta columns round-trip for sorted, unsorted, extreme and multi-block inputs.
+ * @note Also verifies that a sorted ID column packs far below one byte per value and that truncation is detected.
+ * @throws std::runtime_error If a decoded column differs from the original.
+ */
+void test_deltaColumn_roundTrip() {
+    std::vector<std::vector<int64_t>> cases = {
+        {},
+        {42},
+        {5, 5, 5, 5},
+        {3, 1, 4, 1, 5, 9, 2, 6},
+        {LLONG_MIN, LLONG_MAX, 0, -1, LLONG_MAX, LLONG_MIN}
+    };
+    std::vector<int64_t> ids, stamps;
+    for (int64_t i = 0; i < 1000; ++i) {
+        ids.push_back(1000 + i);
+        stamps.push_back(1697000000 + i * 600 + (i * 7919) % 300);
+    }
+    cases.push_back(ids);
+    cases.push_back(stamps);
+    for (const auto& values : cases) {
+        std::string buf = "x";
+        encodeDeltaColumn(values, buf);
+        size_t pos = 1;
+        std::vector<int64_t> decoded;
+        if (!decodeDeltaColumn(buf, pos, decoded)) throw std::runtime_error("Column should decode");
+        if (decoded != values) throw std::runtime_error("Decoded column should match");
+        if (pos != buf.size()) throw std::runtime_error("Decoder should consume the whole column");
+    }
+    std::string buf;
+    encodeDeltaColumn(ids, buf);
+    if (buf.size() > ids.size() / 4) throw std::runtime_error("Sequential IDs should pack to a few bits each");
+    size_t pos = 0;
+    std::vector<int64_t> decoded;
+    if (decodeDeltaColumn(buf.substr(0, buf.size() / 2), pos, decoded)) throw std::runtime_error("Truncated column should be rejected");
+    if (!silentMode) std::cout << "[PASS] test_deltaColumn_roundTrip\n";
+}
+
+/**
+ * @brief Tests moving old completed history into the archive tier.
+ * @note Verifies hot/archive split, lazy lookups by ID and date, summaries, and that archived IDs are not reused.
+ * @throws std::runtime_error If rows are lost, duplicated or misplaced.
+ */
+void test_archiveCompletedHistory() {
+    clearTestFiles();
+    saveHistory({
+        {1, 1, 1, {1}, "2023-10-10 10:00:00", 1200, -1, 0, 1200, "Completed"},
+        {2, 2, 2, {3}, "2023-10-20 11:00:00", 600, -1, 0, 600, "Pending"},
+        {3, 1, 1, {2}, "2023-11-01 09:00:00", 800, 1, 10, 720, "Completed"},
+        {4, 1, 1, {2}, "2024-02-01 09:00:00", 800, -1, 0, 800, "Completed"}
+    });
+    if (archiveCompletedHistory("2024-01-01") != 2) throw std::runtime_error("Should archive two completed rows");
+    auto hot = loadHistory();
+    if (hot.size() != 2 || hot[0].historyId != 2 || hot[1].historyId != 4) throw std::runtime_error("Hot history should keep pending and recent rows");
+    if (loadArchiveIndex().size() != 2) throw std::runtime_error("Should create one segment per month");
+
+    ServiceHistory h;
+    if (!findArchivedHistory(3, h) || h.total != 720) throw std::runtime_error("Archived row should be found by ID");
+    if (findArchivedHistory(2, h)) throw std::runtime_error("Hot row should not be in the archive");
+    if (loadHistoryBetween("2023-10-01", "2023-10-31").size() != 2) throw std::runtime_error("Range load should combine tiers");
+    auto s = summarizeHistoryBetween("2023-01-01", "2024-12-31");
+    if (s.rows != 4 || s.totalSum != 3320) throw std::runtime_error("Summary should cover both tiers");
+
+    saveHistory({});
+    if (nextHistoryId() != 4) throw std::runtime_error("Next history ID should skip archived IDs");
+
+    std::vector<ServiceHistory> december;
+    for (int i = 5; i < 155; ++i) december.push_back({i, 1, 1, {1}, "2023-12-05 10:00:00", 999.99, -1, 0, 999.99, "Completed"});
+    saveHistory(december);
+    archiveCompletedHistory("2024-01-01");
+    if (std::fabs(loadArchiveIndex().back().summary.totalSum - 149998.5) > 0.005) throw std::runtime_error("Index sums should keep the paise");
+
+    // An interrupted run leaves rows in both tiers; archiving them again must not duplicate them
+    saveHistory({{3, 1, 1, {2}, "2023-11-01 09:00:00", 800, 1, 10, 720, "Completed"}});
+    if (archiveCompletedHistory("2024-01-01") != 1) throw std::runtime_error("Should archive the leftover row");
+    if (loadArchiveSegment("2023-11").size() != 1) throw std::runtime_error("Rerun should not duplicate archived rows");
+    if (!silentMode) std::cout << "[PASS] test_archiveCompletedHistory\n";
+}
+
+// =============================
+// 📌 Bloom Filter Test Functions
+// =============================
+
+/**
+ * @brief Tests Bloom filter membership, false-positive rate and serialization.
+ * @note Verifies no false negatives, a false-positive rate near the 1% target, and an exact round trip.
+ * @throws std::runtime_error If membership answers or the serialized form are wrong.
+ */
+void test_bloomFilter_membership() {
+    BloomFilter f = makeBloomFilter(1000);
+    for (int i = 0; i < 1000; ++i) bloomAdd(f, i * 3);
+    for (int i = 0; i < 1000; ++i) {
+        if (!bloomMightContain(f, i * 3)) throw std::runtime_error("Added key must be reported present");
+    }
+    int falsePositives = 0;
+    for (int i = 0; i < 10000; ++i) {
+        if (bloomMightContain(f, 1000000 + i)) falsePositives++;
+    }
+    if (falsePositives > 300) throw std::runtime_error("False-positive rate should stay near 1%");
+
+    std::string buf;
+    serializeBloomFilter(f, buf);
+    size_t pos = 0;
+    BloomFilter g;
+    if (!deserializeBloomFilter(buf, pos, g) || g.words != f.words || g.hashes != f.hashes) throw std::runtime_error("Filter should round-trip");
+    if (!silentMode) std::cout << "[PASS] test_bloomFilter_membership\n";
+}
+
+/**
+ * @brief Tests keyed history lookups through per-segment filters.
+ * @note Verifies lookups by history, customer and vehicle ID across hot and archived segments,
+ *       and that a lookup for an absent ID reads no segment.
+ * @throws std::runtime_error If lookups return wrong rows or read segments they should skip.
+ */
+void test_findHistoryRows_segmentFilters() {
+    clearTestFiles();
+    saveHistory({
+        {1, 1, 10, {1}, "2023-10-10 10:00:00", 1200, -1, 0, 1200, "Completed"},
+        {2, 2, 20, {3}, "2023-11-20 11:00:00", 600, -1, 0, 600, "Pending"},
+        {3, 1, 10, {2}, "2023-12-01 09:00:00", 800, 1, 10, 720, "Completed"}
+    });
+    archiveCompletedHistory("2023-11-01");
+
+    ServiceHistory h;
+    if (!findHistoryById(1, h) || h.vehicleId != 10) throw std::runtime_error("Archived entry should be found by ID");
+    if (!findHistoryById(3, h) || h.total != 720) throw std::runtime_error("Hot entry should be found by ID");
+    if (findHistoryRows(HistoryKey::CustomerId, 1).size() != 2) throw std::runtime_error("Customer lookup should span tiers");
+    if (findHistoryRows(HistoryKey::VehicleId, 20).size() != 1) throw std::runtime_error("Vehicle lookup should match one row");
+
+    long long before = historySegmentReads();
+    if (findHistoryById(4242, h)) throw std::runtime_error("Absent ID should not be found");
+    if (!findHistoryRows(HistoryKey::CustomerId, 4242).empty()) throw std::runtime_error("Absent customer should not be found");
+    if (historySegmentReads() != before) throw std::runtime_error("Absent keys should not read any segment");
+    if (!silentMode) std::cout << "[PASS] test_findHistoryRows_segmentFilters\n";
+}
+
+// =============================
+// 📌 Compaction Test Functions
+// =============================
+
+/**
+ * @brief Tests compaction of a history file with duplicate and malformed rows.
+ * @note Verifies last-writer-wins deduplication, sorted output, quarantine contents and reclaimed bytes.
+ * @throws std::runtime_error If the compacted file or the report does not match expected values.
+ */
+void test_compactDataFile_history() {
+    clearTestFiles();
+    std::ofstream ofs(HISTORY_FILE);
+    ofs << "3|3|3|1,2|2025-08-14 11:45:33|1200|2|2|1176|Completed\n";
+    ofs << "1|1|1|1,2|2023-10-10 10:00:00|2000|-1|0|2000|Pending\n";
+    ofs << "garbage|row\n";
+    ofs << "2|2|2|3|2023-10-11 11:00:00|600|-1|0|600|Completed\n";
+    ofs << "1|1|1|1,2|2023-10-10 10:00:00|2000|-1|0|2000|Completed\n";
+    ofs.close();
+
+    auto reports = compactAllDataFiles();
+    const CompactionReport& r = reports.back();
+    if (!r.rewritten) throw std::runtime_error("History file should be rewritten");
+    if (r.rowsRead != 5 || r.rowsKept != 3 || r.duplicatesDropped != 1 || r.rowsQuarantined != 1) throw std::runtime_error("Report counts should match");
+    if (r.bytesBefore - r.bytesAfter <= 0) throw std::runtime_error("Bytes should be reclaimed");
+
+    auto history = loadHistory();
+    if (history.size() != 3) throw std::runtime_error("Three unique rows should remain");
+    if (history[0].historyId != 1 || history[1].historyId != 2 || history[2].historyId != 3) throw std::runtime_error("Rows should be sorted by ID");
+    if (history[0].status != "Completed") throw std::runtime_error("Last writer should win");
+
+    std::ifstream q(std::string(HISTORY_FILE) + ".quarantine");
+    std::string line;
+    if (!std::getline(q, line) || line != "garbage|row") throw std::runtime_error("Malformed row should be quarantined");
+    if (loadPartitionSummaries().size() != 2) throw std::runtime_error("Partitions should be rebuilt after compaction");
+
+    if (compactAllDataFiles().back().rewritten) throw std::runtime_error("Second pass should find nothing to do");
+    if (!silentMode) std::cout << "[PASS] test_compactDataFile_history\n";
+}
+
+/**
+ * @brief Tests background compaction of the customer file.
+ * @note Verifies the background pass completes and keeps the last record for a duplicated ID.
+ * @throws std::runtime_error If the customer file is not compacted as expected.
+ */
+void test_backgroundCompaction_customers() {
+    clearTestFiles();
+    std::ofstream ofs(CUSTOMER_FILE);
+    ofs << "2|Jane|0987654321|jane@example.com\n";
+    ofs << "1|John|1234567890|john@example.com\n";
+    ofs << "2|Jane Doe|0987654321|jane@example.com\n";
+    ofs.close();
+
+    auto reports = startBackgroundCompaction().get();
+    if (!reports.front().rewritten) throw std::runtime_error("Customer file should be rewritten");
+    auto customers = loadCustomers();
+    if (customers.size() != 2 || customers[1].name != "Jane Doe") throw std::runtime_error("Latest customer record should be kept");
+    if (!silentMode) std::cout << "[PASS] test_backgroundCompaction_customers\n";
+}
+
+// =============================
+// 📌 Snapshot Test Functions
+// =============================
+
+/**
+ * @brief Enables the table caches for the lifetime of a test and disables them again on exit.
+ */
+struct ScopedStoreCache {
+    ScopedStoreCache() { setStoreCacheEnabled(true); }
+    ~ScopedStoreCache() { setStoreCacheEnabled(false); }
+};
+
+/**
+ * @brief Tests writing a snapshot image and restoring every table from it.
+ * @note Verifies all five tables are restored and serve the same rows the text files hold.
+ * @throws std::runtime_error If the restored rows differ from the saved ones.
+ */
+void test_snapshotImage_roundTrip() {
+    clearTestFiles();
+    ScopedStoreCache cache;
+    saveCustomers({{1, "John", "1234567890", "john@example.com"}, {2, "Jane", "0987654321", "jane@example.com"}});
+    saveServices({{1, "Oil Change", 1499.5}});
+    saveHistory({{1, 1, 1, {1, 2}, "2023-10-10 10:00:00", 2000, 1, 12.5, 1750, "Pending"}});
+    if (!writeSnapshotImage()) throw std::runtime_error("Snapshot image should be written");
+
+    clearStoreCache();
+    if (restoreSnapshotImage() != 5) throw std::runtime_error("All five tables should be restored");
+    auto customers = loadCustomers();
+    if (customers.size() != 2 || customers[1].email != "jane@example.com") throw std::runtime_error("Customers should be restored");
+    auto services = loadServices();
+    if (services.size() != 1 || services[0].price != 1499.5) throw std::runtime_error("Services should be restored");
+    auto history = loadHistory();
+    if (history.size() != 1 || history[0].serviceIds.size() != 2 || history[0].discountPercent != 12.5 ||
+        history[0].status != "Pending") throw std::runtime_error("History should be restored");
+    if (!silentMode) std::cout << "[PASS] test_snapshotImage_roundTrip\n";
+}
+
+/**
+ * @brief Tests that a stale or corrupt snapshot image falls back to the text files.
+ * @note Edits the customer file after imaging and expects only that table to be rebuilt from text.
+ * @throws std::runtime_error If stale data is served or a corrupt image is trusted.
+ */
+void test_snapshotImage_staleFallback() {
+    clearTestFiles();
+    ScopedStoreCache cache;
+    saveCustomers({{1, "John", "1234567890", "john@example.com"}});
+    if (!writeSnapshotImage()) throw std::runtime_error("Snapshot image should be written");
+
+    std::ofstream ofs(CUSTOMER_FILE, std::ios::app);
+    ofs << "2|Jane|0987654321|jane@example.com\n";
+    ofs.close();
+    clearStoreCache();
+    if (restoreSnapshotImage() != 4) throw std::runtime_error("Only the unchanged tables should be restored");
+    if (loadCustomers().size() != 2) throw std::runtime_error("Edited table should be rebuilt from text");
+
+    std::ofstream bad(SNAPSHOT_FILE, std::ios::trunc | std::ios::binary);
+    bad << "CSS1\x01\x7f";
+    bad.close();
+    clearStoreCache();
+    if (restoreSnapshotImage() != 0) throw std::runtime_error("Corrupt image should be ignored");
+    if (loadCustomers().size() != 2) throw std::runtime_error("Loads should fall back to text");
+    if (!silentMode) std::cout << "[PASS] test_snapshotImage_staleFallback\n";
+}
+
+// =============================
+// 📌 History Log Test Functions
+// =============================
+
+/**
+ * @brief Path of the running test binary, used to start crash-test child processes.
+ */
+std::string testProgramPath;
+
+/**
+ * @brief Reads a whole test file into a string.
+ * @param path The file path.
+ * @return std::string The content (empty if the file is missing).
+ */
+std::string readTestFile(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::ostringstream buf;
+    buf << ifs.rdbuf();
+    return buf.str();
+}
+
+/**
+ * @brief Runs a request against the REST API, waiting for the response if it is deferred.
+ * @return bool True if the response came through the deferred callback.
+ */
+bool routeHttpRequestAndWait(const HttpRequest& req, int& status, std::string& body) {
+    auto reply = std::make_shared<std::promise<std::pair<int, std::string>>>();
+    auto answer = reply->get_future();
+    if (routeHttpRequest(req, status, body, [reply](int st, const std::string& b) { reply->set_value({st, b}); })) return false;
+    auto answered = answer.get();
+    status = answered.first;
+    body = answered.second;
+    return true;
+}
+
+/**
+ * @brief Writes a history file with two rows and logs a third booking plus a status change on top of it.
+ */
+void prepareLoggedHistory() {
+    clearTestFiles();
+    saveHistory({{1, 1, 1, {1}, "2023-10-10 10:00:00", 1000, -1, 0, 1000, "Pending"},
+                 {2, 2, 2, {2}, "2023-10-11 10:00:00", 1500, -1, 0, 1500, "Pending"}});
+    addHistoryEntry({3, 3, 3, {1, 2}, "2023-11-02 09:00:00", 2500, -1, 0, 2500, "Pending"});
+    setHistoryStatus(1, "Completed");
+}
+
+/**
+ * @brief Checks that the history holds the three rows written by prepareLoggedHistory.
+ * @throws std::runtime_error If a row or the status change is missing.
+ */
+void expectLoggedHistory(const std::string& context) {
+    auto history = loadHistory();
+    if (history.size() != 3) throw std::runtime_error(context + ": three rows expected");
+    if (history[0].status != "Completed" || history[2].historyId != 3) throw std::runtime_error(context + ": logged changes missing");
+}
+
+/**
+ * @brief Tests that bookings and status changes are logged and replayed on load.
+ * @note Verifies the history file is untouched by the logged changes while loads and partitions see them.
+ * @throws std::runtime_error If a logged change is lost or the history file is rewritten.
+ */
+void test_historyLog_replay() {
+    prepareLoggedHistory();
+    std::string base = readTestFile(HISTORY_FILE);
+    if (std::count(base.begin(), base.end(), '\n') != 2) throw std::runtime_error("Logged changes should not rewrite the history file");
+    if (historyLogBytes() == 0) throw std::runtime_error("Changes should be logged");
+    expectLoggedHistory("replay");
+    if (nextHistoryId() != 4) throw std::runtime_error("Logged bookings should reserve their IDs");
+    if (loadPartitionSummaries().size() != 2 || summarizeHistoryBetween("2023-11-01", "2023-11-30").rows != 1)
+        throw std::runtime_error("Partition of the logged booking should be refreshed");
+    if (setHistoryStatus(99, "Completed")) throw std::runtime_error("Unknown history ID should be rejected");
+    if (!silentMode) std::cout << "[PASS] test_historyLog_replay\n";
+}
+
+/**
+ * @brief Tests that a checkpoint folds the log into the history file and truncates the log.
+ * @throws std::runtime_error If records are lost or the log is not truncated.
+ */
+void test_checkpoint_truncatesLog() {
+    prepareLoggedHistory();
+    long long before = historyLogBytes();
+    CheckpointReport r = checkpointHistory();
+    if (!r.ran || r.recordsFolded != 2 || r.recordsCarried != 0) throw std::runtime_error("Checkpoint should fold both records");
+    if (r.logBytesAfter >= before) throw std::runtime_error("Log should be truncated");
+    std::string base = readTestFile(HISTORY_FILE);
+    if (std::count(base.begin(), base.end(), '\n') != 3) throw std::runtime_error("History file should hold all rows");
+    expectLoggedHistory("checkpoint");
+    if (checkpointHistory().ran) throw std::runtime_error("Empty log should not be checkpointed");
+
+    addHistoryEntry({4, 1, 1, {1}, "2023-11-05 09:00:00", 1000, -1, 0, 1000, "Pending"});
+    if (loadHistory().size() != 4) throw std::runtime_error("Bookings after a checkpoint should be logged again");
+    if (!silentMode) std::cout << "[PASS] test_checkpoint_truncatesLog\n";
+}
+
+/**
+ * @brief Tests recovery after the process is killed at each step of a checkpoint.
+ * @note Runs this binary as a child process that exits abruptly at a checkpoint failpoint, then checks that
+ *       loads see every change both before and after recoverHistoryLog() cleans up.
+ * @throws std::runtime_error If any crash point loses or duplicates a change.
+ */
+void test_checkpoint_crashRecovery() {
+    const CheckpointFailpoint points[] = {CheckpointFailpoint::AfterBaseStaged, CheckpointFailpoint::AfterLogStaged,
+                                          CheckpointFailpoint::AfterBaseInstalled};
+    for (CheckpointFailpoint point : points) {
+        std::string context = "failpoint " + std::to_string(static_cast<int>(point));
+        prepareLoggedHistory();
+        std::string command = "\"" + testProgramPath + "\" --checkpoint-crash " + std::to_string(static_cast<int>(point));
+        if (std::system(command.c_str()) == 0) throw std::runtime_error(context + ": child should have crashed");
+        if (!std::filesystem::exists(std::string(HISTORY_FILE) + ".tmp") && point != CheckpointFailpoint::AfterBaseInstalled)
+            throw std::runtime_error(context + ": staged history file should be left behind");
+
+        expectLoggedHistory(context + " before recovery");
+        int expected = point == CheckpointFailpoint::AfterBaseInstalled ? 0 : 2; // Already folded in once installed
+        if (recoverHistoryLog() != expected) throw std::runtime_error(context + ": unexpected number of records recovered");
+        expectLoggedHistory(context + " after recovery");
+        if (std::filesystem::exists(std::string(HISTORY_FILE) + ".tmp") || std::filesystem::exists(std::string(HISTORY_LOG_FILE) + ".next"))
+            throw std::runtime_error(context + ": staged files should be cleaned up");
+        if (checkpointHistory().ran) throw std::runtime_error(context + ": log should be empty after recovery");
+    }
+    if (!silentMode) std::cout << "[PASS] test_checkpoint_crashRecovery\n";
+}
+
+/**
+ * @brief Tests concurrent bookings through the group commit.
+ * @note Eight threads book at once; every booking must be durable in the log and the commit counters must
+ *       account for each record in no more batches than records.
+ * @throws std::runtime_error If a booking is lost or the counters disagree.
+ */
+void test_groupCommit_concurrentBookings() {
+    clearTestFiles();
+    const int threads = 8, perThread = 20;
+    HistoryLogCommitStats before = historyLogCommitStats();
+    std::vector<std::thread> desks;
+    for (int t = 0; t < threads; ++t) {
+        desks.emplace_back([t] {
+            for (int i = 0; i < perThread; ++i) {
+                int id = t * perThread + i + 1;
+                addHistoryEntry({id, t + 1, t + 1, {1}, "2023-12-01 10:00:00", 1000, -1, 0, 1000, "Pending"});
+            }
+        });
+    }
+    for (auto& d : desks) d.join();
+
+    HistoryLogCommitStats after = historyLogCommitStats();
+    if (after.records - before.records != threads * perThread) throw std::runtime_error("Every booking should be committed");
+    if (after.batches - before.batches > threads * perThread) throw std::runtime_error("Batches cannot outnumber records");
+    auto history = loadHistory();
+    if (history.size() != static_cast<size_t>(threads * perThread)) throw std::runtime_error("Every booking should be in the history");
+    std::string log = readTestFile(HISTORY_LOG_FILE);
+    if (std::count(log.begin(), log.end(), '\n') != threads * perThread + 1) throw std::runtime_error("Every booking should be logged once");
+    if (summarizeHistoryBetween("2023-12-01", "2023-12-31").rows != threads * perThread) throw std::runtime_error("Partition should hold every booking");
+    if (!silentMode) std::cout << "[PASS] test_groupCommit_concurrentBookings\n";
+}
+
+/**
+ * @brief Tests that the bounded queue delivers every value from several producers exactly once and reports full.
+ */
+void test_mpscQueue_multiProducer() {
+    MpscQueue<int> small;
+    initMpscQueue(small, 4);
+    for (int i = 0; i < 4; ++i) {
+        if (!mpscTryPush(small, i)) throw std::runtime_error("Queue should accept up to its capacity");
+    }
+    int extra = 99;
+    if (mpscTryPush(small, extra)) throw std::runtime_error("Full queue should refuse a push");
+
+    const int producers = 4, perProducer = 20000;
+    MpscQueue<int> q;
+    initMpscQueue(q, 64);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&q, p] {
+            for (int i = 0; i < perProducer; ++i) {
+                int v = p * perProducer + i;
+                while (!mpscTryPush(q, v)) std::this_thread::yield();
+            }
+        });
+    }
+    std::vector<int> lastSeen(producers, -1);
+    std::vector<char> seen(producers * perProducer, 0);
+    for (int received = 0; received < producers * perProducer;) {
+        int v;
+        if (!mpscTryPop(q, v)) { std::this_thread::yield(); continue; }
+        if (seen[v]) throw std::runtime_error("Value delivered twice");
+        seen[v] = 1;
+        int p = v / perProducer;
+        if (v <= lastSeen[p]) throw std::runtime_error("Values from one producer should arrive in order");
+        lastSeen[p] = v;
+        received++;
+    }
+    for (auto& t : threads) t.join();
+    int v;
+    if (mpscTryPop(q, v)) throw std::runtime_error("Queue should be empty");
+    if (!silentMode) std::cout << "[PASS] test_mpscQueue_multiProducer\n";
+}
+
+/**
+ * @brief Tests that mutations submitted from many threads are all written by the storage writer.
+ */
+void test_storageWriter_concurrentMutations() {
+    clearTestFiles();
+    const int threads = 4, perThread = 25;
+    if (!startStorageWriter(16)) throw std::runtime_error("Writer should start");
+    std::atomic<int> acknowledged{0}, refused{0};
+    std::vector<std::thread> desks;
+    for (int t = 0; t < threads; ++t) {
+        desks.emplace_back([t, &acknowledged, &refused] {
+            for (int i = 0; i < perThread; ++i) {
+                Mutation c;
+                c.type = MutationType::AddCustomer;
+                c.customer = {0, "Desk" + std::to_string(t), "98765" + std::to_string(10000 + i), "d@x.com"};
+                c.done = [&acknowledged](bool ok, int, const std::string&) { if (ok) acknowledged++; };
+                if (!submitMutation(c)) refused++;
+                Mutation b;
+                b.type = MutationType::AddBooking;
+                b.booking = {0, t + 1, t + 1, {1}, "2023-12-01 10:00:00", 1000, -1, 0, 1000, "Pending"};
+                b.done = [&acknowledged](bool ok, int, const std::string&) { if (ok) acknowledged++; };
+                if (!submitMutation(b)) refused++;
+            }
+        });
+    }
+    for (auto& d : desks) d.join();
+    stopStorageWriter();
+
+    if (refused != 0) throw std::runtime_error("Running writer should queue every mutation");
+    Mutation late;
+    if (submitMutation(late)) throw std::runtime_error("Stopped writer should refuse mutations");
+    if (acknowledged != 2 * threads * perThread) throw std::runtime_error("Every mutation should be acknowledged");
+    auto customers = loadCustomers();
+    if (customers.size() != static_cast<size_t>(threads * perThread)) throw std::runtime_error("Every customer should be saved");
+    std::vector<int> ids;
+    for (const auto& c : customers) ids.push_back(c.id);
+    std::sort(ids.begin(), ids.end());
+    if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) throw std::runtime_error("Customer IDs should be unique");
+    auto history = loadHistory();
+    if (history.size() != static_cast<size_t>(threads * perThread)) throw std::runtime_error("Every booking should be saved");
+    ids.clear();
+    for (const auto& h : history) ids.push_back(h.historyId);
+    std::sort(ids.begin(), ids.end());
+    if (std::adjacent_find(ids.begin(), ids.end()) != ids.end() || ids.front() != 1) throw std::runtime_error("History IDs should be assigned once each");
+
+    if (!startStorageWriter(16)) throw std::runtime_error("Writer should restart");
+    Mutation s;
+    s.type = MutationType::SetStatus;
+    s.historyId = 1;
+    s.status = "Completed";
+    submitMutation(s);
+    stopStorageWriter();
+    history = loadHistory();
+    auto it = std::find_if(history.begin(), history.end(), [](const ServiceHistory& h) { return h.historyId == 1; });
+    if (it == history.end() || it->status != "Completed") throw std::runtime_error("Status change should be written");
+
+    StorageWriterStats stats = storageWriterStats();
+    if (stats.written < 2 * threads * perThread + 1 || stats.failed != 0) throw std::runtime_error("Stats should count written mutations");
+    if (latencyPercentileMicros(stats, 0.5) <= 0) throw std::runtime_error("Latency histogram should be filled");
+    if (!silentMode) std::cout << "[PASS] test_storageWriter_concurrentMutations\n";
+}
+
+/**
+ * @brief Tests parallelFor, nested waits and stealing on a pool of four workers.
+ */
+void test_threadPool_parallelForAndStealing() {
+    stopThreadPool();
+    startThreadPool(4);
+    if (threadPoolSize() != 4) throw std::runtime_error("Pool should have four workers");
+
+    std::vector<int> hits(10000, 0);
+    parallelFor(hits.size(), [&hits](size_t i) { hits[i]++; });
+    if (std::count(hits.begin(), hits.end(), 1) != 10000) throw std::runtime_error("Every iteration should run once");
+
+    // Tasks waiting on tasks they submit must not deadlock the pool
+    std::atomic<long long> sum{0};
+    std::vector<TaskHandle> outer;
+    for (int t = 0; t < 8; ++t) {
+        outer.push_back(submitTask([&sum](const std::atomic<bool>&) {
+            parallelFor(100, [&sum](size_t i) { sum += static_cast<long long>(i); });
+        }));
+    }
+    for (auto& t : outer) {
+        if (!waitTask(t)) throw std::runtime_error("Nested task should complete");
+    }
+    if (sum != 8 * 4950) throw std::runtime_error("Nested loops should all run");
+
+    // Tasks queued by a busy worker can only run if another worker steals them
+    long long stolenBefore = threadPoolStats().stolen;
+    std::atomic<int> done{0};
+    TaskHandle producer = submitTask([&done](const std::atomic<bool>&) {
+        for (int i = 0; i < 8; ++i) submitTask([&done](const std::atomic<bool>&) { done++; });
+        while (done < 8) std::this_thread::yield();
+    });
+    waitTask(producer);
+    if (threadPoolStats().stolen - stolenBefore < 8) throw std::runtime_error("Idle workers should steal queued tasks");
+
+    bool threw = false;
+    try {
+        parallelFor(16, [](size_t i) { if (i == 11) throw std::runtime_error("boom"); });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    if (!threw) throw std::runtime_error("Exception in a loop body should reach the caller");
+    if (!silentMode) std::cout << "[PASS] test_threadPool_parallelForAndStealing\n";
+}
+
+/**
+ * @brief Tests that cancelling skips a queued task and stops a running one.
+ */
+void test_threadPool_cancellation() {
+    stopThreadPool();
+    startThreadPool(2);
+    std::atomic<bool> release{false};
+    std::atomic<int> started{0};
+    std::vector<TaskHandle> blockers;
+    for (int i = 0; i < 2; ++i) {
+        blockers.push_back(submitTask([&](const std::atomic<bool>&) {
+            started++;
+            while (!release) std::this_thread::yield();
+        }));
+    }
+    while (started < 2) std::this_thread::yield();
+
+    std::atomic<bool> victimRan{false};
+    TaskHandle victim = submitTask([&victimRan](const std::atomic<bool>&) { victimRan = true; });
+    cancelTask(victim);
+    release = true;
+    if (waitTask(victim) || victimRan) throw std::runtime_error("Cancelled queued task should be skipped");
+    for (auto& b : blockers) waitTask(b);
+
+    std::atomic<bool> spinning{false};
+    TaskHandle longTask = submitTask([&spinning](const std::atomic<bool>& cancelled) {
+        spinning = true;
+        while (!cancelled) std::this_thread::yield();
+    });
+    while (!spinning) std::this_thread::yield();
+    cancelTask(longTask);
+    if (waitTask(longTask)) throw std::runtime_error("Cancelled running task should not count as completed");
+    if (threadPoolStats().cancelled < 1) throw std::runtime_error("Skipped task should be counted");
+    stopThreadPool();
+    if (!silentMode) std::cout << "[PASS] test_threadPool_cancellation\n";
+}
+
+#ifndef _WIN32
+/**
+ * @brief Opens a client connection to the test server socket.
+ * @return int The connected socket, or -1 on failure.
+ */
+int connectTestServer() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::string path = SERVER_SOCKET;
+    path.copy(addr.sun_path, path.size());
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Reads reply lines from a server connection.
+ * @param fd The socket.
+ * @param count Number of lines to read.
+ * @return std::vector<std::string> The lines, without newlines (fewer if the server closed the connection).
+ */
+std::vector<std::string> readServerLines(int fd, size_t count) {
+    std::vector<std::string> lines;
+    std::string buf;
+    char chunk[4096];
+    while (lines.size() < count) {
+        size_t nl = buf.find('\n');
+        if (nl != std::string::npos) {
+            lines.push_back(buf.substr(0, nl));
+            buf.erase(0, nl + 1);
+            continue;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buf.append(chunk, static_cast<size_t>(n));
+    }
+    return lines;
+}
+
+/**
+ * @brief Tests that one event loop holds many idle connections and answers pipelined requests in order.
+ */
+void test_server_pipelinedRequests() {
+    clearTestFiles();
+    ensureDefaultServices();
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com"}});
+    saveVehicles({{1, 1, "KA01AB1234", "Swift", "Red"}});
+    if (!startServer(SERVER_SOCKET)) throw std::runtime_error("Server should start");
+
+    std::vector<int> idle;
+    for (int i = 0; i < 300; ++i) {
+        int fd = connectTestServer();
+        if (fd < 0) throw std::runtime_error("Idle client should connect");
+        idle.push_back(fd);
+    }
+    int fd = connectTestServer();
+    std::string pipeline = "PING\nCUSTOMER 1\nBOOK 1 1 1,2\nHISTORY 1\nCUSTOMER 99\nBOOK 1 2 1\nNOPE\nSTATUS 1 Completed\nHISTORY 1\n";
+    if (send(fd, pipeline.data(), pipeline.size(), 0) != static_cast<ssize_t>(pipeline.size())) throw std::runtime_error("Send failed");
+    auto lines = readServerLines(fd, 11);
+    std::vector<std::string> expected = {"OK PONG", "OK 1|Asha|9876543210|asha@x.com", "OK 1", "OK 1", "", "ERR customer not found",
+                                         "ERR vehicle not found or not owned by customer", "ERR unknown command", "OK 1", "OK 1", ""};
+    if (lines.size() != 11) throw std::runtime_error("Every request should be answered");
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (!expected[i].empty() && lines[i] != expected[i]) throw std::runtime_error("Reply " + std::to_string(i) + " was " + lines[i]);
+    }
+    if (lines[4].compare(0, 4, "1|1|") != 0 || lines[4].find("|Pending") == std::string::npos) throw std::runtime_error("History should show the booking");
+    if (lines[10].find("|Completed") == std::string::npos) throw std::runtime_error("History should show the status change");
+
+    ServerStats stats = serverStats();
+    if (stats.openConnections != 301 || stats.deferred != 2) throw std::runtime_error("Stats should count connections and writes");
+    for (int c : idle) close(c);
+    close(fd);
+    stopServer();
+    stopStorageWriter();
+    if (serverStats().openConnections != 0) throw std::runtime_error("Stopping should close every connection");
+    auto history = loadHistory();
+    if (history.size() != 1 || history[0].status != "Completed" || history[0].serviceIds.size() != 2) throw std::runtime_error("Booking should be saved");
+    if (!silentMode) std::cout << "[PASS] test_server_pipelinedRequests\n";
+}
+
+/**
+ * @brief Reads HTTP responses until the server closes the connection.
+ * @param fd The socket.
+ * @return std::vector<std::pair<int, std::string>> Status code and body of each response.
+ */
+std::vector<std::pair<int, std::string>> readHttpResponses(int fd) {
+    std::string buf;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) buf.append(chunk, static_cast<size_t>(n));
+    std::vector<std::pair<int, std::string>> responses;
+    size_t pos = 0;
+    while (pos < buf.size()) {
+        size_t headEnd = buf.find("\r\n\r\n", pos);
+        size_t cl = buf.find("Content-Length: ", pos);
+        if (headEnd == std::string::npos || cl == std::string::npos) break;
+        size_t length = std::stoul(buf.substr(cl + 16));
+        responses.push_back({std::stoi(buf.substr(pos + 9, 3)), buf.substr(headEnd + 4, length)});
+        pos = headEnd + 4 + length;
+    }
+    return responses;
+}
+
+/**
+ * @brief Tests the HTTP API over one keep-alive connection with pipelined requests.
+ */
+void test_httpApi_keepAlivePipelining() {
+    clearTestFiles();
+    ensureDefaultServices();
+    ensureDefaultDiscounts();
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com"}});
+    saveVehicles({{1, 1, "KA01AB1234", "Swift", "Red"}});
+    if (!startServer(SERVER_SOCKET, 0) || serverHttpPort() <= 0) throw std::runtime_error("HTTP API should start");
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(serverHttpPort()));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) throw std::runtime_error("Client should connect");
+    std::string booking = "{\"customerId\": 1, \"vehicleId\": 1, \"serviceIds\": [1, 2]}";
+    std::string status = "{\"status\": \"Completed\"}";
+    std::string customer = "{\"name\": \"Ravi \\\"RK\\\"\", \"phone\": \"9000000000\", \"email\": \"r@x.com\"}";
+    std::string vehicle = "{\"customerId\": 2, \"regNo\": \"KA05XY0001\", \"model\": \"Baleno\", \"color\": \"Grey\"}";
+    std::string stray = "{\"customerId\": 9, \"regNo\": \"KA05XY0002\"}";
+    std::string pipeline =
+        "GET /customers/1 HTTP/1.1\r\nHost: x\r\n\r\n"
+        "POST /bookings HTTP/1.1\r\nContent-Length: " + std::to_string(booking.size()) + "\r\n\r\n" + booking +
+        "GET /bills/1 HTTP/1.1\r\n\r\n"
+        "GET /nowhere HTTP/1.1\r\n\r\n"
+        "PUT /bookings/1/status HTTP/1.1\r\nContent-Length: " + std::to_string(status.size()) + "\r\n\r\n" + status +
+        "POST /customers HTTP/1.1\r\nContent-Length: " + std::to_string(customer.size()) + "\r\n\r\n" + customer +
+        "POST /vehicles HTTP/1.1\r\nContent-Length: " + std::to_string(vehicle.size()) + "\r\n\r\n" + vehicle +
+        "POST /vehicles HTTP/1.1\r\nContent-Length: " + std::to_string(stray.size()) + "\r\n\r\n" + stray +
+        "DELETE /services HTTP/1.1\r\n\r\n"
+        "GET /customers/1/bookings HTTP/1.1\r\nConnection: close\r\n\r\n"
+        "GET /customers HTTP/1.1\r\n\r\n"; // After "Connection: close": never answered
+    if (send(fd, pipeline.data(), pipeline.size(), 0) != static_cast<ssize_t>(pipeline.size())) throw std::runtime_error("Send failed");
+    auto responses = readHttpResponses(fd);
+    close(fd);
+
+    std::vector<int> codes;
+    for (const auto& r : responses) codes.push_back(r.first);
+    if (codes != std::vector<int>{200, 201, 200, 404, 200, 201, 201, 400, 405, 200}) throw std::runtime_error("Unexpected status codes");
+    if (responses[0].second != "{\"id\":1,\"name\":\"Asha\",\"phone\":\"9876543210\",\"email\":\"asha@x.com\",\"branchId\":0}") {
+        throw std::runtime_error("Customer JSON is wrong: " + responses[0].second);
+    }
+    if (responses[1].second.find("{\"id\":1,\"customerId\":1,\"vehicleId\":1,\"serviceIds\":[1,2],\"dateTime\":\"20") != 0) throw std::runtime_error("Booking JSON is wrong");
+    if (responses[2].second.find("\"items\":[{\"id\":1,") == std::string::npos) throw std::runtime_error("Bill should list the services");
+    if (responses[4].second.find("\"status\":\"Completed\"") == std::string::npos) throw std::runtime_error("Status change should be echoed");
+    if (responses[5].second.find("\"name\":\"Ravi \\\"RK\\\"\"") == std::string::npos) throw std::runtime_error("New customer should be echoed");
+    if (responses[6].second != "{\"id\":2,\"customerId\":2,\"regNo\":\"KA05XY0001\",\"model\":\"Baleno\",\"color\":\"Grey\",\"branchId\":0}") {
+        throw std::runtime_error("New customer's vehicle should be echoed: " + responses[6].second);
+    }
+    if (responses[9].second.find("\"status\":\"Completed\"") == std::string::npos) throw std::runtime_error("Bookings should show the change");
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    std::string bad = "NONSENSE\r\n\r\n";
+    send(fd, bad.data(), bad.size(), 0);
+    responses = readHttpResponses(fd);
+    close(fd);
+    if (responses.size() != 1 || responses[0].first != 400) throw std::runtime_error("Malformed request should get 400 and a close");
+
+    stopServer();
+    stopStorageWriter();
+    if (loadCustomers().size() != 2 || loadVehicles().size() != 2 || loadHistory().size() != 1) throw std::runtime_error("Writes should be saved");
+    if (!silentMode) std::cout << "[PASS] test_httpApi_keepAlivePipelining\n";
+}
+#endif
+
+/**
+ * @brief Tests that table saves and bookings reach the change feed in order with their before and after states,
+ *        and that a reader can resume from any sequence number in a long feed.
+ */
+void test_changeFeed_mutationsInOrder() {
+    clearTestFiles();
+    long long start = lastChangeSeq();
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com"}, {2, "Ravi", "9123456780", "ravi@x.com"}});
+    saveCustomers({{1, "Asha K", "9876543210", "asha@x.com"}});
+    addHistoryEntry({1, 1, 1, {1}, "2024-01-05 10:00:00", 1000, -1, 0, 1000, "Pending"});
+    if (!setHistoryStatus(1, "Completed")) throw std::runtime_error("Status change should succeed");
+
+    auto events = readChanges(start + 1, 100);
+    const std::vector<std::pair<std::string, std::string>> expected = {
+        {"customer", "insert"}, {"customer", "insert"}, {"customer", "update"}, {"customer", "delete"},
+        {"booking", "insert"}, {"booking", "update"}};
+    if (events.size() != expected.size()) throw std::runtime_error("Expected one event per change");
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (events[i].seq != start + 1 + static_cast<long long>(i)) throw std::runtime_error("Sequence numbers should be consecutive");
+        if (events[i].entity != expected[i].first || events[i].op != expected[i].second) throw std::runtime_error("Events out of order");
+    }
+    if (events[2].before != "1|Asha|9876543210|asha@x.com" || events[2].after != "1|Asha K|9876543210|asha@x.com") {
+        throw std::runtime_error("Update should carry both states");
+    }
+    if (!events[3].after.empty() || events[3].before.find("2|Ravi") != 0) throw std::runtime_error("Delete should carry the old state");
+    if (!events[4].before.empty() || events[5].after.find("|Completed") == std::string::npos) throw std::runtime_error("Booking states are wrong");
+    if (lastChangeSeq() != events.back().seq) throw std::runtime_error("Last sequence number should be durable");
+
+    // A long feed: resuming anywhere must land on exactly the requested event
+    std::vector<ChangeEvent> filler;
+    for (int i = 0; i < 20000; ++i) filler.push_back({0, "test", "insert", "", "row|" + std::to_string(i) + "|a \"quoted\" value"});
+    long long last = publishChanges(filler);
+    if (!flushChanges(last)) throw std::runtime_error("Flush should succeed");
+    for (long long from : {last - 19999, last - 12345, last - 1, last}) {
+        auto page = readChanges(from, 3);
+        if (page.empty() || page[0].seq != from) throw std::runtime_error("Resume should start at the requested event");
+        if (page[0].after != "row|" + std::to_string(from - (last - 19999)) + "|a \"quoted\" value") throw std::runtime_error("Payload should round-trip");
+        if (page.size() != static_cast<size_t>(std::min<long long>(3, last - from + 1))) throw std::runtime_error("Page size is wrong");
+    }
+    if (!readChanges(last + 1, 10).empty()) throw std::runtime_error("A caught-up reader should get nothing");
+    if (!silentMode) std::cout << "[PASS] test_changeFeed_mutationsInOrder\n";
+}
+
+/**
+ * @brief Tests JSON escaping, number formatting and parsing of request bodies.
+ */
+void test_json_roundTrip() {
+    std::string out;
+    appendJsonString(out, "Tab\tQuote\"Back\\Ctl\x01 caf\xc3\xa9");
+    if (out != "\"Tab\\tQuote\\\"Back\\\\Ctl\\u0001 caf\xc3\xa9\"") throw std::runtime_error("Escaping is wrong: " + out);
+    out.clear();
+    appendJsonNumber(out, 1499.5);
+    out += ',';
+    appendJsonNumber(out, -42LL);
+    out += ',';
+    appendJsonNumber(out, 0.1 + 0.2);
+    if (out != "1499.5,-42,0.30000000000000004") throw std::runtime_error("Numbers are wrong: " + out);
+
+    std::map<std::string, std::string> f;
+    if (!parseJsonObject(" {\"name\": \"A\\\"B\\u00e9\", \"ids\": [1, 2 ,3], \"n\": -7, \"o\": {\"x\": [true]}} ", f)) {
+        throw std::runtime_error("Object should parse");
+    }
+    if (f["name"] != "A\"B\xc3\xa9" || f["n"] != "-7" || f["o"] != "{\"x\": [true]}") throw std::runtime_error("Members are wrong");
+    std::vector<int> ids;
+    if (!parseJsonIntArray(f["ids"], ids) || ids != std::vector<int>{1, 2, 3}) throw std::runtime_error("Array should parse");
+    f.clear();
+    if (parseJsonObject("{\"a\": 1,}", f) || parseJsonObject("[1]", f) || parseJsonObject("{\"a\": 1} x", f)) {
+        throw std::runtime_error("Malformed objects should be rejected");
+    }
+    if (!silentMode) std::cout << "[PASS] test_json_roundTrip\n";
+}
+
 /**
  * @brief Macro to run a test function and report its result.
  * @param testFunc The test function to execute.
@@ -783,12 +1791,842 @@ void test_addHistoryEntry_emptyServiceIds() {
         } \
     } while(0)
 
+/**
+ * @brief Runs this test program as a standby until it has applied a primary's changes (child process mode).
+ * @param socketPath The primary's replication socket.
+ * @param seq The primary sequence number to reach.
+ * @param snapshots The number of table snapshots the run should need.
+ * @return int 0 once caught up with the expected number of snapshots; non-zero otherwise.
+ */
+int runStandbyUntil(const std::string& socketPath, long long seq, long long snapshots) {
+    if (!startStandby(socketPath)) return 1;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (replicationStats().eventsBehind > 0 || replicationStats().appliedSeq < seq) {
+        if (std::chrono::steady_clock::now() > deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ReplicationStats s = replicationStats();
+    promoteStandby();
+    checkpointHistory(); // Fold the applied bookings into the history file for comparison
+    if (s.appliedSeq < seq || s.eventsBehind != 0) return 2;
+    return s.snapshots == snapshots ? 0 : 3;
+}
+
+/**
+ * @brief Tests that a standby process copies the primary's tables, resumes from the change feed after a
+ *        restart and ends with identical data files.
+ */
+void test_replication_standbyCatchesUp() {
+    namespace fs = std::filesystem;
+    clearTestFiles();
+    fs::remove_all(STANDBY_DIR);
+    fs::create_directories(std::string(STANDBY_DIR) + "/tests");
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com"}, {2, "Ravi", "9123456780", "ravi@x.com"}});
+    saveVehicles({{1, 1, "KA01AB1234", "Swift", "Red"}});
+    saveTaxClasses({{1, "Services", 1800}, {2, "Parts", 2800}, {3, "Luxury", 4000}});
+    saveParts({{1, "Oil Filter", 10}, {2, "Brake Pad", 4}});
+    saveServiceParts({{1, 1, 1}, {2, 2, 2}});
+    std::vector<PartShortage> shortages;
+    Appointment appt;
+    std::string error;
+    if (!reserveParts(1, {1, 2}, shortages) || !bookAppointment(1, 2, "2024-02-01 09:00", appt, error)) {
+        throw std::runtime_error("Booking 1 should reserve its parts and a bay");
+    }
+    addHistoryEntry({1, 1, 1, {1, 2}, "2024-02-01 09:00:00", 2000, -1, 0, 2000, "Pending"});
+    addHistoryEntry({5, 2, 1, {1}, "2023-06-01 09:00:00", 800, -1, 0, 800, "Completed"});
+    if (archiveCompletedHistory("2024-01-01") != 1) throw std::runtime_error("June should be archived before the standby connects");
+
+    std::string socketPath = fs::absolute(REPLICATION_SOCKET).string();
+    std::string program = fs::absolute(testProgramPath).string();
+    if (!startReplicationSource(socketPath)) throw std::runtime_error("Replication source should start");
+    auto runStandby = [&](long long snapshots) {
+        std::string command = std::string("cd ") + STANDBY_DIR + " && \"" + program + "\" --standby-until \"" + socketPath +
+                              "\" " + std::to_string(lastChangeSeq()) + " " + std::to_string(snapshots);
+        return std::system(command.c_str());
+    };
+    int first = runStandby(1);
+
+    // Changes made while the standby is down reach it through the feed, without another snapshot
+    saveCustomers({{1, "Asha K", "9876543210", "asha@x.com"}, {3, "Meena", "9000000001", "meena@x.com"}});
+    setHistoryStatus(1, "Completed"); // Consumes booking 1's parts
+    if (!reserveParts(2, {2}, shortages) || !bookAppointment(2, 1, "2024-02-02 11:30", appt, error)) {
+        throw std::runtime_error("Booking 2 should reserve its parts and a bay");
+    }
+    addHistoryEntry({2, 3, 1, {2}, "2024-02-02 11:30:00", 1500, -1, 0, 1500, "Pending"});
+    receiveParts(1, 5);
+    saveServiceParts({{1, 1, 1}, {2, 2, 1}});
+    saveTaxClasses({{1, "Services", 1800}, {2, "Parts", 2800}});
+    addHistoryEntry({6, 3, 1, {2}, "2023-07-01 10:00:00", 900, -1, 0, 900, "Pending"});
+    setHistoryStatus(6, "Completed");
+    if (archiveCompletedHistory("2024-01-01") != 1) throw std::runtime_error("July should be archived through the feed");
+    int second = runStandby(0);
+    stopReplicationSource();
+    if (first != 0) throw std::runtime_error("New standby should copy a snapshot and catch up");
+    if (second != 0) throw std::runtime_error("Restarted standby should resume from the change feed");
+
+    checkpointHistory();
+    std::string index = std::string(ARCHIVE_DIR) + "/index.txt", june = std::string(ARCHIVE_DIR) + "/2023-06.arc",
+                july = std::string(ARCHIVE_DIR) + "/2023-07.arc";
+    for (const std::string& f : {std::string(CUSTOMER_FILE), std::string(VEHICLE_FILE), std::string(HISTORY_FILE), index, june, july,
+                                 std::string(TAX_CLASS_FILE), std::string(PARTS_FILE), std::string(SERVICE_PARTS_FILE)}) {
+        std::string primary = readTestFile(f), standby = readTestFile(std::string(STANDBY_DIR) + "/" + f);
+        if (primary.empty() || primary != standby) throw std::runtime_error("Standby copy differs: " + f);
+    }
+    // The reservation and appointment logs differ in history, so compare what they leave open
+    auto openEntries = [](const std::string& content) {
+        std::map<std::string, std::string> open;
+        std::istringstream in(content);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.size() < 3) continue;
+            std::string id = line.substr(2, line.find('|', 2) - 2);
+            if (line[0] == 'R' || line[0] == 'A') open[id] = line;
+            else open.erase(id);
+        }
+        return open;
+    };
+    for (const std::string& f : {std::string(RESERVATION_FILE), std::string(APPOINTMENT_FILE)}) {
+        auto primary = openEntries(readTestFile(f)), standby = openEntries(readTestFile(std::string(STANDBY_DIR) + "/" + f));
+        if (primary.size() != (f == RESERVATION_FILE ? 1u : 2u) || primary != standby) throw std::runtime_error("Standby copy differs: " + f);
+    }
+    if (readTestFile(PARTS_FILE) != "1|Oil Filter|14\n2|Brake Pad|2\n") throw std::runtime_error("Booking 1 should have consumed its parts once");
+    fs::remove_all(STANDBY_DIR);
+    if (!silentMode) std::cout << "[PASS] test_replication_standbyCatchesUp\n";
+}
+
+/**
+ * @brief Tests that rows are sharded into per-branch stores on every write, that one branch loads and compacts
+ *        on its own, and that the per-branch summaries add up to the global one.
+ */
+void test_branchStores_shardAndAggregate() {
+    clearTestFiles();
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com", 0}, {2, "Ravi", "9123456780", "ravi@x.com", 1},
+                   {3, "Meena", "9000000000", "meena@x.com", 2}});
+    saveVehicles({{1, 1, "KA01AB1234", "Swift", "Red", 0}, {2, 2, "KA02CD5678", "City", "Blue", 1},
+                  {3, 3, "KA03EF9012", "Creta", "White", 2}});
+    addHistoryEntry({1, 1, 1, {1}, "2024-01-05 10:00:00", 1000, -1, 0, 1000, "Pending", 0});
+    addHistoryEntry({2, 2, 2, {1}, "2024-01-06 11:00:00", 2000, -1, 0, 2000, "Pending", 1});
+    addHistoryEntry({3, 3, 3, {1}, "2024-02-01 09:00:00", 500, -1, 0, 500, "Pending", 2});
+    addHistoryEntry({4, 2, 2, {1}, "2024-01-20 12:00:00", 700, -1, 0, 700, "Pending", 1});
+    if (!setHistoryStatus(2, "Completed")) throw std::runtime_error("Status change should succeed");
+
+    auto customers = loadCustomers();
+    if (customers.size() != 3 || customers[1].branchId != 1 || loadHistory()[3].branchId != 1) {
+        throw std::runtime_error("Branch should survive save and load");
+    }
+    if (formatCustomerLine(customers[0]) != "1|Asha|9876543210|asha@x.com" || formatCustomerLine(customers[2]).back() != '2') {
+        throw std::runtime_error("Only rows of other branches should carry the branch field");
+    }
+    if (listBranches() != std::vector<int>{0, 1, 2}) throw std::runtime_error("Every branch should have a store");
+    auto ravi = loadBranchCustomers(1);
+    if (ravi.size() != 1 || ravi[0].id != 2 || loadBranchVehicles(2).size() != 1) throw std::runtime_error("Branch tables are wrong");
+    auto history = loadBranchHistory(1);
+    if (history.size() != 2 || history[0].historyId != 2 || history[0].status != "Completed") {
+        throw std::runtime_error("Branch history should hold the latest row per booking");
+    }
+
+    auto branches = summarizeAllBranches("2024-01-01", "2024-01-31");
+    PartitionSummary total = emptyPartitionSummary("all");
+    for (const auto& b : branches) mergePartitionSummary(total, b.history);
+    PartitionSummary global = summarizeHistoryBetween("2024-01-01", "2024-01-31");
+    if (branches.size() != 3 || branches[1].history.rows != 2 || branches[1].history.totalSum != 2700 || branches[2].history.rows != 0) {
+        throw std::runtime_error("Branch summaries are wrong");
+    }
+    if (total.rows != global.rows || total.totalSum != global.totalSum || total.completedCount != 1) {
+        throw std::runtime_error("Branches should add up to the global total");
+    }
+
+    auto reports = compactBranchStore(1);
+    if (reports.size() != 3 || reports[2].rowsRead != 3 || reports[2].rowsKept != 2) throw std::runtime_error("Compaction should drop the superseded row");
+    if (loadBranchHistory(1)[0].status != "Completed") throw std::runtime_error("Compaction should keep the latest row");
+
+    // Archived bookings still count towards their branch
+    if (archiveCompletedHistory("2024-02-01") != 1 || loadBranchHistory(1).size() != 1) throw std::runtime_error("Booking 2 should be archived");
+    branches = summarizeAllBranches("2024-01-01", "2024-01-31");
+    if (branches[1].history.rows != 2 || branches[1].history.totalSum != 2700 || summarizeBranch(1, "2024-01-01", "2024-01-31").history.completedCount != 1) {
+        throw std::runtime_error("Branch summaries should include archived bookings");
+    }
+
+    // A customer moving branch leaves the old branch's file empty
+    customers[2].branchId = 1;
+    saveCustomers(customers);
+    if (!loadBranchCustomers(2).empty() || loadBranchCustomers(1).size() != 2) throw std::runtime_error("Moved customer should change store");
+
+    // A stale customer shard left by a crash is rebuilt at startup
+    { std::ofstream stale(branchStorePath(1, "customers.txt"), std::ios::trunc); }
+    ensureBranchStores();
+    if (loadBranchCustomers(1).size() != 2 || loadBranchVehicles(1).size() != 1) throw std::runtime_error("Startup should rebuild every shard");
+    if (!silentMode) std::cout << "[PASS] test_branchStores_shardAndAggregate\n";
+}
+
+/**
+ * @brief Reads a whole file into a string.
+ */
+static std::string readWholeFile(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+/**
+ * @brief Tests batch invoicing by history ID range (across the hot and archive tiers) and by date range, in
+ *        both layouts.
+ */
+void test_invoices_batchRender() {
+    clearTestFiles();
+    saveServices({{1, "Oil Change", 1500}, {2, "Brake <Check>", 800}});
+    saveCustomers({{1, "Asha & Co", "9876543210", "asha@x.com"}});
+    saveVehicles({{1, 1, "KA01AB1234", "Swift", "Red"}});
+    saveHistory({
+        {1, 1, 1, {1, 2}, "2023-10-10 10:00:00", 2300, 1, 10, 2070, "Completed"},
+        {2, 1, 1, {1}, "2024-02-01 09:00:00", 1500, -1, 0, 1500, "Pending"},
+        {3, 9, 9, {2}, "2024-02-05 09:00:00", 800, -1, 0, 800, "Pending"}
+    });
+    if (archiveCompletedHistory("2024-01-01") != 1) throw std::runtime_error("Should archive one row");
+
+    auto byId = loadHistoryByIdRange(1, 2);
+    if (byId.size() != 2 || byId[0].historyId != 1 || byId[1].historyId != 2) throw std::runtime_error("ID range should cover both tiers");
+    std::string dir = std::string(INVOICE_DIR) + "/ids";
+    auto report = writeInvoices(byId, InvoiceFormat::Text, dir);
+    if (report.invoices != 2 || report.failed != 0) throw std::runtime_error("Both invoices should be written");
+    std::string text = readWholeFile(dir + "/INV-000001.txt");
+    if (text.find("INVOICE INV-000001\n") != 0 || text.find("Customer: Asha & Co (9876543210) #1") == std::string::npos ||
+        text.find("Discount (10%)") == std::string::npos || text.find("-Rs.230.00\n") == std::string::npos ||
+        text.find("Rs.2070.00\nStatus: Completed\n") == std::string::npos) {
+        throw std::runtime_error("Text invoice is wrong:\n" + text);
+    }
+    long long bytes = static_cast<long long>(text.size() + readWholeFile(dir + "/INV-000002.txt").size());
+    if (report.bytes != bytes) throw std::runtime_error("Reported bytes should match the files");
+
+    dir = std::string(INVOICE_DIR) + "/dates";
+    report = writeInvoices(loadHistoryBetween("2024-02-01", "2024-02-29"), InvoiceFormat::Html, dir);
+    if (report.invoices != 2) throw std::runtime_error("Date range should select two bookings");
+    if (readWholeFile(dir + "/INV-000002.html").find("Asha &amp; Co") == std::string::npos) throw std::runtime_error("HTML should be escaped");
+    std::string orphan = readWholeFile(dir + "/INV-000003.html");
+    if (orphan.find("Customer: #9<br>") == std::string::npos || orphan.find("Brake &lt;Check&gt;") == std::string::npos) {
+        throw std::runtime_error("Deleted customer should show by ID only:\n" + orphan);
+    }
+    if (!silentMode) std::cout << "[PASS] test_invoices_batchRender\n";
+}
+
+/**
+ * @brief Tests compiling bill templates (fields, widths, sections, errors), HTML escaping, replacing the
+ *        invoice template and the rendered bill formats of the HTTP API.
+ */
+void test_billTemplate_compileAndRender() {
+    clearTestFiles();
+    ServiceItem oil{1, "Oil Change", 1500}, wash{2, "Wash & Wax", 300.5};
+    Customer asha{1, "Asha", "9876543210", "asha@x.com"};
+    ServiceHistory h{7, 1, 3, {1, 2}, "2024-03-01 10:00:00", 1800.5, 2, 12.5, 1575.44, "Pending"};
+    BillData d;
+    d.booking = &h;
+    d.customer = &asha;
+    d.items = {&oil, &wash};
+    d.taxes = {{"CGST 9%", 9, 141.79}};
+
+    BillTemplate t;
+    std::string error;
+    if (!compileBillTemplate("{{invoice}}|{{customerName:-6}}|{{#items}}{{itemName}}={{itemPrice:11}};{{/items}}"
+                             "{{#vehicle}}never{{/vehicle}}{{#discount}}{{discountLabel}} {{discount}}{{/discount}}"
+                             "{{#taxes}}|{{taxLabel}}@{{taxRate}}={{taxAmount}}{{/taxes}}|{{total}}", false, t, error)) {
+        throw std::runtime_error("Template should compile: " + error);
+    }
+    std::string out = "prefix:";
+    renderBill(t, d, out);
+    if (out != "prefix:INV-000007|Asha  |Oil Change= Rs.1500.00;Wash & Wax=  Rs.300.50;"
+               "Discount (12.5%) -Rs.225.06|CGST 9%@9=Rs.141.79|Rs.1575.44") {
+        throw std::runtime_error("Rendered bill is wrong: " + out);
+    }
+    if (compileBillTemplate("<b>{{itemName}}</b>", true, t, error) || error.find("itemName") == std::string::npos) {
+        throw std::runtime_error("Error should name the misplaced field");
+    }
+    for (const char* bad : {"{{#items}}x", "{{/items}}", "{{nope}}", "{{total:x}}", "{{total", "{{#items}}{{/taxes}}"}) {
+        if (compileBillTemplate(bad, false, t, error)) throw std::runtime_error(std::string("Template should not compile: ") + bad);
+    }
+    if (!compileBillTemplate("<b>{{#items}}{{itemName}}{{/items}}</b>", true, t, error)) throw std::runtime_error("HTML template should compile");
+    out.clear();
+    renderBill(t, d, out);
+    if (out != "<b>Oil ChangeWash &amp; Wax</b>") throw std::runtime_error("HTML fields should be escaped: " + out);
+
+    // A replaced template is used by the batch writer and the HTTP API
+    saveServices({oil, wash});
+    saveCustomers({asha});
+    saveHistory({h});
+    if (setInvoiceTemplate(InvoiceFormat::Text, "{{nope}}", error)) throw std::runtime_error("Bad template should be refused");
+    if (!setInvoiceTemplate(InvoiceFormat::Text, "{{invoice}} {{customerName}} {{total}}\n", error)) throw std::runtime_error(error);
+    auto report = writeInvoices(loadHistory(), InvoiceFormat::Text, INVOICE_DIR);
+    std::ifstream ifs(std::string(INVOICE_DIR) + "/INV-000007.txt");
+    std::string line;
+    std::getline(ifs, line);
+    if (report.invoices != 1 || line != "INV-000007 Asha Rs.1575.44") throw std::runtime_error("Custom template not used: " + line);
+
+    HttpRequest req;
+    req.method = "GET";
+    req.path = "/bills/7";
+    req.query = "format=text";
+    int status = 0;
+    std::string body;
+    routeHttpRequest(req, status, body, nullptr);
+    if (status != 200 || body != "INV-000007 Asha Rs.1575.44\n" || std::string(httpContentType(req, status)) != "text/plain; charset=utf-8") {
+        throw std::runtime_error("Text bill over HTTP is wrong: " + body);
+    }
+    req.query = "format=html";
+    body.clear();
+    routeHttpRequest(req, status, body, nullptr);
+    if (body.find("<td>Wash &amp; Wax</td><td class=\"amt\">Rs.300.50</td>") == std::string::npos) throw std::runtime_error("HTML bill is wrong");
+    req.query.clear();
+    body.clear();
+    routeHttpRequest(req, status, body, nullptr);
+    if (body.find("{\"historyId\":7") != 0 || std::string(httpContentType(req, status)) != "application/json") throw std::runtime_error("JSON bill should stay the default");
+    if (!setInvoiceTemplate(InvoiceFormat::Text, builtinBillTemplate(false), error)) throw std::runtime_error(error);
+    if (!silentMode) std::cout << "[PASS] test_billTemplate_compileAndRender\n";
+}
+
+/**
+ * @brief Tests GST computation in paise (discount allocation and rounding per class, CGST/SGST split), the
+ *        booking pipeline, the stored tax lines (history line, archive segment, snapshot) and the GST report.
+ */
+void test_tax_gstBreakdown() {
+    clearTestFiles();
+    ScopedStoreCache cache;
+    saveTaxClasses({{1, "Services", 1800}, {3, "Reduced", 500}});
+    ServiceItem oil{1, "Oil Change", 1200, 1}, brake{2, "Brake Check", 800.55, 1}, pads{3, "Pads", 999.99, 3},
+                wash{4, "Wash", 500}, odd{5, "Odd", 100, 9};
+    auto taxes = computeBookingTaxes({oil, pads, wash, brake, odd}, 12.5, loadTaxClasses());
+    // Services: 2000.55 less 12.5% = 175048 paise taxable, 18% = 31509; reduced: 999.99 less 12.5% = 87499, 5% = 4375
+    if (taxes.size() != 2 || taxes[0].taxClass != 1 || taxes[0].taxablePaise != 175048 || taxes[0].taxPaise != 31509 ||
+        taxes[1].taxClass != 3 || taxes[1].rateBasisPoints != 500 || taxes[1].taxablePaise != 87499 || taxes[1].taxPaise != 4375) {
+        throw std::runtime_error("GST per class is wrong");
+    }
+    long long cgst, sgst;
+    splitGst(taxes[0], cgst, sgst);
+    if (cgst != 15754 || sgst != 15755 || formatRate(1800) != "18%" || formatRate(250) != "2.5%" || formatRate(1225) != "12.25%") {
+        throw std::runtime_error("CGST/SGST split or rate format is wrong");
+    }
+
+    saveCustomers({{1, "Asha", "9876543210", "asha@x.com"}});
+    saveVehicles({{1, 1, "KA01AB1234", "Swift", "Red"}});
+    saveServices({oil, brake, pads, wash});
+    saveDiscounts({{1, "Promo", 12.5, ""}});
+    ServiceHistory h;
+    std::string error;
+    if (!prepareBooking(1, 1, {1, 3, 4, 2}, 1, h, error)) throw std::runtime_error(error);
+    if (h.taxes.size() != 2 || h.taxes[0].taxPaise != 31509 || h.taxes[1].taxPaise != 4375 || bookingTaxPaise(h) != 35884) {
+        throw std::runtime_error("Booking should carry its GST");
+    }
+
+    // Stored tax lines survive the history line, the archive codec and the snapshot image
+    h.historyId = 1;
+    h.dateTime = "2024-04-02 09:30:00";
+    ServiceHistory parsed;
+    if (!parseHistoryLine(formatHistoryLine(h), parsed) || parsed.taxes.size() != 2 || parsed.taxes[1].taxablePaise != 87499) {
+        throw std::runtime_error("Tax lines should round-trip through the history line");
+    }
+    ServiceHistory plain{2, 1, 1, {4}, "2024-04-03 09:30:00", 500, -1, 0, 500, "Completed"};
+    std::string line = formatHistoryLine(plain);
+    if (std::count(line.begin(), line.end(), '|') != 9) throw std::runtime_error("Untaxed rows should keep the old format: " + line);
+    std::vector<ServiceHistory> decoded;
+    if (!decodeArchiveSegment(encodeArchiveSegment({h, plain}), decoded) || decoded[0].taxes.size() != 2 ||
+        decoded[0].taxes[0].rateBasisPoints != 1800 || decoded[0].taxes[0].taxPaise != 31509 || !decoded[1].taxes.empty()) {
+        throw std::runtime_error("Tax lines should round-trip through the archive");
+    }
+    saveHistory({h, plain});
+    if (!writeSnapshotImage()) throw std::runtime_error("Snapshot image should be written");
+    clearStoreCache();
+    if (restoreSnapshotImage() != 6) throw std::runtime_error("All six tables should be restored");
+    auto history = loadHistory();
+    if (history.size() != 2 || history[0].taxes.size() != 2 || history[0].taxes[1].taxPaise != 4375 ||
+        loadServices()[2].taxClass != 3 || loadTaxClasses()[1].rateBasisPoints != 500) {
+        throw std::runtime_error("Snapshot should restore tax classes and lines");
+    }
+
+    // The report sums every line once; a rate change splits the class into two rows
+    ServiceHistory later = h;
+    later.historyId = 3;
+    later.taxes = {{1, 2800, 10001, 2800}};
+    auto report = buildTaxReport({h, plain, later, h});
+    if (report.size() != 3 || report[0].taxClass != 1 || report[0].rateBasisPoints != 1800 || report[1].rateBasisPoints != 2800 ||
+        report[2].taxClass != 3) {
+        throw std::runtime_error("Report should have one row per class and rate");
+    }
+    if (report[0].bookings != 2 || report[0].taxablePaise != 2 * 175048 || report[0].cgstPaise != 2 * 15754 ||
+        report[0].sgstPaise != 2 * 15755 || report[1].cgstPaise + report[1].sgstPaise != 2800) {
+        throw std::runtime_error("Report totals are wrong");
+    }
+    report = taxReportBetween("2024-04-01", "2024-04-30");
+    if (report.size() != 2 || report[0].bookings != 1 || report[1].cgstPaise + report[1].sgstPaise != 4375) {
+        throw std::runtime_error("Date range report should read the stored lines");
+    }
+    if (!silentMode) std::cout << "[PASS] test_tax_gstBreakdown\n";
+}
+
+/**
+ * @brief Tests parts inventory: availability checks, all-or-nothing reservations by the storage writer,
+ *        consumption on completion, replay of the reservation log and reconciliation at startup.
+ */
+void test_inventory_reserveAndConsume() {
+    clearTestFiles();
+    saveParts({{1, "Engine Oil 1L", 5}, {2, "Oil Filter", 2}});
+    saveServiceParts({{1, 1, 4}, {1, 2, 1}, {3, 2, 1}, {4, 2, 0}});
+    std::vector<PartShortage> shortages;
+    if (!checkPartsAvailable({1, 2, 4}, shortages)) throw std::runtime_error("One oil change should be available");
+    if (checkPartsAvailable({1, 1}, shortages) || shortages.size() != 1 || shortages[0].partId != 1 ||
+        shortages[0].needed != 8 || shortages[0].available != 5) {
+        throw std::runtime_error("Two oil changes should be short of oil only");
+    }
+    if (describeShortages(shortages) != "insufficient stock: Engine Oil 1L (need 8, have 5)") throw std::runtime_error(describeShortages(shortages));
+
+    // The writer reserves per booking; the second oil change finds the oil gone and reserves nothing
+    if (!startStorageWriter(16)) throw std::runtime_error("Writer should start");
+    std::atomic<int> accepted{0}, rejected{0};
+    for (int i = 0; i < 2; ++i) {
+        Mutation b;
+        b.type = MutationType::AddBooking;
+        b.booking = {0, 1, 1, {1}, "2024-05-01 10:00:00", 1200, -1, 0, 1200, "Pending"};
+        b.done = [&](bool ok, int, const std::string&) { (ok ? accepted : rejected)++; };
+        submitMutation(b);
+    }
+    stopStorageWriter();
+    if (accepted != 1 || rejected != 1 || loadHistory().size() != 1) throw std::runtime_error("Only one booking should get the oil");
+    int booked = loadHistory()[0].historyId;
+    if (reservedParts(1) != 4 || reservedParts(2) != 1 || availableParts(1) != 1) throw std::runtime_error("Reservation should be all or nothing");
+    if (!reserveParts(50, {3}, shortages) || availableParts(2) != 0) throw std::runtime_error("Last filter should be reservable");
+    if (reserveParts(51, {3}, shortages) || reservedParts(2) != 2) throw std::runtime_error("No filter should be left");
+
+    reloadInventory();
+    if (reservedParts(1) != 4 || reservedParts(2) != 2) throw std::runtime_error("Reservations should replay from the log");
+    if (!setHistoryStatus(booked, "Completed")) throw std::runtime_error("Booking should complete");
+    reloadInventory();
+    auto parts = loadParts();
+    if (parts[0].onHand != 1 || parts[1].onHand != 1 || reservedParts(1) != 0 || reservedParts(2) != 1) {
+        throw std::runtime_error("Completion should take the reserved parts out of stock");
+    }
+    if (consumeParts(booked)) throw std::runtime_error("Parts should be consumed once");
+    if (reconcilePartReservations() != 1 || availableParts(2) != 1) throw std::runtime_error("Reservation without a booking should be dropped");
+    reloadInventory();
+    if (reservedParts(2) != 0) throw std::runtime_error("Reconciled log should be rewritten");
+    if (!silentMode) std::cout << "[PASS] test_inventory_reserveAndConsume\n";
+}
+
+/**
+ * @brief Tests reorder points: consumption rates seeded from the recent history only, and the reorder list
+ *        kept current as stock is reserved, received and consumed.
+ */
+void test_inventory_reorderIncremental() {
+    clearTestFiles();
+    Part oil{1, "Engine Oil 1L", 100}, filter{2, "Oil Filter", 10}, wiper{3, "Wiper", 0};
+    filter.safetyStock = 2;
+    if (formatPartLine(oil) != "1|Engine Oil 1L|100" || formatPartLine(filter) != "2|Oil Filter|10|7|2") {
+        throw std::runtime_error("Reorder policy should be written only when set");
+    }
+    saveParts({oil, filter, wiper});
+    saveServiceParts({{1, 1, 4}, {1, 2, 1}});
+
+    // One oil change a day for the last 14 days, plus one long before the window
+    std::string today = currentDateTime().substr(0, 10);
+    long long midnight;
+    dateTimeToSeconds(today + " 00:00:00", midnight);
+    std::vector<ServiceHistory> history;
+    for (int d = 1; d <= 14; ++d) {
+        history.push_back({d, 1, 1, {1}, secondsToDateTime(midnight - d * 86400LL + 36000), 1200, -1, 0, 1200, "Completed"});
+    }
+    history.push_back({15, 1, 1, {1}, secondsToDateTime(midnight - 40 * 86400LL), 1200, -1, 0, 1200, "Completed"});
+    history.push_back({16, 1, 1, {1}, secondsToDateTime(midnight - 86400LL), 1200, -1, 0, 1200, "Pending"});
+    saveHistory(history);
+    if (refreshPartUsage(today) != 14) throw std::runtime_error("Only completed bookings inside the window should count");
+    if (!reorderList().empty()) throw std::runtime_error("Nothing should need reordering yet");
+
+    // Filter: 14 units over 28 days = 0.5/day, reorder point ceil(0.5 * 7) + 2 = 6
+    std::vector<PartShortage> shortages;
+    if (!reserveParts(100, {1}, shortages) || !receiveParts(2, -4)) throw std::runtime_error("Stock changes should apply");
+    auto list = reorderList();
+    if (list.size() != 1 || list[0].partId != 2 || list[0].available != 5 || list[0].reorderPoint != 6 ||
+        list[0].orderQuantity != 8 || list[0].dailyUsage != 0.5) {
+        throw std::runtime_error("Filter should be at its reorder point");
+    }
+    if (lowStockFor({1}).size() != 1 || !lowStockFor({2}).empty()) throw std::runtime_error("Low stock should be reported per service");
+    consumeParts(100); // 15 units in the window now: ceil(15 / 28 * 21) + 2 - 5 = 9
+    list = reorderList();
+    if (list.size() != 1 || list[0].orderQuantity != 9) throw std::runtime_error("Consumption should update the rate");
+    receiveParts(2, 20);
+    if (!reorderList().empty()) throw std::runtime_error("Received stock should clear the alert");
+    if (!silentMode) std::cout << "[PASS] test_inventory_reorderIncremental\n";
+}
+
+/**
+ * @brief Tests the appointment calendar: free-slot search across bays and days, booking into the first free bay,
+ *        cancellation, log replay, the writer's slot check and the availability endpoint.
+ */
+void test_calendar_slotsAndBooking() {
+    clearTestFiles();
+    saveServices({{1, "Oil Change", 1200, TAX_CLASS_SERVICES, 30}, {5, "Engine Tune-up", 2000, TAX_CLASS_SERVICES, 120},
+                  {6, "Inspection", 500}});
+    if (slotsForServices({1, 5}) != 5 || slotsForServices({6}) != 2 || slotsForServices({1}) != 1) {
+        throw std::runtime_error("Durations should round up to whole slots");
+    }
+    auto offers = nextFreeSlots(5, "2030-01-07", 3);
+    if (offers.size() != 3 || offers[0].start != "2030-01-07 09:00" || offers[2].start != "2030-01-07 10:00" || offers[0].bay != 1) {
+        throw std::runtime_error("An empty day should offer every slot from opening");
+    }
+
+    // Fill all four bays from 09:00 to 11:30
+    Appointment appt;
+    std::string error;
+    for (int bay = 1; bay <= SERVICE_BAYS; ++bay) {
+        if (!bookAppointment(100 + bay, 5, "2030-01-07 09:00", appt, error) || appt.bay != bay) throw std::runtime_error("Each booking should take the next bay");
+    }
+    if (bookAppointment(109, 1, "2030-01-07 10:30", appt, error)) throw std::runtime_error("No bay should be free at 10:30");
+    offers = nextFreeSlots(5, "2030-01-07 08:00", 2);
+    if (offers.size() != 2 || offers[0].start != "2030-01-07 11:30" || offers[1].start != "2030-01-07 12:00") {
+        throw std::runtime_error("Search should skip the busy slots");
+    }
+    offers = nextFreeSlots(5, "2030-01-07 16:10", 1);
+    if (offers.size() != 1 || offers[0].start != "2030-01-08 09:00") throw std::runtime_error("A job past closing should move to the next day");
+    if (validAppointmentStart("2030-01-07 09:15", 1, error) || validAppointmentStart("2030-01-07 16:00", 5, error) ||
+        !validAppointmentStart("2030-01-07 15:30", 5, error) || validAppointmentStart("2030-02-30 09:00", 1, error)) {
+        throw std::runtime_error("Starts should be slot boundaries inside working hours");
+    }
+    if (!cancelAppointment(102) || cancelAppointment(102)) throw std::runtime_error("Cancel should free the slots once");
+    offers = nextFreeSlots(5, "2030-01-07", 1);
+    if (offers.size() != 1 || offers[0].start != "2030-01-07 09:00" || offers[0].bay != 2) throw std::runtime_error("Cancelled bay should be offered");
+
+    reloadCalendar();
+    if (appointmentsOn("2030-01-07").size() != 3 || !findAppointment(103, appt) || appt.bay != 3 || appt.start != "2030-01-07 09:00") {
+        throw std::runtime_error("Appointments should replay from the log");
+    }
+
+    // The writer books the slot; the second booking for the last bay fails
+    if (!startStorageWriter(16)) throw std::runtime_error("Writer should start");
+    std::atomic<int> accepted{0}, rejected{0};
+    for (int i = 0; i < 2; ++i) {
+        Mutation b;
+        b.type = MutationType::AddBooking;
+        b.booking = {0, 1, 1, {1, 5}, "2030-01-01 10:00:00", 3200, -1, 0, 3200, "Pending"};
+        b.appointmentStart = "2030-01-07 09:00";
+        b.done = [&](bool ok, int, const std::string&) { (ok ? accepted : rejected)++; };
+        submitMutation(b);
+    }
+    stopStorageWriter();
+    if (accepted != 1 || rejected != 1 || loadHistory().size() != 1) throw std::runtime_error("Only one booking should get the last bay");
+    int booked = loadHistory()[0].historyId;
+    if (!findAppointment(booked, appt) || appt.bay != 2) throw std::runtime_error("Writer should book the free bay");
+
+    HttpRequest req{"GET", "/availability", "services=1,5&from=2030-01-07&count=2", ""};
+    int status;
+    std::string body;
+    routeHttpRequest(req, status, body, [](int, const std::string&) {});
+    if (status != 200 || body.find("\"minutes\":150") == std::string::npos || body.find("\"start\":\"2030-01-07 11:30\"") == std::string::npos) {
+        throw std::runtime_error("Availability endpoint should list free starts: " + body);
+    }
+    req.query = "services=x";
+    routeHttpRequest(req, status, body, [](int, const std::string&) {});
+    if (status != 400) throw std::runtime_error("Malformed services should be rejected");
+
+    if (reconcileAppointments("2030-01-07") != 3 || appointmentsOn("2030-01-07").size() != 1) {
+        throw std::runtime_error("Appointments without a booking should be dropped");
+    }
+    if (reconcileAppointments("2030-01-08") != 1 || findAppointment(booked, appt)) throw std::runtime_error("Past appointments should be dropped");
+    if (!silentMode) std::cout << "[PASS] test_calendar_slotsAndBooking\n";
+}
+
+/**
+ * @brief Tests the job lifecycle: allowed transitions, stage times recorded by the log and stored in the history
+ *        line and archive, cancellation releasing parts and slots, and incrementally maintained turnaround
+ *        percentiles.
+ */
+void test_lifecycle_transitionsAndTurnaround() {
+    clearTestFiles();
+    saveHistory({{1, 1, 1, {1}, "2030-03-01 09:00:00", 1200, -1, 0, 1200, "Pending"},
+                 {2, 1, 1, {1}, "2030-03-02 10:00:00", 1200, -1, 0, 1200, "Pending"},
+                 {3, 1, 1, {1}, "2030-03-03 10:00:00", 1200, -1, 0, 1200, "Pending"}});
+    if (!canTransition(JobStage::Booked, JobStage::Completed) || canTransition(JobStage::InProgress, JobStage::CheckedIn) ||
+        canTransition(JobStage::Completed, JobStage::Cancelled) || canTransition(JobStage::Cancelled, JobStage::Delivered) ||
+        !canTransition(JobStage::QualityCheck, JobStage::Cancelled)) {
+        throw std::runtime_error("Jobs should only move forward or be cancelled before completion");
+    }
+
+    logHistoryChanges({historyStatusRecord(1, "CheckedIn", "2030-03-01 09:30:00"),
+                       historyStatusRecord(1, "InProgress", "2030-03-01 10:00:00"),
+                       historyStatusRecord(1, "Completed", "2030-03-01 11:30:00")});
+    ServiceHistory h;
+    if (!findHistoryById(1, h) || h.status != "Completed" || formatHistoryLine(h).substr(formatHistoryLine(h).rfind('|') - 2) != "0||1:1800,2:3600,4:9000") {
+        throw std::runtime_error("Stage times should be stored as offsets: " + formatHistoryLine(h));
+    }
+    ServiceHistory parsed;
+    if (!parseHistoryLine(formatHistoryLine(h), parsed) || parsed.stages.size() != 3 || parsed.stages[2].offsetSeconds != 9000) {
+        throw std::runtime_error("Stage times should round-trip through the history line");
+    }
+    std::vector<ServiceHistory> rows{h}, decoded;
+    if (!decodeArchiveSegment(encodeArchiveSegment(rows), decoded) || decoded[0].stages.size() != 3 || decoded[0].stages[1].stage != 2) {
+        throw std::runtime_error("Stage times should round-trip through the archive");
+    }
+    applyHistoryRecord(rows, historyStatusRecord(1, "Completed", "2030-03-01 12:00:00"));
+    if (rows[0].stages.size() != 3) throw std::runtime_error("A replayed stage should be recorded once");
+    long long minutes;
+    if (!turnaroundMinutes(h, minutes) || minutes != 120) throw std::runtime_error("Turnaround should run from check-in");
+
+    if (setHistoryStatus(1, "InProgress") || setHistoryStatus(1, "Cancelled") || !setHistoryStatus(1, "Delivered") ||
+        setHistoryStatus(2, "Booked") || setHistoryStatus(2, "Finished")) {
+        throw std::runtime_error("Status changes should follow the lifecycle");
+    }
+    HttpRequest put{"PUT", "/bookings/1/status", "", "{\"status\":\"InProgress\"}"};
+    int status;
+    std::string body;
+    routeHttpRequest(put, status, body, [](int, const std::string&) {});
+    if (status != 409) throw std::runtime_error("API should refuse a move backwards");
+    if (formatHttpResponse(status, body, true).compare(0, 22, "HTTP/1.1 409 Conflict\r") != 0) throw std::runtime_error("409 should carry its reason phrase");
+
+    // Cancelling releases the job's parts and its bay
+    saveParts({{1, "Engine Oil 1L", 10}});
+    saveServiceParts({{1, 1, 4}});
+    std::vector<PartShortage> shortages;
+    Appointment appt;
+    std::string error;
+    if (!reserveParts(3, {1}, shortages) || !bookAppointment(3, 2, "2030-03-05 09:00", appt, error)) throw std::runtime_error("Job 3 should book");
+    if (!setHistoryStatus(3, "Cancelled") || reservedParts(1) != 0 || findAppointment(3, appt)) {
+        throw std::runtime_error("Cancellation should release parts and the appointment");
+    }
+
+    // Percentiles: built once per month, then kept current as jobs complete
+    TurnaroundHistogram hist = turnaroundBetween("2030-03", "2030-03");
+    if (hist.jobs != 1 || turnaroundPercentile(hist, 50) != 120) throw std::runtime_error("March should hold one job");
+    logHistoryChanges({historyStatusRecord(2, "Completed", "2030-03-02 10:45:00")});
+    hist = turnaroundBetween("2030-02", "2030-04");
+    if (hist.jobs != 2 || turnaroundPercentile(hist, 50) != 45 || turnaroundPercentile(hist, 100) != 120 || hist.totalMinutes != 165) {
+        throw std::runtime_error("Completion should update the cached month");
+    }
+    if (turnaroundBetween("0001-01", "9999-12").jobs != 2 || jobTimesBetween("0001-01-01", "9999-12-31").turnaround.count != 2) {
+        throw std::runtime_error("A wide range should visit only the months holding bookings");
+    }
+    TurnaroundHistogram coarse;
+    addTurnaround(coarse, 300);
+    addTurnaround(coarse, 2000);
+    if (turnaroundPercentile(coarse, 50) != 304 || turnaroundPercentile(coarse, 100) != 2000) {
+        throw std::runtime_error("Percentiles should report the bucket bound, capped at the maximum");
+    }
+    auto summary = summarizeHistoryBetween("2030-03-01", "2030-03-31");
+    if (summary.pendingCount != 0 || summary.completedCount != 2) throw std::runtime_error("Delivered should count as completed, cancelled as neither");
+
+    // Changes checked against the same stale status are checked again by the writer, so the job never moves back
+    logHistoryChanges({historyInsertRecord({4, 1, 1, {1}, "2030-04-01 09:00:00", 1200, -1, 0, 1200, "Pending"})});
+    if (!reserveParts(4, {1}, shortages)) throw std::runtime_error("Job 4 should reserve its parts");
+    if (!startStorageWriter(16)) throw std::runtime_error("Writer should start");
+    std::vector<std::string> outcomes;
+    std::mutex outcomesMutex;
+    for (const char* next : {"Completed", "InProgress", "Completed"}) {
+        Mutation m;
+        m.type = MutationType::SetStatus;
+        m.historyId = 4;
+        m.status = next;
+        m.done = [&](bool ok, int, const std::string& reason) {
+            std::lock_guard<std::mutex> lock(outcomesMutex);
+            outcomes.push_back(ok ? "OK" : reason);
+        };
+        submitMutation(m);
+    }
+    stopStorageWriter();
+    if (outcomes.size() != 3 || outcomes[0] != "OK" || outcomes[1] != "cannot change status from Completed to InProgress" ||
+        outcomes[2] != "cannot change status from Completed to Completed") {
+        throw std::runtime_error("Only the first change should apply");
+    }
+    if (!findHistoryById(4, h) || h.status != "Completed" || loadParts()[0].onHand != 6 || turnaroundBetween("2030-04", "2030-04").jobs > 1) {
+        throw std::runtime_error("Parts and turnaround should be counted once");
+    }
+    if (!silentMode) std::cout << "[PASS] test_lifecycle_transitionsAndTurnaround\n";
+}
+
+/**
+ * @brief Tests the quantile sketch (exact while small, rank error near 1% when large, merged parts matching the
+ *        whole) and the per-day, per-branch, per-service job time sketches kept alongside the history.
+ */
+void test_quantileSketch_jobTimes() {
+    QuantileSketch small;
+    for (double v : {5.0, 1.0, 4.0, 2.0, 3.0}) sketchAdd(small, v);
+    if (sketchQuantile(small, 0.5) != 3 || sketchQuantile(small, 0) != 1 || sketchQuantile(small, 1) != 5) {
+        throw std::runtime_error("A small sketch should be exact");
+    }
+
+    const int n = 100000;
+    QuantileSketch whole, parts[4];
+    uint64_t rng = 88172645463325252ULL;
+    for (int i = 0; i < n; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        double v = static_cast<double>(rng % n);
+        sketchAdd(whole, v);
+        sketchAdd(parts[i % 4], v);
+    }
+    QuantileSketch merged;
+    for (const auto& part : parts) sketchMerge(merged, part);
+    for (const QuantileSketch* s : {&whole, &merged}) {
+        if (s->count != static_cast<uint64_t>(n) || sketchRetained(*s) > 2000) throw std::runtime_error("Sketch should stay small");
+        for (double q : {0.5, 0.9, 0.99}) {
+            if (std::abs(sketchQuantile(*s, q) - q * n) > 0.02 * n) {
+                throw std::runtime_error("Quantile " + std::to_string(q) + " off: " + std::to_string(sketchQuantile(*s, q)));
+            }
+        }
+    }
+
+    // Job 1: service 1 at branch 0; job 2: services 1 and 2 at branch 1; job 3 completes later
+    clearTestFiles();
+    ServiceHistory a{1, 1, 1, {1}, "2030-05-01 09:00:00", 1200, -1, 0, 1200, "Pending"};
+    ServiceHistory b{2, 1, 1, {1, 2}, "2030-05-02 09:00:00", 1200, -1, 0, 1200, "Pending"};
+    b.branchId = 1;
+    ServiceHistory c{3, 1, 1, {2}, "2030-06-01 09:00:00", 1200, -1, 0, 1200, "Pending"};
+    saveHistory({a, b, c});
+    logHistoryChanges({historyStatusRecord(1, "CheckedIn", "2030-05-01 09:00:00"),
+                       historyStatusRecord(1, "InProgress", "2030-05-01 09:20:00"),
+                       historyStatusRecord(1, "Completed", "2030-05-01 10:20:00"),
+                       historyStatusRecord(2, "InProgress", "2030-05-02 10:00:00"),
+                       historyStatusRecord(2, "Completed", "2030-05-02 13:00:00")});
+    JobTimeStats all = jobTimesBetween("2030-05-01", "2030-06-30");
+    if (all.work.count != 2 || sketchQuantile(all.wait, 0.5) != 20 || sketchQuantile(all.work, 1) != 180 ||
+        sketchQuantile(all.turnaround, 0.5) != 80) {
+        throw std::runtime_error("All jobs should be counted once");
+    }
+    JobTimeStats service2 = jobTimesBetween("2030-05-01", "2030-06-30", 2);
+    JobTimeStats branch0 = jobTimesBetween("2030-05-01", "2030-06-30", 1, 0);
+    JobTimeStats day1 = jobTimesBetween("2030-05-02", "2030-05-02");
+    if (service2.work.count != 1 || sketchQuantile(service2.work, 0.5) != 180 || branch0.work.count != 1 ||
+        sketchQuantile(branch0.work, 0.5) != 60 || day1.wait.count != 1 || sketchQuantile(day1.wait, 0.5) != 60) {
+        throw std::runtime_error("Sketches should filter by service, branch and day");
+    }
+    logHistoryChanges({historyStatusRecord(3, "InProgress", "2030-06-01 09:05:00"),
+                       historyStatusRecord(3, "Completed", "2030-06-01 09:35:00")});
+    service2 = jobTimesBetween("2030-05-01", "2030-06-30", 2);
+    if (service2.work.count != 2 || sketchQuantile(service2.work, 0) != 30) throw std::runtime_error("Completion should update the cached sketches");
+    if (jobTimesBetween("2030-5-1", "2030-06-30").work.count != 0) throw std::runtime_error("Malformed dates should give no jobs");
+
+    HttpRequest get{"GET", "/job-times", "from=2030-05-01&to=2030-06-30&service=2", ""};
+    int status;
+    std::string body;
+    if (!routeHttpRequestAndWait(get, status, body)) throw std::runtime_error("Job times should be built off the event loop");
+    if (status != 200 || body.find("\"work\":{\"jobs\":2,\"p50\":30") == std::string::npos) throw std::runtime_error("Unexpected job times: " + body);
+    if (!silentMode) std::cout << "[PASS] test_quantileSketch_jobTimes\n";
+}
+
+/**
+ * @brief Tests HyperLogLog estimates, merging and serialization, and distinct customer and vehicle counts
+ *        answered from the segment sidecars of both tiers.
+ */
+void test_hyperLogLog_distinctCounts() {
+    HyperLogLog all = makeHyperLogLog(), odd = makeHyperLogLog(), even = makeHyperLogLog();
+    for (int i = 0; i < 100000; ++i) {
+        hllAdd(all, i);
+        hllAdd(all, i); // Repeats do not count
+        hllAdd(i % 2 ? odd : even, i);
+    }
+    if (std::abs(hllEstimate(all) - 100000) > 5000) throw std::runtime_error("Estimate off: " + std::to_string(hllEstimate(all)));
+    if (!hllMerge(odd, even) || odd.registers != all.registers) throw std::runtime_error("Merged halves should equal the whole");
+    HyperLogLog few = makeHyperLogLog(), decoded;
+    for (int i = 0; i < 10; ++i) hllAdd(few, i * 7919);
+    if (hllEstimate(few) != 10) throw std::runtime_error("Small counts should be exact");
+    for (const HyperLogLog* h : {&few, &all}) {
+        std::string buf;
+        size_t pos = 0;
+        serializeHyperLogLog(*h, buf);
+        if (!deserializeHyperLogLog(buf, pos, decoded) || pos != buf.size() || decoded.registers != h->registers) {
+            throw std::runtime_error("Sketch should round-trip");
+        }
+    }
+
+    // January is archived; February stays hot and includes a cancelled booking
+    clearTestFiles();
+    std::vector<ServiceHistory> rows{{1, 1, 1, {1}, "2030-01-05 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {2, 2, 2, {1}, "2030-01-06 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {3, 1, 3, {1}, "2030-01-07 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {4, 1, 1, {1}, "2030-02-01 09:00:00", 1200, -1, 0, 1200, "Pending"},
+                                     {5, 3, 4, {1}, "2030-02-02 09:00:00", 1200, -1, 0, 1200, "Cancelled"},
+                                     {6, 4, 5, {1}, "2030-02-03 09:00:00", 1200, -1, 0, 1200, "Pending"}};
+    rows[1].branchId = 1;
+    rows[5].branchId = 1;
+    saveHistory(rows);
+    if (archiveCompletedHistory("2030-02-01") != 3) throw std::runtime_error("January should be archived");
+    DistinctCounts both = distinctBetween("2030-01", "2030-02");
+    DistinctCounts branch0 = distinctBetween("2030-01", "2030-02", 0);
+    DistinctCounts feb = distinctBetween("2030-02", "2030-02");
+    if (both.customers != 3 || both.vehicles != 4 || branch0.customers != 1 || branch0.vehicles != 2 || feb.customers != 2) {
+        throw std::runtime_error("Distinct counts should merge both tiers and filter by branch");
+    }
+    std::filesystem::remove(std::string(PARTITION_DIR) + "/2030-02.hll");
+    if (distinctBetween("2030-01", "2030-02").customers != 3 || !std::filesystem::exists(std::string(PARTITION_DIR) + "/2030-02.hll")) {
+        throw std::runtime_error("A segment without a sidecar should be given one");
+    }
+    if (distinctBetween("2030-1", "2030-02").customers != 0) throw std::runtime_error("Malformed months should count nothing");
+
+    HttpRequest get{"GET", "/distinct", "from=2030-01&to=2030-02&branch=1", ""};
+    int status;
+    std::string body;
+    routeHttpRequest(get, status, body, [](int, const std::string&) {});
+    if (status != 200 || body != "{\"customers\":2,\"vehicles\":2}") throw std::runtime_error("Unexpected distinct counts: " + body);
+    if (!silentMode) std::cout << "[PASS] test_hyperLogLog_distinctCounts\n";
+}
+
+/**
+ * @brief Tests the visit timelines (dense and sparse customer IDs) and the cohort retention matrix built from
+ *        the hot and archived history.
+ */
+void test_cohort_retentionMatrix() {
+    VisitTimeline t = buildVisitTimeline(std::vector<std::pair<int, int>>{{2000000000, 5}, {7, 9}, {2000000000, 3}, {7, 9}, {-4, 1}});
+    if (t.customerIds != std::vector<int>{-4, 7, 2000000000} || t.offsets != std::vector<size_t>{0, 1, 2, 4} ||
+        t.months != std::vector<int>{1, 9, 3, 5}) {
+        throw std::runtime_error("Timelines should be sorted per customer without repeats");
+    }
+
+    // Customer 1 returns in M+1 (twice) and M+3; customer 2 only after M+12; customer 3 joined before the
+    // range; customer 4's cancelled January booking does not make January its cohort
+    clearTestFiles();
+    std::vector<ServiceHistory> rows{{1, 1, 1, {1}, "2030-01-05 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {2, 2, 2, {1}, "2030-01-06 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {3, 3, 3, {1}, "2029-12-06 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {4, 3, 3, {1}, "2030-01-07 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {5, 4, 4, {1}, "2030-01-08 09:00:00", 1200, -1, 0, 1200, "Cancelled"},
+                                     {6, 1, 1, {1}, "2030-02-01 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {7, 1, 1, {1}, "2030-02-20 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {8, 4, 4, {1}, "2030-02-03 09:00:00", 1200, -1, 0, 1200, "Completed"},
+                                     {9, 4, 4, {1}, "2030-03-03 09:00:00", 1200, -1, 0, 1200, "Pending"},
+                                     {10, 1, 1, {1}, "2030-04-03 09:00:00", 1200, -1, 0, 1200, "Pending"},
+                                     {11, 2, 2, {1}, "2031-02-03 09:00:00", 1200, -1, 0, 1200, "Pending"}};
+    saveHistory(rows);
+    archiveCompletedHistory("2030-02-01");
+    RetentionMatrix m = cohortRetentionBetween("2030-01", "2030-03");
+    std::array<int, RETENTION_MONTHS> jan{1, 0, 1}, feb{1};
+    if (m.cohorts != std::vector<std::string>{"2030-01", "2030-02", "2030-03"} || m.sizes != std::vector<int>{2, 1, 0} ||
+        m.returned[0] != jan || m.returned[1] != feb) {
+        throw std::runtime_error("Unexpected retention matrix");
+    }
+    if (!cohortRetentionBetween("2030-13", "2030-03").cohorts.empty()) throw std::runtime_error("Malformed months should give no cohorts");
+
+    HttpRequest get{"GET", "/retention", "from=2030-02&to=2030-02", ""};
+    int status;
+    std::string body;
+    if (!routeHttpRequestAndWait(get, status, body)) throw std::runtime_error("Retention should be built off the event loop");
+    if (status != 200 || body != "[{\"cohort\":\"2030-02\",\"size\":1,\"returned\":[1,0,0,0,0,0,0,0,0,0,0,0]}]") {
+        throw std::runtime_error("Unexpected retention JSON: " + body);
+    }
+    get.query = "from=2030-13&to=2030-02";
+    routeHttpRequestAndWait(get, status, body);
+    if (status != 400) throw std::runtime_error("Malformed months should be rejected");
+    if (!silentMode) std::cout << "[PASS] test_cohort_retentionMatrix\n";
+}
+
 /**
  * @brief Main entry point for the unit test suite.
  * @return int Exit code (0 for successful completion).
  * @note Runs all test cases for customers, vehicles, services, discounts, and service history, then cleans up test files.
+ *       With "--checkpoint-crash <failpoint>" it instead runs one checkpoint that exits at that failpoint, and
+ *       with "--standby-until <socket> <seq> <snapshots>" it follows a primary as a standby until caught up.
  */
-int main() {
+int main(int argc, char* argv[]) {
+    testProgramPath = argv[0];
+    if (argc == 3 && std::string(argv[1]) == "--checkpoint-crash") {
+        setCheckpointFailpoint(static_cast<CheckpointFailpoint>(std::stoi(argv[2])));
+        checkpointHistory();
+        return 0; // Failpoint not reached
+    }
+    if (argc == 5 && std::string(argv[1]) == "--standby-until") {
+        return runStandbyUntil(argv[2], std::stoll(argv[3]), std::stoll(argv[4]));
+    }
     std::cout << "===== Auto Service Management Unit Test Suite =====" << std::endl;
 
     // Customer Tests
@@ -836,6 +2674,78 @@ int main() {
     RUN_TEST(test_addHistoryEntry);
     RUN_TEST(test_addHistoryEntry_emptyServiceIds);
 
+    // History Partition Tests
+    RUN_TEST(test_historyPartitions_summaries);
+    RUN_TEST(test_historyPartitions_dateRange);
+    RUN_TEST(test_historyPartitions_sumPrecision);
+
+    // History Archive Tests
+    RUN_TEST(test_archiveSegment_roundTrip);
+    RUN_TEST(test_deltaColumn_roundTrip);
+    RUN_TEST(test_archiveCompletedHistory);
+
+    // Bloom Filter Tests
+    RUN_TEST(test_bloomFilter_membership);
+    RUN_TEST(test_findHistoryRows_segmentFilters);
+
+    // Compaction Tests
+    RUN_TEST(test_compactDataFile_history);
+    RUN_TEST(test_backgroundCompaction_customers);
+
+    // Snapshot Tests
+    RUN_TEST(test_snapshotImage_roundTrip);
+    RUN_TEST(test_snapshotImage_staleFallback);
+
+    // History Log Tests
+    RUN_TEST(test_historyLog_replay);
+    RUN_TEST(test_checkpoint_truncatesLog);
+    RUN_TEST(test_checkpoint_crashRecovery);
+    RUN_TEST(test_groupCommit_concurrentBookings);
+
+    // Storage Writer Tests
+    RUN_TEST(test_mpscQueue_multiProducer);
+    RUN_TEST(test_storageWriter_concurrentMutations);
+
+    // Thread Pool Tests
+    RUN_TEST(test_threadPool_parallelForAndStealing);
+    RUN_TEST(test_threadPool_cancellation);
+
+    // Change Feed Tests
+    RUN_TEST(test_changeFeed_mutationsInOrder);
+#ifndef _WIN32
+    RUN_TEST(test_replication_standbyCatchesUp);
+#endif
+
+    // Branch Store Tests
+    RUN_TEST(test_branchStores_shardAndAggregate);
+
+    // Invoice Tests
+    RUN_TEST(test_invoices_batchRender);
+    RUN_TEST(test_billTemplate_compileAndRender);
+
+    // Tax Tests
+    RUN_TEST(test_tax_gstBreakdown);
+
+    // Inventory Tests
+    RUN_TEST(test_inventory_reserveAndConsume);
+    RUN_TEST(test_inventory_reorderIncremental);
+
+    // Calendar Tests
+    RUN_TEST(test_calendar_slotsAndBooking);
+
+    // Lifecycle Tests
+    RUN_TEST(test_lifecycle_transitionsAndTurnaround);
+    RUN_TEST(test_quantileSketch_jobTimes);
+    RUN_TEST(test_hyperLogLog_distinctCounts);
+    RUN_TEST(test_cohort_retentionMatrix);
+
+    // Server Tests
+    RUN_TEST(test_json_roundTrip);
+#ifndef _WIN32
+    RUN_TEST(test_server_pipelinedRequests);
+    RUN_TEST(test_httpApi_keepAlivePipelining);
+#endif
+
     std::cout << "=========== Test Suite Completed ===========" << std::endl;
 
     // Clean up test files